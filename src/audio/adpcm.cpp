@@ -0,0 +1,95 @@
+#include "adpcm.h"
+
+static const int16_t kStepTable[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t kIndexTable[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static inline int32_t clamp_i32(int32_t v, int32_t lo, int32_t hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// 按码字更新预测值和步长索引，编码和解码共用，保证两端状态一致
+static inline void ima_update(ImaAdpcmState& state, uint8_t code) {
+    int32_t step = kStepTable[state.index];
+    int32_t diff = step >> 3;
+    if (code & 4) diff += step;
+    if (code & 2) diff += step >> 1;
+    if (code & 1) diff += step >> 2;
+    state.predictor = clamp_i32(code & 8 ? state.predictor - diff : state.predictor + diff, -32768, 32767);
+    state.index = clamp_i32(state.index + kIndexTable[code], 0, 88);
+}
+
+uint8_t ima_adpcm_encode_sample(ImaAdpcmState& state, int16_t sample) {
+    int32_t step = kStepTable[state.index];
+    int32_t diff = sample - state.predictor;
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) { code |= 4; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { code |= 2; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { code |= 1; }
+    ima_update(state, code);
+    return code;
+}
+
+int16_t ima_adpcm_decode_sample(ImaAdpcmState& state, uint8_t code) {
+    ima_update(state, code & 0x0F);
+    return (int16_t)state.predictor;
+}
+
+size_t ima_adpcm_encode_block(ImaAdpcmState& state, const int16_t* in, size_t count, size_t stride,
+                              uint8_t* out, size_t block_align) {
+    if (block_align < 5 || count == 0) return 0;
+    const size_t samples = IMA_ADPCM_SAMPLES_PER_BLOCK(block_align);
+
+    // 块头：第一个样本原样保存，解码端从这里重新同步
+    int16_t first = in[0];
+    state.predictor = first;
+    out[0] = (uint8_t)(first & 0xFF);
+    out[1] = (uint8_t)((uint16_t)first >> 8);
+    out[2] = (uint8_t)state.index;
+    out[3] = 0;
+
+    int16_t last = in[(count - 1) * stride];
+    uint8_t* p = out + 4;
+    for (size_t i = 1; i < samples; i += 2) {
+        int16_t s0 = i < count ? in[i * stride] : last;
+        int16_t s1 = i + 1 < count ? in[(i + 1) * stride] : last;
+        uint8_t lo = ima_adpcm_encode_sample(state, s0);
+        uint8_t hi = ima_adpcm_encode_sample(state, s1);
+        *p++ = (uint8_t)(lo | (hi << 4));
+    }
+    return block_align;
+}
+
+size_t ima_adpcm_decode_block(const uint8_t* in, size_t block_align, int16_t* out) {
+    if (block_align < 5) return 0;
+    const size_t samples = IMA_ADPCM_SAMPLES_PER_BLOCK(block_align);
+
+    ImaAdpcmState state;
+    state.predictor = (int16_t)(in[0] | (in[1] << 8));
+    state.index = clamp_i32(in[2], 0, 88);
+    out[0] = (int16_t)state.predictor;
+
+    const uint8_t* p = in + 4;
+    for (size_t i = 1; i < samples; i += 2) {
+        uint8_t byte = *p++;
+        out[i] = ima_adpcm_decode_sample(state, byte & 0x0F);
+        out[i + 1] = ima_adpcm_decode_sample(state, byte >> 4);
+    }
+    return samples;
+}
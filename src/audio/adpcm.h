@@ -0,0 +1,50 @@
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// IMA ADPCM (4 bit/样本，压缩比 4:1) 编解码。
+// 块格式与 WAV 的 WAVE_FORMAT_IMA_ADPCM (0x0011) 单声道一致：
+//   [0..1] 第一个样本 (int16 小端)  [2] 步长索引  [3] 保留 (0)
+//   之后每字节两个样本，低 4 位在前
+// 所以编码结果可以直接写成 .wav 文件，或逐块解码播放。
+
+// 默认块大小 256 字节 = 505 个样本 (24kHz 下约 21ms)
+#define IMA_ADPCM_BLOCK_ALIGN 256
+#define IMA_ADPCM_SAMPLES_PER_BLOCK(align) ((size_t)((align) - 4) * 2 + 1)
+
+// 编码器状态，跨块保留步长索引可以避免每块开头重新收敛
+struct ImaAdpcmState {
+    int32_t predictor = 0;
+    int32_t index = 0;
+};
+
+/**
+ * @brief 编码一个样本，返回 4 位码字
+ */
+uint8_t ima_adpcm_encode_sample(ImaAdpcmState& state, int16_t sample);
+
+/**
+ * @brief 解码一个 4 位码字
+ */
+int16_t ima_adpcm_decode_sample(ImaAdpcmState& state, uint8_t code);
+
+/**
+ * @brief 编码一个块
+ * @param in      输入样本，按 stride 间隔读取 (交织立体声取单声道时传 2)
+ * @param count   样本数，不足一个块时用最后一个样本补齐
+ * @param out     block_align 字节
+ * @return 写入的字节数 (总是 block_align)，参数非法时返回 0
+ */
+size_t ima_adpcm_encode_block(ImaAdpcmState& state, const int16_t* in, size_t count, size_t stride,
+                              uint8_t* out, size_t block_align = IMA_ADPCM_BLOCK_ALIGN);
+
+/**
+ * @brief 解码一个块
+ * @param out IMA_ADPCM_SAMPLES_PER_BLOCK(block_align) 个样本
+ * @return 输出的样本数
+ */
+size_t ima_adpcm_decode_block(const uint8_t* in, size_t block_align, int16_t* out);
+
+#endif // ADPCM_H
@@ -0,0 +1,183 @@
+#include "audio_agc.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static inline float db_to_linear(float db) {
+    return powf(10.0f, db / 20.0f);
+}
+
+// 平方和，4 路展开以便编译器做流水线调度
+static float sum_squares_s16(const int16_t* x, size_t n) {
+    float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float a = x[i], b = x[i + 1], c = x[i + 2], d = x[i + 3];
+        s0 += a * a;
+        s1 += b * b;
+        s2 += c * c;
+        s3 += d * d;
+    }
+    for (; i < n; i++) {
+        float a = x[i];
+        s0 += a * a;
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+static float peak_abs_f32(const float* x, size_t n) {
+    float m0 = 0, m1 = 0, m2 = 0, m3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        m0 = std::max(m0, fabsf(x[i]));
+        m1 = std::max(m1, fabsf(x[i + 1]));
+        m2 = std::max(m2, fabsf(x[i + 2]));
+        m3 = std::max(m3, fabsf(x[i + 3]));
+    }
+    for (; i < n; i++) {
+        m0 = std::max(m0, fabsf(x[i]));
+    }
+    return std::max(std::max(m0, m1), std::max(m2, m3));
+}
+
+static inline int16_t saturate_s16(float v) {
+    if (v >= 32767.0f) return 32767;
+    if (v <= -32768.0f) return -32768;
+    return (int16_t)lrintf(v);
+}
+
+AudioAgc::AudioAgc(int sample_rate, int channels, const AgcConfig& config)
+    : config_(config),
+      sample_rate_(sample_rate),
+      channels_(channels > 0 ? channels : 1),
+      coarse_db_(config.coarse_initial_db) {
+    lookahead_ = (size_t)(config_.lookahead_ms * sample_rate_ / 1000.0f) * channels_;
+    limiter_threshold_ = 32767.0f * db_to_linear(config_.limiter_dbfs);
+    work_.assign(lookahead_, 0.0f);
+}
+
+void AudioAgc::SetCoarseGainCallback(CoarseGainCallback cb) {
+    coarse_cb_ = std::move(cb);
+    if (coarse_cb_ && !coarse_cb_(coarse_db_)) {
+        coarse_cb_ = nullptr;
+    }
+}
+
+void AudioAgc::Reset() {
+    level_db_ = -90.0f;
+    fine_db_ = 0.0f;
+    fine_linear_ = 1.0f;
+    limiter_gain_ = 1.0f;
+    std::fill(work_.begin(), work_.end(), 0.0f);
+}
+
+void AudioAgc::UpdateGain(float block_db, size_t frames) {
+    // 1. 电平包络 (dB 域一阶平滑)；静音时冻结，避免把底噪拉上来
+    if (block_db > config_.noise_gate_dbfs) {
+        float tau_ms = block_db > level_db_ ? config_.attack_ms : config_.release_ms;
+        float a = expf(-(float)frames * 1000.0f / (tau_ms * sample_rate_));
+        level_db_ = a * level_db_ + (1.0f - a) * block_db;
+    } else {
+        return;
+    }
+
+    // 2. 总增益需求 = 粗调 + 细调；电平是 PGA 之后测得的
+    float wanted_total = coarse_db_ + (config_.target_dbfs - level_db_);
+    wanted_total = std::min(std::max(wanted_total, config_.min_gain_db), config_.max_gain_db);
+    float wanted_fine = wanted_total - coarse_db_;
+
+    // 3. 细调超出一个 PGA 步进时，把整步交给编解码器 (步进本身就是迟滞量)
+    if (coarse_cb_) {
+        float step = 0.0f;
+        if (wanted_fine > config_.coarse_step_db && coarse_db_ + config_.coarse_step_db <= config_.coarse_max_db) {
+            step = config_.coarse_step_db;
+        } else if (wanted_fine < -config_.coarse_step_db && coarse_db_ - config_.coarse_step_db >= config_.coarse_min_db) {
+            step = -config_.coarse_step_db;
+        }
+        if (step != 0.0f && coarse_cb_(coarse_db_ + step)) {
+            coarse_db_ += step;
+            level_db_ += step;
+            wanted_fine -= step;
+            // 立即反向补偿细调，使总增益保持连续
+            fine_db_ -= step;
+        }
+    }
+
+    // 4. 细调限速
+    float max_delta = config_.gain_slew_db_per_s * frames / sample_rate_;
+    float delta = std::min(std::max(wanted_fine - fine_db_, -max_delta), max_delta);
+    fine_db_ += delta;
+}
+
+void AudioAgc::Process(int16_t* samples, size_t count) {
+    AudioPerfScope scope(perf_);
+    // 不足一帧时不处理：块内增益斜坡按帧数插值，frames 为 0 时 step 会除以 0
+    size_t frames = count / channels_;
+    if (frames == 0) return;
+    if (work_.size() < lookahead_ + count) {
+        work_.resize(lookahead_ + count, 0.0f);
+    }
+
+    float mean_sq = sum_squares_s16(samples, count) / (float)count;
+    float block_db = 10.0f * log10f(mean_sq / (32768.0f * 32768.0f) + 1e-12f);
+
+    float old_gain = fine_linear_;
+    UpdateGain(block_db, frames);
+    float new_gain = db_to_linear(fine_db_);
+    fine_linear_ = new_gain;
+
+    // 块内线性增益插值，写入延迟线之后
+    float* in = work_.data() + lookahead_;
+    float step = (new_gain - old_gain) / (float)frames;
+    float g = old_gain;
+    for (size_t f = 0; f < frames; f++) {
+        g += step;
+        const int16_t* src = samples + f * channels_;
+        float* dst = in + f * channels_;
+        for (int c = 0; c < channels_; c++) {
+            dst[c] = src[c] * g;
+        }
+    }
+    for (size_t i = frames * channels_; i < count; i++) {
+        in[i] = samples[i] * new_gain;
+    }
+
+    ApplyLimiter(samples, count);
+
+    // 最后 lookahead_ 个样本留作下一块的延迟线
+    memmove(work_.data(), work_.data() + count, lookahead_ * sizeof(float));
+}
+
+void AudioAgc::ApplyLimiter(int16_t* out, size_t count) {
+    // work_[0, count) 为本次输出，work_[count, count + lookahead_) 为预读。
+    // 对每一段 k，增益在段末必须满足本段和下一段的峰值要求，段内线性过渡，
+    // 因为段首增益已满足本段峰值 (上一段保证)，所以线性斜坡全程不会过冲。
+    const float* x = work_.data();
+    size_t seg = lookahead_ > 0 ? lookahead_ : count;
+    float peak_cur = peak_abs_f32(x, std::min(seg, count));
+
+    for (size_t pos = 0; pos < count; pos += seg) {
+        size_t n = std::min(seg, count - pos);
+        size_t next_len = std::min(seg, count + lookahead_ - (pos + n));
+        float peak_next = next_len ? peak_abs_f32(x + pos + n, next_len) : 0.0f;
+
+        float peak = std::max(peak_cur, peak_next);
+        float target = peak > limiter_threshold_ ? limiter_threshold_ / peak : 1.0f;
+        float g0 = limiter_gain_;
+        float g1 = target;
+        if (target > g0) {
+            float r = expf(-(float)(n / channels_) * 1000.0f / (config_.limiter_release_ms * sample_rate_));
+            g1 = target + (g0 - target) * r;
+        }
+
+        float step = (g1 - g0) / (float)n;
+        float g = g0;
+        for (size_t i = 0; i < n; i++) {
+            g += step;
+            out[pos + i] = saturate_s16(x[pos + i] * g);
+        }
+        limiter_gain_ = g1;
+        peak_cur = peak_next;
+    }
+}
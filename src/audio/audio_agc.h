@@ -0,0 +1,85 @@
+#ifndef AUDIO_AGC_H
+#define AUDIO_AGC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "audio_perf.h"
+
+// AGC 参数，默认值针对 24kHz 语音
+struct AgcConfig {
+    float target_dbfs = -18.0f;          // 目标语音电平 (RMS)
+    float min_gain_db = -12.0f;          // 总增益下限 (模拟 + 数字)
+    float max_gain_db = 36.0f;           // 总增益上限
+    float attack_ms = 20.0f;             // 电平上升时的包络时间常数
+    float release_ms = 400.0f;           // 电平下降时的包络时间常数
+    float gain_slew_db_per_s = 30.0f;    // 数字增益最大变化速度，避免“抽吸”感
+    float noise_gate_dbfs = -60.0f;      // 低于此电平视为静音，冻结增益
+    float limiter_dbfs = -1.0f;          // 限幅器门限
+    float limiter_release_ms = 60.0f;    // 限幅器恢复时间
+    float lookahead_ms = 2.0f;           // 限幅器预读长度
+    // 粗调 (ES8311 PGA) 参数：PGA 步进 6dB，范围 0~42dB
+    float coarse_step_db = 6.0f;
+    float coarse_min_db = 0.0f;
+    float coarse_max_db = 42.0f;
+    float coarse_initial_db = 24.0f;
+};
+
+/**
+ * @brief 采集通路的自动增益控制 + 预读峰值限幅器
+ *
+ * 增益分两级：粗调通过回调写入编解码器的 PGA (esp_codec_dev_set_in_gain)，
+ * 软件只负责粗调步进以内的细调。处理按块进行，每块只计算一次包络和目标增益，
+ * 块内做线性增益插值；限幅器按预读长度分段，段内同样是线性斜坡。
+ * 多声道数据按交织格式处理，所有声道共用同一个增益，保证声像不漂移。
+ */
+class AudioAgc {
+public:
+    // 粗调回调：参数为新的 PGA 增益 (dB)，返回是否设置成功
+    using CoarseGainCallback = std::function<bool(float db)>;
+
+    AudioAgc(int sample_rate, int channels, const AgcConfig& config = AgcConfig());
+
+    void SetCoarseGainCallback(CoarseGainCallback cb);
+
+    /**
+     * @brief 原地处理一块交织的 16 位 PCM
+     *
+     * 输出相对输入延迟 lookahead_ms。
+     */
+    void Process(int16_t* samples, size_t count);
+    void Process(std::vector<int16_t>& samples) { Process(samples.data(), samples.size()); }
+
+    void Reset();
+
+    float level_dbfs() const { return level_db_; }
+    float coarse_gain_db() const { return coarse_db_; }
+    float fine_gain_db() const { return fine_db_; }
+    float limiter_gain() const { return limiter_gain_; }
+    const AudioPerfCounter& perf() const { return perf_; }
+    void ResetPerf() { perf_.Reset(); }
+
+private:
+    void UpdateGain(float block_rms_db, size_t frames);
+    void ApplyLimiter(int16_t* out, size_t count);
+
+    AgcConfig config_;
+    int sample_rate_;
+    int channels_;
+    CoarseGainCallback coarse_cb_;
+
+    float level_db_ = -90.0f;
+    float coarse_db_;
+    float fine_db_ = 0.0f;
+    float fine_linear_ = 1.0f;
+
+    size_t lookahead_;                  // 预读长度 (交织样本数)
+    std::vector<float> work_;           // [延迟线 | 当前块]
+    float limiter_threshold_;
+    float limiter_gain_ = 1.0f;
+
+    AudioPerfCounter perf_;
+};
+
+#endif // AUDIO_AGC_H
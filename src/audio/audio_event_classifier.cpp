@@ -0,0 +1,74 @@
+#include "audio_event_classifier.h"
+
+#include <algorithm>
+#include <cmath>
+
+static size_t model_arena_bytes(const NnModel& net) {
+    return nn_arena_bytes(net.layers, net.num_layers, net.input);
+}
+
+AudioEventClassifier::AudioEventClassifier(const AudioEventModel& model, const MelFeatureExtractor& features,
+                                           const AudioEventConfig& config)
+    : model_(model),
+      features_(features),
+      config_(config),
+      arena_(model_arena_bytes(model.net), DspMemory::INTERNAL),
+      interp_(model.net, arena_.data(), model_arena_bytes(model.net)) {
+    const MelConfig& mel = features_.config();
+    frame_ms_ = 1000.0f * mel.hop_size / mel.sample_rate;
+
+    // 模型输入必须与特征环形缓冲的形状一致
+    const NnShape in = model_.net.input;
+    if (!interp_.valid() || !features_.valid() || in.c != 1 || in.w != features_.feature_dim() ||
+        in.h > features_.ring_frames() || interp_.output_shape().size() != model_.num_labels ||
+        config_.infer_every_frames == 0) {
+        return;
+    }
+    scores_.assign(model_.num_labels, 0.0f);
+    hits_.assign(model_.num_labels, 0);
+    last_event_frame_.assign(model_.num_labels, 0);
+    valid_ = true;
+}
+
+bool AudioEventClassifier::Update() {
+    if (!valid_) return false;
+    const uint64_t now = features_.total_frames();
+    if (now < model_.net.input.h || now - last_frame_ < config_.infer_every_frames) {
+        return false;
+    }
+    last_frame_ = now;
+
+    features_.CopyWindowInt8(interp_.input(), model_.net.input.h, model_.input_scale, model_.input_zero_point);
+    interp_.Invoke();
+
+    // 反量化 + softmax
+    const int8_t* out = interp_.output();
+    float max_logit = -INFINITY;
+    for (size_t i = 0; i < model_.num_labels; i++) {
+        scores_[i] = (out[i] - model_.output_zero_point) * model_.output_scale;
+        max_logit = std::max(max_logit, scores_[i]);
+    }
+    float sum = 0.0f;
+    for (size_t i = 0; i < model_.num_labels; i++) {
+        scores_[i] = expf(scores_[i] - max_logit);
+        sum += scores_[i];
+    }
+    for (size_t i = 0; i < model_.num_labels; i++) {
+        scores_[i] /= sum;
+    }
+
+    // 去抖：连续 hits_required 次超过门限才触发；触发后进入冷却期
+    const uint64_t refractory_frames = (uint64_t)(config_.refractory_ms / frame_ms_);
+    for (size_t i = 0; i < model_.num_labels; i++) {
+        if (!model_.labels[i]) continue;
+        hits_[i] = scores_[i] >= config_.threshold ? hits_[i] + 1 : 0;
+        if (hits_[i] < config_.hits_required) continue;
+        if (last_event_frame_[i] != 0 && now - last_event_frame_[i] < refractory_frames) continue;
+        last_event_frame_[i] = now;
+        hits_[i] = 0;
+        if (event_cb_) {
+            event_cb_(model_.labels[i], scores_[i]);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,73 @@
+#ifndef AUDIO_EVENT_CLASSIFIER_H
+#define AUDIO_EVENT_CLASSIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "mel_features.h"
+#include "nn_int8.h"
+
+// 量化分类模型的描述。输入张量为 [frames][feature_dim][1]，输出为每个类别的 logit
+struct AudioEventModel {
+    NnModel net;
+    float input_scale;
+    int input_zero_point;
+    float output_scale;
+    int output_zero_point;
+    const char* const* labels;   // 与输出通道一一对应，nullptr 表示背景类，不产生事件
+    size_t num_labels;
+};
+
+struct AudioEventConfig {
+    size_t infer_every_frames = 10;   // 每新增多少帧特征推理一次 (约 100ms)
+    float threshold = 0.8f;           // softmax 概率门限
+    int hits_required = 3;            // 连续命中次数，用于去抖
+    uint32_t refractory_ms = 10000;   // 同一类别两次事件的最小间隔
+};
+
+/**
+ * @brief 基于 log-mel 特征的本地音频事件分类 (咳嗽、打鼾、呼救等)
+ *
+ * 只在新特征帧累计到一定数量时推理一次，结果经过去抖和冷却后以事件形式回调，
+ * 由调用方决定如何上报 (例如 mqtt_publish_event)，原始音频不离开设备。
+ */
+class AudioEventClassifier {
+public:
+    using EventCallback = std::function<void(const char* label, float score)>;
+
+    AudioEventClassifier(const AudioEventModel& model, const MelFeatureExtractor& features,
+                         const AudioEventConfig& config = AudioEventConfig());
+
+    bool valid() const { return valid_; }
+    void SetEventCallback(EventCallback cb) { event_cb_ = std::move(cb); }
+
+    /**
+     * @brief 在 MelFeatureExtractor::Push 之后调用，按需执行推理
+     * @return 本次是否执行了推理
+     */
+    bool Update();
+
+    // 最近一次推理各类别的概率
+    const std::vector<float>& scores() const { return scores_; }
+    const AudioPerfCounter& perf() const { return interp_.perf(); }
+    size_t arena_bytes() const { return arena_.size(); }
+
+private:
+    const AudioEventModel& model_;
+    const MelFeatureExtractor& features_;
+    AudioEventConfig config_;
+    DspBuffer<int8_t> arena_;
+    NnInterpreter interp_;
+    bool valid_ = false;
+
+    uint64_t last_frame_ = 0;
+    float frame_ms_;
+    std::vector<float> scores_;
+    std::vector<int> hits_;
+    std::vector<uint64_t> last_event_frame_;
+
+    EventCallback event_cb_;
+};
+
+#endif // AUDIO_EVENT_CLASSIFIER_H
@@ -0,0 +1,168 @@
+#include "audio_history.h"
+
+#include <algorithm>
+#include <cstring>
+
+AudioHistory::AudioHistory(int sample_rate, uint32_t seconds, DspMemory where) : sample_rate_(sample_rate) {
+    // 额外留出写入端的保护区，保证 capacity() 不小于请求的时长
+    size_t samples = (size_t)sample_rate * seconds + kWriteChunk;
+    if (sample_rate <= 0 || seconds == 0 || samples > 0x40000000u) {
+        return;
+    }
+    if (!ring_.Allocate(samples, where)) {
+        return;
+    }
+    capacity_ = samples;
+    modulus_ = (uint32_t)((0xFFFFFFFFull / capacity_) * capacity_);
+}
+
+uint32_t AudioHistory::Advance(uint32_t pos, size_t n) const {
+    uint64_t p = (uint64_t)pos + n % modulus_;
+    return (uint32_t)(p >= modulus_ ? p - modulus_ : p);
+}
+
+uint32_t AudioHistory::Rewind(uint32_t pos, size_t n) const {
+    n %= modulus_;
+    return pos >= n ? pos - (uint32_t)n : (uint32_t)(pos + (modulus_ - n));
+}
+
+size_t AudioHistory::Distance(uint32_t from, uint32_t to) const {
+    return to >= from ? to - from : (size_t)(modulus_ - from) + to;
+}
+
+void AudioHistory::Write(const int16_t* samples, size_t count, size_t stride) {
+    if (!valid()) return;
+    AudioPerfScope scope(write_perf_);
+
+    uint32_t pos = write_pos_.load(std::memory_order_relaxed);
+    size_t filled = filled_.load(std::memory_order_relaxed);
+    while (count > 0) {
+        // 每段都不跨过环形缓冲末尾，也不超过读取端预留的保护区
+        size_t offset = pos % capacity_;
+        size_t n = std::min(std::min(count, kWriteChunk), capacity_ - offset);
+        int16_t* dst = ring_.data() + offset;
+        if (stride == 1) {
+            memcpy(dst, samples, n * sizeof(int16_t));
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                dst[i] = samples[i * stride];
+            }
+        }
+        samples += n * stride;
+        count -= n;
+        bytes_written_ += n * sizeof(int16_t);
+        pos = Advance(pos, n);
+        write_pos_.store(pos, std::memory_order_release);
+        if (filled < capacity_) {
+            filled = std::min(capacity_, filled + n);
+            filled_.store((uint32_t)filled, std::memory_order_release);
+        }
+    }
+}
+
+bool AudioHistory::InRange(uint32_t start, size_t count, uint32_t write_pos) const {
+    size_t age = Distance(start, write_pos);
+    return age <= capacity() && count <= age;
+}
+
+void AudioHistory::CopyOut(uint32_t start, int16_t* out, size_t count) const {
+    size_t offset = start % capacity_;
+    size_t first = std::min(count, capacity_ - offset);
+    memcpy(out, ring_.data() + offset, first * sizeof(int16_t));
+    if (first < count) {
+        memcpy(out + first, ring_.data(), (count - first) * sizeof(int16_t));
+    }
+}
+
+size_t AudioHistory::Read(uint32_t start, int16_t* out, size_t count) {
+    if (!valid() || count == 0) return 0;
+    uint32_t w = write_position();
+    size_t age = Distance(start, w);
+    if (age > capacity()) return 0;
+    count = std::min(count, age);
+
+    uint32_t t0 = audio_perf_cycles();
+    CopyOut(start, out, count);
+    copy_cycles_ += audio_perf_cycles() - t0;
+
+    // 拷贝期间写入端可能追上了这段数据的开头，重新检查
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!InRange(start, count, write_position())) {
+        return 0;
+    }
+    bytes_read_ += count * sizeof(int16_t);
+    return count;
+}
+
+bool AudioHistory::Snapshot(uint32_t start, size_t count, AudioClipFormat format, AudioClip& clip) {
+    if (!valid() || count == 0) return false;
+    AudioPerfScope scope(snapshot_perf_);
+
+    // 裁掉已经过旧的部分，并额外让出 100ms，给编码期间继续写入的数据留余量；
+    // 还没写满一圈时上限是实际写过的样本数 (先读 filled_ 再读写位置，见 filled_ 的说明)
+    size_t written = filled();
+    uint32_t w = write_position();
+    size_t age = Distance(start, w);
+    size_t limit = capacity() - std::min(capacity(), (size_t)sample_rate_ / 10);
+    limit = std::min(limit, written);
+    if (age > limit) {
+        size_t skip = age - limit;
+        if (skip >= count) return false;
+        start = Advance(start, skip);
+        count -= skip;
+        age = limit;
+    }
+    count = std::min(count, age);
+    if (count == 0) return false;
+
+    clip.format = format;
+    clip.sample_rate = sample_rate_;
+    clip.start = start;
+    clip.samples = (uint32_t)count;
+    clip.data.clear();
+
+    if (format == AudioClipFormat::PCM16) {
+        clip.block_align = 0;
+        clip.data.resize(count * sizeof(int16_t));
+        int16_t* out = reinterpret_cast<int16_t*>(clip.data.data());
+        if (Read(start, out, count) != count) {
+            clip.data.clear();
+            return false;
+        }
+        return true;
+    }
+
+    // ADPCM：逐块拷到内部缓冲再编码，不需要整段的 PCM 中间副本
+    const size_t block_align = IMA_ADPCM_BLOCK_ALIGN;
+    const size_t spb = IMA_ADPCM_SAMPLES_PER_BLOCK(block_align);
+    const size_t blocks = (count + spb - 1) / spb;
+    clip.block_align = block_align;
+    clip.data.resize(blocks * block_align);
+
+    std::vector<int16_t> pcm(spb);
+    ImaAdpcmState state;
+    size_t done = 0;
+    for (size_t b = 0; b < blocks; b++) {
+        size_t n = std::min(spb, count - done);
+        if (Read(Advance(start, done), pcm.data(), n) != n) {
+            clip.data.clear();
+            return false;
+        }
+        ima_adpcm_encode_block(state, pcm.data(), n, 1, clip.data.data() + b * block_align, block_align);
+        done += n;
+    }
+    return true;
+}
+
+bool AudioHistory::SnapshotLast(uint32_t duration_ms, AudioClipFormat format, AudioClip& clip) {
+    if (!valid()) return false;
+    size_t count = (size_t)((uint64_t)duration_ms * sample_rate_ / 1000);
+    count = std::min(count, std::min(capacity(), filled()));
+    return Snapshot(Rewind(write_position(), count), count, format, clip);
+}
+
+float AudioHistory::read_bandwidth_mbps() const {
+    if (copy_cycles_ == 0) return 0.0f;
+    double seconds = (double)copy_cycles_ / AUDIO_PERF_CPU_HZ;
+    return (float)(bytes_read_ / seconds / 1e6);
+}
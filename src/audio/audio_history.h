@@ -0,0 +1,121 @@
+#ifndef AUDIO_HISTORY_H
+#define AUDIO_HISTORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "dsp_engine.h"
+#include "audio_perf.h"
+#include "adpcm.h"
+
+enum class AudioClipFormat {
+    PCM16,
+    IMA_ADPCM,  // adpcm.h 中的 WAV 兼容块格式
+};
+
+// 从历史缓冲中截取的一段音频 (单声道)
+struct AudioClip {
+    AudioClipFormat format = AudioClipFormat::PCM16;
+    int sample_rate = 0;
+    uint32_t start = 0;         // 第一个样本在历史流中的位置 (与 write_position() 同一计数)
+    uint32_t samples = 0;       // 有效样本数 (ADPCM 最后一块的补齐部分不计)
+    uint16_t block_align = 0;   // 仅 ADPCM
+    std::vector<uint8_t> data;
+};
+
+/**
+ * @brief 采集音频的预录 (pre-roll) 环形缓冲
+ *
+ * 采集任务每帧调用 Write() 写入单声道样本 (交织数据用 stride 直接取一个声道，
+ * 不需要先解交织)。告警发生时，其他任务调用 Snapshot() 把最近一段时间
+ * 编码成 AudioClip，整个过程不加锁、不暂停采集：
+ *   - 写入端每写完一段 (不超过 kWriteChunk 个样本) 才发布新的写位置；
+ *   - 读取端拷贝完一段后再次检查写位置，若这段数据在拷贝期间可能已被覆盖则放弃。
+ * 位置计数是 32 位，按 position_modulus() (不超过 2^32 的 capacity 整数倍) 取模，
+ * 所以位置到环形缓冲下标始终是 pos % capacity，回绕时也不会错位。
+ *
+ * 只支持一个写入任务和一个 Snapshot 任务。
+ */
+class AudioHistory {
+public:
+    // 写入端单次发布的最大样本数，也是读取端必须避开的保护区
+    static constexpr size_t kWriteChunk = 1024;
+
+    AudioHistory(int sample_rate, uint32_t seconds, DspMemory where = DspMemory::PSRAM);
+
+    bool valid() const { return capacity_ != 0; }
+    int sample_rate() const { return sample_rate_; }
+    // 可安全读取的最大历史长度 (样本)
+    size_t capacity() const { return capacity_ > kWriteChunk ? capacity_ - kWriteChunk : 0; }
+
+    /**
+     * @brief 写入样本 (采集任务)
+     * @param stride 相邻样本间隔，交织立体声取左声道时传 2
+     */
+    void Write(const int16_t* samples, size_t count, size_t stride = 1);
+
+    // 已写入的样本总数 (模 position_modulus())
+    uint32_t write_position() const { return write_pos_.load(std::memory_order_acquire); }
+    // 缓冲中实际写过的样本数，写满一圈之前小于 capacity()
+    size_t filled() const { return filled_.load(std::memory_order_acquire); }
+    uint32_t position_modulus() const { return modulus_; }
+    // 位置运算 (模 position_modulus())
+    uint32_t Advance(uint32_t pos, size_t n) const;
+    uint32_t Rewind(uint32_t pos, size_t n) const;
+    // from 到 to 之间的样本数，to 不早于 from
+    size_t Distance(uint32_t from, uint32_t to) const;
+
+    /**
+     * @brief 拷贝原始样本
+     * @return 实际拷贝的样本数；start 已被覆盖或尚未写入时返回 0
+     */
+    size_t Read(uint32_t start, int16_t* out, size_t count);
+
+    /**
+     * @brief 截取 [start, start + count) 并编码成片段
+     *
+     * 太旧的部分会被裁掉 (从仍然有效的最早位置开始)，尚未写入的部分不会等待；
+     * 缓冲还没写满一圈时，早于第一个写入样本的部分同样裁掉。
+     * @return 至少截取到一个样本时返回 true
+     */
+    bool Snapshot(uint32_t start, size_t count, AudioClipFormat format, AudioClip& clip);
+
+    /**
+     * @brief 截取最近 duration_ms 毫秒，开机后写入的还不够时只截取已写入的部分
+     */
+    bool SnapshotLast(uint32_t duration_ms, AudioClipFormat format, AudioClip& clip);
+
+    // 环形缓冲占用的内存 (字节)
+    size_t MemoryBytes() const { return capacity_ * sizeof(int16_t); }
+
+    // 写入端：每次 Write() 的周期数和累计字节数
+    const AudioPerfCounter& write_perf() const { return write_perf_; }
+    uint64_t bytes_written() const { return bytes_written_; }
+    // 读取端：每次 Snapshot() 的周期数 (含编码) 和从环形缓冲拷出的字节数
+    const AudioPerfCounter& snapshot_perf() const { return snapshot_perf_; }
+    uint64_t bytes_read() const { return bytes_read_; }
+    // 读取端纯拷贝带宽 (MB/s)，只统计 PSRAM -> 内部缓冲的 memcpy
+    float read_bandwidth_mbps() const;
+
+private:
+    // 检查 [start, start + count) 是否仍在安全范围内
+    bool InRange(uint32_t start, size_t count, uint32_t write_pos) const;
+    // 拷贝一段，不做检查
+    void CopyOut(uint32_t start, int16_t* out, size_t count) const;
+
+    int sample_rate_;
+    size_t capacity_ = 0;
+    uint32_t modulus_ = 0;
+    DspBuffer<int16_t> ring_;
+    std::atomic<uint32_t> write_pos_{0};
+    std::atomic<uint32_t> filled_{0};   // 在 write_pos_ 之后发布，读到的值不会超过对应写位置之前的有效样本数
+
+    AudioPerfCounter write_perf_;
+    uint64_t bytes_written_ = 0;
+    AudioPerfCounter snapshot_perf_;
+    uint64_t bytes_read_ = 0;
+    uint64_t copy_cycles_ = 0;
+};
+
+#endif // AUDIO_HISTORY_H
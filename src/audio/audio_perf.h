@@ -0,0 +1,71 @@
+#ifndef AUDIO_PERF_H
+#define AUDIO_PERF_H
+
+#include <cstdint>
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#else
+#include <chrono>
+#endif
+
+// 音频处理阶段的 CPU 开销统计 (以 CPU 周期为单位)
+// 在设备上直接读取 CCOUNT 寄存器；在主机上用 steady_clock 近似 (按 240MHz 换算)，
+// 这样 DSP 代码可以在 PC 上编译做基准对比。
+
+#define AUDIO_PERF_CPU_HZ 240000000u
+
+static inline uint32_t audio_perf_cycles() {
+#ifdef ESP_PLATFORM
+    return esp_cpu_get_cycle_count();
+#else
+    using namespace std::chrono;
+    uint64_t ns = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    return (uint32_t)(ns * (AUDIO_PERF_CPU_HZ / 1000000u) / 1000u);
+#endif
+}
+
+struct AudioPerfCounter {
+    uint32_t last = 0;
+    uint32_t max = 0;
+    uint64_t total = 0;
+    uint32_t count = 0;
+
+    void Add(uint32_t cycles) {
+        last = cycles;
+        if (cycles > max) max = cycles;
+        total += cycles;
+        count++;
+    }
+
+    uint32_t Average() const {
+        return count ? (uint32_t)(total / count) : 0;
+    }
+
+    void Reset() {
+        last = max = count = 0;
+        total = 0;
+    }
+
+    /**
+     * @brief 换算成 CPU 占用率 (百分比)
+     * @param period_us 每次调用对应的实时时长，例如一帧 5ms 传 5000
+     */
+    float LoadPercent(uint32_t period_us) const {
+        if (period_us == 0) return 0.0f;
+        return 100.0f * Average() / ((float)AUDIO_PERF_CPU_HZ / 1000000.0f * period_us);
+    }
+};
+
+// 在作用域内统计耗时：AudioPerfScope scope(counter);
+class AudioPerfScope {
+public:
+    explicit AudioPerfScope(AudioPerfCounter& counter) : counter_(counter), start_(audio_perf_cycles()) {}
+    ~AudioPerfScope() { counter_.Add(audio_perf_cycles() - start_); }
+
+private:
+    AudioPerfCounter& counter_;
+    uint32_t start_;
+};
+
+#endif // AUDIO_PERF_H
@@ -0,0 +1,177 @@
+#ifndef AUDIO_PIPELINE_H
+#define AUDIO_PIPELINE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include "audio_perf.h"
+
+// 类型化的音频处理流水线。
+//
+// 每个阶段是一个普通类型，声明自己的种类和通道数，流水线在编译期把它们连成图：
+//   - Map   无状态的逐样本运算 (增益、偏置等)，提供 int32_t Sample(int32_t) const。
+//           相邻的 Map 阶段在编译期融合成一次遍历，中间结果保持 int32，最后统一饱和，
+//           N 个 Map 阶段只读写一次内存。
+//   - Block 有状态的整块处理 (AGC、降噪、下混、SRC 等)，原地处理并返回输出帧数：
+//           size_t Process(int16_t* data, size_t frames, int channels, uint8_t* scratch)
+//   - Tap   只读分支 (特征提取、预录、录音等)：
+//           void Consume(const int16_t* data, size_t frames, int channels)
+// 每个阶段还提供 const char* name() const，用于统计输出。
+// 阶段声明 kInChannels / kOutChannels (0 表示沿用上一级)，不匹配时编译报错。
+// 需要临时缓冲的阶段声明 kScratchBytes，各阶段依次执行，所以共用流水线内部的一块
+// arena，大小取所有阶段的最大值，构造时一次性确定，运行中不再分配。
+// 每个阶段 (融合组按组) 都有独立的周期统计。
+
+enum class StageKind {
+    Map,
+    Block,
+    Tap,
+};
+
+// 阶段的默认属性，具体阶段继承后按需覆盖
+struct PipelineStage {
+    static constexpr int kInChannels = 0;
+    static constexpr int kOutChannels = 0;
+    static constexpr size_t kScratchBytes = 0;
+};
+
+template <size_t kMaxFrames, int kChannels, typename... Stages>
+class AudioPipeline {
+public:
+    static constexpr size_t kStageCount = sizeof...(Stages);
+    static_assert(kStageCount > 0, "AudioPipeline needs at least one stage");
+
+private:
+    static constexpr StageKind kKinds[kStageCount] = {Stages::kKind...};
+
+    // 第 i 个阶段的输入通道数 (kChannelsAt[kStageCount] 为输出通道数)
+    static constexpr std::array<int, kStageCount + 1> ComputeChannels() {
+        std::array<int, kStageCount + 1> c{};
+        const int out[] = {Stages::kOutChannels...};
+        c[0] = kChannels;
+        for (size_t i = 0; i < kStageCount; i++) {
+            c[i + 1] = out[i] ? out[i] : c[i];
+        }
+        return c;
+    }
+    static constexpr std::array<int, kStageCount + 1> kChannelsAt = ComputeChannels();
+
+    static constexpr bool ChannelsMatch() {
+        const int in[] = {Stages::kInChannels...};
+        for (size_t i = 0; i < kStageCount; i++) {
+            if (in[i] != 0 && in[i] != kChannelsAt[i]) return false;
+        }
+        return true;
+    }
+    static_assert(ChannelsMatch(), "AudioPipeline: stage channel counts do not match");
+
+    static constexpr size_t MaxScratch() {
+        const size_t s[] = {Stages::kScratchBytes...};
+        size_t m = 0;
+        for (size_t v : s) m = v > m ? v : m;
+        return m;
+    }
+
+    // 从 i 开始的连续 Map 阶段的结束位置
+    static constexpr size_t GroupEnd(size_t i) {
+        while (i < kStageCount && kKinds[i] == StageKind::Map) i++;
+        return i;
+    }
+
+    static constexpr size_t CountPasses() {
+        size_t passes = 0;
+        for (size_t i = 0; i < kStageCount; i = kKinds[i] == StageKind::Map ? GroupEnd(i) : i + 1) {
+            passes++;
+        }
+        return passes;
+    }
+
+public:
+    static constexpr int kOutChannels = kChannelsAt[kStageCount];
+    static constexpr size_t kArenaBytes = MaxScratch();
+    // 融合后实际遍历数据的次数
+    static constexpr size_t kPassCount = CountPasses();
+
+    explicit AudioPipeline(Stages... stages) : stages_(std::move(stages)...) {
+        CollectNames(std::make_index_sequence<kStageCount>{});
+    }
+
+    /**
+     * @brief 原地处理一块交织数据
+     * @param data   容量至少 kMaxFrames * max(各级通道数) 个样本
+     * @param frames 输入帧数，不超过 kMaxFrames
+     * @return 输出帧数 (kOutChannels 通道)，输入过长时返回 0
+     */
+    size_t Process(int16_t* data, size_t frames) {
+        if (frames > kMaxFrames) return 0;
+        return Run<0>(data, frames);
+    }
+
+    template <size_t I>
+    auto& stage() { return std::get<I>(stages_); }
+
+    const char* name(size_t i) const { return i < kStageCount ? names_[i] : ""; }
+    // 融合组的周期记在组内第一个阶段上，其余阶段的 fused() 为 true、计数为 0
+    bool fused(size_t i) const { return i > 0 && i < kStageCount && kKinds[i] == StageKind::Map && kKinds[i - 1] == StageKind::Map; }
+    const AudioPerfCounter& perf(size_t i) const { return perf_[i < kStageCount ? i : 0]; }
+    void ResetPerf() {
+        for (auto& p : perf_) p.Reset();
+    }
+
+private:
+    template <size_t I>
+    size_t Run(int16_t* data, size_t frames) {
+        if constexpr (I == kStageCount) {
+            return frames;
+        } else if constexpr (kKinds[I] == StageKind::Map) {
+            constexpr size_t J = GroupEnd(I);
+            uint32_t t0 = audio_perf_cycles();
+            RunFused<I>(data, frames * kChannelsAt[I], std::make_index_sequence<J - I>{});
+            perf_[I].Add(audio_perf_cycles() - t0);
+            return Run<J>(data, frames);
+        } else if constexpr (kKinds[I] == StageKind::Tap) {
+            uint32_t t0 = audio_perf_cycles();
+            std::get<I>(stages_).Consume(data, frames, kChannelsAt[I]);
+            perf_[I].Add(audio_perf_cycles() - t0);
+            return Run<I + 1>(data, frames);
+        } else {
+            uint32_t t0 = audio_perf_cycles();
+            frames = std::get<I>(stages_).Process(data, frames, kChannelsAt[I], arena_);
+            perf_[I].Add(audio_perf_cycles() - t0);
+            return Run<I + 1>(data, frames);
+        }
+    }
+
+    template <size_t... I>
+    void CollectNames(std::index_sequence<I...>) {
+        ((names_[I] = std::get<I>(stages_).name()), ...);
+    }
+
+    template <size_t I, size_t... K>
+    void RunFused(int16_t* data, size_t count, std::index_sequence<K...>) {
+        auto stages = std::tie(std::get<I + K>(stages_)...);
+        for (size_t n = 0; n < count; n++) {
+            int32_t v = data[n];
+            ((v = std::get<K>(stages).Sample(v)), ...);
+            data[n] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+        }
+    }
+
+    std::tuple<Stages...> stages_;
+    const char* names_[kStageCount];
+    AudioPerfCounter perf_[kStageCount];
+    alignas(16) uint8_t arena_[kArenaBytes > 0 ? kArenaBytes : 1];
+};
+
+/**
+ * @brief 推导阶段类型，便于使用 lambda 等匿名类型的阶段
+ *   auto p = make_audio_pipeline<120, 2>(make_tap_stage("vad", f), GainStage(0.5f));
+ */
+template <size_t kMaxFrames, int kChannels, typename... Stages>
+AudioPipeline<kMaxFrames, kChannels, Stages...> make_audio_pipeline(Stages... stages) {
+    return AudioPipeline<kMaxFrames, kChannels, Stages...>(std::move(stages)...);
+}
+
+#endif // AUDIO_PIPELINE_H
@@ -0,0 +1,414 @@
+#include "audio_recorder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <dirent.h>
+#include "esp_log.h"
+#include "esp_spiffs.h"
+#include "esp_timer.h"
+
+static const char* TAG = "AudioRecorder";
+
+// ======== storage 分区 ========
+
+bool audio_storage_mount(void) {
+    if (esp_spiffs_mounted(AUDIO_STORAGE_PARTITION)) {
+        return true;
+    }
+    esp_vfs_spiffs_conf_t conf = {};
+    conf.base_path = AUDIO_STORAGE_BASE_PATH;
+    conf.partition_label = AUDIO_STORAGE_PARTITION;
+    conf.max_files = 4;
+    conf.format_if_mount_failed = true;
+    esp_err_t ret = esp_vfs_spiffs_register(&conf);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount %s: %s", AUDIO_STORAGE_PARTITION, esp_err_to_name(ret));
+        return false;
+    }
+    size_t total = 0, used = 0;
+    esp_spiffs_info(AUDIO_STORAGE_PARTITION, &total, &used);
+    ESP_LOGI(TAG, "Storage mounted at %s: %u / %u KB used", AUDIO_STORAGE_BASE_PATH,
+             (unsigned)(used / 1024), (unsigned)(total / 1024));
+    return true;
+}
+
+// ======== WAV 头 ========
+
+static void put_le16(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t* p, uint32_t v) {
+    put_le16(p, v);
+    put_le16(p + 2, v >> 16);
+}
+
+// PCM 头 44 字节；IMA ADPCM 头 60 字节 (fmt 扩展 + fact 块)
+static const size_t kWavHeaderMax = 60;
+
+static size_t build_wav_header(uint8_t* out, AudioClipFormat format, int sample_rate, size_t block_align,
+                               uint32_t samples, uint32_t data_bytes) {
+    const bool adpcm = format == AudioClipFormat::IMA_ADPCM;
+    const size_t header = adpcm ? 60 : 44;
+    memcpy(out, "RIFF", 4);
+    put_le32(out + 4, (uint32_t)(header - 8 + data_bytes));
+    memcpy(out + 8, "WAVE", 4);
+    memcpy(out + 12, "fmt ", 4);
+    uint8_t* fmt = out + 20;
+    if (adpcm) {
+        const uint32_t spb = (uint32_t)IMA_ADPCM_SAMPLES_PER_BLOCK(block_align);
+        put_le32(out + 16, 20);
+        put_le16(fmt, 0x0011);
+        put_le16(fmt + 2, 1);
+        put_le32(fmt + 4, sample_rate);
+        put_le32(fmt + 8, (uint32_t)((uint64_t)sample_rate * block_align / spb));
+        put_le16(fmt + 12, (uint32_t)block_align);
+        put_le16(fmt + 14, 4);
+        put_le16(fmt + 16, 2);
+        put_le16(fmt + 18, spb);
+        memcpy(out + 40, "fact", 4);
+        put_le32(out + 44, 4);
+        put_le32(out + 48, samples);
+        memcpy(out + 52, "data", 4);
+        put_le32(out + 56, data_bytes);
+    } else {
+        put_le32(out + 16, 16);
+        put_le16(fmt, 0x0001);
+        put_le16(fmt + 2, 1);
+        put_le32(fmt + 4, sample_rate);
+        put_le32(fmt + 8, sample_rate * 2);
+        put_le16(fmt + 12, 2);
+        put_le16(fmt + 14, 16);
+        memcpy(out + 36, "data", 4);
+        put_le32(out + 40, data_bytes);
+    }
+    return header;
+}
+
+bool audio_clip_save_wav(const AudioClip& clip, const char* path) {
+    if (clip.data.empty() || !audio_storage_mount()) return false;
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return false;
+    }
+    uint8_t header[kWavHeaderMax];
+    size_t n = build_wav_header(header, clip.format, clip.sample_rate, clip.block_align, clip.samples,
+                                (uint32_t)clip.data.size());
+    bool ok = fwrite(header, 1, n, f) == n &&
+              fwrite(clip.data.data(), 1, clip.data.size(), f) == clip.data.size();
+    fclose(f);
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to write %s", path);
+        remove(path);
+    }
+    return ok;
+}
+
+// ======== AudioRecorder ========
+
+AudioRecorder::AudioRecorder(const RecorderConfig& config) : config_(config) {
+    // 缓冲按扇区取整，保证每次都是整扇区写入
+    config_.buffer_bytes = std::max<size_t>(4096, config_.buffer_bytes / 4096 * 4096);
+    if (config_.format == AudioClipFormat::IMA_ADPCM) {
+        block_align_ = IMA_ADPCM_BLOCK_ALIGN;
+        block_samples_ = IMA_ADPCM_SAMPLES_PER_BLOCK(block_align_);
+        staging_.Allocate(block_samples_, DspMemory::INTERNAL);
+    }
+    for (int i = 0; i < 2; i++) {
+        buffers_[i].Allocate(config_.buffer_bytes, DspMemory::INTERNAL);
+        busy_[i].store(false);
+    }
+}
+
+AudioRecorder::~AudioRecorder() {
+    Stop();
+    if (task_) {
+        // 等写入任务把队列中的缓冲写完再退出
+        for (int i = 0; i < 100 && (uxQueueMessagesWaiting(queue_) || busy_[0] || busy_[1]); i++) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        vTaskDelete(task_);
+        CloseFile();
+    }
+    if (queue_) vQueueDelete(queue_);
+}
+
+bool AudioRecorder::Start() {
+    if (recording_) return true;
+    if (!buffers_[0].data() || !buffers_[1].data() || (block_align_ && !staging_.data())) {
+        ESP_LOGE(TAG, "Buffer allocation failed");
+        return false;
+    }
+    if (!audio_storage_mount()) return false;
+
+    if (!queue_) {
+        // 最多两个写缓冲 + 一个关闭命令
+        queue_ = xQueueCreate(4, sizeof(WriterCmd));
+        if (!queue_) return false;
+    }
+    if (!task_) {
+        // 找到已有文件的编号范围，重启后继续编号并按序删除旧文件
+        DIR* dir = opendir(AUDIO_STORAGE_BASE_PATH);
+        if (dir) {
+            bool found = false;
+            uint32_t lo = 0, hi = 0;
+            char fmt[32];
+            snprintf(fmt, sizeof(fmt), "%s_%%u.wav", config_.prefix);
+            while (struct dirent* e = readdir(dir)) {
+                unsigned idx;
+                if (sscanf(e->d_name, fmt, &idx) == 1) {
+                    lo = found ? std::min<uint32_t>(lo, idx) : idx;
+                    hi = found ? std::max<uint32_t>(hi, idx) : idx;
+                    found = true;
+                }
+            }
+            closedir(dir);
+            if (found) {
+                oldest_index_ = lo;
+                file_index_ = hi + 1;
+            }
+        }
+        if (xTaskCreate(WriterTaskEntry, "rec_writer", config_.task_stack, this, config_.task_priority, &task_) != pdPASS) {
+            task_ = nullptr;
+            return false;
+        }
+    }
+
+    active_ = 0;
+    fill_ = 0;
+    fill_samples_ = 0;
+    staging_fill_ = 0;
+    adpcm_state_ = ImaAdpcmState();
+    recording_ = true;
+    ESP_LOGI(TAG, "Recording started (%s, %u KB x 2 buffers)",
+             block_align_ ? "IMA ADPCM" : "PCM16", (unsigned)(config_.buffer_bytes / 1024));
+    return true;
+}
+
+void AudioRecorder::Stop() {
+    if (!recording_) return;
+    recording_ = false;
+
+    // 不足一块的 ADPCM 尾巴按最后一个样本补齐
+    if (block_align_ && staging_fill_ > 0) {
+        uint8_t* dst = Reserve(block_align_);
+        if (dst) {
+            ima_adpcm_encode_block(adpcm_state_, staging_.data(), staging_fill_, 1, dst, block_align_);
+            fill_ += block_align_;
+            fill_samples_ += staging_fill_;
+        } else {
+            CountDropped(staging_fill_);
+        }
+        staging_fill_ = 0;
+    }
+    HandOff(kCmdClose);
+}
+
+uint8_t* AudioRecorder::Reserve(size_t bytes) {
+    if (busy_[active_].load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    if (fill_ + bytes > config_.buffer_bytes) {
+        HandOff(kCmdWrite);
+        if (busy_[active_].load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+    }
+    return buffers_[active_].data() + fill_;
+}
+
+void AudioRecorder::Commit(size_t bytes, uint32_t samples) {
+    fill_ += bytes;
+    fill_samples_ += samples;
+    // 写满立即交出，让写入任务尽早开始
+    if (fill_ == config_.buffer_bytes) {
+        HandOff(kCmdWrite);
+    }
+}
+
+void AudioRecorder::HandOff(uint8_t flags) {
+    WriterCmd cmd = {};
+    cmd.buffer = -1;
+    cmd.flags = flags;
+    if (fill_ > 0) {
+        cmd.buffer = (int8_t)active_;
+        cmd.bytes = (uint32_t)fill_;
+        cmd.samples = fill_samples_;
+        busy_[active_].store(true, std::memory_order_release);
+    } else if (!(flags & kCmdClose)) {
+        return;
+    }
+    if (xQueueSend(queue_, &cmd, 0) != pdTRUE) {
+        // 队列长度覆盖了所有缓冲，正常不会走到这里
+        if (cmd.buffer >= 0) {
+            busy_[active_].store(false, std::memory_order_release);
+            CountDropped(fill_samples_);
+        }
+    } else if (cmd.buffer >= 0) {
+        active_ ^= 1;
+    }
+    fill_ = 0;
+    fill_samples_ = 0;
+}
+
+void AudioRecorder::CountDropped(size_t samples) {
+    taskENTER_CRITICAL(&stats_lock_);
+    stats_.dropped_pushes++;
+    stats_.dropped_samples += samples;
+    taskEXIT_CRITICAL(&stats_lock_);
+}
+
+void AudioRecorder::Push(const int16_t* samples, size_t count, size_t stride) {
+    if (!recording_) return;
+
+    if (!block_align_) {
+        // PCM：按 stride 直接拷进写缓冲
+        while (count > 0) {
+            // Commit() 在写满时已经交出缓冲，这里 room 总大于 0
+            size_t n = std::min(count, (config_.buffer_bytes - fill_) / sizeof(int16_t));
+            uint8_t* dst = Reserve(n * sizeof(int16_t));
+            if (!dst) {
+                CountDropped(count);
+                return;
+            }
+            int16_t* out = reinterpret_cast<int16_t*>(dst);
+            for (size_t i = 0; i < n; i++) {
+                out[i] = samples[i * stride];
+            }
+            samples += n * stride;
+            count -= n;
+            Commit(n * sizeof(int16_t), (uint32_t)n);
+        }
+        return;
+    }
+
+    // ADPCM：凑满一块后直接编码到写缓冲，不经过额外的拷贝
+    while (count > 0) {
+        size_t n = std::min(count, block_samples_ - staging_fill_);
+        int16_t* st = staging_.data() + staging_fill_;
+        for (size_t i = 0; i < n; i++) {
+            st[i] = samples[i * stride];
+        }
+        samples += n * stride;
+        count -= n;
+        staging_fill_ += n;
+        if (staging_fill_ < block_samples_) break;
+
+        uint8_t* dst = Reserve(block_align_);
+        if (dst) {
+            ima_adpcm_encode_block(adpcm_state_, staging_.data(), block_samples_, 1, dst, block_align_);
+            Commit(block_align_, (uint32_t)block_samples_);
+        } else {
+            CountDropped(block_samples_);
+        }
+        staging_fill_ = 0;
+    }
+}
+
+RecorderStats AudioRecorder::stats() const {
+    taskENTER_CRITICAL(&stats_lock_);
+    RecorderStats copy = stats_;
+    taskEXIT_CRITICAL(&stats_lock_);
+    return copy;
+}
+
+// ======== 写入任务 ========
+
+void AudioRecorder::WriterTaskEntry(void* arg) {
+    static_cast<AudioRecorder*>(arg)->WriterTask();
+}
+
+void AudioRecorder::WriterTask() {
+    WriterCmd cmd;
+    while (1) {
+        if (xQueueReceive(queue_, &cmd, portMAX_DELAY) != pdTRUE) continue;
+        if (cmd.buffer >= 0) {
+            WriteBuffer(buffers_[cmd.buffer].data(), cmd.bytes, cmd.samples);
+            busy_[cmd.buffer].store(false, std::memory_order_release);
+        }
+        if (cmd.flags & kCmdClose) {
+            CloseFile();
+        }
+    }
+}
+
+bool AudioRecorder::OpenNextFile() {
+    char path[64];
+    // 超出保留数量或剩余空间不足一个文件时，从最旧的开始删
+    size_t total = 0, used = 0;
+    esp_spiffs_info(AUDIO_STORAGE_PARTITION, &total, &used);
+    while (oldest_index_ < file_index_ &&
+           (file_index_ - oldest_index_ >= config_.max_files || total - used < config_.max_file_bytes + kWavHeaderMax)) {
+        snprintf(path, sizeof(path), "%s/%s_%05u.wav", AUDIO_STORAGE_BASE_PATH, config_.prefix, (unsigned)oldest_index_);
+        if (remove(path) == 0) {
+            ESP_LOGI(TAG, "Removed %s", path);
+        }
+        oldest_index_++;
+        esp_spiffs_info(AUDIO_STORAGE_PARTITION, &total, &used);
+    }
+
+    snprintf(path, sizeof(path), "%s/%s_%05u.wav", AUDIO_STORAGE_BASE_PATH, config_.prefix, (unsigned)file_index_);
+    file_ = fopen(path, "wb");
+    if (!file_) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return false;
+    }
+    // 写缓冲本身已经是整扇区的大块，关闭 stdio 缓冲避免再拷贝一次
+    setvbuf(file_, NULL, _IONBF, 0);
+    file_index_++;
+    file_bytes_ = 0;
+    file_samples_ = 0;
+
+    // 先写占位的头，关闭时回填长度
+    uint8_t header[kWavHeaderMax];
+    size_t n = build_wav_header(header, config_.format, config_.sample_rate, block_align_, 0, 0);
+    fwrite(header, 1, n, file_);
+    ESP_LOGI(TAG, "Recording to %s", path);
+    return true;
+}
+
+void AudioRecorder::CloseFile() {
+    if (!file_) return;
+    uint8_t header[kWavHeaderMax];
+    size_t n = build_wav_header(header, config_.format, config_.sample_rate, block_align_,
+                                file_samples_, (uint32_t)file_bytes_);
+    fseek(file_, 0, SEEK_SET);
+    fwrite(header, 1, n, file_);
+    fclose(file_);
+    file_ = nullptr;
+
+    taskENTER_CRITICAL(&stats_lock_);
+    stats_.files++;
+    taskEXIT_CRITICAL(&stats_lock_);
+}
+
+void AudioRecorder::WriteBuffer(const uint8_t* data, size_t bytes, uint32_t samples) {
+    // 缓冲边界上轮转，ADPCM 缓冲总是整块，所以每个文件都能单独解码
+    const uint32_t max_samples = config_.max_file_seconds * (uint32_t)config_.sample_rate;
+    if (file_ && (file_bytes_ + bytes > config_.max_file_bytes || file_samples_ >= max_samples)) {
+        CloseFile();
+    }
+    if (!file_ && !OpenNextFile()) {
+        taskENTER_CRITICAL(&stats_lock_);
+        stats_.write_errors++;
+        stats_.dropped_samples += samples;
+        taskEXIT_CRITICAL(&stats_lock_);
+        return;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    size_t written = fwrite(data, 1, bytes, file_);
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - t0);
+    file_bytes_ += written;
+    file_samples_ += samples;
+
+    taskENTER_CRITICAL(&stats_lock_);
+    stats_.bytes_written += written;
+    stats_.write_us += elapsed;
+    stats_.max_stall_us = std::max(stats_.max_stall_us, elapsed);
+    stats_.buffers_written++;
+    if (written != bytes) stats_.write_errors++;
+    taskEXIT_CRITICAL(&stats_lock_);
+}
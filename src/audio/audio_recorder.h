@@ -0,0 +1,145 @@
+#ifndef AUDIO_RECORDER_H
+#define AUDIO_RECORDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "dsp_engine.h"
+#include "adpcm.h"
+#include "audio_history.h"
+
+// storage 分区 (SPIFFS) 的挂载点
+#define AUDIO_STORAGE_BASE_PATH "/storage"
+#define AUDIO_STORAGE_PARTITION "storage"
+
+/**
+ * @brief 挂载 storage 分区，重复调用无副作用
+ */
+bool audio_storage_mount(void);
+
+/**
+ * @brief 把 AudioHistory 截取的片段保存成 .wav (PCM 或 IMA ADPCM)
+ */
+bool audio_clip_save_wav(const AudioClip& clip, const char* path);
+
+struct RecorderConfig {
+    int sample_rate = 24000;
+    AudioClipFormat format = AudioClipFormat::IMA_ADPCM;
+    // 单个缓冲的大小，必须是 4096 (flash 扇区) 的整数倍；共两个，放内部 SRAM
+    size_t buffer_bytes = 16 * 1024;
+    // 文件轮转：任一条件满足即开始新文件
+    size_t max_file_bytes = 512 * 1024;
+    uint32_t max_file_seconds = 300;
+    // 最多保留的文件数，超出时删除最旧的
+    uint32_t max_files = 8;
+    const char* prefix = "rec";
+    // 写入任务参数：优先级低于采集任务，避免抢占 I2S 读取
+    UBaseType_t task_priority = 3;
+    uint32_t task_stack = 4096;
+};
+
+struct RecorderStats {
+    uint32_t files = 0;             // 已完成的文件数
+    uint64_t bytes_written = 0;
+    uint64_t write_us = 0;          // 累计写 flash 耗时
+    uint32_t max_stall_us = 0;      // 单次写 flash 的最长耗时 (擦除时最明显)
+    uint32_t buffers_written = 0;
+    uint32_t dropped_pushes = 0;    // 两个缓冲都被占用时丢弃的 Push 次数
+    uint64_t dropped_samples = 0;
+    uint32_t write_errors = 0;
+
+    // 写入吞吐 (KB/s)，只计 flash 写入时间
+    float throughput_kbps() const {
+        return write_us ? (float)(bytes_written * 1000000.0 / write_us / 1024.0) : 0.0f;
+    }
+};
+
+/**
+ * @brief 双缓冲的流式录音器，写入 storage 分区
+ *
+ * 采集任务调用 Push() 把样本 (需要时先编码成 ADPCM) 拷进当前缓冲，缓冲写满后
+ * 交给后台写入任务，自己立即切到另一个缓冲继续，从不等待 flash。
+ * 后台任务一次写入整个缓冲 (扇区对齐的大块写)，擦除/编程造成的停顿只影响写入任务；
+ * 如果写入跟不上、两个缓冲都被占用，新数据被丢弃并计入 dropped_*，而不是阻塞采集。
+ *
+ * Push()/Start()/Stop() 只能在同一个任务 (采集任务) 中调用。
+ */
+class AudioRecorder {
+public:
+    explicit AudioRecorder(const RecorderConfig& config = RecorderConfig());
+    ~AudioRecorder();
+
+    bool Start();
+    // 把当前缓冲中剩余的数据交给写入任务并关闭文件，不等待写入完成
+    void Stop();
+    bool recording() const { return recording_; }
+
+    /**
+     * @brief 送入样本 (采集任务)
+     * @param stride 相邻样本间隔，交织立体声取左声道时传 2
+     */
+    void Push(const int16_t* samples, size_t count, size_t stride = 1);
+
+    RecorderStats stats() const;
+
+private:
+    enum : uint8_t {
+        kCmdWrite = 1,
+        kCmdClose = 2,
+    };
+    struct WriterCmd {
+        int8_t buffer;      // -1 表示没有数据
+        uint8_t flags;
+        uint32_t bytes;
+        uint32_t samples;
+    };
+
+    static void WriterTaskEntry(void* arg);
+    void WriterTask();
+    // 以下只在写入任务中调用
+    bool OpenNextFile();
+    void CloseFile();
+    void WriteBuffer(const uint8_t* data, size_t bytes, uint32_t samples);
+
+    // 以下只在采集任务中调用
+    // 当前缓冲中还能写入的位置，缓冲仍被写入任务占用时返回 nullptr
+    uint8_t* Reserve(size_t bytes);
+    void Commit(size_t bytes, uint32_t samples);
+    void HandOff(uint8_t flags);
+    void CountDropped(size_t samples);
+
+    RecorderConfig config_;
+    size_t block_align_ = 0;        // ADPCM 块大小，PCM 为 0
+    size_t block_samples_ = 0;
+
+    DspBuffer<uint8_t> buffers_[2];
+    std::atomic<bool> busy_[2];
+    int active_ = 0;
+    size_t fill_ = 0;
+    uint32_t fill_samples_ = 0;
+    bool recording_ = false;
+
+    // ADPCM 编码前凑整块的暂存区
+    DspBuffer<int16_t> staging_;
+    size_t staging_fill_ = 0;
+    ImaAdpcmState adpcm_state_;
+
+    QueueHandle_t queue_ = nullptr;
+    TaskHandle_t task_ = nullptr;
+
+    // 写入任务私有
+    FILE* file_ = nullptr;
+    uint32_t file_index_ = 0;       // 下一个文件的编号
+    uint32_t oldest_index_ = 0;     // 仍保留的最旧文件编号
+    size_t file_bytes_ = 0;
+    uint32_t file_samples_ = 0;
+
+    mutable portMUX_TYPE stats_lock_ = portMUX_INITIALIZER_UNLOCKED;
+    RecorderStats stats_;
+};
+
+#endif // AUDIO_RECORDER_H
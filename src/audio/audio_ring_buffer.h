@@ -0,0 +1,99 @@
+#ifndef AUDIO_RING_BUFFER_H
+#define AUDIO_RING_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "dsp_engine.h"
+
+/**
+ * @brief 单生产者 / 单消费者的无锁 PCM 环形缓冲 (以帧为单位)
+ *
+ * 容量向上取整到 2 的幂，读写位置是自由递增的 32 位计数，回绕时按位与取下标。
+ * 生产者 (网络/ESP-NOW 接收任务) 只调用 Write()，消费者 (播放任务) 只调用 Read()/Peek()/Skip()，
+ * 两边都可以调用 fill()。
+ */
+class AudioRingBuffer {
+public:
+    AudioRingBuffer(size_t frames, int channels, DspMemory where = DspMemory::INTERNAL) : channels_(channels) {
+        size_t cap = 1;
+        while (cap < frames) cap <<= 1;
+        if (channels > 0 && buffer_.Allocate(cap * channels, where)) {
+            capacity_ = cap;
+        }
+    }
+
+    bool valid() const { return capacity_ != 0; }
+    size_t capacity() const { return capacity_; }
+    int channels() const { return channels_; }
+
+    // 当前可读的帧数
+    size_t fill() const {
+        return write_pos_.load(std::memory_order_acquire) - read_pos_.load(std::memory_order_acquire);
+    }
+    size_t space() const { return capacity_ - fill(); }
+    // 累计写入的帧数 (模 2^32)，用于统计
+    uint32_t total_written() const { return write_pos_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 写入交织帧，空间不足时只写入能放下的部分
+     * @return 实际写入的帧数
+     */
+    size_t Write(const int16_t* data, size_t frames) {
+        uint32_t w = write_pos_.load(std::memory_order_relaxed);
+        uint32_t r = read_pos_.load(std::memory_order_acquire);
+        frames = std::min(frames, capacity_ - (size_t)(w - r));
+        CopyIn(w, data, frames);
+        write_pos_.store(w + (uint32_t)frames, std::memory_order_release);
+        return frames;
+    }
+
+    /**
+     * @brief 拷出 frames 帧但不移动读位置
+     * @return 实际拷贝的帧数
+     */
+    size_t Peek(int16_t* out, size_t frames) const {
+        uint32_t r = read_pos_.load(std::memory_order_relaxed);
+        uint32_t w = write_pos_.load(std::memory_order_acquire);
+        frames = std::min(frames, (size_t)(w - r));
+        CopyOut(r, out, frames);
+        return frames;
+    }
+
+    size_t Skip(size_t frames) {
+        uint32_t r = read_pos_.load(std::memory_order_relaxed);
+        uint32_t w = write_pos_.load(std::memory_order_acquire);
+        frames = std::min(frames, (size_t)(w - r));
+        read_pos_.store(r + (uint32_t)frames, std::memory_order_release);
+        return frames;
+    }
+
+    size_t Read(int16_t* out, size_t frames) {
+        return Skip(Peek(out, frames));
+    }
+
+private:
+    void CopyIn(uint32_t pos, const int16_t* data, size_t frames) {
+        size_t offset = pos & (capacity_ - 1);
+        size_t first = std::min(frames, capacity_ - offset);
+        memcpy(buffer_.data() + offset * channels_, data, first * channels_ * sizeof(int16_t));
+        memcpy(buffer_.data(), data + first * channels_, (frames - first) * channels_ * sizeof(int16_t));
+    }
+
+    void CopyOut(uint32_t pos, int16_t* out, size_t frames) const {
+        size_t offset = pos & (capacity_ - 1);
+        size_t first = std::min(frames, capacity_ - offset);
+        memcpy(out, buffer_.data() + offset * channels_, first * channels_ * sizeof(int16_t));
+        memcpy(out + first * channels_, buffer_.data(), (frames - first) * channels_ * sizeof(int16_t));
+    }
+
+    int channels_;
+    size_t capacity_ = 0;
+    DspBuffer<int16_t> buffer_;
+    std::atomic<uint32_t> write_pos_{0};
+    std::atomic<uint32_t> read_pos_{0};
+};
+
+#endif // AUDIO_RING_BUFFER_H
@@ -0,0 +1,118 @@
+#include "biquad_eq.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+BiquadCascade::BiquadCascade(int channels) : channels_(channels) {}
+
+bool BiquadCascade::SetCoefficients(const BiquadCoeffs* coeffs, size_t count) {
+    if (count > BIQUAD_MAX_SECTIONS || (count > 0 && !coeffs) || pending()) {
+        return false;
+    }
+    // 后台 bank 此时不会被 Process() 读取
+    const int next = 1 - active_.load(std::memory_order_acquire);
+    const float scale = 1.0f / (float)(1 << BIQUAD_COEFF_FRAC_BITS);
+    for (size_t s = 0; s < count; s++) {
+        float* c = banks_[next].coeffs[s];
+        c[0] = coeffs[s].b0 * scale;
+        c[1] = coeffs[s].b1 * scale;
+        c[2] = coeffs[s].b2 * scale;
+        c[3] = coeffs[s].a1 * scale;
+        c[4] = coeffs[s].a2 * scale;
+    }
+    banks_[next].count = count;
+    pending_.store(next, std::memory_order_release);
+    return true;
+}
+
+void BiquadCascade::Reset() {
+    memset(w_, 0, sizeof(w_));
+    memset(hist_, 0, sizeof(hist_));
+}
+
+// 由直接 I 型的历史 (输入 x、输出 y 各两个样本) 求系数 c 下等效的直接 II 型状态 w。
+// 转置 II 型状态 s1 = b1 x1 + b2 x2 - a1 y1 - a2 y2，s2 = b2 x1 - a2 y1 只由历史决定；
+// 它与直接 II 型状态的关系为 s1 = k1 w1 + k2 w2，s2 = k2 w1 + (a1 k2 - a2 k1) w2，
+// 其中 k1 = b1 - b0 a1，k2 = b2 - b0 a2。k1 = k2 = 0 (纯增益节) 时状态不影响输出，取 0
+static void df2_state_from_history(const float* c, const float* x, const float* y, float* w) {
+    const float b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+    const float k1 = b1 - b0 * a1, k2 = b2 - b0 * a2;
+    const float s1 = b1 * x[0] + b2 * x[1] - a1 * y[0] - a2 * y[1];
+    const float s2 = b2 * x[0] - a2 * y[0];
+    const float m = a1 * k2 - a2 * k1;
+    const float det = k1 * m - k2 * k2;
+    if (fabsf(det) < 1e-12f) {
+        w[0] = w[1] = 0.0f;
+        return;
+    }
+    w[0] = (s1 * m - k2 * s2) / det;
+    w[1] = (k1 * s2 - k2 * s1) / det;
+}
+
+// 切换到 active_ 的 bank：新增的节先按直通补齐历史，再按新系数重建所有节的内部状态
+void BiquadCascade::LoadState(size_t old_count) {
+    const Bank& bank = banks_[active_.load(std::memory_order_relaxed)];
+    for (size_t s = old_count; s < bank.count; s++) {
+        for (int ch = 0; ch < channels_; ch++) {
+            hist_[s + 1][ch] = hist_[s][ch];
+        }
+    }
+    for (size_t s = 0; s < bank.count; s++) {
+        for (int ch = 0; ch < channels_; ch++) {
+            const float x[2] = {hist_[s][ch].v1, hist_[s][ch].v2};
+            const float y[2] = {hist_[s + 1][ch].v1, hist_[s + 1][ch].v2};
+            df2_state_from_history(bank.coeffs[s], x, y, w_[s][ch]);
+        }
+    }
+}
+
+static inline void record_history(float* h, const float* buf, size_t n) {
+    if (n >= 2) {
+        h[0] = buf[n - 1];
+        h[1] = buf[n - 2];
+    } else if (n == 1) {
+        h[1] = h[0];
+        h[0] = buf[0];
+    }
+}
+
+void BiquadCascade::Process(int16_t* samples, size_t frames) {
+    if (!valid()) return;
+    AudioPerfScope scope(perf_);
+
+    // 块边界切换系数
+    const int pending = pending_.load(std::memory_order_acquire);
+    if (pending >= 0) {
+        const size_t old_count = banks_[active_.load(std::memory_order_relaxed)].count;
+        active_.store(pending, std::memory_order_release);
+        pending_.store(-1, std::memory_order_release);
+        LoadState(old_count);
+    }
+    const Bank& bank = banks_[active_.load(std::memory_order_relaxed)];
+
+    while (frames > 0) {
+        const size_t n = std::min<size_t>(frames, BIQUAD_BLOCK_FRAMES);
+        for (int ch = 0; ch < channels_; ch++) {
+            float* x = buf_[0];
+            float* y = buf_[1];
+            for (size_t i = 0; i < n; i++) {
+                x[i] = samples[i * channels_ + ch];
+            }
+            // 直通时也记录输入历史，之后切换到非空系数时用得到
+            record_history(&hist_[0][ch].v1, x, n);
+            if (bank.count == 0) continue;
+            for (size_t s = 0; s < bank.count; s++) {
+                dsp_biquad_f32(x, y, n, bank.coeffs[s], w_[s][ch]);
+                record_history(&hist_[s + 1][ch].v1, y, n);
+                std::swap(x, y);
+            }
+            for (size_t i = 0; i < n; i++) {
+                const float v = std::min(32767.0f, std::max(-32768.0f, x[i]));
+                samples[i * channels_ + ch] = (int16_t)lrintf(v);
+            }
+        }
+        samples += n * channels_;
+        frames -= n;
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef BIQUAD_EQ_H
+#define BIQUAD_EQ_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "audio_perf.h"
+#include "dsp_engine.h"
+
+// 系数定点格式：Q4.28 (范围 ±8)，足够容纳 +12dB 以内的峰值/搁架滤波器的 b 系数
+#define BIQUAD_COEFF_FRAC_BITS 28
+#define BIQUAD_MAX_SECTIONS 12
+// 单次处理的最大帧数 (每声道的 float 工作缓冲长度)，更长的块分段处理
+#define BIQUAD_BLOCK_FRAMES 256
+
+/**
+ * @brief 一个二阶节的系数 (已按 a0 归一化)：
+ *   y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+ * 由主机工具 tools/biquad_design.py 设计并生成
+ */
+struct BiquadCoeffs {
+    int32_t b0, b1, b2, a1, a2;
+};
+
+/**
+ * @brief 二阶节级联 (扬声器均衡 / 分频)
+ *
+ * 系数以 Q4.28 提交，提交时转换成 float。每块先按声道拆成 float，每个声道逐节调用 dsp_biquad_f32
+ * (S3 上是 esp-dsp 的 dsps_biquad_f32_aes3，直接 II 型)，最后饱和回 int16。
+ *
+ * 运行中更新系数是安全的：SetCoefficients() 写入后台那一组系数，Process() 只在块边界切换。
+ * 直接 II 型的内部状态与系数有关，所以另外记录每一级输入输出的最后两个样本 (即直接 I 型的历史，与系数无关)，
+ * 切换时按新系数由历史反解出等效的内部状态，之后的输出与新系数的直接 I 型完全一致，不会产生数值跳变；
+ * 节数减少时多出的节直接停用；节数增加时新节的历史取前一节的输出历史 (按接近直通处理)，
+ * 对大多数均衡用的峰值/搁架滤波器来说切换那一块也不会有明显的阶跃。
+ * SetCoefficients() 只能在一个任务中调用，Process() 只能在另一个 (或同一个) 任务中调用。
+ */
+class BiquadCascade {
+public:
+    explicit BiquadCascade(int channels = 2);
+
+    bool valid() const { return channels_ == 1 || channels_ == 2; }
+    int channels() const { return channels_; }
+    size_t sections() const { return banks_[active_.load(std::memory_order_relaxed)].count; }
+
+    /**
+     * @brief 提交一组新系数，下一次 Process() 开始时生效
+     * @param count 节数，0 表示直通
+     * @return 上一次提交尚未生效或参数无效时返回 false
+     */
+    bool SetCoefficients(const BiquadCoeffs* coeffs, size_t count);
+
+    // 是否还有尚未生效的系数
+    bool pending() const { return pending_.load(std::memory_order_acquire) >= 0; }
+
+    /**
+     * @brief 原地处理交织的 16 位 PCM
+     */
+    void Process(int16_t* samples, size_t frames);
+
+    void Reset();
+    const AudioPerfCounter& perf() const { return perf_; }
+    void ResetPerf() { perf_.Reset(); }
+
+private:
+    struct Bank {
+        float coeffs[BIQUAD_MAX_SECTIONS][5];   // {b0, b1, b2, a1, a2}，dsp_biquad_f32 的顺序
+        size_t count = 0;
+    };
+    // 级间节点的最后两个样本：节点 s 是第 s 节的输入，节点 s + 1 是它的输出
+    struct History {
+        float v1, v2;
+    };
+
+    void LoadState(size_t old_count);
+
+    int channels_;
+    Bank banks_[2];
+    std::atomic<int> active_{0};
+    std::atomic<int> pending_{-1};     // 待切换的 bank 下标，-1 表示没有
+    float w_[BIQUAD_MAX_SECTIONS][2][2] = {};      // 每节每声道的直接 II 型状态 {w[n-1], w[n-2]}
+    History hist_[BIQUAD_MAX_SECTIONS + 1][2] = {};
+    alignas(16) float buf_[2][BIQUAD_BLOCK_FRAMES]; // 级间 float 工作缓冲 (两块交替)
+    AudioPerfCounter perf_;
+};
+
+#endif // BIQUAD_EQ_H
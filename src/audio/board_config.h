@@ -19,10 +19,43 @@
 // ES8311 芯片的默认 I2C 地址
 #define AUDIO_CODEC_ES8311_ADDR  0x18
 
+// 可选的 ES7210 多麦克风阵列 (独立的 I2S 口，TDM 模式)。
+// 未接阵列时保持 AUDIO_MIC_ARRAY_COUNT 为 0；接线后填写引脚并设为 2 或 4，MyBoard 随之改用阵列采集 (MyMicArrayCodec)。
+#define AUDIO_MIC_ARRAY_COUNT       0
+#define AUDIO_MIC_ARRAY_SPACING_MM  40.0f   // 线阵相邻麦克风间距
+#define AUDIO_CODEC_ES7210_ADDR     0x40
+#define AUDIO_TDM_GPIO_MCLK GPIO_NUM_NC
+#define AUDIO_TDM_GPIO_BCLK GPIO_NUM_NC
+#define AUDIO_TDM_GPIO_WS   GPIO_NUM_NC
+#define AUDIO_TDM_GPIO_DIN  GPIO_NUM_NC
+
 // Echo Base 上的 I/O 扩展芯片，用于控制功放静音
 #define PI4IOE_I2C_ADDR 0x43
 
 // 音频缓冲区大小，来自 audio_codec.h
 #define AUDIO_CODEC_DMA_FRAME_NUM 240
 
+// 置 1 时启动阶段先运行 DSP 基准测试 (dsp_bench_run)，结果打印到串口
+#define AUDIO_DSP_BENCHMARK 0
+
+// 采集预录缓冲 (单声道)：有 PSRAM 时保留 AUDIO_HISTORY_SECONDS 秒 (24kHz 下每秒 47KB)，
+// 没有 PSRAM 时退回到较短的内部 SRAM 缓冲；告警时截取最近 AUDIO_HISTORY_PREROLL_MS 毫秒
+#define AUDIO_HISTORY_SECONDS          10
+#define AUDIO_HISTORY_SECONDS_NO_PSRAM 2
+#define AUDIO_HISTORY_PREROLL_MS       5000
+// 告警片段保存到 storage 分区时轮流使用的文件数，0 表示只保留在内存中
+#define AUDIO_EVENT_CLIP_FILES         4
+
+// 置 1 时把采集的左声道持续录制到 storage 分区 (IMA ADPCM，按大小/时长轮转)
+#define AUDIO_RECORDER_ENABLE 0
+
+// 置 1 时在采集通路上运行单频点 (DFT) 音调检测，识别附近医疗设备的报警音 (频率表见 main.cpp)
+#define AUDIO_TONE_DETECTOR_ENABLE 1
+
+// 置 1 时在输出前做扬声器均衡，系数由 tools/biquad_design.py 生成 (speaker_eq_coeffs.h)
+#define AUDIO_SPEAKER_EQ_ENABLE 1
+
+// 置 1 时对播放的提示音/回复音频做响度归一化和压缩限幅 (loudness.h)
+#define AUDIO_PLAYBACK_LOUDNESS_ENABLE 1
+
 #endif // BOARD_CONFIG_H
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "breathing_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+// 带通包络的中间采样率：带通工作在 sample_rate/2，能量块输出 20Hz
+static const float kEnergyRateHz = 20.0f;
+// 输入增益变化后保持包络的时长，覆盖 DMA 缓冲中的旧增益数据和带通的瞬态
+static const float kGainHoldS = 0.25f;
+
+BreathingEstimator::BreathingEstimator(const BreathingConfig& config) : config_(config) {
+    const float fs = config_.sample_rate / 2.0f;
+
+    // RBJ 带通 (0dB 峰值增益)
+    float f0 = sqrtf(config_.band_low_hz * config_.band_high_hz);
+    float bw_oct = log2f(config_.band_high_hz / config_.band_low_hz);
+    float w0 = 2.0f * (float)M_PI * f0 / fs;
+    float alpha = sinf(w0) * sinhf(logf(2.0f) / 2.0f * bw_oct * w0 / sinf(w0));
+    float a0 = 1.0f + alpha;
+    b0_ = alpha / a0;
+    b1_ = 0.0f;
+    b2_ = -alpha / a0;
+    a1_ = -2.0f * cosf(w0) / a0;
+    a2_ = (1.0f - alpha) / a0;
+
+    energy_block_ = std::max(1, (int)(fs / kEnergyRateHz));
+    env_decim_ = std::max(1, (int)(kEnergyRateHz / config_.envelope_hz));
+    const float env_hz = kEnergyRateHz / env_decim_;
+
+    // 去趋势时间常数取最长呼吸周期的 2 倍
+    trend_alpha_ = 1.0f - expf(-1.0f / (env_hz * 2.0f * 60.0f / config_.min_bpm));
+
+    min_lag_ = std::max(1, (int)floorf(env_hz * 60.0f / config_.max_bpm));
+    max_lag_ = (int)ceilf(env_hz * 60.0f / config_.min_bpm);
+    forget_ = expf(-1.0f / (env_hz * config_.window_s));
+    history_.assign(max_lag_ + 1, 0.0f);
+    acf_.assign(max_lag_ + 2, 0.0f);
+    report_samples_ = (uint32_t)(config_.report_interval_s * env_hz);
+}
+
+void BreathingEstimator::SetInputGain(float db) {
+    if (db == gain_db_) return;
+    gain_db_ = db;
+    // 能量按 10^(dB/10) 缩放，折算到自然对数域
+    gain_log_offset_ = db * logf(10.0f) / 10.0f;
+    hold_blocks_ = (int)ceilf(kGainHoldS * kEnergyRateHz);
+}
+
+void BreathingEstimator::Push(const int16_t* samples, size_t count, size_t stride) {
+    if (stride == 0) return;
+    AudioPerfScope scope(perf_);
+    const float scale = 1.0f / 32768.0f;
+    for (size_t i = 0; i < count; i += stride) {
+        decim_acc_ += samples[i];
+        if (++decim_phase_ < 2) continue;
+        float x = decim_acc_ * (0.5f * scale);
+        decim_acc_ = 0.0f;
+        decim_phase_ = 0;
+
+        float y = b0_ * x + z1_;
+        z1_ = b1_ * x - a1_ * y + z2_;
+        z2_ = b2_ * x - a2_ * y;
+
+        energy_acc_ += y * y;
+        if (++energy_count_ == energy_block_) {
+            PushEnvelope(energy_acc_ / energy_block_);
+            energy_acc_ = 0.0f;
+            energy_count_ = 0;
+        }
+    }
+}
+
+void BreathingEstimator::PushEnvelope(float energy) {
+    // log 包络对麦克风距离 (整体增益) 不敏感；PGA 增益在这里减掉，刚变化时沿用上一个值
+    float log_energy = logf(energy + 1e-10f) - gain_log_offset_;
+    if (hold_blocks_ > 0) {
+        hold_blocks_--;
+        if (has_log_energy_) {
+            log_energy = last_log_energy_;
+        }
+    }
+    last_log_energy_ = log_energy;
+    has_log_energy_ = true;
+    env_acc_ += log_energy;
+    if (++env_count_ < env_decim_) return;
+    float env = env_acc_ / env_decim_;
+    env_acc_ = 0.0f;
+    env_count_ = 0;
+
+    if (!trend_init_) {
+        trend_ = env;
+        trend_init_ = true;
+    }
+    trend_ += trend_alpha_ * (env - trend_);
+    PushSlowSample(env - trend_);
+}
+
+void BreathingEstimator::PushSlowSample(float x) {
+    const size_t n = history_.size();
+    history_[hist_pos_] = x;
+    // acf[lag] = forget * acf[lag] + x[t] * x[t - lag]
+    size_t lags = std::min(hist_count_ + 1, n);
+    for (size_t lag = 0; lag < lags; lag++) {
+        size_t idx = (hist_pos_ + n - lag) % n;
+        acf_[lag] = forget_ * acf_[lag] + x * history_[idx];
+    }
+    hist_pos_ = (hist_pos_ + 1) % n;
+    if (hist_count_ < n) hist_count_++;
+
+    if (++samples_since_report_ >= report_samples_) {
+        samples_since_report_ = 0;
+        Estimate();
+    }
+}
+
+void BreathingEstimator::Estimate() {
+    bpm_ = -1;
+    confidence_ = 0.0f;
+    if (hist_count_ < history_.size() || acf_[0] <= 0.0f) {
+        return;
+    }
+    // 在 [min_lag, max_lag] 中找第一个显著的局部极大值，避免倍频误判
+    int best = -1;
+    float best_val = 0.0f;
+    for (int lag = min_lag_; lag < max_lag_; lag++) {
+        float v = acf_[lag];
+        if (v > acf_[lag - 1] && v >= acf_[lag + 1] && v > best_val) {
+            best = lag;
+            best_val = v;
+        }
+    }
+    if (best < 0) {
+        if (rate_cb_) rate_cb_(bpm_, confidence_);
+        return;
+    }
+    confidence_ = best_val / acf_[0];
+
+    // 抛物线插值得到分数滞后
+    float ym1 = acf_[best - 1], y0 = acf_[best], yp1 = acf_[best + 1];
+    float denom = ym1 - 2.0f * y0 + yp1;
+    float frac = denom != 0.0f ? 0.5f * (ym1 - yp1) / denom : 0.0f;
+    float lag = best + std::max(-0.5f, std::min(0.5f, frac));
+
+    const float env_hz = kEnergyRateHz / env_decim_;
+    if (confidence_ >= config_.min_confidence) {
+        bpm_ = (int)lrintf(60.0f * env_hz / lag);
+    }
+    if (rate_cb_) rate_cb_(bpm_, confidence_);
+}
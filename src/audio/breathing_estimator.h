@@ -0,0 +1,113 @@
+#ifndef BREATHING_ESTIMATOR_H
+#define BREATHING_ESTIMATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "audio_perf.h"
+
+#ifdef ESP_PLATFORM
+#include "board_config.h"
+#else
+// 主机上编译基准测试时没有板级配置，取与 board_config.h 相同的采集采样率
+#define AUDIO_INPUT_SAMPLE_RATE 24000
+#endif
+
+struct BreathingConfig {
+    int sample_rate = AUDIO_INPUT_SAMPLE_RATE;
+    float band_low_hz = 200.0f;      // 呼吸气流声所在频带
+    float band_high_hz = 1200.0f;
+    float envelope_hz = 5.0f;        // 包络最终采样率
+    float window_s = 30.0f;          // 自相关的等效记忆长度
+    float min_bpm = 6.0f;
+    float max_bpm = 40.0f;
+    float min_confidence = 0.35f;    // 归一化自相关峰值低于此值时不输出
+    float report_interval_s = 10.0f;
+};
+
+/**
+ * @brief 基于麦克风的呼吸频率估计 (次/分钟)
+ *
+ * 处理链：2 倍平均抽取 -> 带通 biquad -> 平方能量按块累加 (20Hz) -> log 包络
+ * -> 再抽取到 5Hz 并去趋势 -> 指数遗忘的增量自相关。
+ * 每个 5Hz 样本只更新几十个滞后项，每隔 report_interval_s 才做一次峰值搜索，
+ * 平均开销远低于采集通路本身，可以常驻后台。
+ *
+ * 输入取自 AGC 之前，但其中仍有 AGC 对 ES8311 PGA 的 6dB 粗调步进，会在包络上留下阶跃。
+ * 每块之前用 SetInputGain() 告知当前的 PGA 增益：log 包络减去增益补偿阶跃，
+ * 增益变化后的 kGainHoldS 内沿用上一个包络值，跳过 DMA 中仍是旧增益的数据和带通滤波器的瞬态。
+ */
+class BreathingEstimator {
+public:
+    using RateCallback = std::function<void(int breaths_per_min, float confidence)>;
+
+    explicit BreathingEstimator(const BreathingConfig& config = BreathingConfig());
+
+    /**
+     * @param stride 交织立体声取单声道时传 2
+     */
+    void Push(const int16_t* samples, size_t count, size_t stride = 1);
+
+    void SetRateCallback(RateCallback cb) { rate_cb_ = std::move(cb); }
+
+    /**
+     * @brief 输入端的模拟增益 (dB)，通常是 AudioAgc::coarse_gain_db()，变化时补偿包络
+     */
+    void SetInputGain(float db);
+
+    // 最近一次的估计值，-1 表示当前没有可信的呼吸节律
+    int breaths_per_minute() const { return bpm_; }
+    float confidence() const { return confidence_; }
+    const AudioPerfCounter& perf() const { return perf_; }
+
+private:
+    void PushEnvelope(float energy);
+    void PushSlowSample(float x);
+    void Estimate();
+
+    BreathingConfig config_;
+
+    // 2 倍抽取
+    float decim_acc_ = 0.0f;
+    int decim_phase_ = 0;
+    // 带通 biquad (直接 II 型转置)，系数已按 a0 归一化
+    float b0_, b1_, b2_, a1_, a2_;
+    float z1_ = 0.0f, z2_ = 0.0f;
+    // 输入增益补偿：log 能量的偏移量，以及增益变化后还要保持的能量块数
+    float gain_db_ = 0.0f;
+    float gain_log_offset_ = 0.0f;
+    int hold_blocks_ = 0;
+    float last_log_energy_ = 0.0f;
+    bool has_log_energy_ = false;
+    // 能量块
+    float energy_acc_ = 0.0f;
+    int energy_count_ = 0;
+    int energy_block_;
+    // 包络再抽取到 envelope_hz
+    float env_acc_ = 0.0f;
+    int env_count_ = 0;
+    int env_decim_;
+    // 去趋势
+    float trend_ = 0.0f;
+    bool trend_init_ = false;
+    float trend_alpha_;
+
+    // 增量自相关：history_ 为最近 max_lag+1 个包络样本的环形缓冲
+    int min_lag_;
+    int max_lag_;
+    float forget_;
+    std::vector<float> history_;
+    size_t hist_pos_ = 0;
+    size_t hist_count_ = 0;
+    std::vector<float> acf_;          // acf_[lag]，lag = 0 .. max_lag
+
+    uint32_t samples_since_report_ = 0;
+    uint32_t report_samples_;
+    int bpm_ = -1;
+    float confidence_ = 0.0f;
+    RateCallback rate_cb_;
+    AudioPerfCounter perf_;
+};
+
+#endif // BREATHING_ESTIMATOR_H
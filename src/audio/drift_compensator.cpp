@@ -0,0 +1,143 @@
+#include "drift_compensator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+DriftCompensator::DriftCompensator(const DriftConfig& config)
+    : config_(config), ring_(config.capacity_frames, config.channels) {
+    if (!ring_.valid() || config_.channels <= 0 || config_.max_block == 0 || config_.sample_rate <= 0 ||
+        config_.target_frames + config_.max_block * 2 > ring_.capacity()) {
+        return;
+    }
+
+    // 每次 Read 最多消费 max_block * (1 + 最大偏移) 帧，再加插值需要的 3 帧历史
+    hist_capacity_ = (size_t)ceil(config_.max_block * (1.0 + config_.max_correction_ppm * 1e-6)) + 5;
+    if (!hist_.Allocate(hist_capacity_ * config_.channels, DspMemory::INTERNAL)) {
+        return;
+    }
+
+    // 缓冲深度 e 的动态: e'' = -rate * (kp * e' + ki * e)，按临界阻尼选增益
+    const float wn = 2.0f * (float)M_PI / std::max(1.0f, config_.settle_seconds);
+    kp_ = 2.0f * wn / config_.sample_rate * 1e6f;
+    ki_ = wn * wn / config_.sample_rate * 1e6f;
+    fill_avg_ = (float)config_.target_frames;
+    ResetStats();
+    valid_ = true;
+}
+
+size_t DriftCompensator::Write(const int16_t* data, size_t frames) {
+    if (!valid_) return 0;
+    size_t written = ring_.Write(data, frames);
+    if (written < frames) {
+        overruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return written;
+}
+
+void DriftCompensator::UpdateControl(float buffered, size_t frames) {
+    const float dt = (float)frames / config_.sample_rate;
+    const float alpha = dt / (config_.fill_smoothing_seconds + dt);
+    fill_avg_ += alpha * (buffered - fill_avg_);
+
+    const float limit = config_.max_correction_ppm;
+    const float e = fill_avg_ - (float)config_.target_frames;
+    // 积分项单独限幅 (抗饱和)，它的稳态值就是时钟偏差的估计
+    integral_ppm_ = std::min(limit, std::max(-limit, integral_ppm_ + ki_ * e * dt));
+    correction_ppm_ = std::min(limit, std::max(-limit, kp_ * e + integral_ppm_));
+}
+
+bool DriftCompensator::Read(int16_t* out, size_t frames) {
+    const int ch = config_.channels;
+    if (!valid_) {
+        memset(out, 0, frames * ch * sizeof(int16_t));
+        return false;
+    }
+    AudioPerfScope scope(perf_);
+
+    uint32_t written = ring_.total_written();
+    stats_.frames_in += (uint32_t)(written - last_written_);
+    last_written_ = written;
+
+    size_t fill = ring_.fill();
+    stats_.fill_min = std::min<uint32_t>(stats_.fill_min, (uint32_t)fill);
+    stats_.fill_max = std::max<uint32_t>(stats_.fill_max, (uint32_t)fill);
+
+    if (priming_) {
+        if (fill < config_.target_frames) {
+            memset(out, 0, frames * ch * sizeof(int16_t));
+            return false;
+        }
+        priming_ = false;
+        hist_frames_ = 0;
+        phase_ = 0.0;
+        fill_avg_ = (float)fill;
+    }
+
+    size_t pos = 0;
+    while (pos < frames) {
+        const size_t n = std::min(config_.max_block, frames - pos);
+        // 缓冲深度包含重采样器里尚未消费的部分
+        UpdateControl((float)fill + (float)hist_frames_ - (float)phase_, n);
+        const double ratio = 1.0 + correction_ppm_ * 1e-6;
+
+        // 本块最后一个输出点需要 hist_[k .. k+3]
+        const double last = phase_ + (n - 1) * ratio;
+        const size_t need = (size_t)last + 4;
+        if (need > hist_frames_) {
+            size_t got = ring_.Read(hist_.data() + hist_frames_ * ch, need - hist_frames_);
+            hist_frames_ += got;
+            if (hist_frames_ < need) {
+                // 读空：输出静音，重新预缓冲，积分项保留 (时钟偏差不会因此改变)
+                memset(out + pos * ch, 0, (frames - pos) * ch * sizeof(int16_t));
+                stats_.underruns++;
+                priming_ = true;
+                break;
+            }
+        }
+
+        const int16_t* h = hist_.data();
+        int16_t* dst = out + pos * ch;
+        double t = phase_;
+        for (size_t i = 0; i < n; i++, t += ratio) {
+            const size_t k = (size_t)t;
+            const float f = (float)(t - k);
+            const int16_t* x = h + k * ch;
+            for (int c = 0; c < ch; c++) {
+                // Catmull-Rom 三次插值 (x0..x3 = hist_[k..k+3])
+                const float x0 = x[c], x1 = x[ch + c], x2 = x[2 * ch + c], x3 = x[3 * ch + c];
+                float y = x1 + 0.5f * f * (x2 - x0 + f * (2.0f * x0 - 5.0f * x1 + 4.0f * x2 - x3 +
+                                                           f * (3.0f * (x1 - x2) + x3 - x0)));
+                y = std::min(32767.0f, std::max(-32768.0f, y));
+                dst[c] = (int16_t)lrintf(y);
+            }
+            dst += ch;
+        }
+
+        // 丢掉已经完全用过的输入帧，保留 x[-1] 起的插值历史
+        const size_t consumed = std::min((size_t)t, hist_frames_);
+        memmove(hist_.data(), hist_.data() + consumed * ch, (hist_frames_ - consumed) * ch * sizeof(int16_t));
+        hist_frames_ -= consumed;
+        phase_ = t - consumed;
+
+        pos += n;
+        fill = ring_.fill();
+    }
+    stats_.frames_out += frames;
+    return !priming_;
+}
+
+DriftStats DriftCompensator::stats() const {
+    DriftStats s = stats_;
+    s.drift_ppm = integral_ppm_;
+    s.correction_ppm = correction_ppm_;
+    s.fill_frames = fill_avg_;
+    s.overruns = overruns_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void DriftCompensator::ResetStats() {
+    stats_.fill_min = UINT32_MAX;
+    stats_.fill_max = 0;
+    perf_.Reset();
+}
@@ -0,0 +1,97 @@
+#ifndef DRIFT_COMPENSATOR_H
+#define DRIFT_COMPENSATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "audio_ring_buffer.h"
+#include "audio_perf.h"
+
+struct DriftConfig {
+    int sample_rate = 24000;        // 输出 (I2S) 采样率，名义上与生产者相同
+    int channels = 2;
+    size_t capacity_frames = 4096;  // 环形缓冲容量 (取整到 2 的幂)
+    size_t target_frames = 1440;    // 目标缓冲深度 (60ms)，即稳态延迟
+    size_t max_block = 512;         // 单次 Read 的最大帧数
+    float max_correction_ppm = 1000.0f;
+    // 控制环的自然周期：越长越平滑，但吸收突变 (如网络抖动后的堆积) 越慢
+    float settle_seconds = 60.0f;
+    // 缓冲深度的平滑时间常数，滤掉按包到达造成的锯齿
+    float fill_smoothing_seconds = 1.0f;
+};
+
+struct DriftStats {
+    float drift_ppm = 0.0f;         // 估计的时钟偏差 (生产者相对 I2S，正数表示生产者偏快)
+    float correction_ppm = 0.0f;    // 当前施加的重采样比偏移
+    float fill_frames = 0.0f;       // 平滑后的缓冲深度
+    uint32_t fill_min = 0;          // 自上次 ResetStats 以来的瞬时最小/最大深度
+    uint32_t fill_max = 0;
+    uint32_t underruns = 0;         // 缓冲读空，输出静音并重新预缓冲
+    uint32_t overruns = 0;          // 缓冲写满，丢弃生产者数据
+    uint64_t frames_in = 0;
+    uint64_t frames_out = 0;
+};
+
+/**
+ * @brief 异步时钟域之间的漂移补偿
+ *
+ * 生产者 (网络、ESP-NOW 等，按自己的时钟送数据) 调用 Write()，播放任务按 I2S 时钟调用 Read()。
+ * 两个时钟的偏差会让缓冲慢慢堆积或读空，这里用一个 PI 控制环跟踪平滑后的缓冲深度，
+ * 输出 ppm 级的重采样比，驱动 4 点三次插值的可变比率重采样器：
+ *   - 比例项吸收短时偏离，积分项收敛到真实的时钟偏差 (即 drift_ppm)；
+ *   - 增益按 settle_seconds 求出 (临界阻尼)，比率变化极慢，听不出音高变化；
+ *   - 只在真正读空时才输出静音并重新预缓冲，正常运行时不需要周期性清空。
+ *
+ * Write() 和 Read() 分别只能在一个任务中调用；stats() 在消费者任务中调用得到一致的值。
+ */
+class DriftCompensator {
+public:
+    explicit DriftCompensator(const DriftConfig& config = DriftConfig());
+
+    bool valid() const { return valid_; }
+    const DriftConfig& config() const { return config_; }
+
+    /**
+     * @brief 生产者写入交织帧
+     * @return 实际写入的帧数，缓冲满时丢弃多余部分并计入 overruns
+     */
+    size_t Write(const int16_t* data, size_t frames);
+
+    /**
+     * @brief 消费者读取，总是输出 frames 帧 (预缓冲或读空时为静音)
+     * @return 预缓冲期间返回 false
+     */
+    bool Read(int16_t* out, size_t frames);
+
+    DriftStats stats() const;
+    void ResetStats();
+    const AudioPerfCounter& perf() const { return perf_; }
+
+private:
+    void UpdateControl(float buffered, size_t frames);
+
+    DriftConfig config_;
+    bool valid_ = false;
+    AudioRingBuffer ring_;
+
+    // 重采样器：hist_ 从 x[-1] 开始保存尚未完全消费的输入帧
+    DspBuffer<int16_t> hist_;
+    size_t hist_frames_ = 0;
+    size_t hist_capacity_ = 0;
+    double phase_ = 0.0;            // 下一个输出点相对 hist_[1] 的位置
+    bool priming_ = true;
+
+    // 控制环
+    float kp_;                      // ppm / 帧
+    float ki_;                      // ppm / (帧 * 秒)
+    float fill_avg_ = 0.0f;
+    float integral_ppm_ = 0.0f;
+    float correction_ppm_ = 0.0f;
+
+    std::atomic<uint32_t> overruns_{0};
+    uint32_t last_written_ = 0;     // 消费者上次看到的 total_written()
+    DriftStats stats_;
+    AudioPerfCounter perf_;
+};
+
+#endif // DRIFT_COMPENSATOR_H
@@ -0,0 +1,624 @@
+// DSP 引擎基准测试：设备和主机共用同一份代码
+// 主机编译见 dsp_engine.h 中 dsp_bench_run() 的说明
+
+#include "dsp_engine.h"
+#include "audio_perf.h"
+#include "mel_features.h"
+#include "nn_int8.h"
+#include "mic_array_dsp.h"
+#include "audio_history.h"
+#include "drift_compensator.h"
+#include "pipeline_stages.h"
+#include "tone_detector.h"
+#include "biquad_eq.h"
+#include "loudness.h"
+#include "breathing_estimator.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const int kBenchIterations = 200;
+
+// 简单的确定性伪随机数，主机和设备结果一致
+uint32_t bench_rand(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state;
+}
+
+void fill_noise(float* x, size_t n, uint32_t seed) {
+    for (size_t i = 0; i < n; i++) {
+        x[i] = (float)((int32_t)(bench_rand(seed) >> 16) - 32768);
+    }
+}
+
+void bench_fft(size_t n) {
+    DspFft fft(n);
+    DspBuffer<float> in(n, DspMemory::INTERNAL);
+    DspBuffer<float> spec(n, DspMemory::INTERNAL);
+    DspBuffer<float> out(n, DspMemory::INTERNAL);
+    if (!fft.valid() || !in.data() || !spec.data() || !out.data()) {
+        printf("fft %4u: allocation failed\n", (unsigned)n);
+        return;
+    }
+    fill_noise(in.data(), n, 12345u + (uint32_t)n);
+
+    AudioPerfCounter fwd, inv;
+    for (int it = 0; it < kBenchIterations; it++) {
+        uint32_t t0 = audio_perf_cycles();
+        fft.Forward(in.data(), spec.data());
+        uint32_t t1 = audio_perf_cycles();
+        fft.Inverse(spec.data(), out.data());
+        uint32_t t2 = audio_perf_cycles();
+        fwd.Add(t1 - t0);
+        inv.Add(t2 - t1);
+    }
+
+    // 往返误差与直接 DFT 的 bin 误差
+    float max_err = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        max_err = fmaxf(max_err, fabsf(out[i] - in[i]));
+    }
+    size_t k = n / 8 + 1;
+    double re = 0.0, im = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double a = -2.0 * M_PI * (double)(k * i) / (double)n;
+        re += in[i] * cos(a);
+        im += in[i] * sin(a);
+    }
+    double bin_err = fabs(re - spec[2 * k]) + fabs(im - spec[2 * k + 1]);
+
+    printf("rfft %4u: fwd %6u cyc, inv %6u cyc (%.1f us), roundtrip err %.3g, bin err %.3g\n",
+           (unsigned)n, (unsigned)fwd.Average(), (unsigned)inv.Average(),
+           fwd.Average() * 1e6f / AUDIO_PERF_CPU_HZ, max_err, bin_err);
+}
+
+void bench_overlap_add(size_t frame, size_t hop, DspMemory history_mem) {
+    OverlapAdd ola(frame, hop, history_mem);
+    DspFft fft(frame);
+    if (!ola.valid() || !fft.valid()) {
+        printf("ola %u/%u: init failed\n", (unsigned)frame, (unsigned)hop);
+        return;
+    }
+    std::vector<float> input(hop * 64), output(hop * 64), spec(frame);
+    fill_noise(input.data(), input.size(), 777u);
+
+    AudioPerfCounter perf;
+    for (size_t h = 0; h < input.size() / hop; h++) {
+        uint32_t t0 = audio_perf_cycles();
+        const float* f = ola.Analyze(input.data() + h * hop);
+        fft.Forward(f, spec.data());
+        fft.Inverse(spec.data(), spec.data());
+        ola.Synthesize(spec.data(), output.data() + h * hop);
+        perf.Add(audio_perf_cycles() - t0);
+    }
+
+    // WOLA 输出相对输入延迟 frame - hop 个样本
+    size_t delay = frame - hop;
+    float max_err = 0.0f;
+    for (size_t i = frame; i < input.size(); i++) {
+        max_err = fmaxf(max_err, fabsf(output[i] - input[i - delay]));
+    }
+    printf("ola %4u/%3u (%s history): %6u cyc/hop, reconstruction err %.3g\n",
+           (unsigned)frame, (unsigned)hop, history_mem == DspMemory::PSRAM ? "psram" : "sram",
+           (unsigned)perf.Average(), max_err);
+}
+
+void bench_mel(size_t num_mfcc) {
+    MelConfig cfg;
+    cfg.num_mfcc = num_mfcc;
+    MelFeatureExtractor mel(cfg);
+    if (!mel.valid()) {
+        printf("mel: init failed\n");
+        return;
+    }
+    // 2 秒交织立体声噪声，按 DMA 帧大小 (120 帧) 分块送入，只取左声道
+    std::vector<int16_t> pcm(cfg.sample_rate * 2 * 2);
+    uint32_t seed = 4242u;
+    for (auto& s : pcm) s = (int16_t)(bench_rand(seed) >> 18);
+    for (size_t pos = 0; pos < pcm.size(); pos += 240) {
+        mel.Push(pcm.data() + pos, 240, 2);
+    }
+    const AudioPerfCounter& perf = mel.perf();
+    printf("%s %u/%u: %u frames, %6u cyc/hop avg, %6u max (%.2f%% CPU), %u bytes\n",
+           num_mfcc ? "mfcc" : "logmel", (unsigned)cfg.fft_size, (unsigned)cfg.hop_size,
+           (unsigned)mel.total_frames(), (unsigned)perf.Average(), (unsigned)perf.max,
+           perf.LoadPercent(cfg.hop_size * 1000000u / cfg.sample_rate), (unsigned)mel.MemoryBytes());
+}
+
+// 典型的关键词/事件分类小网络 (DS-CNN 结构)，输入为 98 帧 x 40 维 log-mel
+void bench_nn() {
+    int failures = nn_self_test(false);
+    printf("nn self test: %s (%d mismatches)\n", failures ? "FAILED" : "bit-exact", failures);
+
+    uint32_t seed = 99u;
+    struct LayerSpec { NnOp op; uint16_t out_c; uint8_t k, stride; };
+    const LayerSpec specs[] = {
+        {NnOp::CONV2D, 16, 3, 2},
+        {NnOp::DEPTHWISE_CONV2D, 0, 3, 1},
+        {NnOp::CONV2D, 32, 1, 1},
+        {NnOp::DEPTHWISE_CONV2D, 0, 3, 2},
+        {NnOp::CONV2D, 32, 1, 1},
+        {NnOp::AVG_POOL, 0, 0, 0},
+        {NnOp::DENSE, 4, 0, 0},
+    };
+    const size_t num_layers = sizeof(specs) / sizeof(specs[0]);
+    const NnShape input = {98, 40, 1};
+
+    NnLayer layers[num_layers];
+    std::vector<std::vector<int8_t>> weights(num_layers);
+    std::vector<std::vector<int32_t>> bias(num_layers);
+    std::vector<std::vector<NnQuant>> quant(num_layers);
+    NnShape s = input;
+    size_t weight_bytes = 0;
+    for (size_t i = 0; i < num_layers; i++) {
+        NnLayer& l = layers[i];
+        l = NnLayer{};
+        l.op = specs[i].op;
+        l.out_c = specs[i].out_c;
+        l.kh = l.kw = specs[i].k;
+        l.stride_h = l.stride_w = specs[i].stride;
+        l.pad_same = true;
+        l.act_min = -128;
+        l.act_max = 127;
+        NnShape o = nn_layer_output_shape(l, s);
+        size_t count = l.op == NnOp::CONV2D ? (size_t)o.c * l.kh * l.kw * s.c
+                     : l.op == NnOp::DEPTHWISE_CONV2D ? (size_t)l.kh * l.kw * s.c
+                     : l.op == NnOp::DENSE ? (size_t)o.c * s.size() : 0;
+        weights[i].resize(count);
+        for (auto& w : weights[i]) w = (int8_t)(bench_rand(seed) >> 24);
+        bias[i].assign(o.c, 0);
+        quant[i].assign(o.c, nn_quantize_multiplier(0.002));
+        l.weights = weights[i].data();
+        l.bias = bias[i].data();
+        l.out_quant = quant[i].data();
+        weight_bytes += count + o.c * (sizeof(int32_t) + sizeof(NnQuant));
+        s = o;
+    }
+
+    NnModel model = {layers, num_layers, input};
+    size_t arena_bytes = nn_arena_bytes(layers, num_layers, input);
+    DspBuffer<int8_t> arena(arena_bytes, DspMemory::INTERNAL);
+    NnInterpreter interp(model, arena.data(), arena_bytes);
+    if (!interp.valid()) {
+        printf("nn model: init failed\n");
+        return;
+    }
+    for (size_t i = 0; i < input.size(); i++) {
+        interp.input()[i] = (int8_t)(bench_rand(seed) >> 24);
+    }
+    std::vector<int8_t> ref(interp.output_shape().size());
+    interp.Invoke(true);
+    memcpy(ref.data(), interp.output(), ref.size());
+    uint32_t ref_cycles = interp.perf().last;
+    for (int it = 0; it < 10; it++) {
+        interp.Invoke(false);
+    }
+    bool exact = memcmp(ref.data(), interp.output(), ref.size()) == 0;
+    printf("nn ds-cnn 98x40: %8u cyc/inference (ref %8u), arena %u bytes, weights %u bytes, %s\n",
+           (unsigned)interp.perf().Average(), (unsigned)ref_cycles, (unsigned)arena_bytes,
+           (unsigned)weight_bytes, exact ? "bit-exact" : "MISMATCH");
+}
+
+// 2/4 麦克风：解交织 + 延迟求和波束形成，块长 120 帧 (5ms)；
+// 同时用端射方向的相干信号验证对齐后的输出能量不衰减
+void bench_mic_array(int channels) {
+    const size_t frames = 120;
+    BeamformerConfig cfg;
+    cfg.channels = channels;
+    cfg.steering_deg = 0.0f;
+    DelayAndSumBeamformer bf(cfg);
+    if (!bf.valid()) {
+        printf("beamformer %d: init failed\n", channels);
+        return;
+    }
+
+    // 构造从 0° (端射) 方向入射的 500Hz 平面波
+    const float spacing_samples = cfg.spacing_mm / 343000.0f * cfg.sample_rate;
+    const size_t total = frames * 200;
+    std::vector<int16_t> pcm(total * channels);
+    for (size_t i = 0; i < total; i++) {
+        for (int ch = 0; ch < channels; ch++) {
+            float t = (float)i + ch * spacing_samples;
+            pcm[i * channels + ch] = (int16_t)(8000.0f * sinf(2.0f * (float)M_PI * 500.0f * t / cfg.sample_rate));
+        }
+    }
+
+    std::vector<int16_t> planar(frames * channels);
+    int16_t* planes[MIC_ARRAY_MAX_CHANNELS];
+    for (int ch = 0; ch < channels; ch++) planes[ch] = planar.data() + ch * frames;
+    AudioPerfCounter deint;
+    std::vector<int16_t> out(total);
+    for (size_t pos = 0; pos < total; pos += frames) {
+        uint32_t t0 = audio_perf_cycles();
+        deinterleave_s16(pcm.data() + pos * channels, frames, channels, planes);
+        deint.Add(audio_perf_cycles() - t0);
+        bf.Process(pcm.data() + pos * channels, frames, out.data() + pos);
+    }
+
+    double in_energy = 0.0, out_energy = 0.0;
+    for (size_t i = total / 2; i < total; i++) {
+        in_energy += (double)pcm[i * channels] * pcm[i * channels];
+        out_energy += (double)out[i] * out[i];
+    }
+    // 运行中转向：提交后要到下一块才生效
+    bool queued = bf.SetSteering(90.0f) && bf.pending() && bf.steering() == 0.0f;
+    bf.Process(pcm.data(), frames, out.data());
+    bool swapped = queued && !bf.pending() && bf.steering() == 90.0f;
+
+    printf("mic x%d: deinterleave %5u cyc/5ms, beamformer %6u cyc/5ms (%.2f%% CPU), on-axis gain %.2f dB, steer swap %s\n",
+           channels, (unsigned)deint.Average(), (unsigned)bf.perf().Average(), bf.perf().LoadPercent(5000),
+           10.0 * log10(out_energy / in_energy), swapped ? "ok" : "FAIL");
+}
+
+// 预录缓冲：10 秒历史，按 5ms 一帧写入交织立体声的左声道，
+// 截取最近 5 秒分别存成 PCM 和 ADPCM，ADPCM 解码后计算信噪比
+void bench_history() {
+    const int rate = 24000;
+    AudioHistory history(rate, 10, DspMemory::PSRAM);
+    if (!history.valid()) {
+        printf("history: init failed\n");
+        return;
+    }
+
+    const size_t frames = 120;
+    std::vector<int16_t> stereo(frames * 2);
+    float phase = 0.0f;
+    uint32_t seed = 7;
+    bool early_ok = false;
+    for (int f = 0; f < 12 * rate / (int)frames; f++) {
+        if (f == rate / (int)frames) {
+            // 刚写了 1 秒：截取 5 秒时只能得到已写入的 1 秒
+            AudioClip early;
+            early_ok = history.SnapshotLast(5000, AudioClipFormat::PCM16, early) && early.samples == (uint32_t)rate;
+        }
+        for (size_t i = 0; i < frames; i++) {
+            int16_t v = (int16_t)(6000.0f * sinf(phase) + (int)(bench_rand(seed) % 512) - 256);
+            phase += 2.0f * (float)M_PI * 440.0f / rate;
+            stereo[2 * i] = v;
+            stereo[2 * i + 1] = 0;
+        }
+        history.Write(stereo.data(), frames, 2);
+    }
+
+    AudioClip pcm, adpcm;
+    bool ok = history.SnapshotLast(5000, AudioClipFormat::PCM16, pcm);
+    uint32_t pcm_cycles = history.snapshot_perf().last;
+    ok = ok && history.SnapshotLast(5000, AudioClipFormat::IMA_ADPCM, adpcm);
+    uint32_t adpcm_cycles = history.snapshot_perf().last;
+    if (!ok) {
+        printf("history: snapshot failed\n");
+        return;
+    }
+
+    const int16_t* ref = reinterpret_cast<const int16_t*>(pcm.data.data());
+    std::vector<int16_t> block(IMA_ADPCM_SAMPLES_PER_BLOCK(adpcm.block_align));
+    double sig = 0.0, err = 0.0;
+    size_t k = 0;
+    for (size_t off = 0; off < adpcm.data.size() && k < adpcm.samples; off += adpcm.block_align) {
+        size_t n = ima_adpcm_decode_block(adpcm.data.data() + off, adpcm.block_align, block.data());
+        for (size_t i = 0; i < n && k < adpcm.samples; i++, k++) {
+            double d = (double)block[i] - ref[k];
+            sig += (double)ref[k] * ref[k];
+            err += d * d;
+        }
+    }
+    printf("history: %u KB ring, write %u cyc/5ms, 5s snapshot pcm %u KB %.2f Mcyc, adpcm %u KB %.2f Mcyc (SNR %.1f dB), copy %.0f MB/s, early clip %s\n",
+           (unsigned)(history.MemoryBytes() / 1024), (unsigned)history.write_perf().Average(),
+           (unsigned)(pcm.data.size() / 1024), pcm_cycles / 1e6, (unsigned)(adpcm.data.size() / 1024),
+           adpcm_cycles / 1e6, 10.0 * log10(sig / (err + 1e-9)), history.read_bandwidth_mbps(),
+           early_ok ? "ok" : "FAIL");
+}
+
+// 漂移补偿：生产者时钟偏快/偏慢 drift_ppm，每 20ms 到一包并带最多 30ms 抖动，
+// 消费者按 5ms 读取。模拟 minutes 分钟，检查估计值和后半段的缓冲深度是否有界
+void bench_drift(float drift_ppm, int minutes) {
+    DriftConfig cfg;
+    DriftCompensator dc(cfg);
+    if (!dc.valid()) {
+        printf("drift: init failed\n");
+        return;
+    }
+    const size_t packet = 480, block = 120;
+    const double producer_rate = cfg.sample_rate * (1.0 + drift_ppm * 1e-6);
+    std::vector<int16_t> in(packet * 2), out(block * 2);
+    uint32_t seed = 11;
+    double phase = 0.0, next_arrival = 0.0;
+    uint64_t packets = 0;
+    const size_t blocks = (size_t)minutes * 60 * cfg.sample_rate / block;
+    for (size_t b = 0; b < blocks; b++) {
+        double now = (double)(b + 1) * block / cfg.sample_rate;
+        while (next_arrival <= now) {
+            for (size_t i = 0; i < packet; i++) {
+                int16_t v = (int16_t)(8000.0 * sin(phase));
+                phase += 2.0 * M_PI * 1000.0 / producer_rate;
+                in[2 * i] = in[2 * i + 1] = v;
+            }
+            dc.Write(in.data(), packet);
+            packets++;
+            double nominal = packets * packet / producer_rate;
+            next_arrival = std::max(next_arrival, nominal + (bench_rand(seed) % 30) * 1e-3);
+        }
+        dc.Read(out.data(), block);
+        if (b == blocks / 2) dc.ResetStats();
+    }
+    DriftStats st = dc.stats();
+    printf("drift %+6.0f ppm: estimate %+7.1f ppm, fill %.0f (min %u max %u, target %u), underruns %u, overruns %u, %u cyc/5ms\n",
+           drift_ppm, st.drift_ppm, st.fill_frames, (unsigned)st.fill_min, (unsigned)st.fill_max,
+           (unsigned)cfg.target_frames, (unsigned)st.underruns, (unsigned)st.overruns, (unsigned)dc.perf().Average());
+}
+
+// 流水线融合：增益 -> 偏置 -> 增益 三个 Map 阶段融合成一次遍历，
+// 对比逐阶段各遍历一次 (每阶段都饱和回 int16)，另带一个 Tap 和一个下混 Block
+void bench_pipeline() {
+    const size_t frames = 120;
+    uint64_t tap_sum = 0;
+    auto pipeline = make_audio_pipeline<frames, 2>(
+        make_tap_stage("tap", [&tap_sum](const int16_t* d, size_t n, int ch) { tap_sum += (uint16_t)d[n * ch - 1]; }),
+        GainStage::FromDb(6.0f), OffsetStage(-12), GainStage::FromDb(-3.0f), DownmixStage());
+    static_assert(decltype(pipeline)::kPassCount == 3, "three map stages should fuse into one pass");
+    static_assert(decltype(pipeline)::kOutChannels == 1, "downmix output is mono");
+
+    std::vector<int16_t> src(frames * 2), fused(frames * 2), ref(frames * 2);
+    uint32_t seed = 5;
+    for (auto& v : src) v = (int16_t)((int32_t)(bench_rand(seed) >> 16) - 32768) / 4;
+
+    const GainStage g1 = GainStage::FromDb(6.0f), g2 = GainStage::FromDb(-3.0f);
+    const OffsetStage off(-12);
+    auto saturate = [](int32_t v) { return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v)); };
+    AudioPerfCounter unfused;
+    bool match = true;
+    for (int iter = 0; iter < 2000; iter++) {
+        fused = src;
+        size_t out = pipeline.Process(fused.data(), frames);
+
+        ref = src;
+        uint32_t t0 = audio_perf_cycles();
+        for (auto& v : ref) v = saturate(g1.Sample(v));
+        for (auto& v : ref) v = saturate(off.Sample(v));
+        for (auto& v : ref) v = saturate(g2.Sample(v));
+        unfused.Add(audio_perf_cycles() - t0);
+        // 中间不饱和时两者一致 (这里的输入幅度不会在中间级削波)
+        for (size_t i = 0; i < frames && iter == 0; i++) {
+            int16_t mono = (int16_t)(((int32_t)ref[2 * i] + ref[2 * i + 1]) >> 1);
+            match = match && out == frames && fused[i] == mono;
+        }
+    }
+    printf("pipeline: %u passes for %u stages, fused map group %u cyc vs %u cyc unfused (%s)",
+           (unsigned)decltype(pipeline)::kPassCount, (unsigned)decltype(pipeline)::kStageCount,
+           (unsigned)pipeline.perf(1).Average(), (unsigned)unfused.Average(), match ? "match" : "MISMATCH");
+    for (size_t i = 0; i < decltype(pipeline)::kStageCount; i++) {
+        if (!pipeline.fused(i)) printf(" | %s %u", pipeline.name(i), (unsigned)pipeline.perf(i).Average());
+    }
+    printf("\n");
+}
+
+// 单频点 DFT 组与 FFT 的开销对比：每 20ms 块 (480 点) 检测 bins 个频点，
+// FFT 方案为 int16 转浮点 + 512 点实数 FFT + 功率谱；另检查检测和去抖结果
+void bench_tones(size_t bins) {
+    static const float kFreqs[] = {440.0f, 523.0f, 660.0f, 784.0f, 880.0f, 960.0f, 1047.0f, 1400.0f,
+                                   1568.0f, 1760.0f, 2093.0f, 2400.0f, 2637.0f, 3136.0f, 3520.0f, 4186.0f};
+    std::vector<ToneTarget> targets;
+    for (size_t i = 0; i < bins; i++) targets.push_back({"tone", kFreqs[i]});
+    ToneDetectorConfig cfg;
+    ToneDetector det(targets.data(), targets.size(), cfg);
+    DspFft fft(512);
+    DspBuffer<float> frame(512, DspMemory::INTERNAL), spec(512, DspMemory::INTERNAL), power(257, DspMemory::INTERNAL);
+    if (!det.valid() || !fft.valid() || !frame.data() || !spec.data() || !power.data()) {
+        printf("tones x%u: init failed\n", (unsigned)bins);
+        return;
+    }
+
+    // 1 秒 960Hz (-20dBFS) 叠加 -40dBFS 噪声，之后 1 秒只有噪声
+    const size_t block = cfg.block_size;
+    std::vector<int16_t> in(cfg.sample_rate * 2);
+    uint32_t seed = 9;
+    for (size_t i = 0; i < in.size(); i++) {
+        float noise = ((int32_t)(bench_rand(seed) >> 16) - 32768) * 0.01f;
+        float tone = i < (size_t)cfg.sample_rate ? 3277.0f * sinf(2.0f * (float)M_PI * 960.0f * i / cfg.sample_rate) : 0.0f;
+        in[i] = (int16_t)(tone + noise);
+    }
+    int events = 0;
+    const char* which = "-";
+    det.SetEventCallback([&](const ToneTarget& t, float) {
+        events++;
+        which = t.freq_hz == 960.0f ? "960Hz" : "wrong bin";
+    });
+
+    AudioPerfCounter bank, fft_cost;
+    for (size_t pos = 0; pos + block <= in.size(); pos += block) {
+        det.Push(in.data() + pos, block);
+
+        uint32_t t0 = audio_perf_cycles();
+        for (size_t i = 0; i < block; i++) frame[i] = in[pos + i];
+        memset(frame.data() + block, 0, (512 - block) * sizeof(float));
+        fft.Forward(frame.data(), spec.data());
+        fft.PowerSpectrum(spec.data(), power.data());
+        fft_cost.Add(audio_perf_cycles() - t0);
+    }
+    bank = det.perf();
+    printf("tones x%-2u: bins %6u cyc/20ms vs rfft512 %6u cyc/20ms (%.2f%% vs %.2f%% CPU), %d event(s) %s\n",
+           (unsigned)bins, (unsigned)bank.Average(), (unsigned)fft_cost.Average(),
+           bank.LoadPercent(20000), fft_cost.LoadPercent(20000), events, which);
+}
+
+// 二阶节级联：立体声 5ms 块，每节都用同一组峰值滤波器系数；
+// 对照双精度直接 I 型计算输出 SNR，中途提交一次新系数检查切换是否平滑
+void bench_biquad(size_t sections) {
+    const int rate = 24000;
+    const size_t frames = 120;
+    const double w0 = 2.0 * M_PI * 1000.0 / rate, alpha = sin(w0) / (2.0 * 1.0), a = pow(10.0, -3.0 / 40.0);
+    const double a0 = 1.0 + alpha / a;
+    const double ref[5] = {(1.0 + alpha * a) / a0, -2.0 * cos(w0) / a0, (1.0 - alpha * a) / a0,
+                           -2.0 * cos(w0) / a0, (1.0 - alpha / a) / a0};
+    BiquadCoeffs c;
+    int32_t* q[5] = {&c.b0, &c.b1, &c.b2, &c.a1, &c.a2};
+    for (int i = 0; i < 5; i++) *q[i] = (int32_t)lrint(ref[i] * (1 << BIQUAD_COEFF_FRAC_BITS));
+    std::vector<BiquadCoeffs> bank(sections, c);
+
+    BiquadCascade eq(2);
+    eq.SetCoefficients(bank.data(), bank.size());
+    std::vector<int16_t> in(frames * 2), out(frames * 2);
+    std::vector<double> st(sections * 2 * 4, 0.0);
+    uint32_t seed = 3;
+    double sig = 0.0, err = 0.0;
+    for (int it = 0; it < kBenchIterations * 4; it++) {
+        for (auto& v : in) v = (int16_t)(((int32_t)(bench_rand(seed) >> 16) - 32768) / 8);
+        out = in;
+        eq.Process(out.data(), frames);
+        for (size_t i = 0; i < frames * 2; i++) {
+            double x = in[i];
+            for (size_t s = 0; s < sections; s++) {
+                double* h = &st[(s * 2 + (i & 1)) * 4];
+                double y = ref[0] * x + ref[1] * h[0] + ref[2] * h[1] - ref[3] * h[2] - ref[4] * h[3];
+                h[1] = h[0]; h[0] = x; h[3] = h[2]; h[2] = y;
+                x = y;
+            }
+            sig += x * x;
+            err += (x - out[i]) * (x - out[i]);
+        }
+    }
+    const float per_sample = (float)eq.perf().Average() / (frames * 2);
+
+    // 运行中减少一节再加回来：切换那一块 (和紧接着的一块) 单独统计最大跳变，
+    // 连同与上一块最后一个样本之间的跳变；之后稳定下来的块另外统计
+    int swap_step = 0, max_step = 0;
+    int16_t last = 0;
+    for (auto& v : in) v = 1000;
+    for (int it = 0; it < 40; it++) {
+        if (it == 10) eq.SetCoefficients(bank.data(), bank.size() - 1);
+        if (it == 20) eq.SetCoefficients(bank.data(), bank.size());
+        out = in;
+        eq.Process(out.data(), frames);
+        int step = it > 0 ? abs(out[0] - last) : 0;
+        for (size_t i = 2; i < frames * 2; i += 2) step = std::max(step, abs(out[i] - out[i - 2]));
+        last = out[frames * 2 - 2];
+        if (it == 10 || it == 11 || it == 20 || it == 21) {
+            swap_step = std::max(swap_step, step);
+        } else if (it > 30) {
+            max_step = std::max(max_step, step);
+        }
+    }
+    printf("biquad x%-2u: %5.1f cyc/sample, %4.1f%% CPU stereo @24k, SNR vs double %.1f dB, "
+           "swap step %d, settled step %d\n",
+           (unsigned)sections, per_sample, per_sample * rate * 2 * 100.0f / AUDIO_PERF_CPU_HZ,
+           10.0 * log10(sig / (err + 1e-9)), swap_step, max_step);
+}
+
+// 响度归一化：合成 8 段 4 秒的"语音" (谐波 + 音节包络 + 停顿)，电平和峰均比各不相同，
+// 逐段 Reset 后处理，比较处理前后综合响度的分布范围和 CPU 开销
+void bench_loudness() {
+    const int rate = 24000;
+    const size_t frames = 120;
+    const float levels_db[] = {-32.0f, -28.0f, -24.0f, -20.0f, -16.0f, -12.0f, -8.0f, -4.0f};
+    LoudnessProcessor proc(rate, 2);
+    std::vector<int16_t> clip(rate * 4 * 2);
+    float in_min = INFINITY, in_max = -INFINITY, out_min = INFINITY, out_max = -INFINITY;
+    int clipped = 0;
+    uint32_t seed = 21;
+
+    for (size_t k = 0; k < sizeof(levels_db) / sizeof(levels_db[0]); k++) {
+        const float f0 = 110.0f + 15.0f * k;
+        const float amp = 32767.0f * powf(10.0f, levels_db[k] / 20.0f);
+        const float harmonics = 3.0f + (k % 4) * 3.0f;   // 谐波数不同，峰均比不同
+        for (size_t i = 0; i < clip.size() / 2; i++) {
+            const float t = (float)i / rate;
+            float env = fmaxf(0.0f, sinf(2.0f * (float)M_PI * 3.5f * t));    // 音节
+            if (fmodf(t, 1.5f) > 1.2f) env = 0.0f;                          // 停顿
+            float v = 0.0f;
+            for (int h = 1; h <= (int)harmonics; h++) {
+                v += sinf(2.0f * (float)M_PI * f0 * h * t) / h;
+            }
+            v = v * env * amp / 2.0f + ((int32_t)(bench_rand(seed) >> 16) - 32768) * 0.002f;
+            v = fminf(32767.0f, fmaxf(-32768.0f, v));
+            clip[2 * i] = clip[2 * i + 1] = (int16_t)v;
+        }
+
+        LoudnessMeter in_meter(rate, 2), out_meter(rate, 2);
+        in_meter.Push(clip.data(), clip.size());
+        proc.Reset();
+        for (size_t pos = 0; pos < clip.size(); pos += frames * 2) {
+            proc.Process(clip.data() + pos, frames * 2);
+        }
+        out_meter.Push(clip.data(), clip.size());
+        for (int16_t v : clip) clipped += (v == 32767 || v == -32768);
+
+        in_min = fminf(in_min, in_meter.integrated_lufs());
+        in_max = fmaxf(in_max, in_meter.integrated_lufs());
+        out_min = fminf(out_min, out_meter.integrated_lufs());
+        out_max = fmaxf(out_max, out_meter.integrated_lufs());
+    }
+    printf("loudness: input %.1f..%.1f LUFS (spread %.1f LU) -> output %.1f..%.1f LUFS (spread %.1f LU), "
+           "%u cyc/5ms avg, %u max (%.2f%% CPU), %d clipped samples\n",
+           in_min, in_max, in_max - in_min, out_min, out_max, out_max - out_min,
+           (unsigned)proc.perf().Average(), (unsigned)proc.perf().max, proc.perf().LoadPercent(5000), clipped);
+}
+
+// 呼吸频率估计：90 秒合成的呼吸气流声 (白噪声按 15 次/分钟的节律调幅，叠加底噪)，
+// 按采集通路的方式以 5ms 立体声块、stride 2 送入，统计每块的开销和最后报告的频率。
+// 每 20 秒模拟一次 AGC 的 PGA 步进 (输入 +6dB / -6dB 交替)，并通过 SetInputGain() 告知
+void bench_breathing() {
+    const int rate = 24000;
+    const size_t frames = 120;
+    const float bpm = 15.0f;
+    BreathingEstimator est;
+    std::vector<int16_t> block(frames * 2);
+    uint32_t seed = 30;
+    int reports = 0;
+    est.SetRateCallback([&reports](int, float) { reports++; });
+
+    for (size_t pos = 0; pos < (size_t)rate * 90; pos += frames) {
+        const float pga_db = (pos / ((size_t)rate * 20)) % 2 ? 6.0f : 0.0f;
+        const float pga = powf(10.0f, pga_db / 20.0f);
+        for (size_t i = 0; i < frames; i++) {
+            const float t = (float)(pos + i) / rate;
+            const float breath = fmaxf(0.0f, sinf(2.0f * (float)M_PI * bpm / 60.0f * t));
+            const float noise = (float)((int32_t)(bench_rand(seed) >> 16) - 32768);
+            block[2 * i] = block[2 * i + 1] = (int16_t)(pga * noise * (0.1f * breath * breath + 0.01f));
+        }
+        est.SetInputGain(pga_db);
+        est.Push(block.data(), block.size(), 2);
+    }
+    printf("breathing: %u cyc/5ms avg, %u max (%.3f%% CPU), %d report(s), last %d bpm (true %.0f, confidence %.2f)\n",
+           (unsigned)est.perf().Average(), (unsigned)est.perf().max, est.perf().LoadPercent(5000), reports,
+           est.breaths_per_minute(), bpm, est.confidence());
+}
+
+} // namespace
+
+void dsp_bench_run() {
+    printf("==== DSP engine benchmark (%d iterations) ====\n", kBenchIterations);
+    for (size_t n = 64; n <= DSP_FFT_MAX_SIZE; n <<= 1) {
+        bench_fft(n);
+    }
+    bench_overlap_add(512, 256, DspMemory::INTERNAL);
+    bench_overlap_add(512, 256, DspMemory::PSRAM);
+    bench_overlap_add(512, 128, DspMemory::PSRAM);
+    bench_mel(0);
+    bench_mel(13);
+    bench_nn();
+    bench_mic_array(2);
+    bench_mic_array(4);
+    bench_history();
+    bench_drift(300.0f, 10);
+    bench_drift(-500.0f, 10);
+    bench_pipeline();
+    bench_tones(2);
+    bench_tones(6);
+    bench_tones(16);
+    for (size_t sections = 4; sections <= 10; sections += 2) {
+        bench_biquad(sections);
+    }
+    bench_loudness();
+    bench_breathing();
+}
+
+#ifdef DSP_BENCH_MAIN
+int main() {
+    dsp_bench_run();
+    return 0;
+}
+#endif
@@ -0,0 +1,338 @@
+#include "dsp_engine.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+#if DSP_USE_ESP_DSP
+#include "dsps_biquad.h"
+#include "dsps_dotprod.h"
+#endif
+
+// ======== 编译期旋转因子表 ========
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// 泰勒级数，角度范围 [0, pi]，25 项在 double 下误差远小于 float 精度
+constexpr double const_sin(double x) {
+    double term = x, sum = x;
+    for (int n = 1; n < 25; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double const_cos(double x) {
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 25; n++) {
+        term *= -x * x / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+// W^k = exp(-2*pi*i*k/N)，交织存放 [cos, -sin]
+struct TwiddleTable {
+    float w[DSP_FFT_MAX_SIZE];
+};
+
+constexpr TwiddleTable make_twiddles() {
+    TwiddleTable t{};
+    for (int k = 0; k < DSP_FFT_MAX_SIZE / 2; k++) {
+        double a = 2.0 * kPi * k / DSP_FFT_MAX_SIZE;
+        t.w[2 * k] = (float)const_cos(a);
+        t.w[2 * k + 1] = (float)-const_sin(a);
+    }
+    return t;
+}
+
+DSP_HOT_DATA constexpr TwiddleTable kTwiddles = make_twiddles();
+
+static_assert((DSP_FFT_MAX_SIZE & (DSP_FFT_MAX_SIZE - 1)) == 0, "DSP_FFT_MAX_SIZE must be a power of two");
+
+bool is_pow2(size_t n) {
+    return n && (n & (n - 1)) == 0;
+}
+
+} // namespace
+
+// ======== 内存放置 ========
+
+void* dsp_alloc(size_t bytes, DspMemory where) {
+    if (bytes == 0) return nullptr;
+#ifdef ESP_PLATFORM
+    void* p = nullptr;
+    if (where == DspMemory::PSRAM) {
+        p = heap_caps_aligned_alloc(16, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (!p) {
+        p = heap_caps_aligned_alloc(16, bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    return p;
+#else
+    (void)where;
+    return aligned_alloc(16, (bytes + 15) & ~(size_t)15);
+#endif
+}
+
+void dsp_free(void* ptr) {
+#ifdef ESP_PLATFORM
+    heap_caps_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+// ======== 向量内核 ========
+
+float dsp_dotprod_f32(const float* a, const float* b, size_t n) {
+#if DSP_USE_ESP_DSP
+    float dest = 0.0f;
+    dsps_dotprod_f32(a, b, &dest, (int)n);
+    return dest;
+#else
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; i++) {
+        s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+#endif
+}
+
+void dsp_biquad_f32(const float* in, float* out, size_t n, const float* coef, float* w) {
+#if DSP_USE_ESP_DSP
+    dsps_biquad_f32(in, out, (int)n, const_cast<float*>(coef), w);
+#else
+    const float b0 = coef[0], b1 = coef[1], b2 = coef[2], a1 = coef[3], a2 = coef[4];
+    float w1 = w[0], w2 = w[1];
+    for (size_t i = 0; i < n; i++) {
+        const float w0 = in[i] - a1 * w1 - a2 * w2;
+        out[i] = b0 * w0 + b1 * w1 + b2 * w2;
+        w2 = w1;
+        w1 = w0;
+    }
+    w[0] = w1;
+    w[1] = w2;
+#endif
+}
+
+// ======== 实数 FFT ========
+
+DspFft::DspFft(size_t n) {
+    if (!is_pow2(n) || n < DSP_FFT_MIN_SIZE || n > DSP_FFT_MAX_SIZE) {
+        return;
+    }
+    n_ = n;
+    half_ = n / 2;
+    stride_ = DSP_FFT_MAX_SIZE / n;
+}
+
+void DspFft::ComplexFft(float* data, bool inverse) const {
+    const size_t m = half_;
+
+    // 位反转重排
+    for (size_t i = 1, j = 0; i < m; i++) {
+        size_t bit = m >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j |= bit;
+        if (i < j) {
+            float tr = data[2 * i], ti = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = tr;
+            data[2 * j + 1] = ti;
+        }
+    }
+
+    // 基 2 蝶形。m 点复数 FFT 需要 exp(-2*pi*i*k/m)，在表中的步长为 2 * stride_
+    const float sign = inverse ? -1.0f : 1.0f;
+    for (size_t len = 2; len <= m; len <<= 1) {
+        const size_t half_len = len >> 1;
+        const size_t step = (m / len) * 2 * stride_;
+        for (size_t base = 0; base < m; base += len) {
+            float* a = data + 2 * base;
+            float* b = a + 2 * half_len;
+            for (size_t k = 0; k < half_len; k++) {
+                float wr = kTwiddles.w[2 * k * step];
+                float wi = sign * kTwiddles.w[2 * k * step + 1];
+                float br = b[2 * k], bi = b[2 * k + 1];
+                float tr = br * wr - bi * wi;
+                float ti = br * wi + bi * wr;
+                float ar = a[2 * k], ai = a[2 * k + 1];
+                a[2 * k] = ar + tr;
+                a[2 * k + 1] = ai + ti;
+                b[2 * k] = ar - tr;
+                b[2 * k + 1] = ai - ti;
+            }
+        }
+    }
+}
+
+void DspFft::Forward(const float* in, float* out) const {
+    if (!n_) return;
+    if (out != in) memcpy(out, in, n_ * sizeof(float));
+
+    // 把实数序列看作 N/2 个复数 z[n] = x[2n] + i*x[2n+1]
+    ComplexFft(out, false);
+
+    const size_t m = half_;
+    // k = 0 与 k = N/2
+    float z0r = out[0], z0i = out[1];
+    out[0] = z0r + z0i;
+    out[1] = z0r - z0i;
+
+    // X[k] = E + W^k * O,  X[m-k] = conj(E - W^k * O)
+    for (size_t k = 1; k < m / 2; k++) {
+        float* zk = out + 2 * k;
+        float* zm = out + 2 * (m - k);
+        float er = 0.5f * (zk[0] + zm[0]);
+        float ei = 0.5f * (zk[1] - zm[1]);
+        float or_ = 0.5f * (zk[1] + zm[1]);
+        float oi = -0.5f * (zk[0] - zm[0]);
+        float wr = kTwiddles.w[2 * k * stride_];
+        float wi = kTwiddles.w[2 * k * stride_ + 1];
+        float tr = or_ * wr - oi * wi;
+        float ti = or_ * wi + oi * wr;
+        zk[0] = er + tr;
+        zk[1] = ei + ti;
+        zm[0] = er - tr;
+        zm[1] = -(ei - ti);
+    }
+    // k = N/4: X = conj(Z)
+    if (m >= 2) {
+        out[2 * (m / 2) + 1] = -out[2 * (m / 2) + 1];
+    }
+}
+
+void DspFft::Inverse(const float* in, float* out) const {
+    if (!n_) return;
+    if (out != in) memcpy(out, in, n_ * sizeof(float));
+
+    const size_t m = half_;
+    float x0 = out[0], xm = out[1];
+    out[0] = 0.5f * (x0 + xm);
+    out[1] = 0.5f * (x0 - xm);
+
+    // E = (X[k] + conj(X[m-k]))/2, W^k*O = (X[k] - conj(X[m-k]))/2, Z[k] = E + i*O
+    for (size_t k = 1; k < m / 2; k++) {
+        float* xk = out + 2 * k;
+        float* xj = out + 2 * (m - k);
+        float er = 0.5f * (xk[0] + xj[0]);
+        float ei = 0.5f * (xk[1] - xj[1]);
+        float dr = 0.5f * (xk[0] - xj[0]);
+        float di = 0.5f * (xk[1] + xj[1]);
+        // O = conj(W^k) * D
+        float wr = kTwiddles.w[2 * k * stride_];
+        float wi = -kTwiddles.w[2 * k * stride_ + 1];
+        float or_ = dr * wr - di * wi;
+        float oi = dr * wi + di * wr;
+        // Z[k] = E + i*O,  Z[m-k] = conj(E) + i*conj(O)
+        xk[0] = er - oi;
+        xk[1] = ei + or_;
+        xj[0] = er + oi;
+        xj[1] = -ei + or_;
+    }
+    if (m >= 2) {
+        out[2 * (m / 2) + 1] = -out[2 * (m / 2) + 1];
+    }
+
+    ComplexFft(out, true);
+
+    const float scale = 1.0f / (float)m;
+    for (size_t i = 0; i < n_; i++) {
+        out[i] *= scale;
+    }
+}
+
+void DspFft::PowerSpectrum(const float* spec, float* power) const {
+    if (!n_) return;
+    power[0] = spec[0] * spec[0];
+    power[half_] = spec[1] * spec[1];
+    for (size_t k = 1; k < half_; k++) {
+        float re = spec[2 * k], im = spec[2 * k + 1];
+        power[k] = re * re + im * im;
+    }
+}
+
+// ======== 加窗重叠相加分帧 ========
+
+OverlapAdd::OverlapAdd(size_t frame_size, size_t hop_size, DspMemory history_mem)
+    : frame_(frame_size), hop_(hop_size) {
+    if (frame_ == 0 || hop_ == 0 || hop_ > frame_ || frame_ % hop_ != 0) {
+        return;
+    }
+    if (!history_.Allocate(frame_, history_mem) ||
+        !frame_buf_.Allocate(frame_, DspMemory::INTERNAL) ||
+        !overlap_.Allocate(frame_, DspMemory::INTERNAL) ||
+        !window_.Allocate(frame_, DspMemory::INTERNAL)) {
+        window_.Allocate(0, DspMemory::INTERNAL);
+        return;
+    }
+
+    // 周期 Hann 在 hop 处的重叠和为 frame/(2*hop)，分析、合成各取平方根
+    const float norm = 2.0f * (float)hop_ / (float)frame_;
+    for (size_t i = 0; i < frame_; i++) {
+        float hann = 0.5f - 0.5f * cosf(2.0f * (float)kPi * i / frame_);
+        window_[i] = sqrtf(hann * norm);
+    }
+}
+
+void OverlapAdd::Reset() {
+    if (!valid()) return;
+    memset(history_.data(), 0, frame_ * sizeof(float));
+    memset(overlap_.data(), 0, frame_ * sizeof(float));
+}
+
+const float* OverlapAdd::Analyze(const float* hop_in) {
+    if (!valid()) return nullptr;
+    float* h = history_.data();
+    memmove(h, h + hop_, (frame_ - hop_) * sizeof(float));
+    memcpy(h + frame_ - hop_, hop_in, hop_ * sizeof(float));
+    const float* w = window_.data();
+    float* f = frame_buf_.data();
+    for (size_t i = 0; i < frame_; i++) {
+        f[i] = h[i] * w[i];
+    }
+    return f;
+}
+
+const float* OverlapAdd::Analyze(const int16_t* hop_in) {
+    if (!valid()) return nullptr;
+    float* h = history_.data();
+    memmove(h, h + hop_, (frame_ - hop_) * sizeof(float));
+    float* dst = h + frame_ - hop_;
+    for (size_t i = 0; i < hop_; i++) {
+        dst[i] = (float)hop_in[i];
+    }
+    const float* w = window_.data();
+    float* f = frame_buf_.data();
+    for (size_t i = 0; i < frame_; i++) {
+        f[i] = h[i] * w[i];
+    }
+    return f;
+}
+
+void OverlapAdd::Synthesize(const float* frame_in, float* hop_out) {
+    if (!valid()) return;
+    float* o = overlap_.data();
+    const float* w = window_.data();
+    for (size_t i = 0; i < frame_; i++) {
+        o[i] += frame_in[i] * w[i];
+    }
+    memcpy(hop_out, o, hop_ * sizeof(float));
+    memmove(o, o + hop_, (frame_ - hop_) * sizeof(float));
+    memset(o + frame_ - hop_, 0, hop_ * sizeof(float));
+}
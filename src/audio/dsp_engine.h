@@ -0,0 +1,181 @@
+#ifndef DSP_ENGINE_H
+#define DSP_ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 各个频域处理阶段 (AEC、降噪、频谱特征) 共用的 FFT 引擎。
+// 只依赖标准库和 esp_heap_caps，可以在主机上编译做基准测试。
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#include "sdkconfig.h"
+// 热数据 (旋转因子、工作缓冲) 放内部 SRAM，不经过 flash/PSRAM cache
+#define DSP_HOT_DATA DRAM_ATTR
+#else
+#define DSP_HOT_DATA
+#endif
+
+// ESP32-S3 上向量内核调用 esp-dsp (选用 PIE 汇编的 *_aes3 版本)，其他平台 (包括主机) 编译同样语义的 C 实现
+#if defined(ESP_PLATFORM) && defined(CONFIG_IDF_TARGET_ESP32S3)
+#define DSP_USE_ESP_DSP 1
+#else
+#define DSP_USE_ESP_DSP 0
+#endif
+
+// 支持的最大 FFT 点数，旋转因子表按此大小在编译期生成 (DSP_FFT_MAX_SIZE / 2 个复数)
+#define DSP_FFT_MAX_SIZE 2048
+#define DSP_FFT_MIN_SIZE 8
+
+// ======== 内存放置 ========
+
+enum class DspMemory {
+    INTERNAL,   // 内部 SRAM：每帧都要访问的热数据
+    PSRAM,      // 外部 PSRAM：长历史缓冲；没有 PSRAM 时回退到内部 SRAM
+};
+
+/**
+ * @brief 按指定位置分配 16 字节对齐的内存
+ * @return 失败返回 nullptr
+ */
+void* dsp_alloc(size_t bytes, DspMemory where);
+void dsp_free(void* ptr);
+
+// 简单的 RAII 缓冲区，只负责分配和释放
+template <typename T>
+class DspBuffer {
+public:
+    DspBuffer() = default;
+    DspBuffer(size_t count, DspMemory where) { Allocate(count, where); }
+    ~DspBuffer() { dsp_free(data_); }
+    DspBuffer(const DspBuffer&) = delete;
+    DspBuffer& operator=(const DspBuffer&) = delete;
+
+    bool Allocate(size_t count, DspMemory where) {
+        dsp_free(data_);
+        data_ = static_cast<T*>(dsp_alloc(count * sizeof(T), where));
+        size_ = data_ ? count : 0;
+        for (size_t i = 0; i < size_; i++) data_[i] = T();
+        return data_ != nullptr;
+    }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// ======== 向量内核 ========
+// 缓冲 16 字节对齐 (DspBuffer) 时 esp-dsp 走 PIE 路径
+
+/**
+ * @brief 点积 Σ a[i] * b[i] (dsps_dotprod_f32)
+ */
+float dsp_dotprod_f32(const float* a, const float* b, size_t n);
+
+/**
+ * @brief 一个直接 II 型二阶节 (dsps_biquad_f32)，in 和 out 不能相同
+ * @param coef {b0, b1, b2, a1, a2}，已按 a0 归一化
+ * @param w    状态 {w[n-1], w[n-2]}，w[n] = x[n] - a1 w[n-1] - a2 w[n-2]
+ */
+void dsp_biquad_f32(const float* in, float* out, size_t n, const float* coef, float* w);
+
+// ======== 实数 FFT ========
+
+/**
+ * @brief 2 的幂点数的实数 FFT / IFFT
+ *
+ * 内部用 N/2 点复数 FFT 加一次拆分实现。频谱采用打包格式 (N 个 float)：
+ *   spec[0] = X[0] (直流, 实数)
+ *   spec[1] = X[N/2] (奈奎斯特, 实数)
+ *   spec[2k], spec[2k+1] = Re/Im X[k]，k = 1 .. N/2-1
+ * 对象本身不持有缓冲区，可以在多个任务间共享 (只读)。
+ */
+class DspFft {
+public:
+    explicit DspFft(size_t n);
+
+    bool valid() const { return n_ != 0; }
+    size_t size() const { return n_; }
+
+    /**
+     * @brief 正变换，out 可以与 in 相同 (原地)
+     */
+    void Forward(const float* in, float* out) const;
+
+    /**
+     * @brief 逆变换，包含 1/N 归一化，Inverse(Forward(x)) == x。out 可以与 in 相同
+     */
+    void Inverse(const float* in, float* out) const;
+
+    /**
+     * @brief 由打包频谱计算功率谱 |X[k]|^2，输出 N/2+1 个值
+     */
+    void PowerSpectrum(const float* spec, float* power) const;
+
+private:
+    void ComplexFft(float* data, bool inverse) const;
+
+    size_t n_ = 0;
+    size_t half_ = 0;
+    size_t stride_ = 0;   // 本尺寸在全局旋转因子表中的步长
+};
+
+// ======== 加窗重叠相加分帧 ========
+
+/**
+ * @brief 加权重叠相加 (WOLA) 分帧辅助
+ *
+ * 分析窗和合成窗都是归一化的 sqrt-Hann，hop 为 frame/2 或 frame/4 时可以完美重构。
+ * 输入历史可以放在 PSRAM，当前帧放在内部 SRAM。
+ */
+class OverlapAdd {
+public:
+    OverlapAdd(size_t frame_size, size_t hop_size, DspMemory history_mem = DspMemory::INTERNAL);
+
+    bool valid() const { return window_.data() != nullptr; }
+    size_t frame_size() const { return frame_; }
+    size_t hop_size() const { return hop_; }
+
+    /**
+     * @brief 送入 hop 个新样本，返回加窗后的分析帧 (frame 个样本，内部缓冲)
+     */
+    const float* Analyze(const float* hop_in);
+    const float* Analyze(const int16_t* hop_in);
+
+    /**
+     * @brief 送入处理后的时域帧，加合成窗后叠加，输出 hop 个完成的样本
+     */
+    void Synthesize(const float* frame_in, float* hop_out);
+
+    void Reset();
+
+private:
+    size_t frame_;
+    size_t hop_;
+    DspBuffer<float> window_;
+    DspBuffer<float> history_;   // 最近 frame 个输入样本
+    DspBuffer<float> frame_buf_; // 加窗后的分析帧
+    DspBuffer<float> overlap_;   // 合成叠加缓冲
+};
+
+// ======== 基准测试 ========
+
+/**
+ * @brief 运行 DSP 引擎基准测试并打印结果 (周期数、往返误差)
+ *
+ * 设备上由 AUDIO_DSP_BENCHMARK 开关在启动时调用；主机上可以单独编译：
+ *   g++ -O2 -std=gnu++17 -DDSP_BENCH_MAIN src/audio/dsp_engine.cpp src/audio/dsp_bench.cpp \
+ *       src/audio/mel_features.cpp src/audio/nn_int8.cpp src/audio/mic_array_dsp.cpp \
+ *       src/audio/adpcm.cpp src/audio/audio_history.cpp src/audio/drift_compensator.cpp \
+ *       src/audio/tone_detector.cpp src/audio/biquad_eq.cpp \
+ *       src/audio/loudness.cpp src/audio/breathing_estimator.cpp
+ */
+void dsp_bench_run();
+
+#endif // DSP_ENGINE_H
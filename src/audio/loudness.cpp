@@ -0,0 +1,275 @@
+#include "loudness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static inline float db_to_linear(float db) {
+    return powf(10.0f, db / 20.0f);
+}
+
+// 绝对值峰值 (esp-dsp 没有对应内核)，4 个独立的 max 链互不等待
+static float peak_abs_f32(const float* x, size_t n) {
+    float m0 = 0, m1 = 0, m2 = 0, m3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        m0 = std::max(m0, fabsf(x[i]));
+        m1 = std::max(m1, fabsf(x[i + 1]));
+        m2 = std::max(m2, fabsf(x[i + 2]));
+        m3 = std::max(m3, fabsf(x[i + 3]));
+    }
+    for (; i < n; i++) {
+        m0 = std::max(m0, fabsf(x[i]));
+    }
+    return std::max(std::max(m0, m1), std::max(m2, m3));
+}
+
+static inline int16_t saturate_s16(float v) {
+    if (v >= 32767.0f) return 32767;
+    if (v <= -32768.0f) return -32768;
+    return (int16_t)lrintf(v);
+}
+
+static inline float energy_to_lufs(float e) {
+    return e > 0.0f ? -0.691f + 10.0f * log10f(e) : -INFINITY;
+}
+
+// ======== LoudnessMeter ========
+
+LoudnessMeter::LoudnessMeter(int sample_rate, int channels) : channels_(channels > 0 ? channels : 1) {
+    // K 计权的两节 (BS.1770 在 48kHz 下给出的系数，这里按 RBJ 公式在实际采样率下重新设计)
+    const double fs = sample_rate;
+    {
+        // 高搁架 +4dB @ 1500Hz，模拟头部的声学效应
+        const double a = pow(10.0, 4.0 / 40.0), w0 = 2.0 * M_PI * 1500.0 / fs;
+        const double cw = cos(w0), alpha = sin(w0) / 2.0 * sqrt(2.0), sa = 2.0 * sqrt(a) * alpha;
+        const double a0 = (a + 1) - (a - 1) * cw + sa;
+        kw_[0][0] = (float)(a * ((a + 1) + (a - 1) * cw + sa) / a0);
+        kw_[0][1] = (float)(-2 * a * ((a - 1) + (a + 1) * cw) / a0);
+        kw_[0][2] = (float)(a * ((a + 1) + (a - 1) * cw - sa) / a0);
+        kw_[0][3] = (float)(2 * ((a - 1) - (a + 1) * cw) / a0);
+        kw_[0][4] = (float)(((a + 1) - (a - 1) * cw - sa) / a0);
+    }
+    {
+        // 高通 38Hz，Q = 0.5
+        const double w0 = 2.0 * M_PI * 38.0 / fs, cw = cos(w0), alpha = sin(w0) / (2.0 * 0.5);
+        const double a0 = 1 + alpha;
+        kw_[1][0] = (float)((1 + cw) / 2 / a0);
+        kw_[1][1] = (float)(-(1 + cw) / a0);
+        kw_[1][2] = (float)((1 + cw) / 2 / a0);
+        kw_[1][3] = (float)(-2 * cw / a0);
+        kw_[1][4] = (float)((1 - alpha) / a0);
+    }
+    z_.assign(channels_ * 4, 0.0f);
+    sub_len_ = (size_t)std::max(1, sample_rate / 10);
+    Reset();
+}
+
+void LoudnessMeter::Reset() {
+    std::fill(z_.begin(), z_.end(), 0.0f);
+    sub_pos_ = 0;
+    sub_energy_ = 0.0f;
+    blocks_ = 0;
+    memset(ring_, 0, sizeof(ring_));
+    memset(hist_count_, 0, sizeof(hist_count_));
+    memset(hist_energy_, 0, sizeof(hist_energy_));
+}
+
+void LoudnessMeter::Push(const int16_t* samples, size_t count) {
+    const size_t frames = count / channels_;
+    size_t f = 0;
+    while (f < frames) {
+        const size_t n = std::min(std::min(frames - f, sub_len_ - sub_pos_), kChunk);
+        // 按声道拆成 float，两节滤波各跑一遍整段，能量用点积累计
+        for (int c = 0; c < channels_; c++) {
+            const int16_t* x = samples + f * channels_ + c;
+            for (size_t i = 0; i < n; i++) {
+                buf_[0][i] = x[i * channels_] * (1.0f / 32768.0f);
+            }
+            float* z = &z_[c * 4];
+            dsp_biquad_f32(buf_[0], buf_[1], n, kw_[0], z);
+            dsp_biquad_f32(buf_[1], buf_[0], n, kw_[1], z + 2);
+            sub_energy_ += dsp_dotprod_f32(buf_[0], buf_[0], n);
+        }
+        f += n;
+        sub_pos_ += n;
+
+        if (sub_pos_ == sub_len_) {
+            ring_[blocks_ % kRing] = sub_energy_ / (float)sub_len_;
+            blocks_++;
+            sub_pos_ = 0;
+            sub_energy_ = 0.0f;
+
+            // 每 100ms 结束一个 400ms 门限块
+            if (blocks_ >= 4) {
+                const float e = MeanEnergy(4);
+                const float l = energy_to_lufs(e);
+                if (l >= -70.0f) {
+                    const int bin = std::min(kHistBins - 1, (int)((l + 70.0f) * 4.0f));
+                    hist_count_[bin]++;
+                    hist_energy_[bin] += e;
+                }
+            }
+        }
+    }
+}
+
+float LoudnessMeter::MeanEnergy(size_t count) const {
+    count = std::min<size_t>(count, std::min<uint32_t>(blocks_, kRing));
+    if (count == 0) return 0.0f;
+    float sum = 0.0f;
+    for (size_t i = 1; i <= count; i++) {
+        sum += ring_[(blocks_ - i) % kRing];
+    }
+    return sum / (float)count;
+}
+
+float LoudnessMeter::momentary_lufs() const {
+    return blocks_ >= 4 ? energy_to_lufs(MeanEnergy(4)) : -INFINITY;
+}
+
+float LoudnessMeter::short_term_lufs() const {
+    return blocks_ >= 4 ? energy_to_lufs(MeanEnergy(kRing)) : -INFINITY;
+}
+
+float LoudnessMeter::integrated_lufs() const {
+    // 绝对门限已在入库时完成；相对门限 = 绝对门限后的平均响度 - 10 LU
+    uint32_t n = 0;
+    double e = 0.0;
+    for (int i = 0; i < kHistBins; i++) {
+        n += hist_count_[i];
+        e += hist_energy_[i];
+    }
+    if (n == 0) return -INFINITY;
+    const float gate = energy_to_lufs((float)(e / n)) - 10.0f;
+    const int first = std::max(0, (int)ceilf((gate + 70.0f) * 4.0f));
+    n = 0;
+    e = 0.0;
+    for (int i = first; i < kHistBins; i++) {
+        n += hist_count_[i];
+        e += hist_energy_[i];
+    }
+    return n ? energy_to_lufs((float)(e / n)) : -INFINITY;
+}
+
+// ======== LoudnessProcessor ========
+
+LoudnessProcessor::LoudnessProcessor(int sample_rate, int channels, const LoudnessConfig& config)
+    : config_(config),
+      sample_rate_(sample_rate),
+      channels_(channels > 0 ? channels : 1),
+      meter_(sample_rate, channels > 0 ? channels : 1) {
+    lookahead_ = (size_t)(config_.lookahead_ms * sample_rate_ / 1000.0f) * channels_;
+    limiter_threshold_ = 32767.0f * db_to_linear(config_.limiter_dbfs);
+    work_.assign(lookahead_, 0.0f);
+}
+
+void LoudnessProcessor::Reset() {
+    meter_.Reset();
+    locked_ = false;
+    norm_db_ = 0.0f;
+    comp_env_db_ = -90.0f;
+    comp_db_ = 0.0f;
+    gain_linear_ = 1.0f;
+    limiter_gain_ = 1.0f;
+    std::fill(work_.begin(), work_.end(), 0.0f);
+}
+
+void LoudnessProcessor::UpdateGain(const float* samples, size_t count) {
+    const size_t frames = count / channels_;
+
+    // 1. 归一化：按瞬时响度判断停顿，停顿中保持增益。
+    //    从第一块起就限速：锁定前按瞬时响度以较快的速度逼近，之后按短期响度慢速跟踪，
+    //    增益不会在一块 (几毫秒) 之内跳变十几 dB
+    const float momentary = meter_.momentary_lufs();
+    if (momentary > config_.gate_lufs) {
+        float wanted = config_.target_lufs - (locked_ ? meter_.short_term_lufs() : momentary);
+        wanted = std::min(std::max(wanted, config_.min_gain_db), config_.max_gain_db);
+        const float slew = locked_ ? config_.gain_slew_db_per_s : config_.initial_slew_db_per_s;
+        const float max_delta = slew * frames / sample_rate_;
+        norm_db_ += std::min(std::max(wanted - norm_db_, -max_delta), max_delta);
+        if (!locked_ && fabsf(wanted - norm_db_) < 0.5f) {
+            locked_ = true;
+        }
+    }
+
+    // 2. 压缩：归一化之后的块 RMS 电平，dB 域一阶包络
+    const float mean_sq = dsp_dotprod_f32(samples, samples, count) / (float)count;
+    const float level_db = 10.0f * log10f(mean_sq / (32768.0f * 32768.0f) + 1e-12f) + norm_db_;
+    const float tau_ms = level_db > comp_env_db_ ? config_.comp_attack_ms : config_.comp_release_ms;
+    const float a = expf(-(float)frames * 1000.0f / (tau_ms * sample_rate_));
+    comp_env_db_ = a * comp_env_db_ + (1.0f - a) * level_db;
+    comp_db_ = std::max(0.0f, comp_env_db_ - config_.comp_threshold_dbfs) * (1.0f - 1.0f / config_.comp_ratio);
+}
+
+void LoudnessProcessor::Process(int16_t* samples, size_t count) {
+    AudioPerfScope scope(perf_);
+    // 与 AudioAgc 相同：不足一帧时不处理，块内增益斜坡按帧数插值
+    const size_t frames = count / channels_;
+    if (frames == 0) return;
+    if (work_.size() < lookahead_ + count) {
+        work_.resize(lookahead_ + count, 0.0f);
+    }
+
+    // 先转换成 float 写入延迟线之后，块 RMS 和增益插值都在这份数据上完成
+    float* in = work_.data() + lookahead_;
+    for (size_t i = 0; i < count; i++) {
+        in[i] = samples[i];
+    }
+
+    meter_.Push(samples, count);
+    UpdateGain(in, count);
+    const float old_gain = gain_linear_;
+    const float new_gain = db_to_linear(norm_db_ - comp_db_);
+    gain_linear_ = new_gain;
+
+    // 块内线性增益插值
+    const float step = (new_gain - old_gain) / (float)frames;
+    float g = old_gain;
+    for (size_t f = 0; f < frames; f++) {
+        g += step;
+        float* dst = in + f * channels_;
+        for (int c = 0; c < channels_; c++) {
+            dst[c] *= g;
+        }
+    }
+    for (size_t i = frames * channels_; i < count; i++) {
+        in[i] *= new_gain;
+    }
+
+    ApplyLimiter(samples, count);
+
+    // 最后 lookahead_ 个样本留作下一块的延迟线
+    memmove(work_.data(), work_.data() + count, lookahead_ * sizeof(float));
+}
+
+void LoudnessProcessor::ApplyLimiter(int16_t* out, size_t count) {
+    // 与 AudioAgc::ApplyLimiter 相同：段末增益同时满足本段和下一段的峰值，段内线性过渡
+    const float* x = work_.data();
+    size_t seg = lookahead_ > 0 ? lookahead_ : count;
+    float peak_cur = peak_abs_f32(x, std::min(seg, count));
+
+    for (size_t pos = 0; pos < count; pos += seg) {
+        size_t n = std::min(seg, count - pos);
+        size_t next_len = std::min(seg, count + lookahead_ - (pos + n));
+        float peak_next = next_len ? peak_abs_f32(x + pos + n, next_len) : 0.0f;
+
+        float peak = std::max(peak_cur, peak_next);
+        float target = peak > limiter_threshold_ ? limiter_threshold_ / peak : 1.0f;
+        float g0 = limiter_gain_;
+        float g1 = target;
+        if (target > g0) {
+            float r = expf(-(float)(n / channels_) * 1000.0f / (config_.limiter_release_ms * sample_rate_));
+            g1 = target + (g0 - target) * r;
+        }
+
+        float step = (g1 - g0) / (float)n;
+        float g = g0;
+        for (size_t i = 0; i < n; i++) {
+            g += step;
+            out[pos + i] = saturate_s16(x[pos + i] * g);
+        }
+        limiter_gain_ = g1;
+        peak_cur = peak_next;
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef LOUDNESS_H
+#define LOUDNESS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "audio_perf.h"
+#include "dsp_engine.h"
+
+/**
+ * @brief ITU-R BS.1770 响度计 (LUFS)
+ *
+ * K 计权 (高搁架 + 高通，按实际采样率设计) 后按 100ms 子块累计各声道能量，
+ * 逐声道拆成 float 后用 dsp_biquad_f32 / dsp_dotprod_f32 (S3 上是 esp-dsp 的 PIE 内核) 计算：
+ *   - 瞬时响度：最近 400ms；短期响度：最近 3s (不足 3s 时取已有部分)；
+ *   - 综合响度：400ms 块 (75% 重叠) 经 -70 LUFS 绝对门限和 -10 LU 相对门限后的平均，
+ *     用 0.25 LU 分辨率的直方图统计，内存固定，不随时长增长。
+ */
+class LoudnessMeter {
+public:
+    LoudnessMeter(int sample_rate, int channels);
+
+    void Push(const int16_t* samples, size_t count);
+    void Reset();
+
+    // 没有足够数据时返回 -INFINITY
+    float momentary_lufs() const;
+    float short_term_lufs() const;
+    float integrated_lufs() const;
+    // 已完成的 100ms 子块数
+    uint32_t blocks() const { return blocks_; }
+
+private:
+    // 单次滤波的最大帧数，更长的段分段处理
+    static const size_t kChunk = 256;
+
+    float MeanEnergy(size_t count) const;
+
+    int channels_;
+    float kw_[2][5];                   // 两节 K 计权系数 {b0, b1, b2, a1, a2}
+    std::vector<float> z_;             // 每声道每节两个状态 (直接 II 型)
+    alignas(16) float buf_[2][kChunk]; // 单声道 float 工作缓冲 (两块交替)
+
+    size_t sub_len_;                   // 100ms 子块的帧数
+    size_t sub_pos_ = 0;
+    float sub_energy_ = 0.0f;          // 当前子块各声道平方和之和
+    static const size_t kRing = 30;
+    float ring_[kRing];                // 最近 30 个子块的均方能量
+    uint32_t blocks_ = 0;
+
+    static const int kHistBins = 320;  // -70 .. +10 LUFS，0.25 LU 一档
+    uint32_t hist_count_[kHistBins];
+    float hist_energy_[kHistBins];
+};
+
+// 响度归一化 + 压缩 + 限幅参数，默认值针对小扬声器上的语音回复
+struct LoudnessConfig {
+    float target_lufs = -20.0f;           // 归一化目标 (短期响度)
+    float gate_lufs = -50.0f;             // 低于此值视为停顿，保持当前增益
+    float min_gain_db = -20.0f;
+    float max_gain_db = 20.0f;
+    float gain_slew_db_per_s = 10.0f;     // 归一化增益的最大变化速度
+    float initial_slew_db_per_s = 60.0f;  // Reset() 后逼近初始增益时的变化速度
+    float comp_threshold_dbfs = -18.0f;   // 压缩器门限 (块 RMS，归一化之后)
+    float comp_ratio = 3.0f;
+    float comp_attack_ms = 5.0f;
+    float comp_release_ms = 150.0f;
+    float limiter_dbfs = -1.0f;
+    float limiter_release_ms = 60.0f;
+    float lookahead_ms = 2.0f;
+};
+
+/**
+ * @brief 播放通路的响度归一化、压缩和限幅
+ *
+ * 不同来源的回复音频电平差别很大，这里按输入的短期响度前馈计算归一化增益，
+ * 再按块 RMS 做压缩，最后是与 AudioAgc 相同结构的预读限幅器。
+ * 增益每块只计算一次，块内线性插值 (代替 esp_codec_dev 软件音量逐样本判断的斜坡)；
+ * 新的一段回复开始前调用 Reset()，增益从 0 dB 开始，有效语音满 400ms 后按瞬时响度以 initial_slew_db_per_s
+ * 逼近初始增益，到达后改按短期响度以 gain_slew_db_per_s 跟踪；两个阶段都逐块限速，不会跳变。
+ * 限幅器应该是播放通路的最后一级，均衡等带提升的处理放在它之前。
+ * 数据为交织的 16 位 PCM，输出相对输入延迟 lookahead_ms。
+ */
+class LoudnessProcessor {
+public:
+    LoudnessProcessor(int sample_rate, int channels, const LoudnessConfig& config = LoudnessConfig());
+
+    void Process(int16_t* samples, size_t count);
+    void Reset();
+
+    const LoudnessMeter& meter() const { return meter_; }
+    float gain_db() const { return norm_db_ - comp_db_; }
+    float normalization_db() const { return norm_db_; }
+    float compression_db() const { return comp_db_; }
+    float limiter_gain() const { return limiter_gain_; }
+    const AudioPerfCounter& perf() const { return perf_; }
+    void ResetPerf() { perf_.Reset(); }
+
+private:
+    void UpdateGain(const float* samples, size_t count);
+    void ApplyLimiter(int16_t* out, size_t count);
+
+    LoudnessConfig config_;
+    int sample_rate_;
+    int channels_;
+    LoudnessMeter meter_;
+
+    bool locked_ = false;               // 是否已逼近初始增益，之后改用慢速跟踪
+    float norm_db_ = 0.0f;
+    float comp_env_db_ = -90.0f;
+    float comp_db_ = 0.0f;
+    float gain_linear_ = 1.0f;
+
+    size_t lookahead_;                  // 预读长度 (交织样本数)
+    std::vector<float> work_;           // [延迟线 | 当前块]
+    float limiter_threshold_;
+    float limiter_gain_ = 1.0f;
+
+    AudioPerfCounter perf_;
+};
+
+#endif // LOUDNESS_H
@@ -0,0 +1,189 @@
+#include "mel_features.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static inline float hz_to_mel(float hz) {
+    return 2595.0f * log10f(1.0f + hz / 700.0f);
+}
+
+static inline float mel_to_hz(float mel) {
+    return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+MelFeatureExtractor::MelFeatureExtractor(const MelConfig& config)
+    : config_(config),
+      fft_(config.fft_size),
+      framer_(config.fft_size, config.hop_size, DspMemory::INTERNAL) {
+    if (!fft_.valid() || !framer_.valid() || config_.num_mels == 0 || config_.ring_frames == 0 ||
+        config_.num_mfcc > config_.num_mels) {
+        return;
+    }
+    const size_t bins = config_.fft_size / 2 + 1;
+    float fmax = std::min(config_.fmax, config_.sample_rate / 2.0f);
+
+    // 三角形滤波器，中心频率在 mel 刻度上等间距；只保存非零权重
+    std::vector<float> edges(config_.num_mels + 2);
+    float mel_lo = hz_to_mel(config_.fmin), mel_hi = hz_to_mel(fmax);
+    for (size_t i = 0; i < edges.size(); i++) {
+        float mel = mel_lo + (mel_hi - mel_lo) * i / (config_.num_mels + 1);
+        edges[i] = mel_to_hz(mel) * config_.fft_size / config_.sample_rate;  // 以 bin 为单位
+    }
+    band_start_.resize(config_.num_mels);
+    band_len_.resize(config_.num_mels);
+    band_offset_.resize(config_.num_mels);
+    for (size_t m = 0; m < config_.num_mels; m++) {
+        float left = edges[m], center = edges[m + 1], right = edges[m + 2];
+        size_t first = (size_t)ceilf(left);
+        size_t last = std::min((size_t)floorf(right), bins - 1);
+        band_start_[m] = (uint16_t)first;
+        band_offset_[m] = (uint16_t)weights_.size();
+        for (size_t k = first; k <= last; k++) {
+            float w = k <= center ? (k - left) / (center - left) : (right - k) / (right - center);
+            weights_.push_back(std::max(w, 0.0f));
+        }
+        // 低频带可能窄于一个 bin，至少保留最近的一个 bin
+        if (weights_.size() == band_offset_[m]) {
+            band_start_[m] = (uint16_t)std::min((size_t)lrintf(center), bins - 1);
+            weights_.push_back(1.0f);
+        }
+        band_len_[m] = (uint16_t)(weights_.size() - band_offset_[m]);
+    }
+
+    // DCT-II (正交归一化)
+    if (config_.num_mfcc) {
+        const size_t n = config_.num_mels;
+        dct_.resize(config_.num_mfcc * n);
+        for (size_t k = 0; k < config_.num_mfcc; k++) {
+            float scale = sqrtf((k == 0 ? 1.0f : 2.0f) / n);
+            for (size_t i = 0; i < n; i++) {
+                dct_[k * n + i] = scale * cosf((float)M_PI * k * (i + 0.5f) / n);
+            }
+        }
+    }
+
+    if (!hop_buf_.Allocate(config_.hop_size, DspMemory::INTERNAL) ||
+        !spec_.Allocate(config_.fft_size, DspMemory::INTERNAL) ||
+        !power_.Allocate(bins, DspMemory::INTERNAL)) {
+        return;
+    }
+    mel_.assign(config_.num_mels, 0.0f);
+    ring_.assign(config_.ring_frames * feature_dim(), 0.0f);
+    power_floor_ = config_.log_floor;
+    valid_ = true;
+}
+
+size_t MelFeatureExtractor::Push(const int16_t* samples, size_t count, size_t stride) {
+    if (!valid_ || stride == 0) return 0;
+    size_t produced = 0;
+    float* hop = hop_buf_.data();
+    const float scale = 1.0f / 32768.0f;
+    for (size_t i = 0; i < count; i += stride) {
+        hop[hop_fill_++] = samples[i] * scale;
+        if (hop_fill_ == config_.hop_size) {
+            hop_fill_ = 0;
+            ComputeFrame();
+            produced++;
+        }
+    }
+    return produced;
+}
+
+void MelFeatureExtractor::ComputeFrame() {
+    uint32_t t0 = audio_perf_cycles();
+    const float* frame = framer_.Analyze(hop_buf_.data());
+    fft_.Forward(frame, spec_.data());
+    fft_.PowerSpectrum(spec_.data(), power_.data());
+    FinishFrame(power_.data());
+    perf_.Add(audio_perf_cycles() - t0);
+}
+
+void MelFeatureExtractor::PushPowerSpectrum(const float* power) {
+    if (!valid_) return;
+    AudioPerfScope scope(perf_);
+    FinishFrame(power);
+}
+
+void MelFeatureExtractor::FinishFrame(const float* power) {
+    // 稀疏 mel 滤波 + log
+    for (size_t m = 0; m < config_.num_mels; m++) {
+        const float* p = power + band_start_[m];
+        const float* w = weights_.data() + band_offset_[m];
+        float acc = 0.0f;
+        for (size_t k = 0; k < band_len_[m]; k++) {
+            acc += p[k] * w[k];
+        }
+        mel_[m] = logf(std::max(acc, power_floor_));
+    }
+
+    const size_t dim = feature_dim();
+    float* dst = ring_.data() + ring_head_ * dim;
+    if (config_.num_mfcc) {
+        const size_t n = config_.num_mels;
+        for (size_t k = 0; k < config_.num_mfcc; k++) {
+            const float* row = dct_.data() + k * n;
+            float acc = 0.0f;
+            for (size_t i = 0; i < n; i++) {
+                acc += row[i] * mel_[i];
+            }
+            dst[k] = acc;
+        }
+    } else {
+        memcpy(dst, mel_.data(), dim * sizeof(float));
+    }
+
+    ring_head_ = (ring_head_ + 1) % config_.ring_frames;
+    if (filled_ < config_.ring_frames) filled_++;
+    total_frames_++;
+
+    if (frame_cb_) {
+        frame_cb_(dst, dim);
+    }
+}
+
+const float* MelFeatureExtractor::latest() const {
+    if (!valid_ || filled_ == 0) return nullptr;
+    size_t idx = (ring_head_ + config_.ring_frames - 1) % config_.ring_frames;
+    return ring_.data() + idx * feature_dim();
+}
+
+size_t MelFeatureExtractor::CopyWindow(float* out, size_t frames) const {
+    if (!valid_) return 0;
+    frames = std::min(frames, filled_);
+    const size_t dim = feature_dim();
+    size_t idx = (ring_head_ + config_.ring_frames - frames) % config_.ring_frames;
+    for (size_t f = 0; f < frames; f++) {
+        memcpy(out + f * dim, ring_.data() + idx * dim, dim * sizeof(float));
+        idx = (idx + 1) % config_.ring_frames;
+    }
+    return frames;
+}
+
+size_t MelFeatureExtractor::CopyWindowInt8(int8_t* out, size_t frames, float scale, int zero_point) const {
+    if (!valid_ || scale <= 0.0f) return 0;
+    frames = std::min(frames, filled_);
+    const size_t dim = feature_dim();
+    const float inv = 1.0f / scale;
+    size_t idx = (ring_head_ + config_.ring_frames - frames) % config_.ring_frames;
+    for (size_t f = 0; f < frames; f++) {
+        const float* src = ring_.data() + idx * dim;
+        int8_t* dst = out + f * dim;
+        for (size_t i = 0; i < dim; i++) {
+            long q = lrintf(src[i] * inv) + zero_point;
+            dst[i] = (int8_t)std::min(127L, std::max(-128L, q));
+        }
+        idx = (idx + 1) % config_.ring_frames;
+    }
+    return frames;
+}
+
+size_t MelFeatureExtractor::MemoryBytes() const {
+    size_t bytes = 0;
+    bytes += (band_start_.capacity() + band_len_.capacity() + band_offset_.capacity()) * sizeof(uint16_t);
+    bytes += (weights_.capacity() + dct_.capacity() + mel_.capacity() + ring_.capacity()) * sizeof(float);
+    bytes += (hop_buf_.size() + spec_.size() + power_.size()) * sizeof(float);
+    // OverlapAdd: 窗、历史、帧、叠加缓冲各 fft_size 个 float
+    bytes += 4 * config_.fft_size * sizeof(float);
+    return bytes;
+}
@@ -0,0 +1,112 @@
+#ifndef MEL_FEATURES_H
+#define MEL_FEATURES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "dsp_engine.h"
+#include "audio_perf.h"
+
+// 特征参数，默认值: 24kHz 输入，512 点窗，256 点 hop (10.7ms)，40 个 mel 频带
+struct MelConfig {
+    int sample_rate = 24000;
+    size_t fft_size = 512;
+    size_t hop_size = 256;
+    size_t num_mels = 40;
+    float fmin = 20.0f;
+    float fmax = 8000.0f;
+    size_t num_mfcc = 0;        // 0 表示只输出 log-mel
+    size_t ring_frames = 98;    // 环形缓冲中保留的帧数 (约 1 秒)
+    float log_floor = 1e-6f;    // log 前的最小能量 (相对满量程)
+};
+
+/**
+ * @brief 增量式 log-mel / MFCC 特征提取
+ *
+ * 每凑满一个 hop 只计算一帧：加窗 + 实数 FFT + 稀疏 mel 滤波 + log，
+ * 结果写入环形缓冲，不会重算整段窗口。如果上游阶段已经算过同一帧的功率谱，
+ * 可以直接 PushPowerSpectrum() 复用，跳过 FFT。
+ */
+class MelFeatureExtractor {
+public:
+    // 每产生一帧特征回调一次，参数为该帧的特征 (num_mels 或 num_mfcc 个)
+    using FrameCallback = std::function<void(const float* features, size_t count)>;
+
+    explicit MelFeatureExtractor(const MelConfig& config = MelConfig());
+
+    bool valid() const { return valid_; }
+    const MelConfig& config() const { return config_; }
+
+    /**
+     * @brief 送入 PCM 样本
+     * @param stride 相邻样本间隔，交织立体声取单声道时传 2，无需先拷贝解交织
+     * @return 本次新产生的特征帧数
+     */
+    size_t Push(const int16_t* samples, size_t count, size_t stride = 1);
+
+    /**
+     * @brief 直接送入一帧功率谱 (fft_size/2+1 个 bin，与本对象相同的 FFT 尺寸和窗)
+     */
+    void PushPowerSpectrum(const float* power);
+
+    void SetFrameCallback(FrameCallback cb) { frame_cb_ = std::move(cb); }
+
+    size_t feature_dim() const { return config_.num_mfcc ? config_.num_mfcc : config_.num_mels; }
+    size_t ring_frames() const { return config_.ring_frames; }
+    // 环形缓冲中已填充的帧数 (不超过 ring_frames)
+    size_t available_frames() const { return filled_; }
+    uint64_t total_frames() const { return total_frames_; }
+
+    /**
+     * @brief 按时间顺序 (旧 -> 新) 拷贝最近 frames 帧特征，行主序 [frames][feature_dim]
+     * @return 实际拷贝的帧数
+     */
+    size_t CopyWindow(float* out, size_t frames) const;
+
+    /**
+     * @brief 同 CopyWindow，但按 q = round(x / scale) + zero_point 量化成 int8，
+     *        可直接作为分类器的输入张量
+     */
+    size_t CopyWindowInt8(int8_t* out, size_t frames, float scale, int zero_point) const;
+
+    // 最新一帧特征
+    const float* latest() const;
+
+    const AudioPerfCounter& perf() const { return perf_; }
+    // 本对象占用的堆内存 (字节)
+    size_t MemoryBytes() const;
+
+private:
+    void ComputeFrame();
+    void FinishFrame(const float* power);
+
+    MelConfig config_;
+    bool valid_ = false;
+    DspFft fft_;
+    OverlapAdd framer_;
+
+    // 稀疏 mel 滤波器：第 m 个频带覆盖 [band_start_[m], band_start_[m] + band_len_[m])，
+    // 权重连续存放在 weights_ 中，从 band_offset_[m] 开始
+    std::vector<uint16_t> band_start_;
+    std::vector<uint16_t> band_len_;
+    std::vector<uint16_t> band_offset_;
+    std::vector<float> weights_;
+    std::vector<float> dct_;            // [num_mfcc][num_mels]
+
+    DspBuffer<float> hop_buf_;
+    size_t hop_fill_ = 0;
+    DspBuffer<float> spec_;
+    DspBuffer<float> power_;
+    std::vector<float> mel_;
+    std::vector<float> ring_;           // [ring_frames][feature_dim]
+    size_t ring_head_ = 0;              // 下一帧写入位置
+    size_t filled_ = 0;
+    uint64_t total_frames_ = 0;
+    float power_floor_;
+
+    FrameCallback frame_cb_;
+    AudioPerfCounter perf_;
+};
+
+#endif // MEL_FEATURES_H
@@ -0,0 +1,150 @@
+#ifndef MIC_ARRAY_H
+#define MIC_ARRAY_H
+
+#include <vector>
+#include "esp_log.h"
+#include "driver/i2c_master.h"
+#include "driver/i2s_std.h"
+#include "driver/i2s_tdm.h"
+#include "board_config.h"
+#include "esp_codec_dev.h"
+#include "esp_codec_dev_defaults.h"
+
+// ES7210 多麦克风采集 (只有输入)。
+// 2 路麦克风时 ES7210 输出标准 I2S 立体声，4 路时切换到 TDM，
+// 两种情况读到的都是按帧交织的 [mic0, mic1, (mic2, mic3)] 16 位数据，
+// 由 mic_array_dsp.h 中的解交织/波束形成处理。
+class MicArrayCapture {
+private:
+    i2c_master_bus_handle_t i2c_bus_handle_;
+    int channels_;
+    i2s_chan_handle_t rx_handle_ = NULL;
+    const audio_codec_data_if_t* data_if_ = nullptr;
+    const audio_codec_ctrl_if_t* ctrl_if_ = nullptr;
+    const audio_codec_if_t* codec_if_ = nullptr;
+    esp_codec_dev_handle_t codec_dev_ = nullptr;
+    const char* TAG = "MicArrayCapture";
+
+public:
+    MicArrayCapture(i2c_master_bus_handle_t bus_handle, int channels)
+        : i2c_bus_handle_(bus_handle), channels_(channels) {}
+
+    int channels() const { return channels_; }
+
+    /**
+     * @brief 创建 RX 通道并配置 ES7210
+     * @param rx_cbs 可选的 I2S 事件回调 (如接收队列溢出计数)，在使能通道前注册
+     */
+    bool Init(const i2s_event_callbacks_t* rx_cbs = nullptr, void* cb_ctx = nullptr) {
+        if (channels_ != 2 && channels_ != 4) {
+            ESP_LOGE(TAG, "Unsupported mic count: %d", channels_);
+            return false;
+        }
+        ESP_LOGI(TAG, "Initializing %d-mic capture (%s)...", channels_, channels_ > 2 ? "TDM" : "STD");
+
+        // 1. 独立的 RX 通道，与 ES8311 的全双工通道互不影响
+        i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_AUTO, I2S_ROLE_MASTER);
+        ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, NULL, &rx_handle_));
+
+        if (channels_ > 2) {
+            i2s_tdm_slot_mask_t mask = (i2s_tdm_slot_mask_t)(I2S_TDM_SLOT0 | I2S_TDM_SLOT1 | I2S_TDM_SLOT2 | I2S_TDM_SLOT3);
+            i2s_tdm_config_t tdm_cfg = {
+                .clk_cfg = I2S_TDM_CLK_DEFAULT_CONFIG(AUDIO_INPUT_SAMPLE_RATE),
+                .slot_cfg = I2S_TDM_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO, mask),
+                .gpio_cfg = {
+                    .mclk = AUDIO_TDM_GPIO_MCLK,
+                    .bclk = AUDIO_TDM_GPIO_BCLK,
+                    .ws = AUDIO_TDM_GPIO_WS,
+                    .dout = I2S_GPIO_UNUSED,
+                    .din = AUDIO_TDM_GPIO_DIN,
+                    .invert_flags = { .mclk_inv = false, .bclk_inv = false, .ws_inv = false },
+                },
+            };
+            ESP_ERROR_CHECK(i2s_channel_init_tdm_mode(rx_handle_, &tdm_cfg));
+        } else {
+            i2s_std_config_t std_cfg = {
+                .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(AUDIO_INPUT_SAMPLE_RATE),
+                .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
+                .gpio_cfg = {
+                    .mclk = AUDIO_TDM_GPIO_MCLK,
+                    .bclk = AUDIO_TDM_GPIO_BCLK,
+                    .ws = AUDIO_TDM_GPIO_WS,
+                    .dout = I2S_GPIO_UNUSED,
+                    .din = AUDIO_TDM_GPIO_DIN,
+                    .invert_flags = { .mclk_inv = false, .bclk_inv = false, .ws_inv = false },
+                },
+            };
+            ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_handle_, &std_cfg));
+        }
+        if (rx_cbs) {
+            ESP_ERROR_CHECK(i2s_channel_register_event_callback(rx_handle_, rx_cbs, cb_ctx));
+        }
+        ESP_ERROR_CHECK(i2s_channel_enable(rx_handle_));
+
+        // 2. ES7210 寄存器配置，端口用 I2S_NUM_AUTO 实际分配到的那个
+        i2s_chan_info_t chan_info = {};
+        ESP_ERROR_CHECK(i2s_channel_get_info(rx_handle_, &chan_info));
+        audio_codec_i2s_cfg_t i2s_cfg = {};
+        i2s_cfg.port = chan_info.id;
+        i2s_cfg.rx_handle = rx_handle_;
+        data_if_ = audio_codec_new_i2s_data(&i2s_cfg);
+
+        audio_codec_i2c_cfg_t i2c_cfg = {};
+        i2c_cfg.port = I2C_NUM_1;
+        i2c_cfg.addr = AUDIO_CODEC_ES7210_ADDR << 1;
+        i2c_cfg.bus_handle = i2c_bus_handle_;
+        ctrl_if_ = audio_codec_new_i2c_ctrl(&i2c_cfg);
+        if (!data_if_ || !ctrl_if_) {
+            ESP_LOGE(TAG, "Failed to create codec interfaces");
+            return false;
+        }
+
+        es7210_codec_cfg_t es7210_cfg = {};
+        es7210_cfg.ctrl_if = ctrl_if_;
+        es7210_cfg.mic_selected = ES7120_SEL_MIC1 | ES7120_SEL_MIC2;
+        if (channels_ > 2) {
+            es7210_cfg.mic_selected |= ES7120_SEL_MIC3 | ES7120_SEL_MIC4;
+        }
+        codec_if_ = es7210_codec_new(&es7210_cfg);
+        if (!codec_if_) {
+            ESP_LOGE(TAG, "Failed to create ES7210 codec interface");
+            return false;
+        }
+
+        esp_codec_dev_cfg_t dev_cfg = {};
+        dev_cfg.dev_type = ESP_CODEC_DEV_TYPE_IN;
+        dev_cfg.codec_if = codec_if_;
+        dev_cfg.data_if = data_if_;
+        codec_dev_ = esp_codec_dev_new(&dev_cfg);
+
+        esp_codec_dev_sample_info_t fs = {};
+        fs.bits_per_sample = 16;
+        fs.channel = channels_;
+        fs.sample_rate = AUDIO_INPUT_SAMPLE_RATE;
+        if (!codec_dev_ || esp_codec_dev_open(codec_dev_, &fs) != ESP_CODEC_DEV_OK) {
+            ESP_LOGE(TAG, "Failed to open ES7210 codec device");
+            return false;
+        }
+        ESP_LOGI(TAG, "ES7210 configured, %d mics.", channels_);
+        return true;
+    }
+
+    /**
+     * @brief 读取交织数据，data.size() 必须是 channels() 的整数倍
+     */
+    bool Read(std::vector<int16_t>& data) {
+        size_t bytes_read = 0;
+        esp_err_t ret = i2s_channel_read(rx_handle_, data.data(), data.size() * sizeof(int16_t), &bytes_read, pdMS_TO_TICKS(100));
+        if (ret != ESP_OK && ret != ESP_ERR_TIMEOUT) {
+            ESP_LOGE(TAG, "I2S Read Error: %s", esp_err_to_name(ret));
+            return false;
+        }
+        return bytes_read > 0;
+    }
+
+    bool SetInputGain(float db) {
+        return codec_dev_ && esp_codec_dev_set_in_gain(codec_dev_, db) == ESP_CODEC_DEV_OK;
+    }
+};
+
+#endif // MIC_ARRAY_H
@@ -0,0 +1,213 @@
+#include "mic_array_dsp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const float kSpeedOfSoundMmPerS = 343000.0f;
+
+// ======== 解交织 ========
+
+void deinterleave_s16(const int16_t* in, size_t frames, int channels, int16_t* const* out) {
+    // Xtensa 不支持非对齐的 32 位访问，只有 4 字节对齐时才走整帧读取
+    const bool aligned = ((uintptr_t)in & 3) == 0;
+    if (channels == 2 && aligned) {
+        // 一次读 32 位 (一帧)，拆成两个 16 位
+        const uint32_t* src = reinterpret_cast<const uint32_t*>(in);
+        int16_t* a = out[0];
+        int16_t* b = out[1];
+        size_t i = 0;
+        for (; i + 2 <= frames; i += 2) {
+            uint32_t f0 = src[i], f1 = src[i + 1];
+            a[i] = (int16_t)(f0 & 0xFFFF);
+            b[i] = (int16_t)(f0 >> 16);
+            a[i + 1] = (int16_t)(f1 & 0xFFFF);
+            b[i + 1] = (int16_t)(f1 >> 16);
+        }
+        for (; i < frames; i++) {
+            a[i] = in[2 * i];
+            b[i] = in[2 * i + 1];
+        }
+    } else if (channels == 4 && aligned) {
+        // 一帧 = 两个 32 位字
+        const uint32_t* src = reinterpret_cast<const uint32_t*>(in);
+        int16_t* a = out[0];
+        int16_t* b = out[1];
+        int16_t* c = out[2];
+        int16_t* d = out[3];
+        for (size_t i = 0; i < frames; i++) {
+            uint32_t lo = src[2 * i], hi = src[2 * i + 1];
+            a[i] = (int16_t)(lo & 0xFFFF);
+            b[i] = (int16_t)(lo >> 16);
+            c[i] = (int16_t)(hi & 0xFFFF);
+            d[i] = (int16_t)(hi >> 16);
+        }
+    } else {
+        for (size_t i = 0; i < frames; i++) {
+            for (int ch = 0; ch < channels; ch++) {
+                out[ch][i] = in[i * channels + ch];
+            }
+        }
+    }
+}
+
+void deinterleave_s16_f32(const int16_t* in, size_t frames, int channels, float* const* out) {
+    if (channels == 2) {
+        float* a = out[0];
+        float* b = out[1];
+        size_t i = 0;
+        for (; i + 2 <= frames; i += 2) {
+            const int16_t* f = in + 2 * i;
+            a[i] = f[0];
+            b[i] = f[1];
+            a[i + 1] = f[2];
+            b[i + 1] = f[3];
+        }
+        for (; i < frames; i++) {
+            a[i] = in[2 * i];
+            b[i] = in[2 * i + 1];
+        }
+    } else if (channels == 4) {
+        float* a = out[0];
+        float* b = out[1];
+        float* c = out[2];
+        float* d = out[3];
+        for (size_t i = 0; i < frames; i++) {
+            const int16_t* f = in + 4 * i;
+            a[i] = f[0];
+            b[i] = f[1];
+            c[i] = f[2];
+            d[i] = f[3];
+        }
+    } else {
+        for (size_t i = 0; i < frames; i++) {
+            for (int ch = 0; ch < channels; ch++) {
+                out[ch][i] = in[i * channels + ch];
+            }
+        }
+    }
+}
+
+// ======== 延迟求和波束形成 ========
+
+DelayAndSumBeamformer::DelayAndSumBeamformer(const BeamformerConfig& config) : config_(config) {
+    const int m = config_.channels;
+    if (m < 1 || m > MIC_ARRAY_MAX_CHANNELS || config_.max_block == 0) {
+        return;
+    }
+    if (config_.positions_mm.empty()) {
+        // 以阵列中心为原点的等间距线阵
+        for (int ch = 0; ch < m; ch++) {
+            config_.positions_mm.push_back((ch - (m - 1) / 2.0f) * config_.spacing_mm);
+        }
+    } else if ((int)config_.positions_mm.size() != m) {
+        return;
+    }
+
+    // 最大相对时延 = 孔径 / 声速，再加 1 个样本的插值居中量和 4 个抽头
+    auto minmax = std::minmax_element(config_.positions_mm.begin(), config_.positions_mm.end());
+    float aperture = *minmax.second - *minmax.first;
+    history_ = (size_t)ceilf(aperture / kSpeedOfSoundMmPerS * config_.sample_rate) + 1 + 4;
+
+    for (int ch = 0; ch < m; ch++) {
+        if (!planar_[ch].Allocate(history_ + config_.max_block, DspMemory::INTERNAL)) {
+            return;
+        }
+    }
+    ComputeDelays(config_.steering_deg, steering_[0]);
+    valid_ = true;
+}
+
+bool DelayAndSumBeamformer::SetSteering(float degrees) {
+    if (!valid_ || pending()) {
+        return false;
+    }
+    // 后台时延表此时不会被 Process() 读取
+    const int next = 1 - active_.load(std::memory_order_acquire);
+    ComputeDelays(degrees, steering_[next]);
+    pending_.store(next, std::memory_order_release);
+    return true;
+}
+
+void DelayAndSumBeamformer::ComputeDelays(float degrees, Steering& out) const {
+    const int m = config_.channels;
+    const float u = cosf(degrees * (float)M_PI / 180.0f);
+    out.degrees = degrees;
+
+    // 平面波到达各麦克风的相对时间 (样本)，越靠近声源越早
+    float arrival[MIC_ARRAY_MAX_CHANNELS];
+    float latest = -INFINITY;
+    for (int ch = 0; ch < m; ch++) {
+        arrival[ch] = -config_.positions_mm[ch] * u / kSpeedOfSoundMmPerS * config_.sample_rate;
+        latest = std::max(latest, arrival[ch]);
+    }
+    for (int ch = 0; ch < m; ch++) {
+        // 早到的通道延迟更多；+1 使插值点落在 4 个抽头的中间段 [1, 2)
+        float d = latest - arrival[ch] + 1.0f;
+        int n0 = (int)floorf(d) - 1;
+        float p = d - n0;
+        out.delay_int[ch] = n0;
+        // 三阶拉格朗日：h_k = Π_{j≠k} (p - j) / (k - j)
+        for (int k = 0; k < 4; k++) {
+            float h = 1.0f;
+            for (int j = 0; j < 4; j++) {
+                if (j != k) h *= (p - j) / (float)(k - j);
+            }
+            out.taps[ch][k] = h;
+        }
+    }
+}
+
+void DelayAndSumBeamformer::Process(const int16_t* interleaved, size_t frames, int16_t* out) {
+    if (!valid_) return;
+    AudioPerfScope scope(perf_);
+    const int m = config_.channels;
+    const float gain = 1.0f / m;
+
+    // 块边界切换时延表；历史缓冲与方向无关，切换后直接按新时延取样
+    const int pending = pending_.load(std::memory_order_acquire);
+    if (pending >= 0) {
+        active_.store(pending, std::memory_order_release);
+        pending_.store(-1, std::memory_order_release);
+    }
+    const Steering& st = steering_[active_.load(std::memory_order_relaxed)];
+
+    for (size_t pos = 0; pos < frames; pos += config_.max_block) {
+        const size_t n = std::min(config_.max_block, frames - pos);
+
+        float* dst[MIC_ARRAY_MAX_CHANNELS];
+        for (int ch = 0; ch < m; ch++) {
+            dst[ch] = planar_[ch].data() + history_;
+        }
+        deinterleave_s16_f32(interleaved + pos * m, n, m, dst);
+
+        // 通道 0 直接写，其余通道累加，最后统一缩放
+        float acc[64];
+        for (size_t base = 0; base < n; base += 64) {
+            const size_t len = std::min<size_t>(64, n - base);
+            for (int ch = 0; ch < m; ch++) {
+                const float* x = planar_[ch].data() + history_ + base - st.delay_int[ch];
+                const float h0 = st.taps[ch][0], h1 = st.taps[ch][1], h2 = st.taps[ch][2], h3 = st.taps[ch][3];
+                if (ch == 0) {
+                    for (size_t i = 0; i < len; i++) {
+                        acc[i] = h0 * x[i] + h1 * x[i - 1] + h2 * x[i - 2] + h3 * x[i - 3];
+                    }
+                } else {
+                    for (size_t i = 0; i < len; i++) {
+                        acc[i] += h0 * x[i] + h1 * x[i - 1] + h2 * x[i - 2] + h3 * x[i - 3];
+                    }
+                }
+            }
+            for (size_t i = 0; i < len; i++) {
+                float v = acc[i] * gain;
+                v = std::min(32767.0f, std::max(-32768.0f, v));
+                out[pos + base + i] = (int16_t)lrintf(v);
+            }
+        }
+
+        for (int ch = 0; ch < m; ch++) {
+            float* p = planar_[ch].data();
+            memmove(p, p + n, history_ * sizeof(float));
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef MIC_ARRAY_DSP_H
+#define MIC_ARRAY_DSP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "dsp_engine.h"
+#include "audio_perf.h"
+
+#define MIC_ARRAY_MAX_CHANNELS 4
+
+// ======== 解交织 ========
+// 标量实现：2/4 通道手工展开，输入 4 字节对齐时按 32 位字读入整帧再拆分，其余情况走通用循环。
+// esp-dsp 没有交织拆分的内核；5ms 一块 (4 路 480 个样本) 的开销见 dsp_bench 的 mic 项，远小于波束形成本身。
+
+/**
+ * @brief 交织 int16 -> 各通道独立的 int16 缓冲
+ */
+void deinterleave_s16(const int16_t* in, size_t frames, int channels, int16_t* const* out);
+
+/**
+ * @brief 交织 int16 -> 各通道独立的 float 缓冲 (保持 int16 量级，不归一化)
+ */
+void deinterleave_s16_f32(const int16_t* in, size_t frames, int channels, float* const* out);
+
+// ======== 延迟求和波束形成 ========
+
+struct BeamformerConfig {
+    int sample_rate = 24000;
+    int channels = 2;
+    // 麦克风在阵列轴上的坐标 (毫米)，为空时按 spacing_mm 生成等间距线阵
+    std::vector<float> positions_mm;
+    float spacing_mm = 40.0f;
+    float steering_deg = 90.0f;   // 90° 为阵列法线方向 (正前方)
+    size_t max_block = 512;       // 单次 Process 的最大帧数
+};
+
+/**
+ * @brief 线阵延迟求和波束形成，输出一路增强信号
+ *
+ * 各通道的相对时延拆成整数部分 (历史缓冲偏移) 和分数部分 (4 抽头三阶拉格朗日插值)。
+ * 运行中调整方向是安全的：时延表有两组，SetSteering() 写入后台那一组，Process() 只在块开始时切换
+ * (与 BiquadCascade 的系数切换相同)。SetSteering() 只能在一个任务中调用，Process() 只能在另一个 (或同一个) 任务中调用。
+ */
+class DelayAndSumBeamformer {
+public:
+    explicit DelayAndSumBeamformer(const BeamformerConfig& config);
+
+    bool valid() const { return valid_; }
+    int channels() const { return config_.channels; }
+
+    /**
+     * @brief 提交新的波束方向，下一次 Process() 开始时生效
+     * @return 上一次提交尚未生效或对象无效时返回 false
+     */
+    bool SetSteering(float degrees);
+    // 当前生效的方向 (度)
+    float steering() const { return steering_[active_.load(std::memory_order_acquire)].degrees; }
+    // 是否还有尚未生效的方向
+    bool pending() const { return pending_.load(std::memory_order_acquire) >= 0; }
+
+    /**
+     * @brief 处理一块交织数据
+     * @param interleaved frames * channels 个样本
+     * @param out         frames 个输出样本
+     */
+    void Process(const int16_t* interleaved, size_t frames, int16_t* out);
+
+    const AudioPerfCounter& perf() const { return perf_; }
+
+private:
+    // 一个方向对应的时延表
+    struct Steering {
+        float degrees = 0.0f;
+        int delay_int[MIC_ARRAY_MAX_CHANNELS] = {};
+        float taps[MIC_ARRAY_MAX_CHANNELS][4] = {};
+    };
+
+    void ComputeDelays(float degrees, Steering& out) const;
+
+    BeamformerConfig config_;
+    bool valid_ = false;
+    size_t history_ = 0;                           // 每通道保留的历史长度
+    DspBuffer<float> planar_[MIC_ARRAY_MAX_CHANNELS];  // [历史 | 当前块]
+    Steering steering_[2];
+    std::atomic<int> active_{0};
+    std::atomic<int> pending_{-1};                 // 待切换的时延表下标，-1 表示没有
+    AudioPerfCounter perf_;
+};
+
+#endif // MIC_ARRAY_DSP_H
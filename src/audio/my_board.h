@@ -1,13 +1,70 @@
 #ifndef MY_BOARD_H
 #define MY_BOARD_H
 
+#include <atomic>
 #include <vector>
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 #include "driver/i2c_master.h"
 #include "driver/i2s_std.h"
 #include "board_config.h"
 #include "freertos/FreeRTOS.h" // 引入 FreeRTOS 头文件
 #include "freertos/semphr.h"   // 引入信号量/互斥锁头文件
+#include "esp_codec_dev.h"
+#include "esp_codec_dev_defaults.h"
+#include "mic_array.h"
+#include "mic_array_dsp.h"
+
+// I2S DMA 队列溢出统计的快照。
+// 两类溢出都说明音频任务没有按时读写 (CPU 被占满或任务被长时间阻塞)；
+// 网络侧的延迟只会表现为上游缓冲 (如 DriftCompensator) 读空，这两个计数保持不变。
+struct AudioLinkStats {
+    uint32_t rx_overflows = 0;         // 接收队列满，最旧的一块 DMA 数据被丢弃
+    uint32_t tx_underflows = 0;        // 发送队列满 (没有新数据)，DMA 重复发送旧数据
+    uint32_t rx_dropped_bytes = 0;
+    uint32_t tx_repeated_bytes = 0;
+    uint32_t last_rx_overflow_ms = 0;  // 最近一次事件的开机时间，对应计数为 0 时无意义
+    uint32_t last_tx_underflow_ms = 0;
+};
+
+// ISR 中更新的计数，只用 32 位原子量 (Xtensa 上无锁)
+struct AudioLinkCounters {
+    std::atomic<uint32_t> rx_overflows{0};
+    std::atomic<uint32_t> tx_underflows{0};
+    std::atomic<uint32_t> rx_dropped_bytes{0};
+    std::atomic<uint32_t> tx_repeated_bytes{0};
+    std::atomic<uint32_t> last_rx_overflow_ms{0};
+    std::atomic<uint32_t> last_tx_underflow_ms{0};
+
+    AudioLinkStats Snapshot() const {
+        AudioLinkStats s;
+        s.rx_overflows = rx_overflows.load(std::memory_order_relaxed);
+        s.tx_underflows = tx_underflows.load(std::memory_order_relaxed);
+        s.rx_dropped_bytes = rx_dropped_bytes.load(std::memory_order_relaxed);
+        s.tx_repeated_bytes = tx_repeated_bytes.load(std::memory_order_relaxed);
+        s.last_rx_overflow_ms = last_rx_overflow_ms.load(std::memory_order_relaxed);
+        s.last_tx_underflow_ms = last_tx_underflow_ms.load(std::memory_order_relaxed);
+        return s;
+    }
+};
+
+// I2S 事件回调在 ISR 中执行 (CONFIG_I2S_ISR_IRAM_SAFE 下必须位于 IRAM)，只做计数
+static IRAM_ATTR bool audio_i2s_on_recv_q_ovf(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) {
+    AudioLinkCounters* c = static_cast<AudioLinkCounters*>(user_ctx);
+    c->rx_overflows.fetch_add(1, std::memory_order_relaxed);
+    c->rx_dropped_bytes.fetch_add((uint32_t)event->size, std::memory_order_relaxed);
+    c->last_rx_overflow_ms.store((uint32_t)(esp_timer_get_time() / 1000), std::memory_order_relaxed);
+    return false;
+}
+
+static IRAM_ATTR bool audio_i2s_on_send_q_ovf(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) {
+    AudioLinkCounters* c = static_cast<AudioLinkCounters*>(user_ctx);
+    c->tx_underflows.fetch_add(1, std::memory_order_relaxed);
+    c->tx_repeated_bytes.fetch_add((uint32_t)event->size, std::memory_order_relaxed);
+    c->last_tx_underflow_ms.store((uint32_t)(esp_timer_get_time() / 1000), std::memory_order_relaxed);
+    return false;
+}
 
 class AudioCodec {
 public:
@@ -15,15 +72,83 @@ public:
     virtual void Init() = 0;
     virtual bool InputData(std::vector<int16_t>& data) = 0;
     virtual void OutputData(const std::vector<int16_t>& data) = 0;
+    // 直接输出一段样本 (交织立体声)，数据可以来自 flash 映射区，不需要先拷进 vector
+    virtual void OutputSamples(const int16_t* data, size_t count) = 0;
+    // 设置模拟输入 (PGA) 增益，单位 dB；不支持硬件增益的编解码器返回 false
+    virtual bool SetInputGain(float db) { return false; }
+    // I2S DMA 溢出统计，可在任意任务中调用
+    virtual AudioLinkStats GetLinkStats() const { return AudioLinkStats(); }
 };
 
 class MyEs8311Codec : public AudioCodec {
-private:
+protected:
     i2c_master_bus_handle_t i2c_bus_handle_;
     i2s_chan_handle_t rx_handle_ = NULL; // 初始化为 NULL
     i2s_chan_handle_t tx_handle_ = NULL; // 初始化为 NULL
+    // esp_codec_dev 只用于 ES8311 的寄存器控制 (PGA 等)，数据仍直接走 I2S 通道
+    const audio_codec_data_if_t* data_if_ = nullptr;
+    const audio_codec_ctrl_if_t* ctrl_if_ = nullptr;
+    const audio_codec_gpio_if_t* gpio_if_ = nullptr;
+    const audio_codec_if_t* codec_if_ = nullptr;
+    esp_codec_dev_handle_t codec_dev_ = nullptr;
+    AudioLinkCounters link_counters_;
     const char* TAG = "MyEs8311Codec";
 
+    void InitializeCodecControl() {
+        // 端口用 I2S_NUM_AUTO 实际分配到的那个 (ES7210 阵列可能先占用了 I2S0)
+        i2s_chan_info_t chan_info = {};
+        ESP_ERROR_CHECK(i2s_channel_get_info(rx_handle_, &chan_info));
+        audio_codec_i2s_cfg_t i2s_cfg = {};
+        i2s_cfg.port = chan_info.id;
+        i2s_cfg.rx_handle = rx_handle_;
+        i2s_cfg.tx_handle = tx_handle_;
+        data_if_ = audio_codec_new_i2s_data(&i2s_cfg);
+
+        audio_codec_i2c_cfg_t i2c_cfg = {};
+        i2c_cfg.port = I2C_NUM_1;
+        i2c_cfg.addr = AUDIO_CODEC_ES8311_ADDR << 1; // esp_codec_dev 使用 8 位地址
+        i2c_cfg.bus_handle = i2c_bus_handle_;
+        ctrl_if_ = audio_codec_new_i2c_ctrl(&i2c_cfg);
+        gpio_if_ = audio_codec_new_gpio();
+        if (!data_if_ || !ctrl_if_ || !gpio_if_) {
+            ESP_LOGE(TAG, "Failed to create codec interfaces");
+            return;
+        }
+
+        es8311_codec_cfg_t es8311_cfg = {};
+        es8311_cfg.ctrl_if = ctrl_if_;
+        es8311_cfg.gpio_if = gpio_if_;
+        es8311_cfg.codec_mode = ESP_CODEC_DEV_WORK_MODE_BOTH;
+        es8311_cfg.pa_pin = -1;          // 功放由 PI4IOE 控制
+        es8311_cfg.use_mclk = AUDIO_I2S_GPIO_MCLK != GPIO_NUM_NC;
+        es8311_cfg.hw_gain.pa_voltage = 5.0;
+        es8311_cfg.hw_gain.codec_dac_voltage = 3.3;
+        codec_if_ = es8311_codec_new(&es8311_cfg);
+        if (!codec_if_) {
+            ESP_LOGE(TAG, "Failed to create ES8311 codec interface");
+            return;
+        }
+
+        esp_codec_dev_cfg_t dev_cfg = {};
+        dev_cfg.dev_type = ESP_CODEC_DEV_TYPE_IN_OUT;
+        dev_cfg.codec_if = codec_if_;
+        dev_cfg.data_if = data_if_;
+        codec_dev_ = esp_codec_dev_new(&dev_cfg);
+
+        // open 会经 esp_codec_dev 的 I2S 数据接口重新配置并重新使能 I2S 通道：采样率和位宽取自 fs，
+        // 时隙固定为 Philips 格式 (I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG)，与 ES8311 默认的 I2S 格式一致。
+        // Init() 中也用 Philips 格式，open 前后数据格式不变
+        esp_codec_dev_sample_info_t fs = {};
+        fs.bits_per_sample = 16;
+        fs.channel = 2;
+        fs.sample_rate = AUDIO_INPUT_SAMPLE_RATE;
+        if (!codec_dev_ || esp_codec_dev_open(codec_dev_, &fs) != ESP_CODEC_DEV_OK) {
+            ESP_LOGE(TAG, "Failed to open ES8311 codec device");
+            return;
+        }
+        ESP_LOGI(TAG, "ES8311 Codec configured via I2C.");
+    }
+
 public:
     MyEs8311Codec(i2c_master_bus_handle_t bus_handle) : i2c_bus_handle_(bus_handle) {}
 
@@ -38,10 +163,11 @@ public:
         ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &tx_handle_, &rx_handle_));
 
         // 3. 配置 I2S 标准模式
-        // Echo Base 的麦克风和扬声器使用相同的时钟，所以只需配置一次
+        // Echo Base 的麦克风和扬声器使用相同的时钟，所以只需配置一次。
+        // 用 Philips 格式：之后 InitializeCodecControl() 中的 esp_codec_dev_open 会按 Philips 格式重新配置通道
         i2s_std_config_t std_cfg = {
             .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(AUDIO_OUTPUT_SAMPLE_RATE),
-            .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
+            .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
             .gpio_cfg = {
                 .mclk = AUDIO_I2S_GPIO_MCLK,
                 .bclk = AUDIO_I2S_GPIO_BCLK,
@@ -56,12 +182,38 @@ public:
         ESP_ERROR_CHECK(i2s_channel_init_std_mode(tx_handle_, &std_cfg));
         ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_handle_, &std_cfg));
 
+        // 队列溢出回调必须在使能通道之前注册
+        i2s_event_callbacks_t rx_cbs = {};
+        rx_cbs.on_recv_q_ovf = audio_i2s_on_recv_q_ovf;
+        ESP_ERROR_CHECK(i2s_channel_register_event_callback(rx_handle_, &rx_cbs, &link_counters_));
+        i2s_event_callbacks_t tx_cbs = {};
+        tx_cbs.on_send_q_ovf = audio_i2s_on_send_q_ovf;
+        ESP_ERROR_CHECK(i2s_channel_register_event_callback(tx_handle_, &tx_cbs, &link_counters_));
+
         // 5. 启动 I2S
         ESP_ERROR_CHECK(i2s_channel_enable(tx_handle_));
         ESP_ERROR_CHECK(i2s_channel_enable(rx_handle_));
         
         ESP_LOGI(TAG, "I2S Driver Started in Full-Duplex mode.");
-        ESP_LOGI(TAG, "ES8311 Codec configured via I2C (simulated).");
+
+        // 6. 配置 ES8311 寄存器
+        InitializeCodecControl();
+    }
+
+    bool SetInputGain(float db) override {
+        if (!codec_dev_) {
+            return false;
+        }
+        int ret = esp_codec_dev_set_in_gain(codec_dev_, db);
+        if (ret != ESP_CODEC_DEV_OK) {
+            ESP_LOGW(TAG, "Failed to set input gain %.1f dB: %d", db, ret);
+            return false;
+        }
+        return true;
+    }
+
+    AudioLinkStats GetLinkStats() const override {
+        return link_counters_.Snapshot();
     }
 
     // InputData 和 OutputData 函数无需修改
@@ -76,15 +228,100 @@ public:
     }
 
     void OutputData(const std::vector<int16_t>& data) override {
+        OutputSamples(data.data(), data.size());
+    }
+
+    void OutputSamples(const int16_t* data, size_t count) override {
         size_t bytes_written = 0;
-        esp_err_t ret = i2s_channel_write(tx_handle_, data.data(), data.size() * sizeof(int16_t), &bytes_written, portMAX_DELAY);
+        esp_err_t ret = i2s_channel_write(tx_handle_, data, count * sizeof(int16_t), &bytes_written, portMAX_DELAY);
          if (ret != ESP_OK) {
             ESP_LOGE(TAG, "I2S Write Error: %s", esp_err_to_name(ret));
         }
     }
 };
 
-// MyBoard 类无需修改，保持原样
+// 接了 ES7210 阵列 (AUDIO_MIC_ARRAY_COUNT 为 2 或 4) 时使用：ES8311 只负责播放，
+// 采集改走阵列的独立 I2S 口，经延迟求和波束形成得到一路信号，再复制到左右声道，
+// InputData() 的数据格式与 MyEs8311Codec 相同，上层通路不需要区分。
+// 阵列初始化失败时退回 ES8311 的麦克风。
+class MyMicArrayCodec : public MyEs8311Codec {
+private:
+    MicArrayCapture mics_;
+    DelayAndSumBeamformer beamformer_;
+    std::vector<int16_t> raw_;    // 阵列的交织数据
+    std::vector<int16_t> mono_;   // 波束形成输出
+    bool array_ok_ = false;
+    const char* TAG = "MyMicArrayCodec";
+
+    static BeamformerConfig MakeBeamformerConfig() {
+        BeamformerConfig cfg;
+        cfg.sample_rate = AUDIO_INPUT_SAMPLE_RATE;
+        cfg.channels = AUDIO_MIC_ARRAY_COUNT;
+        cfg.spacing_mm = AUDIO_MIC_ARRAY_SPACING_MM;
+        cfg.max_block = AUDIO_CODEC_DMA_FRAME_NUM;
+        return cfg;
+    }
+
+public:
+    MyMicArrayCodec(i2c_master_bus_handle_t bus_handle)
+        : MyEs8311Codec(bus_handle),
+          mics_(bus_handle, AUDIO_MIC_ARRAY_COUNT),
+          beamformer_(MakeBeamformerConfig()) {}
+
+    void Init() override {
+        MyEs8311Codec::Init();
+
+        // 阵列的接收队列溢出同样计入 GetLinkStats()
+        i2s_event_callbacks_t rx_cbs = {};
+        rx_cbs.on_recv_q_ovf = audio_i2s_on_recv_q_ovf;
+        if (!beamformer_.valid() || !mics_.Init(&rx_cbs, &link_counters_)) {
+            ESP_LOGE(TAG, "Mic array unavailable, falling back to ES8311 microphone");
+            return;
+        }
+        // 采集改由阵列负责：停掉 ES8311 的接收通道，否则没人读取的 DMA 队列会一直溢出
+        ESP_ERROR_CHECK(i2s_channel_disable(rx_handle_));
+        raw_.resize(AUDIO_CODEC_DMA_FRAME_NUM * mics_.channels());
+        mono_.resize(AUDIO_CODEC_DMA_FRAME_NUM);
+        array_ok_ = true;
+        ESP_LOGI(TAG, "Capturing from %d-mic array, steering %.0f deg", mics_.channels(), beamformer_.steering());
+    }
+
+    bool SetInputGain(float db) override {
+        if (!array_ok_) {
+            return MyEs8311Codec::SetInputGain(db);
+        }
+        if (!mics_.SetInputGain(db)) {
+            ESP_LOGW(TAG, "Failed to set array input gain %.1f dB", db);
+            return false;
+        }
+        return true;
+    }
+
+    bool InputData(std::vector<int16_t>& data) override {
+        if (!array_ok_) {
+            return MyEs8311Codec::InputData(data);
+        }
+        const size_t frames = data.size() / 2;
+        // 块长不变时容量不变，不会重新分配
+        raw_.resize(frames * mics_.channels());
+        mono_.resize(frames);
+        if (!mics_.Read(raw_)) {
+            return false;
+        }
+        beamformer_.Process(raw_.data(), frames, mono_.data());
+        for (size_t i = 0; i < frames; i++) {
+            data[2 * i] = mono_[i];
+            data[2 * i + 1] = mono_[i];
+        }
+        return true;
+    }
+
+    // 运行中调整波束方向 (度，90° 为阵列正前方)，下一块生效
+    bool SetSteering(float degrees) {
+        return array_ok_ && beamformer_.SetSteering(degrees);
+    }
+};
+
 class MyBoard {
 private:
     i2c_master_bus_handle_t i2c_bus_handle_;
@@ -131,7 +368,11 @@ public:
     MyBoard() {
         InitializeI2c();
         InitializePi4ioe();
+#if AUDIO_MIC_ARRAY_COUNT > 0
+        audio_codec_ = new MyMicArrayCodec(i2c_bus_handle_);
+#else
         audio_codec_ = new MyEs8311Codec(i2c_bus_handle_);
+#endif
         audio_codec_->Init();
     }
 
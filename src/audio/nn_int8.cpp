@@ -0,0 +1,615 @@
+#include "nn_int8.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if NN_USE_ESP_NN
+#include "esp_log.h"
+#include "esp_nn.h"
+
+static const char* TAG = "NnInt8";
+#endif
+
+// ======== 定点运算 (与 TFLite 参考实现保持一致) ========
+
+static inline int32_t saturating_rounding_doubling_high_mul(int32_t a, int32_t b) {
+    bool overflow = a == b && a == INT32_MIN;
+    int64_t ab = (int64_t)a * (int64_t)b;
+    int32_t nudge = ab >= 0 ? (1 << 30) : (1 - (1 << 30));
+    int32_t high = (int32_t)((ab + nudge) / (1LL << 31));
+    return overflow ? INT32_MAX : high;
+}
+
+static inline int32_t rounding_divide_by_pot(int32_t x, int exponent) {
+    int32_t mask = (int32_t)((1LL << exponent) - 1);
+    int32_t remainder = x & mask;
+    int32_t threshold = (mask >> 1) + (x < 0 ? 1 : 0);
+    return (x >> exponent) + (remainder > threshold ? 1 : 0);
+}
+
+NnQuant nn_quantize_multiplier(double real_multiplier) {
+    NnQuant q = {0, 0};
+    if (real_multiplier <= 0.0) {
+        return q;
+    }
+    int shift = 0;
+    double frac = frexp(real_multiplier, &shift);
+    int64_t fixed = (int64_t)llround(frac * (double)(1LL << 31));
+    if (fixed == (1LL << 31)) {
+        fixed /= 2;
+        shift++;
+    }
+    if (shift < -31) {
+        return q;
+    }
+    q.multiplier = (int32_t)fixed;
+    q.shift = shift;
+    return q;
+}
+
+int32_t nn_requantize(int32_t acc, NnQuant q) {
+    int left = q.shift > 0 ? q.shift : 0;
+    int right = q.shift > 0 ? 0 : -q.shift;
+    return rounding_divide_by_pot(saturating_rounding_doubling_high_mul(acc * (1 << left), q.multiplier), right);
+}
+
+static inline int8_t nn_output(const NnLayer& l, int32_t acc, int channel) {
+    int32_t v = nn_requantize(acc, l.out_quant[channel]) + l.output_offset;
+    v = std::max<int32_t>(v, l.act_min);
+    v = std::min<int32_t>(v, l.act_max);
+    return (int8_t)v;
+}
+
+static inline int nn_pad(uint16_t in, uint16_t out, uint8_t k, uint8_t stride, bool same) {
+    if (!same) return 0;
+    int total = ((int)out - 1) * stride + k - (int)in;
+    return total > 0 ? total / 2 : 0;
+}
+
+// Σ (x + offset) * w，4 路展开
+static inline int32_t dot_s8(const int8_t* x, const int8_t* w, size_t n, int32_t offset) {
+    int32_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a0 += (int32_t)(int16_t)(x[i] + offset) * w[i];
+        a1 += (int32_t)(int16_t)(x[i + 1] + offset) * w[i + 1];
+        a2 += (int32_t)(int16_t)(x[i + 2] + offset) * w[i + 2];
+        a3 += (int32_t)(int16_t)(x[i + 3] + offset) * w[i + 3];
+    }
+    for (; i < n; i++) {
+        a0 += (int32_t)(int16_t)(x[i] + offset) * w[i];
+    }
+    return (a0 + a1) + (a2 + a3);
+}
+
+// ======== 优化实现 ========
+
+#if NN_USE_ESP_NN
+static data_dims_t nn_dims(uint16_t w, uint16_t h, uint16_t c, uint16_t extra) {
+    data_dims_t d;
+    d.width = w;
+    d.height = h;
+    d.channels = c;
+    d.extra = extra;
+    return d;
+}
+
+// esp-nn 的量化参数是乘数、移位两个数组，从 NnQuant 拆出来放在 scratch 开头，
+// 偏置为空时补一组 0；返回之后留给内核的临时缓冲
+static void* nn_esp_nn_params(const NnLayer& l, int count, void* scratch, quant_data_t* quant, const int32_t** bias) {
+    int32_t* mult = static_cast<int32_t*>(scratch);
+    int32_t* shift = mult + count;
+    int32_t* zero_bias = shift + count;
+    for (int i = 0; i < count; i++) {
+        mult[i] = l.out_quant[i].multiplier;
+        shift[i] = l.out_quant[i].shift;
+    }
+    if (!l.bias) {
+        memset(zero_bias, 0, count * sizeof(int32_t));
+    }
+    quant->mult = mult;
+    quant->shift = shift;
+    *bias = l.bias ? l.bias : zero_bias;
+    return static_cast<int8_t*>(scratch) + nn_align16((size_t)count * 3 * sizeof(int32_t));
+}
+
+static conv_params_t nn_conv_params(const NnLayer& l, int pad_x, int pad_y) {
+    conv_params_t p = {};
+    p.in_offset = l.input_offset;
+    p.out_offset = l.output_offset;
+    p.stride.width = l.stride_w;
+    p.stride.height = l.stride_h;
+    p.padding.width = pad_x;
+    p.padding.height = pad_y;
+    p.dilation.width = 1;
+    p.dilation.height = 1;
+    p.activation.min = l.act_min;
+    p.activation.max = l.act_max;
+    return p;
+}
+
+static dw_conv_params_t nn_dw_conv_params(const NnLayer& l, int pad_x, int pad_y) {
+    dw_conv_params_t p = {};
+    p.in_offset = l.input_offset;
+    p.out_offset = l.output_offset;
+    p.ch_mult = 1;
+    p.stride.width = l.stride_w;
+    p.stride.height = l.stride_h;
+    p.padding.width = pad_x;
+    p.padding.height = pad_y;
+    p.dilation.width = 1;
+    p.dilation.height = 1;
+    p.activation.min = l.act_min;
+    p.activation.max = l.act_max;
+    return p;
+}
+
+// esp-nn 实际需要的内核临时缓冲，用于核对 nn_accel_scratch_bytes() 的估计
+static size_t nn_esp_nn_scratch_needed(const NnLayer& l, NnShape in_shape, NnShape out_shape) {
+    const int pad_y = nn_pad(in_shape.h, out_shape.h, l.kh, l.stride_h, l.pad_same);
+    const int pad_x = nn_pad(in_shape.w, out_shape.w, l.kw, l.stride_w, l.pad_same);
+    const data_dims_t in_dims = nn_dims(in_shape.w, in_shape.h, in_shape.c, 1);
+    const data_dims_t out_dims = nn_dims(out_shape.w, out_shape.h, out_shape.c, 1);
+    if (l.op == NnOp::CONV2D) {
+        const data_dims_t filter_dims = nn_dims(l.kw, l.kh, in_shape.c, out_shape.c);
+        const conv_params_t params = nn_conv_params(l, pad_x, pad_y);
+        return (size_t)esp_nn_get_conv_scratch_size(&in_dims, &filter_dims, &out_dims, &params);
+    }
+    if (l.op == NnOp::DEPTHWISE_CONV2D) {
+        const data_dims_t filter_dims = nn_dims(l.kw, l.kh, in_shape.c, 1);
+        const dw_conv_params_t params = nn_dw_conv_params(l, pad_x, pad_y);
+        return (size_t)esp_nn_get_depthwise_conv_scratch_size(&in_dims, &filter_dims, &out_dims, &params);
+    }
+    return 0;
+}
+#endif
+
+void nn_conv2d(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out,
+               void* scratch) {
+    const int pad_y = nn_pad(in_shape.h, out_shape.h, l.kh, l.stride_h, l.pad_same);
+    const int pad_x = nn_pad(in_shape.w, out_shape.w, l.kw, l.stride_w, l.pad_same);
+#if NN_USE_ESP_NN
+    const data_dims_t in_dims = nn_dims(in_shape.w, in_shape.h, in_shape.c, 1);
+    const data_dims_t filter_dims = nn_dims(l.kw, l.kh, in_shape.c, out_shape.c);
+    const data_dims_t out_dims = nn_dims(out_shape.w, out_shape.h, out_shape.c, 1);
+    const conv_params_t params = nn_conv_params(l, pad_x, pad_y);
+    quant_data_t quant;
+    const int32_t* bias;
+    esp_nn_set_conv_scratch_buf(nn_esp_nn_params(l, out_shape.c, scratch, &quant, &bias));
+    esp_nn_conv_s8(&in_dims, in, &filter_dims, l.weights, bias, &out_dims, out, &params, &quant);
+#else
+    (void)scratch;
+    const size_t in_c = in_shape.c;
+    const size_t filter_size = (size_t)l.kh * l.kw * in_c;
+
+    for (int oy = 0; oy < out_shape.h; oy++) {
+        const int iy0 = oy * l.stride_h - pad_y;
+        const int ky0 = std::max(0, -iy0);
+        const int ky1 = std::min<int>(l.kh, in_shape.h - iy0);
+        for (int ox = 0; ox < out_shape.w; ox++) {
+            const int ix0 = ox * l.stride_w - pad_x;
+            const int kx0 = std::max(0, -ix0);
+            const int kx1 = std::min<int>(l.kw, in_shape.w - ix0);
+            // 有效区间内同一行的 kx 在输入中是连续的，可以合并成一次点积
+            const size_t run = (size_t)(kx1 - kx0) * in_c;
+            int8_t* dst = out + ((size_t)oy * out_shape.w + ox) * out_shape.c;
+            for (int oc = 0; oc < out_shape.c; oc++) {
+                const int8_t* filter = l.weights + oc * filter_size;
+                int32_t acc = l.bias ? l.bias[oc] : 0;
+                for (int ky = ky0; ky < ky1; ky++) {
+                    const int8_t* src = in + (((size_t)(iy0 + ky) * in_shape.w + (ix0 + kx0)) * in_c);
+                    const int8_t* w = filter + ((size_t)ky * l.kw + kx0) * in_c;
+                    acc += dot_s8(src, w, run, l.input_offset);
+                }
+                dst[oc] = nn_output(l, acc, oc);
+            }
+        }
+    }
+#endif
+}
+
+void nn_depthwise_conv2d(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out,
+                         void* scratch) {
+    const int pad_y = nn_pad(in_shape.h, out_shape.h, l.kh, l.stride_h, l.pad_same);
+    const int pad_x = nn_pad(in_shape.w, out_shape.w, l.kw, l.stride_w, l.pad_same);
+#if NN_USE_ESP_NN
+    const data_dims_t in_dims = nn_dims(in_shape.w, in_shape.h, in_shape.c, 1);
+    const data_dims_t filter_dims = nn_dims(l.kw, l.kh, in_shape.c, 1);
+    const data_dims_t out_dims = nn_dims(out_shape.w, out_shape.h, out_shape.c, 1);
+    const dw_conv_params_t params = nn_dw_conv_params(l, pad_x, pad_y);
+    quant_data_t quant;
+    const int32_t* bias;
+    esp_nn_set_depthwise_conv_scratch_buf(nn_esp_nn_params(l, in_shape.c, scratch, &quant, &bias));
+    esp_nn_depthwise_conv_s8(&in_dims, in, &filter_dims, l.weights, bias, &out_dims, out, &params, &quant);
+#else
+    int32_t* acc = static_cast<int32_t*>(scratch);
+    const size_t c = in_shape.c;
+    const int32_t offset = l.input_offset;
+
+    for (int oy = 0; oy < out_shape.h; oy++) {
+        const int iy0 = oy * l.stride_h - pad_y;
+        const int ky0 = std::max(0, -iy0);
+        const int ky1 = std::min<int>(l.kh, in_shape.h - iy0);
+        for (int ox = 0; ox < out_shape.w; ox++) {
+            const int ix0 = ox * l.stride_w - pad_x;
+            const int kx0 = std::max(0, -ix0);
+            const int kx1 = std::min<int>(l.kw, in_shape.w - ix0);
+            for (size_t ch = 0; ch < c; ch++) {
+                acc[ch] = l.bias ? l.bias[ch] : 0;
+            }
+            // 通道维连续，逐抽头对整行通道做乘加
+            for (int ky = ky0; ky < ky1; ky++) {
+                for (int kx = kx0; kx < kx1; kx++) {
+                    const int8_t* src = in + (((size_t)(iy0 + ky) * in_shape.w + (ix0 + kx)) * c);
+                    const int8_t* w = l.weights + ((size_t)ky * l.kw + kx) * c;
+                    size_t ch = 0;
+                    for (; ch + 4 <= c; ch += 4) {
+                        acc[ch] += (int32_t)(int16_t)(src[ch] + offset) * w[ch];
+                        acc[ch + 1] += (int32_t)(int16_t)(src[ch + 1] + offset) * w[ch + 1];
+                        acc[ch + 2] += (int32_t)(int16_t)(src[ch + 2] + offset) * w[ch + 2];
+                        acc[ch + 3] += (int32_t)(int16_t)(src[ch + 3] + offset) * w[ch + 3];
+                    }
+                    for (; ch < c; ch++) {
+                        acc[ch] += (int32_t)(int16_t)(src[ch] + offset) * w[ch];
+                    }
+                }
+            }
+            int8_t* dst = out + ((size_t)oy * out_shape.w + ox) * c;
+            for (size_t ch = 0; ch < c; ch++) {
+                dst[ch] = nn_output(l, acc[ch], (int)ch);
+            }
+        }
+    }
+#endif
+}
+
+void nn_dense(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out) {
+    const size_t n = in_shape.size();
+#if NN_USE_ESP_NN
+    // esp-nn 的全连接只支持整层一个乘数，按输出通道逐行调用以保留逐通道量化；
+    // 内核沿行长度向量化，逐行调用不损失并行度
+    static const int32_t kZeroBias = 0;
+    for (int o = 0; o < out_shape.c; o++) {
+        esp_nn_fully_connected_s8(in, l.input_offset, (uint16_t)n, l.weights + (size_t)o * n, 0,
+                                  l.bias ? l.bias + o : &kZeroBias, out + o, 1, l.output_offset,
+                                  l.out_quant[o].shift, l.out_quant[o].multiplier, l.act_min, l.act_max);
+    }
+#else
+    for (int o = 0; o < out_shape.c; o++) {
+        int32_t acc = (l.bias ? l.bias[o] : 0) + dot_s8(in, l.weights + (size_t)o * n, n, l.input_offset);
+        out[o] = nn_output(l, acc, o);
+    }
+#endif
+}
+
+static inline int8_t nn_pool_output(const NnLayer& l, int32_t sum, int32_t count) {
+    int32_t avg = sum > 0 ? (sum + count / 2) / count : (sum - count / 2) / count;
+    avg = std::max<int32_t>(avg, l.act_min);
+    avg = std::min<int32_t>(avg, l.act_max);
+    return (int8_t)avg;
+}
+
+void nn_avg_pool(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out,
+                 int32_t* sum) {
+    const size_t c = in_shape.c;
+    // 全局池化时窗口就是整个输入 (可能超过 255)
+    const int kh = l.kh ? l.kh : in_shape.h;
+    const int kw = l.kw ? l.kw : in_shape.w;
+    const int sh = l.kh ? l.stride_h : 1;
+    const int sw = l.kw ? l.stride_w : 1;
+    const int pad_y = l.kh ? nn_pad(in_shape.h, out_shape.h, l.kh, l.stride_h, l.pad_same) : 0;
+    const int pad_x = l.kw ? nn_pad(in_shape.w, out_shape.w, l.kw, l.stride_w, l.pad_same) : 0;
+
+    for (int oy = 0; oy < out_shape.h; oy++) {
+        const int iy0 = oy * sh - pad_y;
+        const int y0 = std::max(0, iy0), y1 = std::min<int>(in_shape.h, iy0 + kh);
+        for (int ox = 0; ox < out_shape.w; ox++) {
+            const int ix0 = ox * sw - pad_x;
+            const int x0 = std::max(0, ix0), x1 = std::min<int>(in_shape.w, ix0 + kw);
+            memset(sum, 0, c * sizeof(int32_t));
+            for (int y = y0; y < y1; y++) {
+                const int8_t* row = in + ((size_t)y * in_shape.w) * c;
+                for (int x = x0; x < x1; x++) {
+                    const int8_t* px = row + (size_t)x * c;
+                    for (size_t ch = 0; ch < c; ch++) {
+                        sum[ch] += px[ch];
+                    }
+                }
+            }
+            const int32_t count = (y1 - y0) * (x1 - x0);
+            int8_t* dst = out + ((size_t)oy * out_shape.w + ox) * c;
+            for (size_t ch = 0; ch < c; ch++) {
+                dst[ch] = count ? nn_pool_output(l, sum[ch], count) : (int8_t)l.output_offset;
+            }
+        }
+    }
+}
+
+// ======== 参考实现 ========
+
+void nn_conv2d_ref(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out) {
+    const int pad_y = nn_pad(in_shape.h, out_shape.h, l.kh, l.stride_h, l.pad_same);
+    const int pad_x = nn_pad(in_shape.w, out_shape.w, l.kw, l.stride_w, l.pad_same);
+    for (int oy = 0; oy < out_shape.h; oy++) {
+        for (int ox = 0; ox < out_shape.w; ox++) {
+            for (int oc = 0; oc < out_shape.c; oc++) {
+                int32_t acc = l.bias ? l.bias[oc] : 0;
+                for (int ky = 0; ky < l.kh; ky++) {
+                    for (int kx = 0; kx < l.kw; kx++) {
+                        int iy = oy * l.stride_h - pad_y + ky;
+                        int ix = ox * l.stride_w - pad_x + kx;
+                        if (iy < 0 || iy >= in_shape.h || ix < 0 || ix >= in_shape.w) continue;
+                        for (int ic = 0; ic < in_shape.c; ic++) {
+                            int32_t x = in[((size_t)iy * in_shape.w + ix) * in_shape.c + ic] + l.input_offset;
+                            int32_t w = l.weights[(((size_t)oc * l.kh + ky) * l.kw + kx) * in_shape.c + ic];
+                            acc += x * w;
+                        }
+                    }
+                }
+                out[((size_t)oy * out_shape.w + ox) * out_shape.c + oc] = nn_output(l, acc, oc);
+            }
+        }
+    }
+}
+
+void nn_depthwise_conv2d_ref(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out) {
+    const int pad_y = nn_pad(in_shape.h, out_shape.h, l.kh, l.stride_h, l.pad_same);
+    const int pad_x = nn_pad(in_shape.w, out_shape.w, l.kw, l.stride_w, l.pad_same);
+    for (int oy = 0; oy < out_shape.h; oy++) {
+        for (int ox = 0; ox < out_shape.w; ox++) {
+            for (int c = 0; c < in_shape.c; c++) {
+                int32_t acc = l.bias ? l.bias[c] : 0;
+                for (int ky = 0; ky < l.kh; ky++) {
+                    for (int kx = 0; kx < l.kw; kx++) {
+                        int iy = oy * l.stride_h - pad_y + ky;
+                        int ix = ox * l.stride_w - pad_x + kx;
+                        if (iy < 0 || iy >= in_shape.h || ix < 0 || ix >= in_shape.w) continue;
+                        int32_t x = in[((size_t)iy * in_shape.w + ix) * in_shape.c + c] + l.input_offset;
+                        int32_t w = l.weights[((size_t)ky * l.kw + kx) * in_shape.c + c];
+                        acc += x * w;
+                    }
+                }
+                out[((size_t)oy * out_shape.w + ox) * in_shape.c + c] = nn_output(l, acc, c);
+            }
+        }
+    }
+}
+
+void nn_dense_ref(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out) {
+    const size_t n = in_shape.size();
+    for (int o = 0; o < out_shape.c; o++) {
+        int32_t acc = l.bias ? l.bias[o] : 0;
+        for (size_t i = 0; i < n; i++) {
+            acc += (in[i] + l.input_offset) * (int32_t)l.weights[(size_t)o * n + i];
+        }
+        out[o] = nn_output(l, acc, o);
+    }
+}
+
+void nn_avg_pool_ref(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out) {
+    const int kh = l.kh ? l.kh : in_shape.h;
+    const int kw = l.kw ? l.kw : in_shape.w;
+    const int sh = l.kh ? l.stride_h : 1;
+    const int sw = l.kw ? l.stride_w : 1;
+    const int pad_y = l.kh ? nn_pad(in_shape.h, out_shape.h, l.kh, l.stride_h, l.pad_same) : 0;
+    const int pad_x = l.kw ? nn_pad(in_shape.w, out_shape.w, l.kw, l.stride_w, l.pad_same) : 0;
+    for (int oy = 0; oy < out_shape.h; oy++) {
+        for (int ox = 0; ox < out_shape.w; ox++) {
+            for (int c = 0; c < in_shape.c; c++) {
+                int32_t sum = 0, count = 0;
+                for (int ky = 0; ky < kh; ky++) {
+                    for (int kx = 0; kx < kw; kx++) {
+                        int iy = oy * sh - pad_y + ky;
+                        int ix = ox * sw - pad_x + kx;
+                        if (iy < 0 || iy >= in_shape.h || ix < 0 || ix >= in_shape.w) continue;
+                        sum += in[((size_t)iy * in_shape.w + ix) * in_shape.c + c];
+                        count++;
+                    }
+                }
+                out[((size_t)oy * out_shape.w + ox) * in_shape.c + c] =
+                    count ? nn_pool_output(l, sum, count) : (int8_t)l.output_offset;
+            }
+        }
+    }
+}
+
+// ======== 解释器 ========
+
+NnInterpreter::NnInterpreter(const NnModel& model, int8_t* arena, size_t arena_bytes)
+    : model_(model), arena_(arena) {
+    scratch_bytes_ = nn_scratch_bytes(model.layers, model.num_layers, model.input);
+    tensor_bytes_ = nn_tensor_bytes(model.layers, model.num_layers, model.input);
+    if (!arena_ || arena_bytes < scratch_bytes_ + tensor_bytes_ || model.input.size() == 0) {
+        return;
+    }
+    NnShape s = model.input;
+    for (size_t i = 0; i < model.num_layers; i++) {
+        const NnLayer& l = model.layers[i];
+        const NnShape in = s;
+        s = nn_layer_output_shape(l, s);
+        if (s.size() == 0 || (l.op != NnOp::AVG_POOL && (!l.weights || !l.out_quant))) {
+            return;
+        }
+#if NN_USE_ESP_NN
+        // 全连接的行长度是 uint16_t；卷积的临时缓冲以 esp-nn 的计算为准
+        if (l.op == NnOp::DENSE && in.size() > UINT16_MAX) {
+            return;
+        }
+        size_t needed = nn_esp_nn_scratch_needed(l, in, s);
+        if (needed > nn_accel_scratch_bytes(l, in)) {
+            ESP_LOGE(TAG, "layer %u: esp-nn needs %u scratch bytes, planned %u", (unsigned)i, (unsigned)needed,
+                     (unsigned)nn_accel_scratch_bytes(l, in));
+            return;
+        }
+#else
+        (void)in;
+#endif
+    }
+    output_shape_ = s;
+    valid_ = true;
+}
+
+int8_t* NnInterpreter::tensor(size_t index) const {
+    // 偶数张量在低端，奇数张量靠高端对齐
+    int8_t* base = arena_ + scratch_bytes_;
+    if (index % 2 == 0) {
+        return base;
+    }
+    NnShape s = model_.input;
+    for (size_t i = 0; i < index; i++) {
+        s = nn_layer_output_shape(model_.layers[i], s);
+    }
+    return base + tensor_bytes_ - s.size();
+}
+
+const int8_t* NnInterpreter::output() const {
+    return valid_ ? tensor(model_.num_layers) : nullptr;
+}
+
+bool NnInterpreter::Invoke(bool reference) {
+    if (!valid_) return false;
+    AudioPerfScope scope(perf_);
+    int32_t* scratch = reinterpret_cast<int32_t*>(arena_);
+    int8_t* base = arena_ + scratch_bytes_;
+
+    NnShape in_shape = model_.input;
+    for (size_t i = 0; i < model_.num_layers; i++) {
+        const NnLayer& l = model_.layers[i];
+        NnShape out_shape = nn_layer_output_shape(l, in_shape);
+        const int8_t* in = i % 2 == 0 ? base : base + tensor_bytes_ - in_shape.size();
+        int8_t* out = i % 2 == 0 ? base + tensor_bytes_ - out_shape.size() : base;
+        switch (l.op) {
+            case NnOp::CONV2D:
+                reference ? nn_conv2d_ref(l, in_shape, in, out_shape, out)
+                          : nn_conv2d(l, in_shape, in, out_shape, out, scratch);
+                break;
+            case NnOp::DEPTHWISE_CONV2D:
+                reference ? nn_depthwise_conv2d_ref(l, in_shape, in, out_shape, out)
+                          : nn_depthwise_conv2d(l, in_shape, in, out_shape, out, scratch);
+                break;
+            case NnOp::DENSE:
+                reference ? nn_dense_ref(l, in_shape, in, out_shape, out)
+                          : nn_dense(l, in_shape, in, out_shape, out);
+                break;
+            case NnOp::AVG_POOL:
+                reference ? nn_avg_pool_ref(l, in_shape, in, out_shape, out)
+                          : nn_avg_pool(l, in_shape, in, out_shape, out, scratch);
+                break;
+        }
+        in_shape = out_shape;
+    }
+    return true;
+}
+
+// ======== 自检 ========
+
+namespace {
+
+struct TestRng {
+    uint32_t state;
+    uint32_t next() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+    int range(int lo, int hi) { return lo + (int)(next() % (uint32_t)(hi - lo + 1)); }
+};
+
+struct TestCase {
+    const char* name;
+    NnOp op;
+    NnShape in;
+    uint16_t out_c;
+    uint8_t k, stride;
+    bool same;
+};
+
+int run_case(const TestCase& tc, TestRng& rng, bool verbose) {
+    NnLayer l = {};
+    l.op = tc.op;
+    l.out_c = tc.out_c;
+    l.kh = l.kw = tc.k;
+    l.stride_h = l.stride_w = tc.stride;
+    l.pad_same = tc.same;
+    l.input_offset = rng.range(-20, 20);
+    l.output_offset = rng.range(-10, 10);
+    l.act_min = tc.op == NnOp::AVG_POOL ? -128 : (int8_t)l.output_offset;   // 融合 ReLU
+    l.act_max = 127;
+
+    NnShape out = nn_layer_output_shape(l, tc.in);
+    size_t out_c = out.c;
+    size_t weight_count = 0;
+    switch (tc.op) {
+        case NnOp::CONV2D: weight_count = out_c * tc.k * tc.k * tc.in.c; break;
+        case NnOp::DEPTHWISE_CONV2D: weight_count = (size_t)tc.k * tc.k * tc.in.c; break;
+        case NnOp::DENSE: weight_count = out_c * tc.in.size(); break;
+        case NnOp::AVG_POOL: break;
+    }
+    std::vector<int8_t> input(tc.in.size()), weights(weight_count);
+    std::vector<int32_t> bias(out_c);
+    std::vector<NnQuant> quant(out_c);
+    for (auto& v : input) v = (int8_t)rng.range(-128, 127);
+    for (auto& v : weights) v = (int8_t)rng.range(-127, 127);
+    for (auto& v : bias) v = rng.range(-5000, 5000);
+    for (auto& q : quant) q = nn_quantize_multiplier(0.0005 + (rng.next() % 1000) * 0.00001);
+    l.weights = weights.data();
+    l.bias = bias.data();
+    l.out_quant = quant.data();
+
+    std::vector<int8_t> out_opt(out.size()), out_ref(out.size());
+    // 按 int32 分配以保证对齐
+    std::vector<int32_t> scratch(nn_layer_scratch_bytes(l, tc.in) / sizeof(int32_t) + 4);
+    switch (tc.op) {
+        case NnOp::CONV2D:
+            nn_conv2d(l, tc.in, input.data(), out, out_opt.data(), scratch.data());
+            nn_conv2d_ref(l, tc.in, input.data(), out, out_ref.data());
+            break;
+        case NnOp::DEPTHWISE_CONV2D:
+            nn_depthwise_conv2d(l, tc.in, input.data(), out, out_opt.data(), scratch.data());
+            nn_depthwise_conv2d_ref(l, tc.in, input.data(), out, out_ref.data());
+            break;
+        case NnOp::DENSE:
+            nn_dense(l, tc.in, input.data(), out, out_opt.data());
+            nn_dense_ref(l, tc.in, input.data(), out, out_ref.data());
+            break;
+        case NnOp::AVG_POOL:
+            nn_avg_pool(l, tc.in, input.data(), out, out_opt.data(), scratch.data());
+            nn_avg_pool_ref(l, tc.in, input.data(), out, out_ref.data());
+            break;
+    }
+    bool ok = out_opt == out_ref;
+    if (verbose || !ok) {
+        printf("nn %-18s %2ux%2ux%2u -> %2ux%2ux%2u: %s\n", tc.name, tc.in.h, tc.in.w, tc.in.c,
+               out.h, out.w, out.c, ok ? "bit-exact" : "MISMATCH");
+    }
+    return ok ? 0 : 1;
+}
+
+} // namespace
+
+int nn_self_test(bool verbose) {
+    static const TestCase kCases[] = {
+        {"conv3x3 same s1", NnOp::CONV2D, {12, 10, 3}, 8, 3, 1, true},
+        {"conv3x3 valid s2", NnOp::CONV2D, {13, 11, 5}, 6, 3, 2, false},
+        {"conv1x1", NnOp::CONV2D, {6, 7, 16}, 12, 1, 1, false},
+        {"conv5x5 same s2", NnOp::CONV2D, {20, 9, 1}, 4, 5, 2, true},
+        {"dw3x3 same s1", NnOp::DEPTHWISE_CONV2D, {10, 10, 13}, 0, 3, 1, true},
+        {"dw3x3 same s2", NnOp::DEPTHWISE_CONV2D, {11, 9, 8}, 0, 3, 2, true},
+        {"dw5x5 valid", NnOp::DEPTHWISE_CONV2D, {9, 9, 7}, 0, 5, 1, false},
+        {"dense", NnOp::DENSE, {1, 1, 67}, 10, 0, 0, false},
+        {"dense 2d input", NnOp::DENSE, {4, 5, 3}, 7, 0, 0, false},
+        {"avgpool global", NnOp::AVG_POOL, {7, 5, 9}, 0, 0, 0, false},
+        {"avgpool 2x2 s2", NnOp::AVG_POOL, {9, 8, 6}, 0, 2, 2, true},
+    };
+    TestRng rng = {0x1234567u};
+    int failures = 0;
+    for (const auto& tc : kCases) {
+        for (int rep = 0; rep < 4; rep++) {
+            failures += run_case(tc, rng, verbose && rep == 0);
+        }
+    }
+    return failures;
+}
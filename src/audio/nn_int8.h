@@ -0,0 +1,221 @@
+#ifndef NN_INT8_H
+#define NN_INT8_H
+
+#include <cstddef>
+#include <cstdint>
+#include "audio_perf.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+// ESP32-S3 上卷积、深度卷积和全连接调用 esp-nn 的 PIE 汇编内核，其他平台 (包括主机) 编译本库的 C 实现
+#if defined(ESP_PLATFORM) && defined(CONFIG_IDF_TARGET_ESP32S3)
+#define NN_USE_ESP_NN 1
+#else
+#define NN_USE_ESP_NN 0
+#endif
+
+// 小型 int8 量化推理引擎，用于本地音频事件分类 (咳嗽、打鼾、呼救等)。
+// 量化方案与 TFLite Micro 一致：激活非对称 int8，权重对称 int8 (零点为 0)，
+// 偏置 int32，按输出通道的定点乘数重新量化。因此可以直接导入 TFLite 训练后量化的模型参数。
+// 每个算子都有一个逐元素的参考实现 (*_ref)，优化实现只改变整数累加的顺序，
+// 结果必须与参考实现逐字节一致，nn_self_test() 在主机和设备上都可以验证这一点。
+
+// 定点乘数：real = multiplier * 2^(shift - 31)，multiplier 取值 [2^30, 2^31)
+struct NnQuant {
+    int32_t multiplier;
+    int32_t shift;
+};
+
+/**
+ * @brief 把实数缩放系数转换成定点乘数 (在主机上生成模型参数时使用)
+ */
+NnQuant nn_quantize_multiplier(double real_multiplier);
+
+/**
+ * @brief acc * real_multiplier，带舍入 (与 TFLite MultiplyByQuantizedMultiplier 相同)
+ */
+int32_t nn_requantize(int32_t acc, NnQuant q);
+
+// NHWC，batch 固定为 1
+struct NnShape {
+    uint16_t h;
+    uint16_t w;
+    uint16_t c;
+    constexpr size_t size() const { return (size_t)h * w * c; }
+};
+
+enum class NnOp : uint8_t {
+    CONV2D,            // 权重 [out_c][kh][kw][in_c]
+    DEPTHWISE_CONV2D,  // 权重 [kh][kw][c]，通道乘数固定为 1
+    DENSE,             // 权重 [out_c][in_size]，输入按扁平向量处理
+    AVG_POOL,          // kh/kw 为 0 时为全局平均池化；输入输出量化参数必须相同
+};
+
+struct NnLayer {
+    NnOp op;
+    uint16_t out_c;          // CONV2D / DENSE 的输出通道数，其余算子忽略
+    uint8_t kh, kw;
+    uint8_t stride_h, stride_w;
+    bool pad_same;           // true: SAME 填充，false: VALID
+    const int8_t* weights;
+    const int32_t* bias;     // 可为 nullptr
+    const NnQuant* out_quant;// 按输出通道，AVG_POOL 不使用
+    int32_t input_offset;    // = -输入零点
+    int32_t output_offset;   // = 输出零点
+    int8_t act_min;          // 融合的激活函数 (ReLU 即 act_min = 输出零点)
+    int8_t act_max;
+};
+
+struct NnModel {
+    const NnLayer* layers;
+    size_t num_layers;
+    NnShape input;
+};
+
+// ======== 静态内存规划 ========
+// 顺序模型中张量 i 只在第 i-1 层 (输出) 和第 i 层 (输入) 存活，
+// 偶数张量放在竞技场低端，奇数张量放在高端，竞技场大小取相邻两个张量之和的最大值。
+// 全部为 constexpr，模型定义为 constexpr 时可以直接声明静态数组：
+//   static int8_t arena[nn_arena_bytes(kLayers, kNumLayers, kInput)];
+
+constexpr uint16_t nn_conv_out_dim(uint16_t in, uint8_t k, uint8_t stride, bool same) {
+    return stride == 0 ? 0 : same ? (uint16_t)((in + stride - 1) / stride)
+                                  : (in < k ? 0 : (uint16_t)((in - k) / stride + 1));
+}
+
+constexpr NnShape nn_layer_output_shape(const NnLayer& l, NnShape in) {
+    switch (l.op) {
+        case NnOp::CONV2D:
+            return NnShape{nn_conv_out_dim(in.h, l.kh, l.stride_h, l.pad_same),
+                           nn_conv_out_dim(in.w, l.kw, l.stride_w, l.pad_same), l.out_c};
+        case NnOp::DEPTHWISE_CONV2D:
+            return NnShape{nn_conv_out_dim(in.h, l.kh, l.stride_h, l.pad_same),
+                           nn_conv_out_dim(in.w, l.kw, l.stride_w, l.pad_same), in.c};
+        case NnOp::DENSE:
+            return NnShape{1, 1, l.out_c};
+        case NnOp::AVG_POOL:
+            return l.kh == 0 ? NnShape{1, 1, in.c}
+                             : NnShape{nn_conv_out_dim(in.h, l.kh, l.stride_h, l.pad_same),
+                                       nn_conv_out_dim(in.w, l.kw, l.stride_w, l.pad_same), in.c};
+    }
+    return NnShape{0, 0, 0};
+}
+
+constexpr size_t nn_align16(size_t bytes) { return (bytes + 15) & ~(size_t)15; }
+
+// esp-nn 卷积/深度卷积内核的临时缓冲上限：内核会把输入补零后重排、把权重重排，
+// 按 2 * (权重 + 补零后的输入) 加对齐余量估计；NnInterpreter 构造时用 esp-nn 自己的计算结果核对
+constexpr size_t nn_accel_scratch_bytes(const NnLayer& l, NnShape in) {
+    size_t filter = (size_t)l.kh * l.kw * in.c * (l.op == NnOp::CONV2D ? l.out_c : 1);
+    size_t padded = (size_t)(in.h + l.kh + l.stride_h) * (in.w + l.kw + l.stride_w) * in.c;
+    return nn_align16(2 * (filter + padded) + 16 * (size_t)in.c + 64);
+}
+
+// 单层的临时缓冲：
+// C 实现中深度卷积和池化每个输出像素需要 c 个 int32 累加器；
+// esp-nn 卷积需要按输出通道拆开的乘数/移位/偏置 3 个 int32 数组，后面跟内核自己的临时缓冲
+constexpr size_t nn_layer_scratch_bytes(const NnLayer& l, NnShape in) {
+    switch (l.op) {
+        case NnOp::CONV2D:
+            return NN_USE_ESP_NN ? nn_align16((size_t)l.out_c * 3 * sizeof(int32_t)) + nn_accel_scratch_bytes(l, in) : 0;
+        case NnOp::DEPTHWISE_CONV2D:
+            return NN_USE_ESP_NN ? nn_align16((size_t)in.c * 3 * sizeof(int32_t)) + nn_accel_scratch_bytes(l, in)
+                                 : nn_align16((size_t)in.c * sizeof(int32_t));
+        case NnOp::AVG_POOL:
+            return nn_align16((size_t)in.c * sizeof(int32_t));
+        case NnOp::DENSE:
+            return 0;
+    }
+    return 0;
+}
+
+constexpr size_t nn_scratch_bytes(const NnLayer* layers, size_t n, NnShape input) {
+    size_t scratch = 0;
+    NnShape s = input;
+    for (size_t i = 0; i < n; i++) {
+        size_t b = nn_layer_scratch_bytes(layers[i], s);
+        scratch = b > scratch ? b : scratch;
+        s = nn_layer_output_shape(layers[i], s);
+    }
+    return scratch;
+}
+
+constexpr size_t nn_tensor_bytes(const NnLayer* layers, size_t n, NnShape input) {
+    size_t bytes = 0;
+    NnShape s = input;
+    for (size_t i = 0; i < n; i++) {
+        NnShape o = nn_layer_output_shape(layers[i], s);
+        size_t pair = s.size() + o.size();
+        bytes = pair > bytes ? pair : bytes;
+        s = o;
+    }
+    return n == 0 ? input.size() : bytes;
+}
+
+constexpr size_t nn_arena_bytes(const NnLayer* layers, size_t n, NnShape input) {
+    return nn_scratch_bytes(layers, n, input) + nn_tensor_bytes(layers, n, input);
+}
+
+// ======== 算子 ========
+// 优化实现：NN_USE_ESP_NN 时卷积、深度卷积和全连接转给 esp-nn (量化方案与 TFLite 相同，结果一致)；
+// 否则以及池化用 C 实现，内层循环沿连续内存 (通道维) 展开。两种实现都必须与参考实现逐字节一致。
+// scratch 至少 nn_layer_scratch_bytes() 字节，16 字节对齐
+
+void nn_conv2d(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out,
+               void* scratch);
+void nn_depthwise_conv2d(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out,
+                         void* scratch);
+void nn_dense(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out);
+void nn_avg_pool(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out,
+                 int32_t* scratch);
+
+// 参考实现：逐输出元素直接按定义计算，供主机逐字节比对
+void nn_conv2d_ref(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out);
+void nn_depthwise_conv2d_ref(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out);
+void nn_dense_ref(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out);
+void nn_avg_pool_ref(const NnLayer& l, NnShape in_shape, const int8_t* in, NnShape out_shape, int8_t* out);
+
+// ======== 解释器 ========
+
+class NnInterpreter {
+public:
+    /**
+     * @param arena 至少 nn_arena_bytes() 字节，16 字节对齐，由调用者静态分配
+     */
+    NnInterpreter(const NnModel& model, int8_t* arena, size_t arena_bytes);
+
+    bool valid() const { return valid_; }
+    int8_t* input() { return tensor(0); }
+    const int8_t* output() const;
+    NnShape input_shape() const { return model_.input; }
+    NnShape output_shape() const { return output_shape_; }
+
+    /**
+     * @brief 执行一次推理
+     * @param reference true 时使用参考实现 (用于比对)
+     */
+    bool Invoke(bool reference = false);
+
+    const AudioPerfCounter& perf() const { return perf_; }
+
+private:
+    int8_t* tensor(size_t index) const;
+
+    NnModel model_;
+    int8_t* arena_;
+    size_t scratch_bytes_;
+    size_t tensor_bytes_;
+    NnShape output_shape_{0, 0, 0};
+    bool valid_ = false;
+    AudioPerfCounter perf_;
+};
+
+/**
+ * @brief 随机生成各类算子，比对优化实现与参考实现是否逐字节一致
+ * @return 不一致的用例数，0 表示全部通过
+ */
+int nn_self_test(bool verbose);
+
+#endif // NN_INT8_H
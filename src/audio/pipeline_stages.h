@@ -0,0 +1,126 @@
+#ifndef PIPELINE_STAGES_H
+#define PIPELINE_STAGES_H
+
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include "audio_pipeline.h"
+#include "audio_agc.h"
+#include "biquad_eq.h"
+#include "loudness.h"
+
+// AudioPipeline 的常用阶段。Map 阶段保持无状态，才能被融合进同一次遍历。
+
+// ======== Map ========
+
+// 固定增益 (Q12 定点，±18dB 以内精度足够)
+struct GainStage : PipelineStage {
+    static constexpr StageKind kKind = StageKind::Map;
+    const char* name() const { return "gain"; }
+
+    explicit GainStage(float gain) : q12_((int32_t)lrintf(gain * 4096.0f)) {}
+    static GainStage FromDb(float db) { return GainStage(powf(10.0f, db / 20.0f)); }
+
+    int32_t Sample(int32_t x) const { return (x * q12_) >> 12; }
+
+private:
+    int32_t q12_;
+};
+
+// 固定直流偏置 (例如校正 ADC 的已知偏移)
+struct OffsetStage : PipelineStage {
+    static constexpr StageKind kKind = StageKind::Map;
+    const char* name() const { return "offset"; }
+
+    explicit OffsetStage(int32_t offset) : offset_(offset) {}
+    int32_t Sample(int32_t x) const { return x + offset_; }
+
+private:
+    int32_t offset_;
+};
+
+// ======== Block ========
+
+// 采集 AGC (audio_agc.h)，AGC 对象由调用方持有
+struct AgcStage : PipelineStage {
+    static constexpr StageKind kKind = StageKind::Block;
+    const char* name() const { return "agc"; }
+
+    explicit AgcStage(AudioAgc& agc) : agc_(&agc) {}
+    size_t Process(int16_t* data, size_t frames, int channels, uint8_t*) {
+        agc_->Process(data, frames * channels);
+        return frames;
+    }
+
+private:
+    AudioAgc* agc_;
+};
+
+// 播放响度归一化 + 压缩/限幅 (loudness.h)，对象由调用方持有
+struct LoudnessStage : PipelineStage {
+    static constexpr StageKind kKind = StageKind::Block;
+    const char* name() const { return "loudness"; }
+
+    explicit LoudnessStage(LoudnessProcessor& proc) : proc_(&proc) {}
+    size_t Process(int16_t* data, size_t frames, int channels, uint8_t*) {
+        proc_->Process(data, frames * channels);
+        return frames;
+    }
+
+private:
+    LoudnessProcessor* proc_;
+};
+
+// 定点二阶节级联 (biquad_eq.h)，对象由调用方持有，可在其他任务中更新系数
+struct BiquadStage : PipelineStage {
+    static constexpr StageKind kKind = StageKind::Block;
+    const char* name() const { return "eq"; }
+
+    explicit BiquadStage(BiquadCascade& eq) : eq_(&eq) {}
+    size_t Process(int16_t* data, size_t frames, int, uint8_t*) {
+        eq_->Process(data, frames);
+        return frames;
+    }
+
+private:
+    BiquadCascade* eq_;
+};
+
+// 立体声下混为单声道，原地写到缓冲前半部分
+struct DownmixStage : PipelineStage {
+    static constexpr StageKind kKind = StageKind::Block;
+    const char* name() const { return "downmix"; }
+    static constexpr int kInChannels = 2;
+    static constexpr int kOutChannels = 1;
+
+    size_t Process(int16_t* data, size_t frames, int, uint8_t*) {
+        for (size_t i = 0; i < frames; i++) {
+            data[i] = (int16_t)(((int32_t)data[2 * i] + data[2 * i + 1]) >> 1);
+        }
+        return frames;
+    }
+};
+
+// ======== Tap ========
+
+// 把任意可调用对象 f(const int16_t* data, size_t frames, int channels) 接成只读分支，
+// name 会出现在流水线的统计输出中
+template <typename F>
+struct TapStage : PipelineStage {
+    static constexpr StageKind kKind = StageKind::Tap;
+
+    TapStage(const char* name, F f) : name_(name), f_(std::move(f)) {}
+    const char* name() const { return name_; }
+    void Consume(const int16_t* data, size_t frames, int channels) { f_(data, frames, channels); }
+
+private:
+    const char* name_;
+    F f_;
+};
+
+template <typename F>
+TapStage<F> make_tap_stage(const char* name, F f) {
+    return TapStage<F>(name, std::move(f));
+}
+
+#endif // PIPELINE_STAGES_H
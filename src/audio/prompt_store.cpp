@@ -0,0 +1,219 @@
+#include "prompt_store.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+static const char* TAG = "PromptStore";
+#define PROMPT_LOGE(...) ESP_LOGE(TAG, __VA_ARGS__)
+#define PROMPT_LOGI(...) ESP_LOGI(TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define PROMPT_LOGE(...) (printf(__VA_ARGS__), printf("\n"))
+#define PROMPT_LOGI(...) (printf(__VA_ARGS__), printf("\n"))
+#endif
+
+// 与 zlib.crc32 一致 (tools/prompt_pack.py 使用)
+static uint32_t prompt_crc32(const uint8_t* data, size_t size) {
+#ifdef ESP_PLATFORM
+    return esp_rom_crc32_le(0, data, size);
+#else
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+#endif
+}
+
+// ======== PromptStore ========
+
+PromptStore::~PromptStore() {
+#ifdef ESP_PLATFORM
+    if (mapped_) {
+        esp_partition_munmap(mmap_handle_);
+    }
+#endif
+}
+
+bool PromptStore::Init(const char* partition_label) {
+#ifdef ESP_PLATFORM
+    const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           (esp_partition_subtype_t)PROMPT_PARTITION_SUBTYPE,
+                                                           partition_label);
+    if (!part) {
+        PROMPT_LOGE("Partition '%s' not found", partition_label);
+        return false;
+    }
+
+    // 先读头部得到资源包实际大小，只映射用到的部分
+    PromptPackHeader header;
+    if (esp_partition_read(part, 0, &header, sizeof(header)) != ESP_OK ||
+        header.magic != PROMPT_PACK_MAGIC || header.total_size > part->size) {
+        PROMPT_LOGI("No prompt pack in '%s' (build one with tools/prompt_pack.py)", partition_label);
+        return false;
+    }
+
+    const void* ptr = nullptr;
+    esp_err_t ret = esp_partition_mmap(part, 0, header.total_size, ESP_PARTITION_MMAP_DATA, &ptr, &mmap_handle_);
+    if (ret != ESP_OK) {
+        PROMPT_LOGE("mmap failed: %s", esp_err_to_name(ret));
+        return false;
+    }
+    mapped_ = true;
+    if (!Parse(static_cast<const uint8_t*>(ptr), header.total_size)) {
+        esp_partition_munmap(mmap_handle_);
+        mapped_ = false;
+        return false;
+    }
+    PROMPT_LOGI("Mapped %u prompts (%u KB) from '%s'", (unsigned)count(),
+                (unsigned)(header.total_size / 1024), partition_label);
+    return true;
+#else
+    (void)partition_label;
+    return false;
+#endif
+}
+
+bool PromptStore::InitFromMemory(const uint8_t* data, size_t size) {
+    return Parse(data, size);
+}
+
+bool PromptStore::Parse(const uint8_t* data, size_t size) {
+    base_ = nullptr;
+    header_ = nullptr;
+    entries_ = nullptr;
+    if (size < sizeof(PromptPackHeader)) return false;
+
+    const PromptPackHeader* h = reinterpret_cast<const PromptPackHeader*>(data);
+    if (h->magic != PROMPT_PACK_MAGIC || h->version != PROMPT_PACK_VERSION) {
+        PROMPT_LOGE("Bad prompt pack magic/version");
+        return false;
+    }
+    const size_t index_end = sizeof(PromptPackHeader) + (size_t)h->count * sizeof(PromptEntry);
+    if (h->total_size > size || index_end > h->data_offset || h->data_offset > h->total_size) {
+        PROMPT_LOGE("Bad prompt pack layout");
+        return false;
+    }
+    const PromptEntry* e = reinterpret_cast<const PromptEntry*>(data + sizeof(PromptPackHeader));
+    if (prompt_crc32(reinterpret_cast<const uint8_t*>(e), h->count * sizeof(PromptEntry)) != h->index_crc32) {
+        PROMPT_LOGE("Prompt index CRC mismatch");
+        return false;
+    }
+
+    // 逐条检查边界和格式，之后播放时不再做这些检查
+    for (size_t i = 0; i < h->count; i++) {
+        const PromptEntry& p = e[i];
+        bool ok = memchr(p.name, 0, PROMPT_NAME_MAX) != nullptr &&
+                  p.offset >= h->data_offset && (p.offset & 3) == 0 &&
+                  p.size <= h->total_size - p.offset &&
+                  (p.channels == 1 || p.channels == 2) && p.sample_rate > 0;
+        if (ok && p.format == PROMPT_FORMAT_PCM16) {
+            ok = (uint64_t)p.samples * p.channels * sizeof(int16_t) == p.size;
+        } else if (ok && p.format == PROMPT_FORMAT_IMA_ADPCM) {
+            size_t spb = p.block_align > 4 ? IMA_ADPCM_SAMPLES_PER_BLOCK(p.block_align) : 0;
+            ok = p.channels == 1 && p.block_align > 4 && p.block_align <= IMA_ADPCM_BLOCK_ALIGN &&
+                 p.size == (p.samples + spb - 1) / spb * p.block_align;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            PROMPT_LOGE("Bad prompt entry %u", (unsigned)i);
+            return false;
+        }
+    }
+
+    base_ = data;
+    header_ = h;
+    entries_ = e;
+    return true;
+}
+
+const PromptEntry* PromptStore::Find(const char* name) const {
+    for (size_t i = 0; i < count(); i++) {
+        if (strncmp(entries_[i].name, name, PROMPT_NAME_MAX) == 0) {
+            return &entries_[i];
+        }
+    }
+    return nullptr;
+}
+
+bool PromptStore::Verify(const PromptEntry* e) const {
+    return valid() && e && prompt_crc32(data(e), e->size) == e->crc32;
+}
+
+// ======== PromptPlayer ========
+
+PromptPlayer::PromptPlayer(const PromptStore& store, const PromptEntry* entry, int output_rate) {
+    Open(store, entry, output_rate);
+}
+
+bool PromptPlayer::Open(const PromptStore& store, const PromptEntry* entry, int output_rate) {
+    entry_ = entry;
+    data_ = nullptr;
+    valid_ = false;
+    pos_ = 0;
+    total_ = 0;
+    block_index_ = (size_t)-1;
+    if (!store.valid() || !entry) return false;
+    if ((int)entry->sample_rate != output_rate) {
+        // 资源在打包时就按输出采样率重采样，运行时不做转换
+        PROMPT_LOGE("Prompt '%s' is %u Hz, output is %d Hz", entry->name, (unsigned)entry->sample_rate, output_rate);
+        return false;
+    }
+    data_ = store.data(entry);
+    total_ = entry->samples;
+    valid_ = true;
+    return true;
+}
+
+void PromptPlayer::Rewind() {
+    pos_ = 0;
+}
+
+size_t PromptPlayer::Next(int16_t* scratch, size_t max_frames, const int16_t** out) {
+    if (!valid_ || pos_ >= total_ || max_frames == 0) return 0;
+    size_t n = std::min(max_frames, total_ - pos_);
+
+    if (entry_->format == PROMPT_FORMAT_PCM16) {
+        const int16_t* src = reinterpret_cast<const int16_t*>(data_);
+        if (entry_->channels == 2) {
+            // 零拷贝：直接交出映射区的指针
+            *out = src + pos_ * 2;
+        } else {
+            const int16_t* mono = src + pos_;
+            for (size_t i = 0; i < n; i++) {
+                scratch[2 * i] = scratch[2 * i + 1] = mono[i];
+            }
+            *out = scratch;
+        }
+        pos_ += n;
+        return n;
+    }
+
+    // ADPCM：跨块时解码下一块，块内直接从解码缓冲扩展到立体声
+    const size_t spb = IMA_ADPCM_SAMPLES_PER_BLOCK(entry_->block_align);
+    size_t done = 0;
+    while (done < n) {
+        size_t block = (pos_ + done) / spb;
+        if (block != block_index_) {
+            ima_adpcm_decode_block(data_ + block * entry_->block_align, entry_->block_align, block_);
+            block_index_ = block;
+        }
+        size_t offset = (pos_ + done) % spb;
+        size_t len = std::min(n - done, spb - offset);
+        for (size_t i = 0; i < len; i++) {
+            int16_t v = block_[offset + i];
+            scratch[2 * (done + i)] = scratch[2 * (done + i) + 1] = v;
+        }
+        done += len;
+    }
+    pos_ += n;
+    *out = scratch;
+    return n;
+}
@@ -0,0 +1,144 @@
+#ifndef PROMPT_STORE_H
+#define PROMPT_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "adpcm.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_partition.h"
+#endif
+
+// 提示音/语音提示资源包，构建时由 tools/prompt_pack.py 打包并烧写到 prompts 分区。
+// 运行时整个分区通过 esp_partition_mmap 映射到地址空间，播放时直接从映射区读取，
+// 不会先把资源拷贝到 RAM。
+//
+// 分区布局 (小端)：
+//   PromptPackHeader (32 字节)
+//   PromptEntry[count] (每个 48 字节)
+//   资源数据，每段起始地址 4 字节对齐
+// 修改这些结构时必须同步修改 tools/prompt_pack.py 并增加版本号。
+
+#define PROMPT_PACK_MAGIC      0x544D5250u   // "PRMT"
+#define PROMPT_PACK_VERSION    1
+#define PROMPT_PARTITION_LABEL "prompts"
+#define PROMPT_PARTITION_SUBTYPE 0x40
+#define PROMPT_NAME_MAX        24
+
+enum PromptFormat : uint8_t {
+    PROMPT_FORMAT_PCM16 = 0,
+    PROMPT_FORMAT_IMA_ADPCM = 1,    // adpcm.h 中的块格式，仅单声道
+};
+
+struct PromptPackHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t data_offset;       // 第一段资源数据相对分区起始的偏移
+    uint32_t total_size;        // 整个资源包的字节数 (映射长度)
+    uint32_t index_crc32;       // PromptEntry 表的 CRC32
+    uint32_t reserved[3];
+};
+
+struct PromptEntry {
+    char name[PROMPT_NAME_MAX]; // 以 0 结尾
+    uint32_t offset;            // 相对分区起始
+    uint32_t size;              // 字节数
+    uint32_t samples;           // 每声道样本数
+    uint32_t sample_rate;
+    uint8_t format;             // PromptFormat
+    uint8_t channels;           // 1 或 2
+    uint16_t block_align;       // 仅 ADPCM
+    uint32_t crc32;             // 资源数据的 CRC32
+};
+
+static_assert(sizeof(PromptPackHeader) == 32, "PromptPackHeader layout must match tools/prompt_pack.py");
+static_assert(sizeof(PromptEntry) == 48, "PromptEntry layout must match tools/prompt_pack.py");
+
+/**
+ * @brief 只读的资源包索引，数据指针都指向 flash 映射区
+ */
+class PromptStore {
+public:
+    PromptStore() = default;
+    ~PromptStore();
+    PromptStore(const PromptStore&) = delete;
+    PromptStore& operator=(const PromptStore&) = delete;
+
+    /**
+     * @brief 映射分区并校验索引
+     */
+    bool Init(const char* partition_label = PROMPT_PARTITION_LABEL);
+
+    /**
+     * @brief 直接使用一块内存中的资源包 (主机测试或资源嵌入固件时使用)
+     */
+    bool InitFromMemory(const uint8_t* data, size_t size);
+
+    bool valid() const { return base_ != nullptr; }
+    size_t count() const { return header_ ? header_->count : 0; }
+    const PromptEntry* entry(size_t i) const { return i < count() ? &entries_[i] : nullptr; }
+    const PromptEntry* Find(const char* name) const;
+    const uint8_t* data(const PromptEntry* e) const { return base_ + e->offset; }
+
+    /**
+     * @brief 校验资源数据的 CRC (需要读完整段 flash，只在调试或首次启动时用)
+     */
+    bool Verify(const PromptEntry* e) const;
+
+private:
+    bool Parse(const uint8_t* data, size_t size);
+
+    const uint8_t* base_ = nullptr;
+    const PromptPackHeader* header_ = nullptr;
+    const PromptEntry* entries_ = nullptr;
+#ifdef ESP_PLATFORM
+    esp_partition_mmap_handle_t mmap_handle_ = 0;
+    bool mapped_ = false;
+#endif
+};
+
+/**
+ * @brief 把一个资源转换成输出格式 (交织立体声 int16) 的帧流
+ *
+ * 资源本身就是输出格式的立体声 PCM 时，Next() 直接返回映射区内的指针，
+ * 全程没有拷贝；单声道 PCM 扩展成立体声、ADPCM 先按块解码，只用调用方提供的
+ * 一帧暂存区和内部一个块大小的解码缓冲。
+ */
+class PromptPlayer {
+public:
+    PromptPlayer() = default;
+    PromptPlayer(const PromptStore& store, const PromptEntry* entry, int output_rate);
+
+    /**
+     * @brief 换成另一个资源并从头开始 (播放器可以静态分配后反复使用)
+     * @return 资源可以按 output_rate 播放时返回 true
+     */
+    bool Open(const PromptStore& store, const PromptEntry* entry, int output_rate);
+
+    bool valid() const { return valid_; }
+    bool finished() const { return pos_ >= total_; }
+    void Rewind();
+
+    /**
+     * @brief 取下一段输出帧
+     * @param scratch    调用方提供的暂存区，max_frames * 2 个样本
+     * @param max_frames 最多返回的帧数
+     * @param out        指向本段数据：映射区或 scratch
+     * @return 本段帧数，播完返回 0
+     */
+    size_t Next(int16_t* scratch, size_t max_frames, const int16_t** out);
+
+private:
+    const PromptEntry* entry_ = nullptr;
+    const uint8_t* data_ = nullptr;
+    bool valid_ = false;
+    size_t pos_ = 0;            // 已输出的帧数
+    size_t total_ = 0;
+
+    // ADPCM 解码缓冲
+    int16_t block_[IMA_ADPCM_SAMPLES_PER_BLOCK(IMA_ADPCM_BLOCK_ALIGN)];
+    size_t block_index_ = (size_t)-1;
+};
+
+#endif // PROMPT_STORE_H
@@ -0,0 +1,20 @@
+// 由 tools/biquad_design.py 生成，不要手工修改
+// biquad_design.py --name speaker_eq --rate 24000 lr4hp:180 peak:900:-4:1.2 peak:3000:3:1.0 hs:7000:4
+
+#ifndef SPEAKER_EQ_COEFFS_H
+#define SPEAKER_EQ_COEFFS_H
+
+#include "biquad_eq.h"
+
+#define SPEAKER_EQ_SAMPLE_RATE 24000
+#define SPEAKER_EQ_SECTIONS 5
+
+static const BiquadCoeffs kSpeakerEq[SPEAKER_EQ_SECTIONS] = {
+    {259638016, -519276033, 259638016, -518987642, 251128968},
+    {259638016, -519276033, 259638016, -518987642, 251128968},
+    {257628042, -465085420, 220672870, -465085420, 209865456},
+    {293825200, -292586874, 119955125, -292586874, 145344869},
+    {326201900, 57054431, 57733163, 117370879, 55183159},
+};
+
+#endif // SPEAKER_EQ_COEFFS_H
@@ -0,0 +1,105 @@
+#include "tone_detector.h"
+
+#include <algorithm>
+#include <cmath>
+
+ToneDetector::ToneDetector(const ToneTarget* targets, size_t count, const ToneDetectorConfig& config)
+    : config_(config), targets_(targets, targets + count) {
+    // 块长上限只用来约束表的内存 (每个频点 2 * block_size 个 float)
+    if (count == 0 || config_.sample_rate <= 0 || config_.block_size < 32 || config_.block_size > 1024) {
+        return;
+    }
+    for (const ToneTarget& t : targets_) {
+        if (t.freq_hz <= 0.0f || t.freq_hz >= config_.sample_rate / 2) {
+            return;
+        }
+    }
+
+    stride_ = (config_.block_size + 3) & ~(size_t)3;
+    if (!block_.Allocate(stride_, DspMemory::INTERNAL) || !basis_.Allocate(count * 2 * stride_, DspMemory::INTERNAL)) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const double w = 2.0 * M_PI * targets_[i].freq_hz / config_.sample_rate;
+        float* c = basis_.data() + i * 2 * stride_;
+        float* s = c + stride_;
+        for (size_t n = 0; n < config_.block_size; n++) {
+            c[n] = (float)cos(w * n);
+            s[n] = (float)sin(w * n);
+        }
+    }
+    block_ms_ = (uint32_t)(1000u * config_.block_size / config_.sample_rate);
+
+    level_dbfs_.assign(count, -120.0f);
+    purity_.assign(count, 0.0f);
+    on_ms_.assign(count, 0);
+    gap_ms_.assign(count, 0);
+    since_event_ms_.assign(count, config_.refractory_ms);
+    fired_.assign(count, false);
+    valid_ = true;
+}
+
+void ToneDetector::Push(const int16_t* samples, size_t count, size_t stride) {
+    if (!valid_) return;
+    AudioPerfScope scope(perf_);
+    while (count > 0) {
+        const size_t n = std::min(count, config_.block_size - block_pos_);
+        Accumulate(samples, n, stride);
+        samples += n * stride;
+        count -= n;
+        block_pos_ += n;
+        if (block_pos_ == config_.block_size) {
+            FinishBlock();
+            block_pos_ = 0;
+        }
+    }
+}
+
+void ToneDetector::Accumulate(const int16_t* samples, size_t count, size_t stride) {
+    float* dst = block_.data() + block_pos_;
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = samples[i * stride];
+    }
+}
+
+void ToneDetector::FinishBlock() {
+    const size_t len = config_.block_size;
+    const float n = (float)len;
+    const float* x = block_.data();
+    // 幅度为 A 的正弦：频点能量约 (A*N/2)^2，整块能量约 N*A^2/2
+    const float energy = dsp_dotprod_f32(x, x, len);
+
+    for (size_t i = 0; i < targets_.size(); i++) {
+        const float* c = basis_.data() + i * 2 * stride_;
+        const float re = dsp_dotprod_f32(x, c, len);
+        const float im = dsp_dotprod_f32(x, c + stride_, len);
+        const float power = re * re + im * im;
+
+        const float amplitude = 2.0f * sqrtf(power) / n;
+        level_dbfs_[i] = amplitude > 0.0f ? 20.0f * log10f(amplitude / 32768.0f) : -120.0f;
+        purity_[i] = energy > 0.0f ? std::min(1.0f, 2.0f * power / (n * energy)) : 0.0f;
+
+        since_event_ms_[i] = std::min(since_event_ms_[i] + block_ms_, config_.refractory_ms);
+        if (level_dbfs_[i] >= config_.min_level_dbfs && purity_[i] >= config_.min_purity) {
+            on_ms_[i] += block_ms_;
+            gap_ms_[i] = 0;
+        } else if (on_ms_[i] > 0) {
+            // 短暂丢失不清零 (拍频、回声造成的凹陷)，丢失过久才认为音调结束
+            gap_ms_[i] += block_ms_;
+            if (gap_ms_[i] > config_.max_gap_ms) {
+                on_ms_[i] = 0;
+                gap_ms_[i] = 0;
+                fired_[i] = false;
+            }
+        }
+
+        // 每段连续的音调只触发一次
+        if (!fired_[i] && on_ms_[i] >= config_.min_on_ms && since_event_ms_[i] >= config_.refractory_ms) {
+            fired_[i] = true;
+            since_event_ms_[i] = 0;
+            if (event_cb_) {
+                event_cb_(targets_[i], level_dbfs_[i]);
+            }
+        }
+    }
+}
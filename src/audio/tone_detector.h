@@ -0,0 +1,85 @@
+#ifndef TONE_DETECTOR_H
+#define TONE_DETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "audio_perf.h"
+#include "dsp_engine.h"
+
+// 要识别的单个音调 (例如附近医疗设备的报警音基频)
+struct ToneTarget {
+    const char* label;
+    float freq_hz;
+};
+
+struct ToneDetectorConfig {
+    int sample_rate = 24000;
+    size_t block_size = 480;          // 每块样本数 (20ms)，频率分辨率约 sample_rate / block_size
+    float min_level_dbfs = -50.0f;    // 音调幅度低于此值不计
+    // 音调能量占整块能量的比例门限 (纯正弦为 1)，用来排除宽带噪声和语音
+    float min_purity = 0.4f;
+    uint32_t min_on_ms = 100;         // 连续命中这么久才认为音调出现 (去抖)
+    uint32_t max_gap_ms = 60;         // 音调内允许的短暂丢失，超过后重新计时
+    uint32_t refractory_ms = 5000;    // 同一音调两次事件的最小间隔
+};
+
+/**
+ * @brief 单频点 DFT 检测器组，低开销地检测少量固定频率的音调
+ *
+ * 只关心几个目标频率时，逐个频点计算比每块做一次 FFT 省得多。
+ * 样本按块缓存成 float，块结束时每个频点与预先生成的 cos/sin 表各做一次点积
+ * (dsp_dotprod_f32，S3 上是 esp-dsp 的 PIE 内核)，得到与 Goertzel 递推相同的 |X(f)|^2，
+ * 整块能量用同一个内核计算，两者比较得到"纯度"。每个频点的表占 2 * block_size 个 float。
+ * 命中经过去抖 (min_on_ms / max_gap_ms) 和冷却 (refractory_ms) 后以事件回调。
+ * 回调在 Push 的调用者任务中执行，不要在其中阻塞。
+ */
+class ToneDetector {
+public:
+    using EventCallback = std::function<void(const ToneTarget& target, float level_dbfs)>;
+
+    ToneDetector(const ToneTarget* targets, size_t count, const ToneDetectorConfig& config = ToneDetectorConfig());
+
+    bool valid() const { return valid_; }
+    void SetEventCallback(EventCallback cb) { event_cb_ = std::move(cb); }
+
+    /**
+     * @param stride 交织立体声取单声道时传 2
+     */
+    void Push(const int16_t* samples, size_t count, size_t stride = 1);
+
+    size_t size() const { return targets_.size(); }
+    // 最近一块各频点的幅度 (dBFS) 和纯度
+    float level_dbfs(size_t i) const { return level_dbfs_[i]; }
+    float purity(size_t i) const { return purity_[i]; }
+    // 当前处于去抖后"出现"状态的音调
+    bool active(size_t i) const { return on_ms_[i] >= config_.min_on_ms; }
+    const AudioPerfCounter& perf() const { return perf_; }
+
+private:
+    void Accumulate(const int16_t* samples, size_t count, size_t stride);
+    void FinishBlock();
+
+    ToneDetectorConfig config_;
+    std::vector<ToneTarget> targets_;
+    bool valid_ = false;
+
+    DspBuffer<float> block_;          // 当前块的样本 (保持 int16 量级)
+    DspBuffer<float> basis_;          // 每个频点一行：cos 表 stride_ 个，sin 表 stride_ 个
+    size_t stride_ = 0;               // block_size 按 4 个 float 对齐，各行保持 16 字节对齐
+    size_t block_pos_ = 0;
+    uint32_t block_ms_;
+
+    std::vector<float> level_dbfs_;
+    std::vector<float> purity_;
+    std::vector<uint32_t> on_ms_;     // 当前连续出现的时长
+    std::vector<uint32_t> gap_ms_;    // 当前丢失的时长
+    std::vector<uint32_t> since_event_ms_;
+    std::vector<bool> fired_;
+
+    EventCallback event_cb_;
+    AudioPerfCounter perf_;
+};
+
+#endif // TONE_DETECTOR_H
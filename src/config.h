@@ -10,4 +10,8 @@
 #define WIFI_SSID "Gionix"
 #define WIFI_PASSWORD "u6t4z9ip"
 
+// --- 遥测 ---
+// 聚合数据 (呼吸频率、I2S 溢出统计等) 通过 MQTT 发布的周期
+#define TELEMETRY_PUBLISH_INTERVAL_MS 10000
+
 #endif // CONFIG_H
\ No newline at end of file
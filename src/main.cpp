@@ -1,8 +1,31 @@
 #include <stdio.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "audio/my_board.h" // 包含我们定义的板子类
+#include "audio/audio_agc.h"
+#include "audio/dsp_engine.h"
+#include "audio/breathing_estimator.h"
+#include "audio/audio_history.h"
+#include "audio/audio_recorder.h"
+#include "audio/prompt_store.h"
+#include "audio/pipeline_stages.h"
+#include "audio/tone_detector.h"
+#include "audio/speaker_eq_coeffs.h"
+#include "module_mqtt/mqtt_manager.h"
+#include "module_wifi/wifi_manager.h"
+#include "config.h"
+#include "esp_heap_caps.h"
+#include "esp_mac.h"
+#include "nvs_flash.h"
+#include <sys/time.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
 #include <vector>
 
 static const char* TAG = "MAIN";
@@ -10,6 +33,149 @@ static const char* TAG = "MAIN";
 // 声明板子对象指针
 MyBoard* board = nullptr;
 
+// 采集预录缓冲，以及最近一次告警截取的音频片段 (供上传或存储)
+static AudioHistory* s_history = nullptr;
+static std::mutex s_event_clip_mutex;
+static AudioClip s_event_clip;
+static uint32_t s_event_clip_count = 0;
+
+// 提示音资源包 (flash 映射，只读)
+static PromptStore s_prompts;
+
+// 扬声器均衡：提示音和 loopback 输出都经过它 (两者不会同时播放)
+static BiquadCascade s_speaker_eq(2);
+// 播放音频的响度归一化，不同来源的电平统一到同一目标响度
+static LoudnessProcessor s_playback_loudness(AUDIO_OUTPUT_SAMPLE_RATE, 2);
+
+// 播放一个提示音：数据从 flash 映射区直接送到 I2S，单声道/ADPCM 只用一个帧大小的暂存区
+// 播放器内含一个 ADPCM 解码块 (约 1KB)，和一帧暂存区一起静态分配，不占 app_main 的栈 (main 任务栈只有几 KB)；
+// play_prompt 只在 app_main 中调用，不可重入
+static PromptPlayer s_prompt_player;
+static int16_t s_prompt_scratch[AUDIO_CODEC_DMA_FRAME_NUM];
+
+static bool play_prompt(AudioCodec* codec, const char* name) {
+    PromptPlayer& player = s_prompt_player;
+    if (!player.Open(s_prompts, s_prompts.Find(name), AUDIO_OUTPUT_SAMPLE_RATE)) return false;
+    int16_t* scratch = s_prompt_scratch;
+    const int16_t* frames = nullptr;
+#if AUDIO_PLAYBACK_LOUDNESS_ENABLE
+    s_playback_loudness.Reset();
+#endif
+    while (size_t n = player.Next(scratch, AUDIO_CODEC_DMA_FRAME_NUM / 2, &frames)) {
+#if AUDIO_SPEAKER_EQ_ENABLE || AUDIO_PLAYBACK_LOUDNESS_ENABLE
+        // 映射区只读，先拷进暂存区再原地处理
+        if (frames != scratch) {
+            memcpy(scratch, frames, n * 2 * sizeof(int16_t));
+            frames = scratch;
+        }
+#endif
+        // 均衡的提升段放在限幅器之前，否则会在 -1 dBFS 的限幅之后再次削波
+#if AUDIO_SPEAKER_EQ_ENABLE
+        s_speaker_eq.Process(scratch, n);
+#endif
+#if AUDIO_PLAYBACK_LOUDNESS_ENABLE
+        s_playback_loudness.Process(scratch, n * 2);
+#endif
+        codec->OutputSamples(frames, n * 2);
+    }
+    return true;
+}
+
+// 告警发布前截取预录音频，在发布告警的任务中执行，不影响采集
+static void on_alert_event(const std::string& device_id, const std::string& event_type, const std::string& priority) {
+    if (!s_history || !s_history->valid()) return;
+    std::lock_guard<std::mutex> lock(s_event_clip_mutex);
+    if (s_history->SnapshotLast(AUDIO_HISTORY_PREROLL_MS, AudioClipFormat::IMA_ADPCM, s_event_clip)) {
+        const AudioPerfCounter& perf = s_history->snapshot_perf();
+        ESP_LOGI(TAG, "Clip for '%s': %u samples -> %u bytes ADPCM, %u cycles, copy %.1f MB/s",
+                 event_type.c_str(), (unsigned)s_event_clip.samples, (unsigned)s_event_clip.data.size(),
+                 (unsigned)perf.last, s_history->read_bandwidth_mbps());
+#if AUDIO_EVENT_CLIP_FILES > 0
+        char path[48];
+        snprintf(path, sizeof(path), AUDIO_STORAGE_BASE_PATH "/event_%u.wav",
+                 (unsigned)(s_event_clip_count++ % AUDIO_EVENT_CLIP_FILES));
+        if (audio_clip_save_wav(s_event_clip, path)) {
+            ESP_LOGI(TAG, "Clip saved to %s", path);
+        }
+#endif
+    } else {
+        ESP_LOGW(TAG, "No audio history available for '%s'", event_type.c_str());
+    }
+}
+
+#if AUDIO_TONE_DETECTOR_ENABLE
+// 需要识别的报警音基频，按现场设备实测填写；识别到后作为 MQTT 事件发布，优先级与表项一一对应
+static const ToneTarget kAlarmTones[] = {
+    {"alarm_high", 960.0f},
+    {"alarm_medium", 523.0f},
+};
+static const char* const kAlarmTonePriorities[] = {"high", "medium"};
+static_assert(sizeof(kAlarmTonePriorities) / sizeof(kAlarmTonePriorities[0]) ==
+              sizeof(kAlarmTones) / sizeof(kAlarmTones[0]), "one priority per alarm tone");
+
+// 音频任务里只把识别结果放进队列 (不阻塞，满了就丢弃)，发布和告警监听 (截取预录音频) 在遥测任务中执行
+struct ToneEvent {
+    uint8_t index;                 // kAlarmTones 中的下标
+    float level_dbfs;
+};
+#define TONE_EVENT_QUEUE_LEN 4
+static QueueHandle_t s_tone_events = nullptr;
+static std::atomic<uint32_t> s_tone_events_dropped{0};
+#endif
+
+// 设备 ID (主题后缀)：取出厂 MAC 地址，每块板子唯一
+static const std::string& device_id() {
+    static std::string id;
+    if (id.empty()) {
+        uint8_t mac[6] = {};
+        esp_efuse_mac_get_default(mac);
+        char buf[13];
+        snprintf(buf, sizeof(buf), "%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        id = buf;
+    }
+    return id;
+}
+
+// 遥测任务：WiFi 连上后启动 MQTT 客户端，之后按周期把聚合数据缓存的快照发布出去；
+// 等待期间随时发布报警音事件
+static void telemetry_task(void* pvParameters) {
+    bool mqtt_started = false;
+    int64_t next_publish_us = esp_timer_get_time() + TELEMETRY_PUBLISH_INTERVAL_MS * 1000LL;
+    while (1) {
+        int64_t wait_ms = std::max<int64_t>(0, (next_publish_us - esp_timer_get_time()) / 1000);
+#if AUDIO_TONE_DETECTOR_ENABLE
+        ToneEvent ev;
+        if (xQueueReceive(s_tone_events, &ev, pdMS_TO_TICKS(wait_ms)) == pdTRUE) {
+            const ToneTarget& tone = kAlarmTones[ev.index];
+            ESP_LOGW(TAG, "Tone detected: %s (%.0f Hz, %.1f dBFS)", tone.label, tone.freq_hz, ev.level_dbfs);
+            mqtt_publish_event(device_id(), tone.label, kAlarmTonePriorities[ev.index]);
+            continue;
+        }
+#else
+        vTaskDelay(pdMS_TO_TICKS(wait_ms));
+#endif
+        // 发布耽误了好几个周期时不补发
+        next_publish_us = std::max(next_publish_us + TELEMETRY_PUBLISH_INTERVAL_MS * 1000LL, esp_timer_get_time());
+#if AUDIO_TONE_DETECTOR_ENABLE
+        if (uint32_t dropped = s_tone_events_dropped.exchange(0, std::memory_order_relaxed)) {
+            ESP_LOGW(TAG, "%u tone event(s) dropped, event queue full", (unsigned)dropped);
+        }
+#endif
+        if (!mqtt_started && wifi_get_status() == WIFI_STATUS_CONNECTED) {
+            mqtt_app_start();
+            mqtt_started = true;
+        }
+        if (!mqtt_is_connected()) {
+            continue;
+        }
+        // 没有 SNTP 同步时这是开机以来的时间，服务端可以据此识别
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        uint64_t timestamp_ms = (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+        mqtt_publish_aggregated_data(device_id(), mqtt_aggregate_snapshot(), timestamp_ms);
+    }
+}
+
 // Loopback 任务
 void loopback_task(void* pvParameters) {
     ESP_LOGI(TAG, "Loopback task started.");
@@ -27,13 +193,105 @@ void loopback_task(void* pvParameters) {
     // 大小来自 config.h，这里是 240 个采样点 (int16_t)
     std::vector<int16_t> audio_buffer(AUDIO_CODEC_DMA_FRAME_NUM);
 
+    // 采集通路的自动增益：粗调写入 ES8311 PGA，软件负责细调和限幅
+    AudioAgc agc(AUDIO_INPUT_SAMPLE_RATE, 2);
+    agc.SetCoarseGainCallback([codec](float db) { return codec->SetInputGain(db); });
+    // 每帧的实时时长 (微秒)，用于换算 CPU 占用
+    const uint32_t frame_us = AUDIO_CODEC_DMA_FRAME_NUM / 2 * 1000000ULL / AUDIO_INPUT_SAMPLE_RATE;
+    uint32_t frame_count = 0;
+    AudioLinkStats last_link;
+
+    // 后台呼吸频率估计，结果写入 MQTT 聚合数据缓存
+    BreathingEstimator breathing;
+    breathing.SetRateCallback([](int bpm, float confidence) {
+        ESP_LOGI(TAG, "Breathing: %d bpm (confidence %.2f)", bpm, confidence);
+        mqtt_aggregate_set_breathing(bpm);
+    });
+
+#if AUDIO_RECORDER_ENABLE
+    // 后台录音：写 flash 在独立任务中进行，不阻塞本任务的 I2S 读取
+    AudioRecorder recorder;
+    recorder.Start();
+#endif
+
+#if AUDIO_TONE_DETECTOR_ENABLE
+    ToneDetectorConfig tone_cfg;
+    tone_cfg.sample_rate = AUDIO_INPUT_SAMPLE_RATE;
+    ToneDetector tones(kAlarmTones, sizeof(kAlarmTones) / sizeof(kAlarmTones[0]), tone_cfg);
+    tones.SetEventCallback([](const ToneTarget& tone, float level_dbfs) {
+        ToneEvent ev = {(uint8_t)(&tone - kAlarmTones), level_dbfs};
+        if (xQueueSend(s_tone_events, &ev, 0) != pdTRUE) {
+            s_tone_events_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+#endif
+
+    // 采集流水线：只读分支都取 AGC 之前的原始信号 (呼吸估计避免软件增益调制包络，PGA 步进由它自己补偿，
+    // 预录和录音直接按 stride 从交织数据取左声道)，最后扬声器均衡和 AGC 原地处理。
+    // AGC 的限幅器必须是最后一级，均衡的提升放在它之前才不会削波
+    auto pipeline = make_audio_pipeline<AUDIO_CODEC_DMA_FRAME_NUM / 2, 2>(
+        make_tap_stage("breathing", [&breathing, &agc](const int16_t* d, size_t frames, int ch) {
+            breathing.SetInputGain(agc.coarse_gain_db());
+            breathing.Push(d, frames * ch, ch);
+        }),
+        make_tap_stage("history", [](const int16_t* d, size_t frames, int ch) {
+            if (s_history) s_history->Write(d, frames, ch);
+        }),
+#if AUDIO_TONE_DETECTOR_ENABLE
+        make_tap_stage("tones", [&tones](const int16_t* d, size_t frames, int ch) {
+            tones.Push(d, frames, ch);
+        }),
+#endif
+#if AUDIO_RECORDER_ENABLE
+        make_tap_stage("recorder", [&recorder](const int16_t* d, size_t frames, int ch) {
+            recorder.Push(d, frames, ch);
+        }),
+#endif
+        BiquadStage(s_speaker_eq),
+        AgcStage(agc));
+    static_assert(decltype(pipeline)::kOutChannels == 2, "loopback output must stay stereo");
+
     ESP_LOGI(TAG, "Starting audio loopback... Speak into the microphone!");
 
     while (1) {
         // 3. 从麦克风读取数据到缓冲区
         if (codec->InputData(audio_buffer)) {
+            pipeline.Process(audio_buffer.data(), audio_buffer.size() / 2);
             // 4. 将缓冲区的数据直接写到扬声器
             codec->OutputData(audio_buffer);
+
+            if (++frame_count % 1000 == 0) {
+                const AudioPerfCounter& perf = agc.perf();
+                ESP_LOGI(TAG, "AGC: level %.1f dBFS, PGA %.0f dB, fine %.1f dB | %u cycles/frame avg, %u max (%.2f%% CPU)",
+                         agc.level_dbfs(), agc.coarse_gain_db(), agc.fine_gain_db(),
+                         (unsigned)perf.Average(), (unsigned)perf.max, perf.LoadPercent(frame_us));
+                for (size_t i = 0; i < decltype(pipeline)::kStageCount; i++) {
+                    if (pipeline.fused(i)) continue;
+                    const AudioPerfCounter& p = pipeline.perf(i);
+                    ESP_LOGI(TAG, "Pipeline %-10s %u cycles/frame avg, %u max (%.2f%% CPU)",
+                             pipeline.name(i), (unsigned)p.Average(), (unsigned)p.max, p.LoadPercent(frame_us));
+                }
+                // I2S 溢出计数推送到遥测缓存；新增时打警告，便于和当时的 CPU 占用对照
+                AudioLinkStats link = codec->GetLinkStats();
+                if (link.rx_overflows != last_link.rx_overflows || link.tx_underflows != last_link.tx_underflows) {
+                    ESP_LOGW(TAG, "I2S: +%u rx overflows (%u bytes dropped), +%u tx underflows (%u bytes repeated)",
+                             (unsigned)(link.rx_overflows - last_link.rx_overflows),
+                             (unsigned)(link.rx_dropped_bytes - last_link.rx_dropped_bytes),
+                             (unsigned)(link.tx_underflows - last_link.tx_underflows),
+                             (unsigned)(link.tx_repeated_bytes - last_link.tx_repeated_bytes));
+                }
+                last_link = link;
+                mqtt_aggregate_set_i2s_stats(link.rx_overflows, link.tx_underflows,
+                                             link.last_rx_overflow_ms, link.last_tx_underflow_ms);
+#if AUDIO_RECORDER_ENABLE
+                RecorderStats rs = recorder.stats();
+                ESP_LOGI(TAG, "Recorder: %u files, %u KB, %.0f KB/s, max stall %u us, dropped %u pushes (%u samples)",
+                         (unsigned)rs.files, (unsigned)(rs.bytes_written / 1024), rs.throughput_kbps(),
+                         (unsigned)rs.max_stall_us, (unsigned)rs.dropped_pushes, (unsigned)rs.dropped_samples);
+#endif
+                agc.ResetPerf();
+                pipeline.ResetPerf();
+            }
         } else {
             // 如果读取失败，稍等一下再试
             vTaskDelay(pdMS_TO_TICKS(5));
@@ -45,10 +303,54 @@ void loopback_task(void* pvParameters) {
 extern "C" void app_main(void) {
     ESP_LOGI(TAG, "Application starting...");
 
+#if AUDIO_DSP_BENCHMARK
+    dsp_bench_run();
+#endif
+
+    // 0. NVS (WiFi 驱动的校准数据和配置保存在其中) 和 WiFi，连接在后台进行，
+    //    连上后遥测任务启动 MQTT
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+    wifi_init_sta();
+
     // 1. 创建板子对象
     // 在构造函数 MyBoard() 中，所有硬件初始化都会被完成
     board = new MyBoard();
 
+#if AUDIO_SPEAKER_EQ_ENABLE
+    static_assert(SPEAKER_EQ_SAMPLE_RATE == AUDIO_OUTPUT_SAMPLE_RATE, "regenerate speaker_eq_coeffs.h for the output rate");
+    s_speaker_eq.SetCoefficients(kSpeakerEq, SPEAKER_EQ_SECTIONS);
+#endif
+
+    // 映射提示音分区，有开机提示音就先播放 (在 loopback 任务启动前，独占输出)
+    if (s_prompts.Init()) {
+        play_prompt(board->GetAudioCodec(), "boot");
+    }
+
+    // 预录缓冲优先放 PSRAM，没有 PSRAM 时缩短时长以免挤占内部 SRAM
+    uint32_t history_seconds = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) ? AUDIO_HISTORY_SECONDS : AUDIO_HISTORY_SECONDS_NO_PSRAM;
+    s_history = new AudioHistory(AUDIO_INPUT_SAMPLE_RATE, history_seconds, DspMemory::PSRAM);
+    if (s_history->valid()) {
+        ESP_LOGI(TAG, "Audio history: %u s, %u KB", (unsigned)history_seconds, (unsigned)(s_history->MemoryBytes() / 1024));
+        mqtt_set_event_listener(on_alert_event);
+    } else {
+        ESP_LOGE(TAG, "Failed to allocate audio history");
+        delete s_history;
+        s_history = nullptr;
+    }
+
+#if AUDIO_TONE_DETECTOR_ENABLE
+    s_tone_events = xQueueCreate(TONE_EVENT_QUEUE_LEN, sizeof(ToneEvent));
+    configASSERT(s_tone_events);
+#endif
+
     // 2. 创建并启动 loopback 任务
     xTaskCreate(loopback_task, "loopback_task", 4096, NULL, 5, NULL);
+
+    // 3. 遥测发布，优先级低于音频。JSON 文档在栈上，告警监听还要在这里编码预录音频，栈留大一些
+    xTaskCreate(telemetry_task, "telemetry_task", 6144, NULL, 3, NULL);
 }
\ No newline at end of file
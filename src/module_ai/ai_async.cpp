@@ -0,0 +1,402 @@
+// src/module_ai/ai_async.cpp
+
+#include "ai_async.h"
+#include "ai_hedge.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+static const char *TAG = "AI_ASYNC";
+
+#define AI_ASYNC_QUEUE_DEPTH 8
+// mbedTLS 握手 (证书链校验、ECDHE) 在调用任务的栈上进行，再加上 esp_http_client 和响应解析，8KB 留有余量
+#define AI_ASYNC_TASK_STACK 8192
+#define AI_ASYNC_TASK_PRIORITY 4
+
+#define AI_ERROR_CANCELLED "<错误: 请求已取消>"
+#define AI_ERROR_EXPIRED "<错误: 请求已超过截止时间>"
+
+struct ai_request {
+    std::atomic<int> refs;            // 调用方一份，队列/工作任务一份
+    AiModel model;
+    std::string input;
+    AiRequestOptions options;
+    uint32_t seq;                     // 同优先级内按提交顺序执行
+    int64_t submit_us;
+    int64_t deadline_us;              // 0 表示不限
+    std::atomic<AiRequestState> state;
+    std::atomic<bool> abort;          // 传给 ai_service 的中止标志
+    bool cancel_requested;            // 以下三个标志在 s_lock 内读写，说明中止的原因
+    bool expired;
+    bool preempted;
+    std::string result;
+    AiStreamStats stream_stats;
+    SemaphoreHandle_t done;
+};
+
+static SemaphoreHandle_t s_lock = NULL;
+static TaskHandle_t s_worker = NULL;
+static esp_timer_handle_t s_deadline_timer = NULL;
+static ai_request* s_queue[AI_ASYNC_QUEUE_DEPTH];
+static int s_count = 0;
+static uint32_t s_seq = 0;
+static ai_request* s_current = NULL;  // 工作任务正在执行的请求
+static AiAsyncStats s_stats = {};
+
+static bool _is_finished(AiRequestState state) {
+    return state == AiRequestState::DONE || state == AiRequestState::CANCELLED ||
+           state == AiRequestState::EXPIRED;
+}
+
+static void _release(ai_request* req) {
+    if (req->refs.fetch_sub(1) == 1) {
+        vSemaphoreDelete(req->done);
+        delete req;
+    }
+}
+
+// 写入结果并通知等待方，同时释放队列持有的引用；调用时不能持有 s_lock
+static void _finish(ai_request* req, AiRequestState state, std::string result) {
+    req->result = std::move(result);
+    req->state.store(state, std::memory_order_release);
+    if (req->options.on_done) {
+        req->options.on_done(req, req->options.done_arg);
+    }
+    xSemaphoreGive(req->done);
+    _release(req);
+}
+
+// 以下队列操作都要求持有 s_lock
+static void _queue_insert(ai_request* req) {
+    s_queue[s_count++] = req;
+    s_stats.depth = s_count;
+    s_stats.max_depth = std::max(s_stats.max_depth, s_stats.depth);
+}
+
+static void _queue_remove_at(int index) {
+    for (int i = index; i < s_count - 1; i++) {
+        s_queue[i] = s_queue[i + 1];
+    }
+    s_count--;
+    s_stats.depth = s_count;
+}
+
+// 取优先级最高的请求，同优先级取最早提交的
+static ai_request* _queue_pop() {
+    int best = -1;
+    for (int i = 0; i < s_count; i++) {
+        const ai_request* r = s_queue[i];
+        if (best < 0 || r->options.priority < s_queue[best]->options.priority ||
+            (r->options.priority == s_queue[best]->options.priority && (int32_t)(r->seq - s_queue[best]->seq) < 0)) {
+            best = i;
+        }
+    }
+    if (best < 0) {
+        return NULL;
+    }
+    ai_request* req = s_queue[best];
+    _queue_remove_at(best);
+    return req;
+}
+
+// 把已过截止时间的排队请求移出，返回移出的个数
+static int _queue_take_expired(int64_t now, ai_request** out) {
+    int n = 0;
+    for (int i = 0; i < s_count;) {
+        if (s_queue[i]->deadline_us && now >= s_queue[i]->deadline_us) {
+            out[n++] = s_queue[i];
+            _queue_remove_at(i);
+        } else {
+            i++;
+        }
+    }
+    s_stats.expired += n;
+    return n;
+}
+
+static void _on_deadline(void* arg) {
+    (void)arg;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    // esp_timer_stop 不等待已经开始的回调，这里再核对一次，避免误伤下一个请求
+    if (s_current && s_current->deadline_us && esp_timer_get_time() >= s_current->deadline_us) {
+        s_current->expired = true;
+        s_current->abort.store(true);
+    }
+    xSemaphoreGive(s_lock);
+}
+
+static void _run(ai_request* req) {
+    // 中止标志要等下一个 HTTP 事件才生效，非流式请求在服务器生成完回答前收不到事件，
+    // 所以剩余时间同时作为请求的超时上限，到期时由 socket 超时结束等待
+    uint32_t timeout_ms = 0;
+    if (req->deadline_us) {
+        int64_t remaining = req->deadline_us - esp_timer_get_time();
+        esp_timer_start_once(s_deadline_timer, std::max<int64_t>(remaining, 1));
+        timeout_ms = (uint32_t)std::max<int64_t>(remaining / 1000, 1);
+    }
+    if (req->options.stream) {
+        req->stream_stats = AiStreamStats();
+        req->result = get_ai_answer_stream(req->model, req->input, req->options.on_delta, req->options.delta_arg,
+                                           &req->stream_stats, &req->abort, timeout_ms);
+    } else if (req->options.hedged) {
+        req->result = get_ai_answer_hedged(req->model, req->input, &req->abort);
+    } else {
+        req->result = get_ai_answer(req->model, req->input, &req->abort, timeout_ms);
+    }
+    if (req->deadline_us) {
+        esp_timer_stop(s_deadline_timer);
+    }
+}
+
+static void _worker_task(void* arg) {
+    (void)arg;
+    for (;;) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        ai_request* req = _queue_pop();
+        if (!req) {
+            xSemaphoreGive(s_lock);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        int64_t start = esp_timer_get_time();
+        if (req->deadline_us && start >= req->deadline_us) {
+            s_stats.expired++;
+            xSemaphoreGive(s_lock);
+            ESP_LOGW(TAG, "请求 #%u 排队时已过截止时间", (unsigned)req->seq);
+            _finish(req, AiRequestState::EXPIRED, AI_ERROR_EXPIRED);
+            continue;
+        }
+        int prio = (int)req->options.priority;
+        uint32_t wait_ms = (uint32_t)((start - req->submit_us) / 1000);
+        s_stats.wait_count[prio]++;
+        s_stats.wait_total_ms[prio] += wait_ms;
+        s_stats.wait_max_ms[prio] = std::max(s_stats.wait_max_ms[prio], wait_ms);
+        req->state.store(AiRequestState::RUNNING);
+        s_current = req;
+        xSemaphoreGive(s_lock);
+
+        ESP_LOGI(TAG, "开始请求 #%u (优先级 %d, 排队 %u ms)", (unsigned)req->seq, prio, (unsigned)wait_ms);
+        _run(req);
+        uint32_t service_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+
+        // 请求可能在中止标志生效前已经正常完成，此时按完成处理。
+        // 截止时间到时非流式请求通常是 socket 超时先返回，同样算作过期
+        bool aborted = req->result == AI_ERROR_ABORTED;
+        bool timed_out = req->deadline_us && esp_timer_get_time() >= req->deadline_us &&
+                         req->result.compare(0, strlen("<错误:"), "<错误:") == 0;
+        AiRequestState state = AiRequestState::DONE;
+        const char* error = NULL;
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        s_current = NULL;
+        s_stats.service_total_ms += service_ms;
+        s_stats.service_max_ms = std::max(s_stats.service_max_ms, service_ms);
+        if (aborted && req->cancel_requested) {
+            state = AiRequestState::CANCELLED;
+            error = AI_ERROR_CANCELLED;
+            s_stats.cancelled++;
+        } else if ((aborted && req->expired) || (timed_out && !aborted)) {
+            state = AiRequestState::EXPIRED;
+            error = AI_ERROR_EXPIRED;
+            s_stats.expired++;
+        } else if (aborted && req->preempted && s_count < AI_ASYNC_QUEUE_DEPTH) {
+            // 被抢占：保留原来的序号重新排队，轮到时从头执行
+            req->preempted = false;
+            req->abort.store(false);
+            req->state.store(AiRequestState::QUEUED);
+            _queue_insert(req);
+            s_stats.preempted++;
+            xSemaphoreGive(s_lock);
+            ESP_LOGI(TAG, "请求 #%u 被抢占，重新排队", (unsigned)req->seq);
+            continue;
+        } else if (aborted) {
+            // 被抢占但队列已满，只能放弃
+            state = AiRequestState::CANCELLED;
+            error = AI_ERROR_CANCELLED;
+            s_stats.cancelled++;
+        } else {
+            s_stats.completed++;
+        }
+        xSemaphoreGive(s_lock);
+
+        ESP_LOGI(TAG, "请求 #%u 结束, 执行 %u ms", (unsigned)req->seq, (unsigned)service_ms);
+        _finish(req, state, error ? std::string(error) : std::move(req->result));
+    }
+}
+
+esp_err_t ai_async_init(void) {
+    if (s_worker) {
+        return ESP_OK;
+    }
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = _on_deadline;
+    timer_args.name = "ai_deadline";
+    esp_err_t err = esp_timer_create(&timer_args, &s_deadline_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (xTaskCreate(_worker_task, "ai_worker", AI_ASYNC_TASK_STACK, NULL, AI_ASYNC_TASK_PRIORITY, &s_worker) != pdPASS) {
+        ESP_LOGE(TAG, "创建工作任务失败");
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "AI 异步队列已启动, 深度 %d", AI_ASYNC_QUEUE_DEPTH);
+    return ESP_OK;
+}
+
+ai_request_handle_t ai_async_submit(AiModel model, const std::string& input_text, const AiRequestOptions& options) {
+    if (!s_worker) {
+        return NULL;
+    }
+    ai_request* req = new (std::nothrow) ai_request();
+    if (!req) {
+        return NULL;
+    }
+    req->done = xSemaphoreCreateBinary();
+    if (!req->done) {
+        delete req;
+        return NULL;
+    }
+    req->refs.store(2);
+    req->model = model;
+    req->input = input_text;
+    req->options = options;
+    req->submit_us = esp_timer_get_time();
+    req->deadline_us = options.deadline_ms ? req->submit_us + (int64_t)options.deadline_ms * 1000 : 0;
+    req->state.store(AiRequestState::QUEUED);
+    req->abort.store(false);
+
+    ai_request* expired[AI_ASYNC_QUEUE_DEPTH];
+    int expired_count = 0;
+    bool accepted = false;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_count == AI_ASYNC_QUEUE_DEPTH) {
+        expired_count = _queue_take_expired(req->submit_us, expired);
+    }
+    if (s_count < AI_ASYNC_QUEUE_DEPTH) {
+        req->seq = s_seq++;
+        _queue_insert(req);
+        s_stats.submitted++;
+        accepted = true;
+        // URGENT 请求抢占正在执行的后台请求。只抢占流式请求：非流式请求在回答整段到达之前
+        // 不会检查中止标志，抢占既不能让 URGENT 提前开始，还会丢掉已经到达的回答再从头执行
+        if (options.priority == AiPriority::URGENT && s_current && s_current->options.stream &&
+            s_current->options.priority == AiPriority::BACKGROUND) {
+            s_current->preempted = true;
+            s_current->abort.store(true);
+        }
+    } else {
+        s_stats.rejected++;
+    }
+    xSemaphoreGive(s_lock);
+
+    for (int i = 0; i < expired_count; i++) {
+        _finish(expired[i], AiRequestState::EXPIRED, AI_ERROR_EXPIRED);
+    }
+    if (!accepted) {
+        ESP_LOGW(TAG, "请求队列已满");
+        vSemaphoreDelete(req->done);
+        delete req;
+        return NULL;
+    }
+    xTaskNotifyGive(s_worker);
+    return req;
+}
+
+bool ai_request_wait(ai_request_handle_t request, uint32_t timeout_ms) {
+    if (_is_finished(request->state.load(std::memory_order_acquire))) {
+        return true;
+    }
+    if (xSemaphoreTake(request->done, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        return false;
+    }
+    // 放回去，之后再等待的调用也能立即返回
+    xSemaphoreGive(request->done);
+    return true;
+}
+
+void ai_request_cancel(ai_request_handle_t request) {
+    bool removed = false;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    AiRequestState state = request->state.load();
+    if (state == AiRequestState::QUEUED) {
+        for (int i = 0; i < s_count; i++) {
+            if (s_queue[i] == request) {
+                _queue_remove_at(i);
+                removed = true;
+                s_stats.cancelled++;
+                break;
+            }
+        }
+    } else if (state == AiRequestState::RUNNING) {
+        request->cancel_requested = true;
+        request->abort.store(true);
+    }
+    xSemaphoreGive(s_lock);
+    if (removed) {
+        _finish(request, AiRequestState::CANCELLED, AI_ERROR_CANCELLED);
+    }
+}
+
+AiRequestState ai_request_state(ai_request_handle_t request) {
+    return request->state.load(std::memory_order_acquire);
+}
+
+std::string ai_request_result(ai_request_handle_t request) {
+    if (!_is_finished(request->state.load(std::memory_order_acquire))) {
+        return "";
+    }
+    return request->result;
+}
+
+AiStreamStats ai_request_stream_stats(ai_request_handle_t request) {
+    if (!_is_finished(request->state.load(std::memory_order_acquire))) {
+        return AiStreamStats();
+    }
+    return request->stream_stats;
+}
+
+void ai_request_release(ai_request_handle_t request) {
+    if (request) {
+        _release(request);
+    }
+}
+
+void ai_async_get_stats(AiAsyncStats* stats) {
+    if (!s_lock) {
+        *stats = AiAsyncStats();
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_lock);
+}
+
+void ai_async_log_stats(void) {
+    static const char* kNames[3] = { "URGENT", "NORMAL", "BACKGROUND" };
+    AiAsyncStats st;
+    ai_async_get_stats(&st);
+    uint32_t finished = st.completed + st.cancelled + st.expired;
+    ESP_LOGI(TAG, "--- AI 请求队列 ---");
+    ESP_LOGI(TAG, "提交 %u, 拒绝 %u, 完成 %u, 取消 %u, 过期 %u, 抢占 %u", (unsigned)st.submitted,
+             (unsigned)st.rejected, (unsigned)st.completed, (unsigned)st.cancelled, (unsigned)st.expired,
+             (unsigned)st.preempted);
+    ESP_LOGI(TAG, "队列深度 %u (最大 %u)", (unsigned)st.depth, (unsigned)st.max_depth);
+    for (int i = 0; i < 3; i++) {
+        if (!st.wait_count[i]) continue;
+        ESP_LOGI(TAG, "%-10s 等待: %u 次, 平均 %u ms, 最大 %u ms", kNames[i], (unsigned)st.wait_count[i],
+                 (unsigned)(st.wait_total_ms[i] / st.wait_count[i]), (unsigned)st.wait_max_ms[i]);
+    }
+    uint32_t runs = st.wait_count[0] + st.wait_count[1] + st.wait_count[2];
+    ESP_LOGI(TAG, "执行: %u 次 (结束 %u), 平均 %u ms, 最大 %u ms", (unsigned)runs, (unsigned)finished,
+             (unsigned)(runs ? st.service_total_ms / runs : 0), (unsigned)st.service_max_ms);
+}
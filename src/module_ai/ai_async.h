@@ -0,0 +1,119 @@
+// src/module_ai/ai_async.h
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "esp_err.h"
+#include "ai_service.h"
+
+/**
+ * @brief AI 请求的异步队列
+ *
+ * get_ai_answer 会阻塞调用任务 15~30 秒。这里由一个专用工作任务 (栈按 TLS 握手的需要分配)
+ * 依次执行有界优先级队列中的请求，调用方提交后立即返回一个句柄，之后可以：
+ *   - 用 ai_request_wait 等待 (类似 future)，或在 on_done 回调里拿结果；
+ *   - 用 ai_request_cancel 取消：排队中的直接移出，执行中的在下一段响应数据到达时中止
+ *     (非流式请求要等整段回答到达)；
+ *   - 设置截止时间：排队超时不再执行；执行时剩余时间作为请求的超时上限，到期同样结束。
+ * URGENT 请求会抢占正在执行的 BACKGROUND 流式请求：后者被中止后放回队列，之后从头重新执行
+ * (流式回调会再次从第一段文本收到)。非流式请求一旦开始就不再被抢占。
+ */
+
+enum class AiPriority : uint8_t {
+    URGENT = 0,       // 用户正在等的问题
+    NORMAL,
+    BACKGROUND,       // 预取、摘要等，流式执行时可以被 URGENT 抢占
+};
+
+enum class AiRequestState : uint8_t {
+    QUEUED,
+    RUNNING,
+    DONE,             // 已完成，结果可能是"<错误:"开头的错误描述
+    CANCELLED,
+    EXPIRED,          // 截止时间已过
+};
+
+typedef struct ai_request* ai_request_handle_t;
+
+/**
+ * @brief 请求完成回调，不要在其中阻塞
+ *
+ * 通常在工作任务中调用；排队中的请求被 ai_request_cancel 取消，或在 ai_async_submit 中因过期被移出时，
+ * 在调用这两个函数的任务中同步调用。
+ */
+typedef void (*ai_request_done_cb_t)(ai_request_handle_t request, void* arg);
+
+struct AiRequestOptions {
+    AiPriority priority = AiPriority::NORMAL;
+    uint32_t deadline_ms = 0;             // 从提交开始计算，0 表示不限
+    bool stream = false;                  // 用 get_ai_answer_stream 执行
+    bool hedged = false;                  // 用 get_ai_answer_hedged 执行 (不能与 stream 同时使用)
+    ai_delta_cb_t on_delta = nullptr;     // 流式增量回调 (工作任务中调用)
+    void* delta_arg = nullptr;
+    ai_request_done_cb_t on_done = nullptr;
+    void* done_arg = nullptr;
+};
+
+struct AiAsyncStats {
+    uint32_t submitted;
+    uint32_t rejected;                    // 队列已满
+    uint32_t completed;
+    uint32_t cancelled;
+    uint32_t expired;
+    uint32_t preempted;                   // 被 URGENT 请求抢占后重新排队
+    uint32_t depth;                       // 当前排队数
+    uint32_t max_depth;
+    uint32_t wait_count[3];               // 按优先级统计的排队等待 (提交到开始执行)
+    uint64_t wait_total_ms[3];
+    uint32_t wait_max_ms[3];
+    uint64_t service_total_ms;            // 执行耗时 (开始到结束，含建连)
+    uint32_t service_max_ms;
+};
+
+/**
+ * @brief 创建工作任务，在 ai_service_init 之后调用一次
+ */
+esp_err_t ai_async_init(void);
+
+/**
+ * @brief 提交一个请求
+ * @return 请求句柄，用完后必须 ai_request_release；队列已满或未初始化时返回 NULL
+ */
+ai_request_handle_t ai_async_submit(AiModel model, const std::string& input_text,
+                                    const AiRequestOptions& options = AiRequestOptions());
+
+/**
+ * @brief 等待请求结束 (完成、取消或过期)
+ * @return 在 timeout_ms 内结束返回 true
+ */
+bool ai_request_wait(ai_request_handle_t request, uint32_t timeout_ms);
+
+/**
+ * @brief 取消请求，对已经结束的请求无效果
+ */
+void ai_request_cancel(ai_request_handle_t request);
+
+AiRequestState ai_request_state(ai_request_handle_t request);
+
+/**
+ * @brief 请求结束后的回答 (或"<错误:"开头的错误描述)，未结束时返回空字符串
+ */
+std::string ai_request_result(ai_request_handle_t request);
+
+/**
+ * @brief 流式请求的首字延迟和总耗时，非流式请求全为 0
+ */
+AiStreamStats ai_request_stream_stats(ai_request_handle_t request);
+
+/**
+ * @brief 释放句柄。不会取消请求：未结束的请求仍会执行并调用 on_done
+ */
+void ai_request_release(ai_request_handle_t request);
+
+void ai_async_get_stats(AiAsyncStats* stats);
+
+/**
+ * @brief 打印队列深度、各优先级的等待时间和执行时间
+ */
+void ai_async_log_stats(void);
@@ -0,0 +1,479 @@
+// src/module_ai/ai_cache.cpp
+
+#include "ai_cache.h"
+#include "../audio/audio_recorder.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "AI_CACHE";
+
+#define AI_CACHE_MAGIC 0x32434941u   // "AIC2"，归一化规则改变后旧条目在加载时删除
+#define AI_CACHE_FILE_FMT AUDIO_STORAGE_BASE_PATH "/aic_%016llx"
+// 缓存时钟检查点在 NVS 中的位置 (需要 app_main 已初始化 NVS)
+#define AI_CACHE_NVS_NAMESPACE "ai_cache"
+#define AI_CACHE_NVS_CLOCK_KEY "clock"
+
+// flash 中每个条目的文件头，后面依次是归一化的问题和回答
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t model;
+    uint8_t reserved[3];
+    uint64_t key;
+    uint32_t created_s;
+    uint32_t expires_s;
+    uint16_t prompt_len;
+    uint16_t answer_len;
+    uint32_t crc;                 // 问题 + 回答的 CRC32
+} cache_file_header_t;
+
+struct ram_entry_t {
+    bool used;
+    uint8_t model;
+    uint64_t key;
+    uint32_t expires_s;
+    uint32_t last_used;           // LRU 计数
+    std::string prompt;
+    std::string answer;
+};
+
+typedef struct {
+    bool used;
+    uint64_t key;
+    uint32_t expires_s;
+    uint32_t last_used;           // 只在内存中更新，避免每次命中都写 flash
+} flash_entry_t;
+
+static SemaphoreHandle_t s_lock = NULL;
+static ram_entry_t s_ram[AI_CACHE_RAM_ENTRIES];
+static flash_entry_t s_flash[AI_CACHE_FLASH_ENTRIES];
+static bool s_flash_ok = false;
+static uint32_t s_clock_base = 0;    // 缓存时钟在本次开机时的起点 (秒)
+static esp_timer_handle_t s_clock_timer = NULL;
+static uint32_t s_tick = 0;
+static ai_cache_stats_t s_stats = {};
+
+// 这些问题的回答很快就会过时，只短暂缓存
+static const char* const kVolatileWords[] = {
+    "几点", "时间", "现在", "今天", "明天", "昨天", "星期", "日期", "天气", "温度",
+    "time", "date", "today", "weather",
+};
+
+// 归一化时去掉的全角标点 (UTF-8 均为 3 字节)，全角空格按空白处理
+static const char* const kCjkPunct[] = {
+    "，", "。", "？", "！", "、", "；", "：", "“", "”", "‘", "’", "（", "）", "《", "》", "…", "～",
+};
+static const char kCjkSpace[] = "　";
+
+static uint32_t _now_s() {
+    return s_clock_base + (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+// 上次保存的缓存时钟检查点，没有时返回 0
+static uint32_t _clock_checkpoint_load() {
+    nvs_handle_t nvs;
+    uint32_t value = 0;
+    if (nvs_open(AI_CACHE_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        nvs_get_u32(nvs, AI_CACHE_NVS_CLOCK_KEY, &value);
+        nvs_close(nvs);
+    }
+    return value;
+}
+
+// 在 esp_timer 任务中执行：只写一个 u32，NVS 通常只是追加一个条目，偶尔换页擦除也在几十毫秒以内
+static void _clock_checkpoint_save(void* arg) {
+    (void)arg;
+    nvs_handle_t nvs;
+    if (nvs_open(AI_CACHE_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_u32(nvs, AI_CACHE_NVS_CLOCK_KEY, _now_s()) == ESP_OK) {
+        nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+}
+
+static bool _is_ascii_alnum(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+// 只去掉不影响语义的部分：运算符、小数点等 ASCII 符号都要保留，否则 "1+1" 和 "11" 会得到同一个键
+std::string ai_cache_normalize(const std::string& input) {
+    std::string out;
+    out.reserve(input.size());
+    const char* s = input.data();
+    size_t n = input.size();
+    bool pending_space = false;   // 跳过了空白
+    bool pending_punct = false;   // 跳过了全角标点
+    for (size_t i = 0; i < n;) {
+        unsigned char c = (unsigned char)s[i];
+        size_t len = c < 0x80 ? 1 : c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        len = std::min(len, n - i);
+        if (c <= ' ' || (len == 3 && memcmp(s + i, kCjkSpace, 3) == 0)) {
+            pending_space = true;
+            i += len;
+            continue;
+        }
+        bool punct = false;
+        if (len == 3) {
+            for (const char* p : kCjkPunct) {
+                if (memcmp(s + i, p, 3) == 0) {
+                    punct = true;
+                    break;
+                }
+            }
+        }
+        if (punct) {
+            pending_punct = true;
+            i += len;
+            continue;
+        }
+        // 连续空白合并成一个空格；去掉的全角标点两侧都是字母数字时也留一个空格，避免 "1，2" 变成 "12"
+        if (!out.empty() && (pending_space ||
+                             (pending_punct && _is_ascii_alnum(out.back()) && _is_ascii_alnum(c)))) {
+            out += ' ';
+        }
+        pending_space = pending_punct = false;
+        if (c >= 'A' && c <= 'Z') {
+            out += (char)(c + ('a' - 'A'));
+        } else {
+            out.append(s + i, len);
+        }
+        i += len;
+    }
+    // 去掉句末的标点和空格 ("几点了?" 和 "几点了" 是同一个问题)
+    while (!out.empty() && strchr("?!.~ ", out.back())) {
+        out.pop_back();
+    }
+    return out;
+}
+
+static uint64_t _hash(int model, const std::string& normalized) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    h = (h ^ (uint8_t)model) * 0x100000001b3ULL;
+    for (unsigned char c : normalized) {
+        h = (h ^ c) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static bool _is_volatile(const std::string& normalized) {
+    for (const char* w : kVolatileWords) {
+        if (normalized.find(w) != std::string::npos) return true;
+    }
+    return false;
+}
+
+static void _file_path(char* buf, size_t size, uint64_t key) {
+    snprintf(buf, size, AI_CACHE_FILE_FMT, (unsigned long long)key);
+}
+
+// ======== RAM 级 (调用方持有 s_lock) ========
+
+static ram_entry_t* _ram_find(uint64_t key, int model, const std::string& prompt) {
+    for (ram_entry_t& e : s_ram) {
+        if (e.used && e.key == key && e.model == model && e.prompt == prompt) return &e;
+    }
+    return NULL;
+}
+
+static void _ram_erase(ram_entry_t* e) {
+    e->used = false;
+    std::string().swap(e->prompt);
+    std::string().swap(e->answer);
+}
+
+static void _ram_insert(uint64_t key, int model, const std::string& prompt, const std::string& answer,
+                        uint32_t expires_s) {
+    ram_entry_t* slot = _ram_find(key, model, prompt);
+    if (!slot) {
+        for (ram_entry_t& e : s_ram) {
+            if (!e.used) {
+                slot = &e;
+                break;
+            }
+            if (!slot || e.last_used < slot->last_used) slot = &e;
+        }
+        if (slot->used) s_stats.ram_evictions++;
+    }
+    slot->used = true;
+    slot->model = (uint8_t)model;
+    slot->key = key;
+    slot->expires_s = expires_s;
+    slot->last_used = ++s_tick;
+    slot->prompt = prompt;
+    slot->answer = answer;
+}
+
+// ======== flash 级 (调用方持有 s_lock) ========
+
+static flash_entry_t* _flash_find(uint64_t key) {
+    for (flash_entry_t& e : s_flash) {
+        if (e.used && e.key == key) return &e;
+    }
+    return NULL;
+}
+
+static void _flash_erase(flash_entry_t* e) {
+    char path[48];
+    _file_path(path, sizeof(path), e->key);
+    unlink(path);
+    e->used = false;
+    s_stats.flash_entries--;
+}
+
+static bool _flash_read(uint64_t key, int model, const std::string& prompt, std::string* answer) {
+    char path[48];
+    _file_path(path, sizeof(path), key);
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    cache_file_header_t h;
+    std::string data;
+    bool ok = fread(&h, sizeof(h), 1, f) == 1 && h.magic == AI_CACHE_MAGIC && h.key == key && h.model == model;
+    if (ok) {
+        data.resize(h.prompt_len + h.answer_len);
+        ok = fread(&data[0], 1, data.size(), f) == data.size() &&
+             esp_rom_crc32_le(0, (const uint8_t*)data.data(), data.size()) == h.crc;
+    }
+    fclose(f);
+    if (!ok) {
+        s_stats.flash_errors++;
+        return false;
+    }
+    if (data.compare(0, h.prompt_len, prompt) != 0 || h.prompt_len != prompt.size()) {
+        return false;  // 哈希碰撞
+    }
+    answer->assign(data, h.prompt_len, h.answer_len);
+    return true;
+}
+
+static void _flash_write(uint64_t key, int model, const std::string& prompt, const std::string& answer,
+                         uint32_t now, uint32_t expires_s) {
+    flash_entry_t* slot = _flash_find(key);
+    if (!slot) {
+        for (flash_entry_t& e : s_flash) {
+            if (!e.used) {
+                slot = &e;
+                break;
+            }
+            if (!slot || e.last_used < slot->last_used) slot = &e;
+        }
+        if (slot->used) {
+            _flash_erase(slot);
+            s_stats.flash_evictions++;
+        }
+        s_stats.flash_entries++;
+    }
+
+    cache_file_header_t h = {};
+    h.magic = AI_CACHE_MAGIC;
+    h.model = (uint8_t)model;
+    h.key = key;
+    h.created_s = now;
+    h.expires_s = expires_s;
+    h.prompt_len = (uint16_t)prompt.size();
+    h.answer_len = (uint16_t)answer.size();
+    h.crc = esp_rom_crc32_le(0, (const uint8_t*)prompt.data(), prompt.size());
+    h.crc = esp_rom_crc32_le(h.crc, (const uint8_t*)answer.data(), answer.size());
+
+    char path[48];
+    _file_path(path, sizeof(path), key);
+    FILE* f = fopen(path, "wb");
+    bool ok = f && fwrite(&h, sizeof(h), 1, f) == 1 &&
+              fwrite(prompt.data(), 1, prompt.size(), f) == prompt.size() &&
+              fwrite(answer.data(), 1, answer.size(), f) == answer.size();
+    if (f) fclose(f);
+    if (!ok) {
+        // 写了一半的文件 CRC 对不上，读取时也会被丢弃，这里直接删掉
+        unlink(path);
+        slot->used = false;
+        s_stats.flash_entries--;
+        s_stats.flash_errors++;
+        return;
+    }
+    slot->used = true;
+    slot->key = key;
+    slot->expires_s = expires_s;
+    slot->last_used = ++s_tick;
+}
+
+// 扫描 storage 分区中的缓存文件，重建索引；缓存时钟不早于最新条目的写入时间
+static void _flash_load() {
+    DIR* dir = opendir(AUDIO_STORAGE_BASE_PATH);
+    if (!dir) return;
+    uint32_t latest = 0;
+    while (struct dirent* d = readdir(dir)) {
+        unsigned long long key;
+        if (sscanf(d->d_name, "aic_%16llx", &key) != 1) continue;
+        char path[48];
+        _file_path(path, sizeof(path), key);
+        cache_file_header_t h;
+        FILE* f = fopen(path, "rb");
+        bool ok = f && fread(&h, sizeof(h), 1, f) == 1 && h.magic == AI_CACHE_MAGIC && h.key == key;
+        if (f) fclose(f);
+        flash_entry_t* slot = NULL;
+        for (flash_entry_t& e : s_flash) {
+            if (!e.used) {
+                slot = &e;
+                break;
+            }
+        }
+        if (!ok || !slot) {
+            unlink(path);
+            continue;
+        }
+        slot->used = true;
+        slot->key = key;
+        slot->expires_s = h.expires_s;
+        slot->last_used = h.created_s;  // 按写入时间近似 LRU
+        s_stats.flash_entries++;
+        latest = std::max(latest, h.created_s);
+    }
+    closedir(dir);
+
+    s_clock_base = std::max(s_clock_base, latest);
+    for (flash_entry_t& e : s_flash) {
+        if (e.used && e.expires_s <= s_clock_base) _flash_erase(&e);
+    }
+    s_tick = latest;
+}
+
+// ======== 公共接口 ========
+
+esp_err_t ai_cache_init(void) {
+    if (s_lock) {
+        return ESP_OK;
+    }
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    // 缓存时钟从上次保存的检查点继续 (最多少算一个保存周期)，关机的时间不计入
+    s_clock_base = _clock_checkpoint_load();
+    s_flash_ok = audio_storage_mount();
+    if (s_flash_ok) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        _flash_load();
+        xSemaphoreGive(s_lock);
+    }
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = _clock_checkpoint_save;
+    timer_args.name = "ai_cache_clock";
+    if (esp_timer_create(&timer_args, &s_clock_timer) == ESP_OK) {
+        esp_timer_start_periodic(s_clock_timer, AI_CACHE_CLOCK_SAVE_S * 1000000ULL);
+    } else {
+        ESP_LOGW(TAG, "创建时钟检查点定时器失败，重启后时钟从最新条目继续");
+    }
+    ESP_LOGI(TAG, "回答缓存: RAM %d 条, flash %s, 已有 %u 条", AI_CACHE_RAM_ENTRIES,
+             s_flash_ok ? "可用" : "不可用", (unsigned)s_stats.flash_entries);
+    return ESP_OK;
+}
+
+bool ai_cache_get(int model, const std::string& input, std::string* answer) {
+    if (!s_lock) return false;
+    int64_t t0 = esp_timer_get_time();
+    std::string prompt = ai_cache_normalize(input);
+    uint64_t key = _hash(model, prompt);
+    uint32_t now = _now_s();
+    bool hit = false;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    ram_entry_t* e = _ram_find(key, model, prompt);
+    if (e && e->expires_s <= now) {
+        _ram_erase(e);
+        s_stats.expired++;
+        e = NULL;
+    }
+    if (e) {
+        e->last_used = ++s_tick;
+        *answer = e->answer;
+        s_stats.ram_hits++;
+        hit = true;
+    } else if (s_flash_ok) {
+        flash_entry_t* fe = _flash_find(key);
+        if (fe && fe->expires_s <= now) {
+            _flash_erase(fe);
+            s_stats.expired++;
+        } else if (fe && _flash_read(key, model, prompt, answer)) {
+            fe->last_used = ++s_tick;
+            _ram_insert(key, model, prompt, *answer, fe->expires_s);
+            s_stats.flash_hits++;
+            hit = true;
+        }
+    }
+    if (hit) {
+        uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+        s_stats.bytes_served += answer->size();
+        s_stats.hit_total_us += us;
+        s_stats.hit_max_us = std::max(s_stats.hit_max_us, us);
+    } else {
+        s_stats.misses++;
+    }
+    xSemaphoreGive(s_lock);
+    return hit;
+}
+
+void ai_cache_put(int model, const std::string& input, const std::string& answer) {
+    if (!s_lock || answer.empty() || answer.size() > AI_CACHE_MAX_ANSWER) return;
+    std::string prompt = ai_cache_normalize(input);
+    if (prompt.empty() || prompt.size() > UINT16_MAX) return;
+    uint64_t key = _hash(model, prompt);
+    bool short_lived = _is_volatile(prompt);
+    uint32_t now = _now_s();
+    uint32_t expires = now + (short_lived ? AI_CACHE_SHORT_TTL_S : AI_CACHE_TTL_S);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    _ram_insert(key, model, prompt, answer, expires);
+    if (s_flash_ok && !short_lived) {
+        _flash_write(key, model, prompt, answer, now, expires);
+    }
+    s_stats.inserts++;
+    xSemaphoreGive(s_lock);
+}
+
+void ai_cache_clear(void) {
+    if (!s_lock) return;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (ram_entry_t& e : s_ram) {
+        if (e.used) _ram_erase(&e);
+    }
+    for (flash_entry_t& e : s_flash) {
+        if (e.used) _flash_erase(&e);
+    }
+    xSemaphoreGive(s_lock);
+}
+
+void ai_cache_get_stats(ai_cache_stats_t* stats) {
+    if (!s_lock) {
+        *stats = ai_cache_stats_t();
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_lock);
+}
+
+void ai_cache_log_stats(void) {
+    ai_cache_stats_t st;
+    ai_cache_get_stats(&st);
+    uint32_t hits = st.ram_hits + st.flash_hits;
+    uint32_t lookups = hits + st.misses;
+    ESP_LOGI(TAG, "--- 回答缓存 ---");
+    ESP_LOGI(TAG, "命中 %u/%u (%.1f%%): RAM %u, flash %u; 过期 %u", (unsigned)hits, (unsigned)lookups,
+             lookups ? 100.0 * hits / lookups : 0.0, (unsigned)st.ram_hits, (unsigned)st.flash_hits,
+             (unsigned)st.expired);
+    ESP_LOGI(TAG, "命中耗时: 平均 %u us, 最大 %u us; 省下 %u 字节下行",
+             (unsigned)(hits ? st.hit_total_us / hits : 0), (unsigned)st.hit_max_us, (unsigned)st.bytes_served);
+    ESP_LOGI(TAG, "写入 %u, 淘汰 RAM %u / flash %u, flash 条目 %u, flash 错误 %u", (unsigned)st.inserts,
+             (unsigned)st.ram_evictions, (unsigned)st.flash_evictions, (unsigned)st.flash_entries,
+             (unsigned)st.flash_errors);
+}
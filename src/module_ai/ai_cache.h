@@ -0,0 +1,80 @@
+// src/module_ai/ai_cache.h
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "esp_err.h"
+
+/**
+ * @brief AI 回答缓存：相同的问题直接返回上次的回答，不再请求 DeepSeek/Coze
+ *
+ * 键为 模型 + 归一化后的问题 的 64 位 FNV-1a 哈希 (归一化：连续空白合并为一个空格，去掉全角标点和句末标点，
+ * ASCII 转小写；运算符、小数点等其他 ASCII 符号保留)，
+ * 条目里同时保存归一化的问题，哈希碰撞时不会返回错误的回答。分两级：
+ *   - RAM：AI_CACHE_RAM_ENTRIES 条，LRU 淘汰，命中在微秒级；
+ *   - flash：storage 分区 (SPIFFS) 中每条一个文件 aic_<哈希>，最多 AI_CACHE_FLASH_ENTRIES 条，
+ *     重启后仍然有效，命中后提升到 RAM。
+ * 过期时间按"设备运行时间"计算：没有 RTC/NTP，缓存时钟每 AI_CACHE_CLOCK_SAVE_S 秒在 NVS 中保存一次检查点，
+ * 重启后从检查点 (不早于已有条目的最新写入时间) 继续计时，关机的时间不计入。
+ * 含时间、天气等易变内容的问题只缓存 AI_CACHE_SHORT_TTL_S 秒且不写 flash。
+ */
+
+#define AI_CACHE_RAM_ENTRIES   16
+#define AI_CACHE_FLASH_ENTRIES 64
+#define AI_CACHE_MAX_ANSWER    2048          // 超过此长度的回答不缓存
+#define AI_CACHE_TTL_S         (24 * 3600)
+#define AI_CACHE_SHORT_TTL_S   60
+#define AI_CACHE_CLOCK_SAVE_S  300           // 缓存时钟检查点的保存周期
+
+typedef struct {
+    uint32_t ram_hits;
+    uint32_t flash_hits;
+    uint32_t misses;
+    uint32_t expired;             // 找到了但已过期
+    uint32_t inserts;
+    uint32_t ram_evictions;
+    uint32_t flash_evictions;
+    uint32_t flash_errors;        // 读写失败或校验不通过
+    uint64_t bytes_served;        // 从缓存返回的回答字节数 (省下的下行流量)
+    uint64_t hit_total_us;
+    uint32_t hit_max_us;
+    uint32_t flash_entries;
+} ai_cache_stats_t;
+
+/**
+ * @brief 挂载 storage 分区并加载 flash 中的条目索引，在 ai_service_init 中调用
+ *
+ * flash 不可用时只使用 RAM 级。
+ */
+esp_err_t ai_cache_init(void);
+
+/**
+ * @brief 查询缓存
+ * @param model  模型编号 (AiModel 转成 int)
+ * @param answer 命中时写入回答
+ * @return 是否命中
+ */
+bool ai_cache_get(int model, const std::string& input, std::string* answer);
+
+/**
+ * @brief 写入一条回答 (错误描述不要写入)
+ */
+void ai_cache_put(int model, const std::string& input, const std::string& answer);
+
+/**
+ * @brief 清空两级缓存
+ */
+void ai_cache_clear(void);
+
+/**
+ * @brief 归一化问题文本：连续空白合并为一个空格，去掉全角标点和句末的 ?!.~，ASCII 字母转小写
+ */
+std::string ai_cache_normalize(const std::string& input);
+
+void ai_cache_get_stats(ai_cache_stats_t* stats);
+
+/**
+ * @brief 打印命中率、命中耗时和节省的流量
+ */
+void ai_cache_log_stats(void);
@@ -0,0 +1,159 @@
+// src/module_ai/ai_conversation.cpp
+
+#include "ai_conversation.h"
+
+#include <string.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "AI_CONV";
+
+typedef struct {
+    uint16_t offset;              // 片段在 arena 中的位置
+    uint16_t len;
+    uint16_t tokens;
+} turn_t;
+
+// 片段按时间顺序紧挨着存放，淘汰最早的一轮时把后面的整体前移
+static char s_arena[AI_CONV_ARENA_SIZE];
+static turn_t s_turns[AI_CONV_MAX_TURNS];
+static int s_turn_count = 0;
+static size_t s_used = 0;
+static uint32_t s_tokens = 0;
+static ai_conversation_stats_t s_stats = {};
+static SemaphoreHandle_t s_lock = NULL;
+
+// 调用时持有 s_lock
+static void _evict_oldest() {
+    const turn_t oldest = s_turns[0];
+    memmove(s_arena, s_arena + oldest.len, s_used - oldest.len);
+    s_used -= oldest.len;
+    s_tokens -= oldest.tokens;
+    for (int i = 1; i < s_turn_count; i++) {
+        s_turns[i - 1] = s_turns[i];
+        s_turns[i - 1].offset -= oldest.len;
+    }
+    s_turn_count--;
+    s_stats.evicted++;
+}
+
+static const char kUserHead[] = "{\"role\":\"user\",\"content\":";
+static const char kAssistantHead[] = "{\"role\":\"assistant\",\"content\":";
+static const char kMessageTail[] = "},";
+
+esp_err_t ai_conversation_init(void) {
+    if (s_lock) {
+        return ESP_OK;
+    }
+    s_lock = xSemaphoreCreateMutex();
+    return s_lock ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+uint32_t ai_conversation_estimate_tokens(const char* text, size_t len) {
+    uint32_t ascii = 0;
+    uint32_t others = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c < 0x80) {
+            ascii++;
+        } else if ((c & 0xC0) != 0x80) {
+            others++;             // 多字节字符的首字节
+        }
+    }
+    return others + (ascii + 3) / 4;
+}
+
+bool ai_conversation_append(const std::string& user, const std::string& assistant) {
+    if (!s_lock) {
+        return false;
+    }
+    uint32_t tokens = ai_conversation_estimate_tokens(user.data(), user.size()) +
+                      ai_conversation_estimate_tokens(assistant.data(), assistant.size());
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (tokens > AI_CONV_MAX_TOKENS) {
+        s_stats.rejected++;
+        xSemaphoreGive(s_lock);
+        ESP_LOGW(TAG, "单轮对话约 %u token，超过上限，不保存", (unsigned)tokens);
+        return false;
+    }
+    // 先算出片段长度，单轮放不下时直接拒绝，不会白白清空已有的上下文
+    size_t len = sizeof(kUserHead) - 1 + ai_json_string_len(user.data(), user.size()) + sizeof(kMessageTail) - 1 +
+                 sizeof(kAssistantHead) - 1 + ai_json_string_len(assistant.data(), assistant.size()) +
+                 sizeof(kMessageTail) - 1;
+    if (len >= AI_CONV_ARENA_SIZE) {
+        s_stats.rejected++;
+        xSemaphoreGive(s_lock);
+        ESP_LOGW(TAG, "单轮对话序列化后 %u 字节，超过上限，不保存", (unsigned)len);
+        return false;
+    }
+    while (s_turn_count && (s_tokens + tokens > AI_CONV_MAX_TOKENS || s_used + len >= AI_CONV_ARENA_SIZE ||
+                            s_turn_count >= AI_CONV_MAX_TURNS)) {
+        _evict_oldest();
+    }
+
+    // 直接序列化到 arena 末尾
+    ai_json_writer_t w;
+    ai_json_writer_init(&w, s_arena + s_used, AI_CONV_ARENA_SIZE - s_used);
+    AI_JSON_WRITE_LITERAL(&w, kUserHead);
+    ai_json_write_string(&w, user.data(), user.size());
+    AI_JSON_WRITE_LITERAL(&w, kMessageTail);
+    AI_JSON_WRITE_LITERAL(&w, kAssistantHead);
+    ai_json_write_string(&w, assistant.data(), assistant.size());
+    AI_JSON_WRITE_LITERAL(&w, kMessageTail);
+    ai_json_writer_finish(&w);
+
+    turn_t* turn = &s_turns[s_turn_count++];
+    turn->offset = (uint16_t)s_used;
+    turn->len = (uint16_t)w.len;
+    turn->tokens = (uint16_t)tokens;
+    s_used += w.len;
+    s_tokens += tokens;
+    s_stats.appended++;
+    xSemaphoreGive(s_lock);
+    return true;
+}
+
+void ai_conversation_write(ai_json_writer_t* writer) {
+    if (!s_lock) {
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    ai_json_write_raw(writer, s_arena, s_used);
+    xSemaphoreGive(s_lock);
+}
+
+void ai_conversation_clear(void) {
+    if (!s_lock) {
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_turn_count = 0;
+    s_used = 0;
+    s_tokens = 0;
+    xSemaphoreGive(s_lock);
+    ESP_LOGI(TAG, "对话上下文已清空");
+}
+
+void ai_conversation_get_stats(ai_conversation_stats_t* stats) {
+    if (!s_lock) {
+        *stats = ai_conversation_stats_t();
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    stats->turns = s_turn_count;
+    stats->bytes = s_used;
+    stats->tokens = s_tokens;
+    xSemaphoreGive(s_lock);
+}
+
+void ai_conversation_log_stats(void) {
+    ai_conversation_stats_t st;
+    ai_conversation_get_stats(&st);
+    ESP_LOGI(TAG, "--- 对话上下文 ---");
+    ESP_LOGI(TAG, "%u 轮, %u/%u 字节, 约 %u/%u token; 追加 %u, 淘汰 %u, 拒绝 %u", (unsigned)st.turns,
+             (unsigned)st.bytes, (unsigned)AI_CONV_ARENA_SIZE, (unsigned)st.tokens, (unsigned)AI_CONV_MAX_TOKENS,
+             (unsigned)st.appended, (unsigned)st.evicted, (unsigned)st.rejected);
+}
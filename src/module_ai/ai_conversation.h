@@ -0,0 +1,67 @@
+// src/module_ai/ai_conversation.h
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include "esp_err.h"
+#include "ai_json_writer.h"
+
+/**
+ * @brief 多轮对话的上下文 (只用于 DeepSeek 的 messages 数组)
+ *
+ * 每轮对话 (用户问题 + 回答) 在加入时就序列化成 JSON 片段
+ *   {"role":"user","content":"..."},{"role":"assistant","content":"..."},
+ * 存进固定大小的 arena，之后每次请求只需把这些片段原样拷进请求体，不再重复转义或建树。
+ * 超出 AI_CONV_ARENA_SIZE 字节、AI_CONV_MAX_TOKENS 个估算 token 或 AI_CONV_MAX_TURNS 轮时，
+ * 从最早的一轮开始淘汰。
+ *
+ * token 按 DeepSeek 分词的粗略规律估算：非 ASCII 字符 (主要是汉字) 每个 1 个，ASCII 每 4 字节 1 个。
+ */
+
+#define AI_CONV_ARENA_SIZE 4096
+#define AI_CONV_MAX_TOKENS 1500
+#define AI_CONV_MAX_TURNS  16
+
+typedef struct {
+    uint32_t turns;               // 当前保存的轮数
+    uint32_t bytes;               // arena 已用字节
+    uint32_t tokens;              // 估算 token 数
+    uint32_t appended;
+    uint32_t evicted;             // 因超出预算被淘汰的轮数
+    uint32_t rejected;            // 单轮就超出预算，没有保存
+} ai_conversation_stats_t;
+
+/**
+ * @brief 在 ai_service_init 中调用
+ */
+esp_err_t ai_conversation_init(void);
+
+/**
+ * @brief 追加一轮对话，必要时淘汰最早的轮次
+ * @return 单轮就超出预算时返回 false (上下文不变)
+ */
+bool ai_conversation_append(const std::string& user, const std::string& assistant);
+
+/**
+ * @brief 把已保存的全部片段写进请求体 (位于 system 消息和本次的 user 消息之间)
+ */
+void ai_conversation_write(ai_json_writer_t* writer);
+
+/**
+ * @brief 清空上下文，开始新的对话
+ */
+void ai_conversation_clear(void);
+
+/**
+ * @brief 估算一段 UTF-8 文本的 token 数
+ */
+uint32_t ai_conversation_estimate_tokens(const char* text, size_t len);
+
+void ai_conversation_get_stats(ai_conversation_stats_t* stats);
+
+/**
+ * @brief 打印当前轮数、占用和淘汰次数
+ */
+void ai_conversation_log_stats(void);
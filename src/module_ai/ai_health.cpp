@@ -0,0 +1,261 @@
+// src/module_ai/ai_health.cpp
+
+#include "ai_health.h"
+
+#include <algorithm>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "AI_HEALTH";
+
+typedef struct {
+    // 熔断器
+    AiBreakerState state;
+    uint32_t consecutive_failures;
+    uint32_t cooldown_ms;
+    int64_t open_until_us;
+    bool probe_in_flight;
+    // 延迟：环形窗口按 count % AI_HEALTH_WINDOW 写入
+    uint32_t window[AI_HEALTH_WINDOW];
+    uint32_t count;
+    uint32_t histogram[AI_HEALTH_HIST_BUCKETS];
+    // 统计
+    uint32_t successes;
+    uint32_t failures;
+    uint32_t rejected;
+    uint32_t trips;
+    uint32_t probes;
+} backend_health_t;
+
+static backend_health_t s_backends[2];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static backend_health_t* _backend(AiModel model) {
+    return &s_backends[model == AiModel::COZE ? 1 : 0];
+}
+
+static const char* _model_name(AiModel model) {
+    return model == AiModel::DEEPSEEK ? "DeepSeek" : "Coze";
+}
+
+static const char* _state_name(AiBreakerState state) {
+    switch (state) {
+        case AiBreakerState::CLOSED: return "CLOSED";
+        case AiBreakerState::OPEN: return "OPEN";
+        default: return "HALF_OPEN";
+    }
+}
+
+// 调用时持有 s_lock
+static void _open(backend_health_t* b, int64_t now) {
+    b->state = AiBreakerState::OPEN;
+    b->open_until_us = now + (int64_t)b->cooldown_ms * 1000;
+    b->trips++;
+}
+
+static int _bucket(uint32_t ms) {
+    int i = 0;
+    for (uint32_t edge = 500; i < AI_HEALTH_HIST_BUCKETS - 1 && ms >= edge; edge *= 2) {
+        i++;
+    }
+    return i;
+}
+
+// 从窗口拷出已排序的样本，返回样本数
+static uint32_t _sorted_window(const backend_health_t* b, uint32_t* out) {
+    uint32_t n = std::min<uint32_t>(b->count, AI_HEALTH_WINDOW);
+    memcpy(out, b->window, n * sizeof(out[0]));
+    std::sort(out, out + n);
+    return n;
+}
+
+// 最近秩法：第 ceil(n * p / 100) 个样本
+static uint32_t _percentile(const uint32_t* sorted, uint32_t n, int percent) {
+    percent = std::max(0, std::min(percent, 100));
+    uint32_t rank = (n * percent + 99) / 100;
+    return sorted[rank ? rank - 1 : 0];
+}
+
+// 调用时持有 s_lock
+static void _record_latency(backend_health_t* b, uint32_t latency_ms) {
+    b->window[b->count % AI_HEALTH_WINDOW] = latency_ms;
+    b->count++;
+    b->histogram[_bucket(latency_ms)]++;
+}
+
+bool ai_health_acquire(AiModel model) {
+    backend_health_t* b = _backend(model);
+    int64_t now = esp_timer_get_time();
+    bool allowed = true;
+    bool probe = false;
+
+    portENTER_CRITICAL(&s_lock);
+    if (b->state == AiBreakerState::OPEN && now >= b->open_until_us) {
+        b->state = AiBreakerState::HALF_OPEN;
+    }
+    if (b->state == AiBreakerState::OPEN ||
+        (b->state == AiBreakerState::HALF_OPEN && b->probe_in_flight)) {
+        allowed = false;
+        b->rejected++;
+    } else if (b->state == AiBreakerState::HALF_OPEN) {
+        b->probe_in_flight = true;
+        b->probes++;
+        probe = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (probe) {
+        ESP_LOGI(TAG, "%s 熔断冷却结束，发送探测请求", _model_name(model));
+    }
+    return allowed;
+}
+
+void ai_health_report(AiModel model, AiOutcome outcome, uint32_t latency_ms) {
+    backend_health_t* b = _backend(model);
+    int64_t now = esp_timer_get_time();
+    AiBreakerState before, after;
+    uint32_t cooldown_ms;
+
+    portENTER_CRITICAL(&s_lock);
+    before = b->state;
+    bool was_probe = b->probe_in_flight;
+    b->probe_in_flight = false;
+    if (b->cooldown_ms == 0) {
+        b->cooldown_ms = AI_HEALTH_COOLDOWN_MS;
+    }
+    if (outcome == AiOutcome::SUCCESS) {
+        b->successes++;
+        b->consecutive_failures = 0;
+        b->state = AiBreakerState::CLOSED;
+        b->cooldown_ms = AI_HEALTH_COOLDOWN_MS;
+        if (latency_ms) {
+            _record_latency(b, latency_ms);
+        }
+    } else if (outcome == AiOutcome::FAILURE) {
+        b->failures++;
+        b->consecutive_failures++;
+        if (b->state == AiBreakerState::HALF_OPEN && was_probe) {
+            b->cooldown_ms = std::min<uint32_t>(b->cooldown_ms * 2, AI_HEALTH_MAX_COOLDOWN_MS);
+            _open(b, now);
+        } else if (b->state == AiBreakerState::CLOSED &&
+                   b->consecutive_failures >= AI_HEALTH_TRIP_FAILURES) {
+            _open(b, now);
+        }
+    }
+    after = b->state;
+    cooldown_ms = b->cooldown_ms;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (after != before) {
+        if (after == AiBreakerState::OPEN) {
+            ESP_LOGW(TAG, "%s 熔断: %s -> OPEN，%u ms 后探测", _model_name(model), _state_name(before),
+                     (unsigned)cooldown_ms);
+        } else {
+            ESP_LOGI(TAG, "%s 恢复: %s -> %s", _model_name(model), _state_name(before), _state_name(after));
+        }
+    }
+}
+
+void ai_health_record_latency(AiModel model, uint32_t latency_ms) {
+    if (latency_ms == 0) {
+        return;
+    }
+    backend_health_t* b = _backend(model);
+    portENTER_CRITICAL(&s_lock);
+    _record_latency(b, latency_ms);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+int ai_health_timeout_ms(AiModel model, int max_ms) {
+    backend_health_t* b = _backend(model);
+    uint32_t sorted[AI_HEALTH_WINDOW];
+
+    portENTER_CRITICAL(&s_lock);
+    bool probing = b->state != AiBreakerState::CLOSED;
+    uint32_t n = std::min<uint32_t>(b->count, AI_HEALTH_WINDOW);
+    memcpy(sorted, b->window, n * sizeof(sorted[0]));
+    portEXIT_CRITICAL(&s_lock);
+
+    if (probing || n < AI_HEALTH_MIN_SAMPLES) {
+        return max_ms;
+    }
+    std::sort(sorted, sorted + n);
+    int64_t timeout = (int64_t)_percentile(sorted, n, 95) * AI_HEALTH_TIMEOUT_FACTOR;
+    return (int)std::max<int64_t>(std::min<int64_t>(AI_HEALTH_MIN_TIMEOUT_MS, max_ms),
+                                  std::min<int64_t>(timeout, max_ms));
+}
+
+uint32_t ai_health_latency_percentile(AiModel model, int percent, uint32_t min_samples) {
+    backend_health_t* b = _backend(model);
+    uint32_t sorted[AI_HEALTH_WINDOW];
+
+    portENTER_CRITICAL(&s_lock);
+    uint32_t n = std::min<uint32_t>(b->count, AI_HEALTH_WINDOW);
+    memcpy(sorted, b->window, n * sizeof(sorted[0]));
+    portEXIT_CRITICAL(&s_lock);
+
+    if (n == 0 || n < min_samples) {
+        return 0;
+    }
+    std::sort(sorted, sorted + n);
+    return _percentile(sorted, n, percent);
+}
+
+void ai_health_get(AiModel model, AiBackendHealth* health) {
+    backend_health_t* b = _backend(model);
+    backend_health_t copy;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    copy = *b;
+    portEXIT_CRITICAL(&s_lock);
+
+    *health = AiBackendHealth();
+    health->state = copy.state;
+    // OPEN 状态在下一次 acquire 时才转为 HALF_OPEN，这里按时间提前反映出来
+    if (copy.state == AiBreakerState::OPEN && now >= copy.open_until_us) {
+        health->state = AiBreakerState::HALF_OPEN;
+    }
+    health->consecutive_failures = copy.consecutive_failures;
+    health->cooldown_ms = copy.cooldown_ms ? copy.cooldown_ms : AI_HEALTH_COOLDOWN_MS;
+    if (health->state == AiBreakerState::OPEN) {
+        health->open_remaining_ms = (uint32_t)((copy.open_until_us - now) / 1000);
+    }
+    health->successes = copy.successes;
+    health->failures = copy.failures;
+    health->rejected = copy.rejected;
+    health->trips = copy.trips;
+    health->probes = copy.probes;
+    memcpy(health->histogram, copy.histogram, sizeof(health->histogram));
+
+    uint32_t sorted[AI_HEALTH_WINDOW];
+    uint32_t n = _sorted_window(&copy, sorted);
+    health->samples = n;
+    if (n) {
+        health->p50_ms = _percentile(sorted, n, 50);
+        health->p95_ms = _percentile(sorted, n, 95);
+        health->p99_ms = _percentile(sorted, n, 99);
+    }
+}
+
+void ai_health_log_stats(void) {
+    ESP_LOGI(TAG, "--- AI 后端健康状态 ---");
+    for (AiModel model : { AiModel::DEEPSEEK, AiModel::COZE }) {
+        AiBackendHealth h;
+        ai_health_get(model, &h);
+        ESP_LOGI(TAG, "%s: %s, 连续失败 %u, 成功 %u, 失败 %u, 熔断 %u 次, 拒绝 %u, 探测 %u", _model_name(model),
+                 _state_name(h.state), (unsigned)h.consecutive_failures, (unsigned)h.successes,
+                 (unsigned)h.failures, (unsigned)h.trips, (unsigned)h.rejected, (unsigned)h.probes);
+        if (h.state == AiBreakerState::OPEN) {
+            ESP_LOGI(TAG, "  %u ms 后半开 (冷却 %u ms)", (unsigned)h.open_remaining_ms, (unsigned)h.cooldown_ms);
+        }
+        ESP_LOGI(TAG, "  最近 %u 次: p50 %u ms, p95 %u ms, p99 %u ms", (unsigned)h.samples,
+                 (unsigned)h.p50_ms, (unsigned)h.p95_ms, (unsigned)h.p99_ms);
+        ESP_LOGI(TAG, "  直方图 (<0.5/1/2/4/8/16/32s/更长): %u %u %u %u %u %u %u %u",
+                 (unsigned)h.histogram[0], (unsigned)h.histogram[1], (unsigned)h.histogram[2],
+                 (unsigned)h.histogram[3], (unsigned)h.histogram[4], (unsigned)h.histogram[5],
+                 (unsigned)h.histogram[6], (unsigned)h.histogram[7]);
+    }
+}
@@ -0,0 +1,101 @@
+// src/module_ai/ai_health.h
+
+#pragma once
+
+#include <stdint.h>
+#include "ai_service.h"
+
+/**
+ * @brief 每个 AI 后端的健康状态：延迟统计、自适应超时和熔断器
+ *
+ * 延迟：最近 AI_HEALTH_WINDOW 次成功的非流式请求耗时 (以及 ai_health_record_latency 补记的样本)
+ * 用来计算分位数 (反映当前状况)，另有一个按 2 的幂分桶的累计直方图用于日志。
+ *
+ * 超时：样本足够时取 p95 × AI_HEALTH_TIMEOUT_FACTOR，限制在 [AI_HEALTH_MIN_TIMEOUT_MS, 配置的上限] 之间，
+ * 后端变慢时超时随之变长，直到上限。
+ *
+ * 熔断器：
+ *   CLOSED    正常放行，连续失败 AI_HEALTH_TRIP_FAILURES 次后转为 OPEN；
+ *   OPEN      直接拒绝 (返回 AI_ERROR_BACKEND_DOWN)，冷却时间到后转为 HALF_OPEN；
+ *   HALF_OPEN 只放行一个探测请求 (使用上限超时)，成功则 CLOSED，失败则回到 OPEN 且冷却时间加倍
+ *             (最长 AI_HEALTH_MAX_COOLDOWN_MS)。
+ * 只有连接失败、超时、5xx 和 429 算失败；中止、连接池繁忙、其他 4xx、解析错误不影响熔断器。
+ */
+
+#define AI_HEALTH_WINDOW           32
+#define AI_HEALTH_MIN_SAMPLES      10
+#define AI_HEALTH_TIMEOUT_FACTOR   3
+#define AI_HEALTH_MIN_TIMEOUT_MS   5000
+#define AI_HEALTH_TRIP_FAILURES    3
+#define AI_HEALTH_COOLDOWN_MS      10000
+#define AI_HEALTH_MAX_COOLDOWN_MS  (5 * 60 * 1000)
+#define AI_HEALTH_HIST_BUCKETS     8          // <0.5s, <1s, <2s, ... <32s, >=32s
+
+enum class AiBreakerState : uint8_t {
+    CLOSED,
+    OPEN,
+    HALF_OPEN,
+};
+
+enum class AiOutcome : uint8_t {
+    SUCCESS,
+    FAILURE,          // 计入熔断器
+    NEUTRAL,          // 不影响熔断器 (仍会结束半开状态下的探测)
+};
+
+struct AiBackendHealth {
+    AiBreakerState state;
+    uint32_t consecutive_failures;
+    uint32_t cooldown_ms;                 // 当前冷却时间
+    uint32_t open_remaining_ms;           // OPEN 状态下距离半开还有多久
+    uint32_t successes;
+    uint32_t failures;
+    uint32_t rejected;                    // 熔断期间直接拒绝的请求
+    uint32_t trips;                       // 进入 OPEN 的次数
+    uint32_t probes;
+    uint32_t samples;                     // 窗口内的延迟样本数
+    uint32_t p50_ms;
+    uint32_t p95_ms;
+    uint32_t p99_ms;
+    uint32_t histogram[AI_HEALTH_HIST_BUCKETS];
+};
+
+/**
+ * @brief 请求前调用：是否放行
+ *
+ * 返回 true 后必须用 ai_health_report 报告这次请求的结果 (半开状态下它就是探测请求)。
+ */
+bool ai_health_acquire(AiModel model);
+
+/**
+ * @brief 报告请求结果
+ * @param latency_ms 成功的非流式请求的耗时，计入延迟统计；为 0 时不计入
+ */
+void ai_health_report(AiModel model, AiOutcome outcome, uint32_t latency_ms);
+
+/**
+ * @brief 只记录一个延迟样本，不影响熔断器
+ *
+ * 用于不经过 ai_health_report 计时的请求，例如对冲请求：主后端落败时真实耗时未知，
+ * 记录被中止时已经等待的时间作为下限 (截尾样本)，否则分位数只反映跑赢了的快请求，会越来越偏低。
+ */
+void ai_health_record_latency(AiModel model, uint32_t latency_ms);
+
+/**
+ * @brief 本次请求应使用的超时
+ * @param max_ms 配置的超时上限；样本不足或半开探测时直接使用
+ */
+int ai_health_timeout_ms(AiModel model, int max_ms);
+
+/**
+ * @brief 最近成功请求耗时的分位数
+ * @return 毫秒；样本少于 min_samples 时为 0
+ */
+uint32_t ai_health_latency_percentile(AiModel model, int percent, uint32_t min_samples = 1);
+
+void ai_health_get(AiModel model, AiBackendHealth* health);
+
+/**
+ * @brief 打印两个后端的熔断状态、延迟分位数和直方图
+ */
+void ai_health_log_stats(void);
@@ -0,0 +1,376 @@
+// src/module_ai/ai_hedge.cpp
+
+#include "ai_hedge.h"
+#include "ai_cache.h"
+#include "ai_health.h"
+#include "../module_wifi/wifi_manager.h"
+
+#include <algorithm>
+#include <new>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+static const char *TAG = "AI_HEDGE";
+
+// 与 ai_async 的工作任务相同：TLS 握手在请求任务的栈上进行
+#define AI_HEDGE_TASK_STACK 8192
+#define AI_HEDGE_TASK_PRIORITY 4
+// 检查对冲时机和调用方 abort 标志的周期
+#define AI_HEDGE_POLL_MS 100
+// 同时等待对冲的请求上限，超出的请求不对冲 (仍会失败转移)
+#define AI_HEDGE_MAX_ACTIVE 4
+
+typedef struct {
+    AiModel model;
+    std::atomic<bool> abort;
+    std::atomic<bool> finished;       // 置位后 result/http_ms 不再改变
+    std::string result;
+    uint32_t http_ms;                 // 流式请求返回的 HTTP 交互耗时
+} hedge_leg_t;
+
+// 调用方、备用后端的任务和正在处理它的定时器回调各持有一份引用：调用方返回后备用后端可能还在执行
+struct hedge_ctx {
+    std::atomic<int> refs;
+    std::string input;
+    const std::atomic<bool>* abort;   // 调用方的中止标志
+    int64_t hedge_at_us;
+    uint32_t delay_ms;
+    bool second_claimed;              // 定时器已决定启动备用后端，s_active_lock 保护
+    bool second_failed_to_start;      // 在 legs[1].finished 之前写入
+    SemaphoreHandle_t signal;         // 备用后端结束时 give
+    hedge_leg_t legs[2];              // [0] 主后端 (调用方任务)，[1] 备用后端
+};
+
+static AiHedgeStats s_stats = {};
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 正在执行主后端的请求，定时器回调在 s_active_lock 内读取；
+// s_track_lock 让登记/注销和定时器的启停按顺序进行
+static hedge_ctx* s_active[AI_HEDGE_MAX_ACTIVE];
+static int s_active_count = 0;
+static portMUX_TYPE s_active_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t s_track_lock = NULL;
+static esp_timer_handle_t s_tick_timer = NULL;
+
+static const char* _model_name(AiModel model) {
+    return model == AiModel::DEEPSEEK ? "DeepSeek" : "Coze";
+}
+
+static bool _is_error(const std::string& result) {
+    return result.compare(0, strlen("<错误:"), "<错误:") == 0;
+}
+
+static void _release(hedge_ctx* ctx) {
+    if (ctx->refs.fetch_sub(1) == 1) {
+        vSemaphoreDelete(ctx->signal);
+        delete ctx;
+    }
+}
+
+// 同时保持两条 TLS 连接需要的内存是否足够
+static bool _heap_allows_second_leg() {
+    if (heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) >= AI_HEDGE_MIN_FREE_BLOCK) {
+        return true;
+    }
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.skipped_low_heap++;
+    portEXIT_CRITICAL(&s_stats_lock);
+    return false;
+}
+
+// 备用后端的临时任务。用流式请求执行：中止标志在每段增量到达时检查，落败时在一段增量内就会关闭连接、
+// 释放请求体缓冲区和任务。胜出时中止主后端，回答在结束时一次交出，不需要增量回调
+static void _leg_task(void* arg) {
+    hedge_ctx* ctx = (hedge_ctx*)arg;
+    hedge_leg_t* leg = &ctx->legs[1];
+    AiStreamStats st;
+    leg->result = get_ai_answer_stream(leg->model, ctx->input, NULL, NULL, &st, &leg->abort);
+    leg->http_ms = st.http_ms;
+    if (!_is_error(leg->result)) {
+        ctx->legs[0].abort.store(true);
+    }
+    leg->finished.store(true, std::memory_order_release);
+    xSemaphoreGive(ctx->signal);
+    _release(ctx);
+    vTaskDelete(NULL);
+}
+
+// 启动备用后端；失败时直接标记为已结束，调用方改为在自己的任务中失败转移
+static void _start_second(hedge_ctx* ctx) {
+    ESP_LOGI(TAG, "%s 超过 %u ms 未回答，同时请求 %s", _model_name(ctx->legs[0].model), (unsigned)ctx->delay_ms,
+             _model_name(ctx->legs[1].model));
+    if (_heap_allows_second_leg()) {
+        ctx->refs.fetch_add(1);
+        if (xTaskCreate(_leg_task, "ai_hedge", AI_HEDGE_TASK_STACK, ctx, AI_HEDGE_TASK_PRIORITY, NULL) == pdPASS) {
+            return;
+        }
+        ESP_LOGE(TAG, "创建请求任务失败");
+        ctx->refs.fetch_sub(1);
+    }
+    ctx->second_failed_to_start = true;
+    ctx->legs[1].finished.store(true, std::memory_order_release);
+    xSemaphoreGive(ctx->signal);
+}
+
+// 在 esp_timer 任务中执行：把调用方的中止转发给两方，主后端超过对冲延迟时启动备用后端。
+// 锁内只挑出要启动的请求并加引用，创建任务在锁外进行
+static void _tick(void* arg) {
+    (void)arg;
+    hedge_ctx* due[AI_HEDGE_MAX_ACTIVE];
+    int n = 0;
+    const int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_active_lock);
+    for (hedge_ctx* ctx : s_active) {
+        if (!ctx) continue;
+        if (ctx->abort && ctx->abort->load()) {
+            ctx->legs[0].abort.store(true);
+            ctx->legs[1].abort.store(true);
+        } else if (!ctx->second_claimed && now >= ctx->hedge_at_us) {
+            ctx->second_claimed = true;
+            ctx->refs.fetch_add(1);
+            due[n++] = ctx;
+        }
+    }
+    portEXIT_CRITICAL(&s_active_lock);
+    for (int i = 0; i < n; i++) {
+        _start_second(due[i]);
+        _release(due[i]);
+    }
+}
+
+// 登记到定时器的检查列表，第一个请求启动定时器；定时器不可用或列表已满时返回 false
+static bool _track(hedge_ctx* ctx) {
+    if (!s_tick_timer) {
+        return false;
+    }
+    xSemaphoreTake(s_track_lock, portMAX_DELAY);
+    bool tracked = false;
+    portENTER_CRITICAL(&s_active_lock);
+    for (hedge_ctx*& slot : s_active) {
+        if (!slot) {
+            slot = ctx;
+            tracked = true;
+            s_active_count++;
+            break;
+        }
+    }
+    const bool first = tracked && s_active_count == 1;
+    portEXIT_CRITICAL(&s_active_lock);
+    if (first) {
+        esp_timer_start_periodic(s_tick_timer, AI_HEDGE_POLL_MS * 1000ULL);
+    }
+    xSemaphoreGive(s_track_lock);
+    return tracked;
+}
+
+// 从检查列表移除，之后定时器不会再启动备用后端。返回备用后端是否已经 (尝试) 启动
+static bool _untrack(hedge_ctx* ctx) {
+    xSemaphoreTake(s_track_lock, portMAX_DELAY);
+    portENTER_CRITICAL(&s_active_lock);
+    for (hedge_ctx*& slot : s_active) {
+        if (slot == ctx) {
+            slot = NULL;
+            s_active_count--;
+            break;
+        }
+    }
+    const bool last = s_active_count == 0;
+    const bool claimed = ctx->second_claimed;
+    portEXIT_CRITICAL(&s_active_lock);
+    if (last) {
+        // 不等待已经开始的回调：它持有所处理请求的引用
+        esp_timer_stop(s_tick_timer);
+    }
+    xSemaphoreGive(s_track_lock);
+    return claimed;
+}
+
+esp_err_t ai_hedge_init(void) {
+    if (s_tick_timer) {
+        return ESP_OK;
+    }
+    s_track_lock = xSemaphoreCreateMutex();
+    if (!s_track_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = _tick;
+    timer_args.name = "ai_hedge";
+    esp_err_t err = esp_timer_create(&timer_args, &s_tick_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "创建对冲定时器失败: %s", esp_err_to_name(err));
+        vSemaphoreDelete(s_track_lock);
+        s_track_lock = NULL;
+        s_tick_timer = NULL;
+    }
+    return err;
+}
+
+uint32_t ai_hedge_delay_ms(AiModel primary) {
+    uint32_t ms = ai_health_latency_percentile(primary, AI_HEDGE_PERCENTILE, AI_HEDGE_MIN_SAMPLES);
+    if (ms == 0) {
+        return AI_HEDGE_DEFAULT_DELAY_MS;
+    }
+    return std::max<uint32_t>(AI_HEDGE_MIN_DELAY_MS, std::min<uint32_t>(ms, AI_HEDGE_MAX_DELAY_MS));
+}
+
+std::string get_ai_answer_hedged(AiModel primary, const std::string& input_text,
+                                 const std::atomic<bool>* abort, AiModel* winner) {
+    AiModel secondary = primary == AiModel::DEEPSEEK ? AiModel::COZE : AiModel::DEEPSEEK;
+    if (winner) {
+        *winner = primary;
+    }
+
+    // 缓存命中、没有网络等立即就能返回的情况不必登记
+    std::string cached;
+    if (ai_cache_get((int)primary, input_text, &cached)) {
+        return cached;
+    }
+    if (wifi_get_status() != WIFI_STATUS_CONNECTED || input_text.empty()) {
+        return get_ai_answer(primary, input_text, abort);
+    }
+
+    hedge_ctx* ctx = new (std::nothrow) hedge_ctx();
+    if (!ctx) {
+        return get_ai_answer(primary, input_text, abort);
+    }
+    ctx->signal = xSemaphoreCreateBinary();
+    if (!ctx->signal) {
+        delete ctx;
+        return get_ai_answer(primary, input_text, abort);
+    }
+    ctx->refs.store(1);
+    ctx->input = input_text;
+    ctx->abort = abort;
+    ctx->legs[0].model = primary;
+    ctx->legs[1].model = secondary;
+    for (hedge_leg_t& leg : ctx->legs) {
+        leg.abort.store(false);
+        leg.finished.store(false);
+        leg.http_ms = 0;
+    }
+    hedge_leg_t& first = ctx->legs[0];
+    hedge_leg_t& second = ctx->legs[1];
+
+    // 1. 主后端在本任务中执行，定时器在对冲延迟到期时另起任务请求备用后端
+    int64_t start_us = esp_timer_get_time();
+    ctx->delay_ms = ai_hedge_delay_ms(primary);
+    ctx->hedge_at_us = start_us + (int64_t)ctx->delay_ms * 1000;
+    const bool tracked = _track(ctx);
+    AiStreamStats st;
+    first.result = get_ai_answer_stream(primary, input_text, NULL, NULL, &st, &first.abort);
+    first.http_ms = st.http_ms;
+    first.finished.store(true, std::memory_order_release);
+    bool second_started = tracked && _untrack(ctx);
+
+    int win = -1;
+    bool failover = false;
+    bool aborted = abort && abort->load();
+    if (!aborted && !_is_error(first.result)) {
+        win = 0;
+    }
+
+    // 2. 主后端没有给出回答 (失败或被胜出的备用后端中止)：等已经启动的备用后端
+    if (win < 0 && !aborted && second_started) {
+        while (!second.finished.load(std::memory_order_acquire)) {
+            if (abort && abort->load()) {
+                second.abort.store(true);
+            }
+            xSemaphoreTake(ctx->signal, pdMS_TO_TICKS(AI_HEDGE_POLL_MS));
+        }
+        aborted = abort && abort->load();
+        if (!aborted && !_is_error(second.result)) {
+            win = 1;
+        }
+        second_started = !ctx->second_failed_to_start;
+    }
+    const bool hedged = second_started;
+
+    // 3. 主后端失败而备用后端还没请求过：在本任务中直接请求备用后端
+    if (win < 0 && !aborted && !second_started) {
+        ESP_LOGW(TAG, "%s 失败 (%s)，改用 %s", _model_name(primary), first.result.c_str(), _model_name(secondary));
+        failover = true;
+        AiStreamStats st2;
+        second.result = get_ai_answer_stream(secondary, input_text, NULL, NULL, &st2, abort);
+        second.http_ms = st2.http_ms;
+        aborted = abort && abort->load();
+        if (!aborted && !_is_error(second.result)) {
+            win = 1;
+        }
+    }
+
+    // 主后端胜出 (或调用方中止) 时备用后端可能还在执行：中止它，它在下一段增量到达时返回，之后自行释放引用
+    uint32_t losers = 0;
+    if (hedged && win != 1 && !second.finished.load(std::memory_order_acquire)) {
+        second.abort.store(true);
+        losers++;
+    }
+    const bool primary_lost = hedged && win == 1 && first.result == AI_ERROR_ABORTED;
+    losers += primary_lost;
+
+    std::string result;
+    if (aborted) {
+        result = AI_ERROR_ABORTED;
+    } else if (win >= 0) {
+        result = ctx->legs[win].result;
+        if (winner) {
+            *winner = ctx->legs[win].model;
+        }
+        ESP_LOGI(TAG, "%s 胜出 (HTTP %u ms)%s", _model_name(ctx->legs[win].model), (unsigned)ctx->legs[win].http_ms,
+                 losers ? "，已中止另一方" : "");
+    } else {
+        // 两方都失败 (或只请求了主后端)，返回主后端的错误
+        result = first.result;
+    }
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+
+    // 对冲延迟取自主后端的延迟分位数。流式请求不计入延迟统计，这里补记主后端的 HTTP 耗时 (不含本地排队)：
+    // 胜出时是实际耗时，被备用后端抢先中止时是中止前的耗时 (真实耗时只会更长)
+    if (first.http_ms && (win == 0 || primary_lost)) {
+        ai_health_record_latency(primary, first.http_ms);
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.requests++;
+    s_stats.hedged += hedged;
+    s_stats.failovers += failover;
+    s_stats.losers_aborted += losers;
+    if (win == 0) {
+        s_stats.primary_wins++;
+    } else if (win == 1) {
+        s_stats.secondary_wins++;
+    } else if (!aborted) {
+        s_stats.both_failed++;
+    }
+    s_stats.total_ms += elapsed_ms;
+    s_stats.max_ms = std::max(s_stats.max_ms, elapsed_ms);
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    _release(ctx);
+    return result;
+}
+
+void ai_hedge_get_stats(AiHedgeStats* stats) {
+    portENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void ai_hedge_log_stats(void) {
+    AiHedgeStats st;
+    ai_hedge_get_stats(&st);
+    ESP_LOGI(TAG, "--- 对冲请求 ---");
+    ESP_LOGI(TAG, "请求 %u, 超时对冲 %u, 失败转移 %u, 内存不足未对冲 %u", (unsigned)st.requests,
+             (unsigned)st.hedged, (unsigned)st.failovers, (unsigned)st.skipped_low_heap);
+    ESP_LOGI(TAG, "主后端胜出 %u, 备用后端胜出 %u, 都失败 %u, 中止落败方 %u", (unsigned)st.primary_wins,
+             (unsigned)st.secondary_wins, (unsigned)st.both_failed, (unsigned)st.losers_aborted);
+    ESP_LOGI(TAG, "耗时: 平均 %u ms, 最大 %u ms", (unsigned)(st.requests ? st.total_ms / st.requests : 0),
+             (unsigned)st.max_ms);
+    ESP_LOGI(TAG, "当前对冲延迟: DeepSeek 主 %u ms, Coze 主 %u ms", (unsigned)ai_hedge_delay_ms(AiModel::DEEPSEEK),
+             (unsigned)ai_hedge_delay_ms(AiModel::COZE));
+}
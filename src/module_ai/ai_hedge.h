@@ -0,0 +1,77 @@
+// src/module_ai/ai_hedge.h
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include "esp_err.h"
+#include "ai_service.h"
+
+/**
+ * @brief 对冲请求：主后端迟迟没有回答时，同时向另一个后端 (DeepSeek <-> Coze) 发出同一个问题
+ *
+ * 先只请求主后端；等待时间超过主后端最近成功请求耗时的 AI_HEDGE_PERCENTILE 分位数
+ * (限制在 [AI_HEDGE_MIN_DELAY_MS, AI_HEDGE_MAX_DELAY_MS]，样本不足时用 AI_HEDGE_DEFAULT_DELAY_MS) 后
+ * 再启动备用后端；主后端提前返回错误时立即启动备用后端。先拿到有效回答的一方胜出，另一方被中止。
+ * 于是大多数请求只花一份流量，只有落在长尾上的请求才会被"对冲"。
+ *
+ * 主后端在调用方任务中以流式方式执行，大多数请求不需要额外的任务；对冲时机由一个共用的周期定时器检查，
+ * 到期时才为备用后端创建临时任务。对冲期间同时持有两条 TLS 连接，最大空闲块小于 AI_HEDGE_MIN_FREE_BLOCK 时
+ * 不对冲。主后端失败而备用后端还没启动时，直接在调用方任务中请求备用后端。
+ * 中止在对方的下一个 HTTP 事件 (流式增量或 keep-alive 注释) 时生效，所以备用后端胜出后，
+ * 调用方要等主后端的下一个事件才能返回。
+ * 主后端的 HTTP 耗时 (不含等待请求体缓冲区和连接池) 由这里记入延迟统计，落败时记录被中止前的耗时 (截尾样本)。
+ */
+
+#define AI_HEDGE_PERCENTILE       90
+#define AI_HEDGE_MIN_SAMPLES      5
+#define AI_HEDGE_DEFAULT_DELAY_MS 4000
+#define AI_HEDGE_MIN_DELAY_MS     1000
+#define AI_HEDGE_MAX_DELAY_MS     12000
+// TLS 上下文和收发缓冲区要连续的内存，看最大空闲块而不是空闲总量
+#define AI_HEDGE_MIN_FREE_BLOCK   (48 * 1024)
+
+struct AiHedgeStats {
+    uint32_t requests;
+    uint32_t hedged;              // 因为等待超时启动了备用后端
+    uint32_t failovers;           // 因为主后端出错启动了备用后端
+    uint32_t primary_wins;
+    uint32_t secondary_wins;
+    uint32_t both_failed;
+    uint32_t losers_aborted;      // 胜出时另一方仍在执行，被中止
+    uint32_t skipped_low_heap;    // 内存不足，没有启动备用后端
+    uint64_t total_ms;            // 从调用到拿到结果
+    uint32_t max_ms;
+};
+
+/**
+ * @brief 创建检查对冲时机的定时器，在 ai_service_init 中调用
+ *
+ * 创建失败时不对冲，只在主后端失败时转移到备用后端。
+ */
+esp_err_t ai_hedge_init(void);
+
+/**
+ * @brief 以对冲方式获取回答，阻塞直到有一方给出有效回答或两方都失败
+ *
+ * @param primary    主后端，备用后端是另一个
+ * @param input_text 用户问题
+ * @param abort      可选的中止标志，置 true 后两方请求都被中止并返回 AI_ERROR_ABORTED
+ * @param winner     可选，输出给出回答的后端
+ * @return 回答；两方都失败时返回主后端的错误描述 ("<错误:" 开头)
+ */
+std::string get_ai_answer_hedged(AiModel primary, const std::string& input_text,
+                                 const std::atomic<bool>* abort = nullptr, AiModel* winner = nullptr);
+
+/**
+ * @brief 当前使用的对冲延迟 (毫秒)
+ */
+uint32_t ai_hedge_delay_ms(AiModel primary);
+
+void ai_hedge_get_stats(AiHedgeStats* stats);
+
+/**
+ * @brief 打印对冲比例、两方胜出次数和耗时
+ */
+void ai_hedge_log_stats(void);
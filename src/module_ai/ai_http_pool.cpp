@@ -0,0 +1,382 @@
+// src/module_ai/ai_http_pool.cpp
+
+#include "ai_http_pool.h"
+#include "../module_wifi/wifi_manager.h"
+
+#include <algorithm>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "esp_cpu.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+static const char *TAG = "AI_HTTP_POOL";
+
+#define AI_HTTP_POOL_MAX_CONNS 4
+// 后台检查空闲连接的周期
+#define AI_HTTP_POOL_SWEEP_MS 5000
+
+typedef struct {
+    esp_http_client_handle_t client;
+    bool in_use;
+    bool connected;               // 上一次请求成功后连接保持打开
+    bool expired;                 // 后台定时器标记的空闲超时连接，由请求任务顺路关闭
+    uint32_t epoch;               // 建立连接时的 WiFi 连接代数
+    int64_t last_used_us;
+    // 当前请求的事件回调，由 _slot_event_handler 转发
+    http_event_handle_cb handler;
+    void* user_data;
+    size_t bytes_received;
+    // 握手计时：本次请求开始的时间和 CCOUNT，建立新连接 (HTTP_EVENT_ON_CONNECTED) 时记录差值。
+    // CCOUNT 每个核各一个，请求任务在握手中途换了核时周期数无效
+    bool has_session;             // 客户端里已经保存了会话票据，下次建连会尝试恢复
+    bool handshake_done;
+    bool handshake_cycles_valid;
+    int attempt_core;
+    int64_t attempt_start_us;
+    uint32_t attempt_start_cycles;
+    uint32_t handshake_us;
+    uint32_t handshake_cycles;
+} pool_slot_t;
+
+struct ai_http_pool {
+    ai_http_pool_config_t config;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t available;  // 计数信号量，空闲槽位数
+    esp_timer_handle_t sweep_timer;
+    pool_slot_t slots[AI_HTTP_POOL_MAX_CONNS];
+    ai_http_pool_stats_t stats;
+};
+
+// esp_http_client 的事件回调在 init 时固定，这里转发给当前请求的回调并替换 user_data
+static esp_err_t _slot_event_handler(esp_http_client_event_t *evt) {
+    pool_slot_t* slot = static_cast<pool_slot_t*>(evt->user_data);
+    if (evt->event_id == HTTP_EVENT_ON_DATA) {
+        slot->bytes_received += evt->data_len;
+    } else if (evt->event_id == HTTP_EVENT_ON_CONNECTED) {
+        // DNS + TCP + TLS 握手完成；握手在调用任务里同步进行，同 audio_perf 一样用 CCOUNT 计周期。
+        // 32 位计数器在 240MHz 下约 17 秒回绕，更长的握手只记时间
+        slot->handshake_done = true;
+        slot->handshake_us = (uint32_t)(esp_timer_get_time() - slot->attempt_start_us);
+        slot->handshake_cycles = (uint32_t)esp_cpu_get_cycle_count() - slot->attempt_start_cycles;
+        slot->handshake_cycles_valid = xPortGetCoreID() == slot->attempt_core &&
+                                       (uint64_t)slot->handshake_us * esp_rom_get_cpu_ticks_per_us() < UINT32_MAX;
+    }
+    if (!slot->handler) {
+        return ESP_OK;
+    }
+    evt->user_data = slot->user_data;
+    esp_err_t ret = slot->handler(evt);
+    evt->user_data = slot;
+    return ret;
+}
+
+static bool _slot_expired(const ai_http_pool* pool, const pool_slot_t* slot, int64_t now_us) {
+    return now_us - slot->last_used_us > (int64_t)pool->config.idle_timeout_ms * 1000;
+}
+
+// 占住空闲的连接以便在锁外关闭：同时拿走一个可用计数并标记 in_use，请求任务不会再选中它们。
+// 调用时持有 pool->lock，返回占住的个数
+static int _claim_idle(ai_http_pool* pool, bool expired_only, pool_slot_t** out) {
+    int n = 0;
+    for (int i = 0; i < pool->config.max_conns; i++) {
+        pool_slot_t* slot = &pool->slots[i];
+        if (slot->in_use || !slot->connected || (expired_only && !slot->expired)) {
+            continue;
+        }
+        if (xSemaphoreTake(pool->available, 0) != pdTRUE) {
+            break;
+        }
+        slot->in_use = true;
+        out[n++] = slot;
+    }
+    return n;
+}
+
+// 在锁外关闭占住的连接 (发送 close_notify、释放 TLS 内存)，再归还槽位
+static void _close_claimed(ai_http_pool* pool, pool_slot_t** slots, int n, bool idle_timeout) {
+    for (int i = 0; i < n; i++) {
+        esp_http_client_close(slots[i]->client);
+    }
+    // 锁只在更新槽位和统计时短暂持有，从不跨越网络操作，这里的等待很短
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    for (int i = 0; i < n; i++) {
+        slots[i]->connected = false;
+        slots[i]->expired = false;
+        slots[i]->in_use = false;
+    }
+    if (idle_timeout) {
+        pool->stats.idle_closes += n;
+    }
+    xSemaphoreGive(pool->lock);
+    for (int i = 0; i < n; i++) {
+        xSemaphoreGive(pool->available);
+    }
+}
+
+// 在 esp_timer 任务中执行，只做标记：关闭 TLS 连接要在阻塞 socket 上发送 close_notify (最长等 timeout_ms)，
+// 不能放在栈很小、所有定时器共用的 esp_timer 任务里。锁正被请求任务占用时跳过这一轮，下一轮再检查
+static void _sweep_idle(void* arg) {
+    ai_http_pool* pool = static_cast<ai_http_pool*>(arg);
+    if (xSemaphoreTake(pool->lock, 0) != pdTRUE) {
+        return;
+    }
+    const int64_t now = esp_timer_get_time();
+    for (int i = 0; i < pool->config.max_conns; i++) {
+        pool_slot_t* slot = &pool->slots[i];
+        if (!slot->in_use && slot->connected && _slot_expired(pool, slot, now)) {
+            slot->expired = true;
+        }
+    }
+    xSemaphoreGive(pool->lock);
+}
+
+// 在请求任务里关闭定时器标记过的空闲连接
+static void _close_expired(ai_http_pool* pool) {
+    pool_slot_t* slots[AI_HTTP_POOL_MAX_CONNS];
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    int n = _claim_idle(pool, true, slots);
+    xSemaphoreGive(pool->lock);
+    if (n) {
+        _close_claimed(pool, slots, n, true);
+        ESP_LOGD(TAG, "%s: 关闭 %d 个空闲连接", pool->config.name, n);
+    }
+}
+
+ai_http_pool_handle_t ai_http_pool_create(const ai_http_pool_config_t* config) {
+    if (!config || !config->url || config->max_conns <= 0) {
+        return NULL;
+    }
+    ai_http_pool* pool = static_cast<ai_http_pool*>(calloc(1, sizeof(ai_http_pool)));
+    if (!pool) {
+        return NULL;
+    }
+    pool->config = *config;
+    pool->config.max_conns = std::min(config->max_conns, AI_HTTP_POOL_MAX_CONNS);
+    pool->lock = xSemaphoreCreateMutex();
+    pool->available = xSemaphoreCreateCounting(pool->config.max_conns, pool->config.max_conns);
+
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = _sweep_idle;
+    timer_args.arg = pool;
+    timer_args.name = "ai_pool_sweep";
+    if (!pool->lock || !pool->available || esp_timer_create(&timer_args, &pool->sweep_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "%s: 创建连接池失败", config->name);
+        if (pool->lock) vSemaphoreDelete(pool->lock);
+        if (pool->available) vSemaphoreDelete(pool->available);
+        free(pool);
+        return NULL;
+    }
+    esp_timer_start_periodic(pool->sweep_timer, AI_HTTP_POOL_SWEEP_MS * 1000ULL);
+    ESP_LOGI(TAG, "%s: 连接池已创建, 最多 %d 个连接, 空闲 %u ms 后关闭",
+             pool->config.name, pool->config.max_conns, (unsigned)pool->config.idle_timeout_ms);
+    return pool;
+}
+
+// 取一个空闲槽位，优先选择连接仍然可用的
+static pool_slot_t* _acquire_slot(ai_http_pool* pool, uint32_t epoch, int64_t now) {
+    pool_slot_t* best = NULL;
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    for (int i = 0; i < pool->config.max_conns; i++) {
+        pool_slot_t* slot = &pool->slots[i];
+        if (slot->in_use) continue;
+        bool warm = slot->connected && !slot->expired && slot->epoch == epoch && !_slot_expired(pool, slot, now);
+        if (!best || warm) {
+            best = slot;
+            if (warm) break;
+        }
+    }
+    if (best) {
+        best->in_use = true;
+    }
+    xSemaphoreGive(pool->lock);
+    return best;
+}
+
+static esp_err_t _perform_once(ai_http_pool* pool, pool_slot_t* slot,
+                               ai_http_prepare_cb_t prepare, void* prepare_arg) {
+    slot->bytes_received = 0;
+    slot->handshake_done = false;
+    if (prepare) {
+        prepare(slot->client, prepare_arg);
+    }
+    const bool resumable = slot->has_session;
+    slot->attempt_core = xPortGetCoreID();
+    slot->attempt_start_cycles = (uint32_t)esp_cpu_get_cycle_count();
+    slot->attempt_start_us = esp_timer_get_time();
+    esp_err_t err = esp_http_client_perform(slot->client);
+    if (!slot->handshake_done) {
+        return err;
+    }
+
+    // 有票据时是否真的恢复成功取决于服务器，被拒绝时会退回完整握手，耗时会体现在"恢复"一栏里
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    slot->has_session = true;
+#endif
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    ai_http_pool_handshake_stats_t* hs = resumable ? &pool->stats.resumed : &pool->stats.full;
+    hs->count++;
+    hs->total_ms += slot->handshake_us / 1000;
+    hs->max_ms = std::max(hs->max_ms, slot->handshake_us / 1000);
+    if (slot->handshake_cycles_valid) {
+        hs->total_cycles += slot->handshake_cycles;
+        hs->cycle_samples++;
+    }
+    xSemaphoreGive(pool->lock);
+    ESP_LOGI(TAG, "%s: %s握手 %u ms, %.1f M 周期", pool->config.name, resumable ? "恢复会话" : "完整",
+             (unsigned)(slot->handshake_us / 1000),
+             slot->handshake_cycles_valid ? slot->handshake_cycles / 1e6 : 0.0);
+    return err;
+}
+
+esp_err_t ai_http_pool_perform(ai_http_pool_handle_t pool,
+                               http_event_handle_cb event_handler, void* user_data,
+                               ai_http_prepare_cb_t prepare, void* prepare_arg,
+                               int* status_code, uint32_t wait_ms,
+                               const std::atomic<bool>* abort, uint32_t* elapsed_out) {
+    if (elapsed_out) {
+        *elapsed_out = 0;
+    }
+    if (!pool) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (xSemaphoreTake(pool->available, pdMS_TO_TICKS(wait_ms)) != pdTRUE) {
+        ESP_LOGW(TAG, "%s: 连接池繁忙", pool->config.name);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    const uint32_t epoch = wifi_get_connection_epoch();
+    int64_t start = esp_timer_get_time();
+    pool_slot_t* slot = _acquire_slot(pool, epoch, start);
+    bool epoch_reset = false;
+
+    // 1. 检查连接是否还能用：断过网的和空闲太久的关闭后重连
+    //    只关闭 socket 不销毁客户端，客户端里保存的 TLS 会话票据留着给下一次握手用
+    if (slot->connected && slot->epoch != epoch) {
+        esp_http_client_close(slot->client);
+        slot->connected = false;
+        epoch_reset = true;
+    } else if (slot->connected && (slot->expired || _slot_expired(pool, slot, start))) {
+        esp_http_client_close(slot->client);
+        slot->connected = false;
+    }
+    slot->expired = false;
+    if (!slot->client) {
+        esp_http_client_config_t config = {};
+        config.url = pool->config.url;
+        config.cert_pem = pool->config.cert_pem;
+        config.timeout_ms = pool->config.timeout_ms;
+        config.event_handler = _slot_event_handler;
+        config.user_data = slot;
+        config.keep_alive_enable = true;
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        config.save_client_session = true;
+#endif
+        slot->client = esp_http_client_init(&config);
+    }
+    if (!slot->client) {
+        xSemaphoreTake(pool->lock, portMAX_DELAY);
+        slot->in_use = false;
+        xSemaphoreGive(pool->lock);
+        xSemaphoreGive(pool->available);
+        ESP_LOGE(TAG, "%s: 创建 HTTP 客户端失败", pool->config.name);
+        return ESP_ERR_NO_MEM;
+    }
+    slot->handler = event_handler;
+    slot->user_data = user_data;
+
+    // 2. 执行请求；复用的连接可能已被对端关闭，还没收到数据时在新连接上重试一次。
+    //    在响应头阶段被调用方中止的请求同样没有数据，不能重试
+    bool reused = slot->connected;
+    bool retried = false;
+    esp_err_t err = _perform_once(pool, slot, prepare, prepare_arg);
+    if (err != ESP_OK && reused && slot->bytes_received == 0 && !(abort && abort->load())) {
+        ESP_LOGW(TAG, "%s: 复用的连接已失效 (%s)，重新连接", pool->config.name, esp_err_to_name(err));
+        esp_http_client_close(slot->client);
+        reused = false;
+        retried = true;
+        err = _perform_once(pool, slot, prepare, prepare_arg);
+    }
+    *status_code = err == ESP_OK ? esp_http_client_get_status_code(slot->client) : 0;
+    if (err != ESP_OK) {
+        esp_http_client_close(slot->client);
+    }
+    if (!reused) {
+        slot->epoch = epoch;
+    }
+    slot->connected = err == ESP_OK;
+    slot->handler = NULL;
+    slot->user_data = NULL;
+
+    // 3. 统计并归还槽位
+    int64_t end = esp_timer_get_time();
+    uint32_t elapsed_ms = (uint32_t)((end - start) / 1000);
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    ai_http_pool_stats_t* st = &pool->stats;
+    if (err == ESP_OK) {
+        if (reused) {
+            st->warm_requests++;
+            st->warm_total_ms += elapsed_ms;
+            st->warm_max_ms = std::max(st->warm_max_ms, elapsed_ms);
+        } else {
+            st->cold_requests++;
+            st->cold_total_ms += elapsed_ms;
+            st->cold_max_ms = std::max(st->cold_max_ms, elapsed_ms);
+        }
+    }
+    st->stale_retries += retried ? 1 : 0;
+    st->epoch_resets += epoch_reset ? 1 : 0;
+    slot->last_used_us = end;
+    slot->in_use = false;
+    xSemaphoreGive(pool->lock);
+    xSemaphoreGive(pool->available);
+
+    ESP_LOGI(TAG, "%s: %s 请求 %u ms, 状态码 %d", pool->config.name, reused ? "热" : "冷",
+             (unsigned)elapsed_ms, *status_code);
+    if (elapsed_out) {
+        *elapsed_out = elapsed_ms;
+    }
+    // 响应已经交给调用方，顺路关闭其他槽位上已过期的空闲连接
+    _close_expired(pool);
+    return err;
+}
+
+void ai_http_pool_get_stats(ai_http_pool_handle_t pool, ai_http_pool_stats_t* stats) {
+    if (!pool || !stats) return;
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    *stats = pool->stats;
+    xSemaphoreGive(pool->lock);
+}
+
+void ai_http_pool_log_stats(ai_http_pool_handle_t pool) {
+    ai_http_pool_stats_t st;
+    ai_http_pool_get_stats(pool, &st);
+    if (!pool) return;
+    ESP_LOGI(TAG, "--- %s 连接池延迟 ---", pool->config.name);
+    ESP_LOGI(TAG, "冷请求: %u 次, 平均 %u ms, 最大 %u ms", (unsigned)st.cold_requests,
+             (unsigned)(st.cold_requests ? st.cold_total_ms / st.cold_requests : 0), (unsigned)st.cold_max_ms);
+    ESP_LOGI(TAG, "热请求: %u 次, 平均 %u ms, 最大 %u ms", (unsigned)st.warm_requests,
+             (unsigned)(st.warm_requests ? st.warm_total_ms / st.warm_requests : 0), (unsigned)st.warm_max_ms);
+    ESP_LOGI(TAG, "失效重试 %u 次, 断网重建 %u 次, 空闲关闭 %u 次", (unsigned)st.stale_retries,
+             (unsigned)st.epoch_resets, (unsigned)st.idle_closes);
+    const ai_http_pool_handshake_stats_t* kinds[2] = {&st.full, &st.resumed};
+    for (int i = 0; i < 2; i++) {
+        const ai_http_pool_handshake_stats_t* hs = kinds[i];
+        ESP_LOGI(TAG, "%s握手: %u 次, 平均 %u ms, 最大 %u ms, 平均 %.1f M 周期", i ? "恢复会话" : "完整",
+                 (unsigned)hs->count, (unsigned)(hs->count ? hs->total_ms / hs->count : 0), (unsigned)hs->max_ms,
+                 hs->cycle_samples ? (double)hs->total_cycles / hs->cycle_samples / 1e6 : 0.0);
+    }
+}
+
+void ai_http_pool_close_idle(ai_http_pool_handle_t pool) {
+    if (!pool) return;
+    pool_slot_t* slots[AI_HTTP_POOL_MAX_CONNS];
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    int n = _claim_idle(pool, false, slots);
+    xSemaphoreGive(pool->lock);
+    _close_claimed(pool, slots, n, false);
+}
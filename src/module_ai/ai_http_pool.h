@@ -0,0 +1,104 @@
+// src/module_ai/ai_http_pool.h
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "esp_http_client.h"
+
+/**
+ * @brief 每个 AI 后端一个的 HTTPS 长连接池
+ *
+ * 每次问答都新建 esp_http_client 需要重新做 DNS、TCP 和完整的 TLS 握手，在 ESP32-S3 上要数秒。
+ * 连接池为每个后端保留少量已经握手完成的客户端，请求结束后放回池中，下一次直接复用 (HTTP keep-alive)：
+ *   - 健康检查：空闲超过 idle_timeout_ms 的连接不再复用 (服务器和 NAT 可能已经悄悄丢弃它，
+ *     复用会一直等到超时)。后台定时器只做标记，标记过的连接在下一次请求结束后由请求任务关闭，
+ *     释放 TLS 占用的内部 RAM (关闭要发送 close_notify，可能阻塞，不放在 esp_timer 任务里)；
+ *     复用的连接上请求失败且还没收到任何数据时，关闭后在新连接上重试一次 (调用方中止的请求除外)；
+ *   - WiFi 重连后 (wifi_get_connection_epoch 变化) 旧连接一律关闭重建，对调用方透明。
+ * 开启 CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS 时客户端保存服务器下发的会话票据，连接关闭后客户端本身保留，
+ * 重新建连时用票据恢复会话，省掉证书链校验和 ECDHE 计算。每个后端一个池，票据也就按主机缓存在 RAM 里。
+ * 每个 TLS 连接约占 40KB 内部 RAM，没有 PSRAM 时 max_conns 保持 1。
+ */
+
+typedef struct {
+    const char* name;             // 日志和统计中使用的后端名
+    const char* url;
+    const char* cert_pem;
+    int timeout_ms;
+    int max_conns;                // 池中最多的客户端数，也是该后端的最大并发请求数
+    uint32_t idle_timeout_ms;     // 空闲多久后不再复用并关闭，应小于服务器的 keep-alive 超时
+} ai_http_pool_config_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_ms;
+    uint64_t total_ms;            // 从请求开始到连接建立 (DNS + TCP + TLS)
+    uint64_t total_cycles;        // 握手期间所在核的时钟周期 (CCOUNT)，包括等待网络和被其他任务抢占的时间
+    uint32_t cycle_samples;       // 计入 total_cycles 的次数，握手中途换核或超过计数器周期的不计
+} ai_http_pool_handshake_stats_t;
+
+typedef struct {
+    uint32_t cold_requests;       // 需要新建连接 (DNS + TCP + TLS) 的请求
+    uint32_t warm_requests;       // 复用已有连接的请求
+    uint64_t cold_total_ms;
+    uint64_t warm_total_ms;
+    uint32_t cold_max_ms;
+    uint32_t warm_max_ms;
+    uint32_t stale_retries;       // 复用的连接已被对端关闭，在新连接上重试
+    uint32_t epoch_resets;        // WiFi 重连后丢弃的连接
+    uint32_t idle_closes;         // 空闲超时关闭的连接
+    ai_http_pool_handshake_stats_t full;     // 没有会话票据的完整握手
+    ai_http_pool_handshake_stats_t resumed;  // 带票据的握手 (服务器拒绝时实际是完整握手)
+} ai_http_pool_stats_t;
+
+typedef struct ai_http_pool* ai_http_pool_handle_t;
+
+/**
+ * @brief 一次请求的回调，在取出的客户端上设置请求方法、头和请求体
+ *
+ * 连接池在需要重试时会再次调用它，因此必须可以重复执行。
+ */
+typedef void (*ai_http_prepare_cb_t)(esp_http_client_handle_t client, void* arg);
+
+/**
+ * @brief 创建连接池，此时不建立任何连接
+ * @return 失败返回 NULL
+ */
+ai_http_pool_handle_t ai_http_pool_create(const ai_http_pool_config_t* config);
+
+/**
+ * @brief 在池中的连接上执行一次请求
+ *
+ * @param pool        连接池
+ * @param event_handler HTTP 事件回调 (接收响应数据)，user_data 为回调参数
+ * @param user_data   传给 event_handler 的参数
+ * @param prepare     设置请求的回调，见 ai_http_prepare_cb_t
+ * @param prepare_arg 传给 prepare 的参数
+ * @param status_code 输出 HTTP 状态码
+ * @param wait_ms     池中连接全部被占用时最多等待多久
+ * @param abort       可选，调用方的中止标志。event_handler 中止请求 (esp_http_client_cancel_request) 后
+ *                    连接上同样没有收到数据，置位时不当作失效连接重试
+ * @param elapsed_ms  可选，输出取得连接之后的耗时 (含建连和重试，不含在池外排队的时间)
+ * @return esp_http_client_perform 的结果；池繁忙时返回 ESP_ERR_TIMEOUT
+ */
+esp_err_t ai_http_pool_perform(ai_http_pool_handle_t pool,
+                               http_event_handle_cb event_handler, void* user_data,
+                               ai_http_prepare_cb_t prepare, void* prepare_arg,
+                               int* status_code, uint32_t wait_ms,
+                               const std::atomic<bool>* abort = nullptr, uint32_t* elapsed_ms = nullptr);
+
+/**
+ * @brief 获取统计信息的拷贝
+ */
+void ai_http_pool_get_stats(ai_http_pool_handle_t pool, ai_http_pool_stats_t* stats);
+
+/**
+ * @brief 打印冷/热请求的延迟对比，以及完整握手和会话恢复的耗时、CPU 周期对比
+ */
+void ai_http_pool_log_stats(ai_http_pool_handle_t pool);
+
+/**
+ * @brief 关闭池中所有空闲连接 (例如即将进入低功耗)
+ */
+void ai_http_pool_close_idle(ai_http_pool_handle_t pool);
@@ -0,0 +1,432 @@
+// src/module_ai/ai_json_stream.cpp
+
+#include "ai_json_stream.h"
+
+#include <string.h>
+
+enum {
+    S_VALUE,            // 期待一个值
+    S_VALUE_OR_CLOSE,   // '[' 之后：值或 ']'
+    S_KEY_OR_CLOSE,     // '{' 之后：键或 '}'
+    S_KEY,              // ',' 之后：键
+    S_COLON,
+    S_AFTER,            // 值之后：',' 或右括号
+    S_STRING,
+    S_ESCAPE,
+    S_UNICODE,
+    S_LITERAL,          // 数字 / true / false / null
+    S_DONE,
+    S_ERROR,
+};
+
+void ai_json_stream_init(ai_json_stream_t* parser, const char* const* selectors, int selector_count,
+                         const ai_json_callbacks_t* callbacks, void* arg) {
+    memset(parser, 0, sizeof(*parser));
+    parser->selectors = selectors;
+    parser->selector_count = selector_count < AI_JSON_MAX_SELECTORS ? selector_count : AI_JSON_MAX_SELECTORS;
+    if (callbacks) {
+        parser->callbacks = *callbacks;
+    }
+    parser->arg = arg;
+    parser->state = S_VALUE;
+    parser->match = -1;
+}
+
+bool ai_json_stream_failed(const ai_json_stream_t* parser) {
+    return parser->state == S_ERROR;
+}
+
+static bool _is_ws(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// 当前路径 (栈中各层的键/下标) 是否与选择器一致
+static bool _path_matches(const ai_json_stream_t* p, const char* sel) {
+    for (int i = 0; i < p->depth; i++) {
+        const ai_json_frame_t* f = &p->stack[i];
+        if (f->type == '{') {
+            if (i > 0) {
+                if (*sel != '.') return false;
+                sel++;
+            }
+            const char* end = sel;
+            while (*end && *end != '.' && *end != '[') end++;
+            size_t n = end - sel;
+            if (f->key_too_long || strlen(f->key) != n || memcmp(f->key, sel, n) != 0) return false;
+            sel = end;
+        } else {
+            if (*sel != '[') return false;
+            sel++;
+            if (*sel == '*') {
+                sel++;
+            } else {
+                int32_t n = 0;
+                if (*sel < '0' || *sel > '9') return false;
+                while (*sel >= '0' && *sel <= '9') n = n * 10 + (*sel++ - '0');
+                if (n != f->index) return false;
+            }
+            if (*sel != ']') return false;
+            sel++;
+        }
+    }
+    return *sel == '\0';
+}
+
+static void _begin_value(ai_json_stream_t* p, ai_json_type_t type) {
+    p->match = -1;
+    for (int i = 0; i < p->selector_count; i++) {
+        if (_path_matches(p, p->selectors[i])) {
+            p->match = i;
+            break;
+        }
+    }
+    if (p->match >= 0 && p->callbacks.on_value) {
+        p->callbacks.on_value(p->match, type, p->arg);
+    }
+}
+
+static void _end_value(ai_json_stream_t* p) {
+    p->match = -1;
+    p->state = p->depth == 0 ? S_DONE : S_AFTER;
+}
+
+static bool _push(ai_json_stream_t* p, char type) {
+    if (p->depth >= AI_JSON_MAX_DEPTH) {
+        p->state = S_ERROR;
+        return false;
+    }
+    ai_json_frame_t* f = &p->stack[p->depth++];
+    f->type = type;
+    f->index = 0;
+    f->key[0] = '\0';
+    f->key_too_long = false;
+    p->state = type == '{' ? S_KEY_OR_CLOSE : S_VALUE_OR_CLOSE;
+    return true;
+}
+
+static void _flush(ai_json_stream_t* p, bool done) {
+    if (p->match >= 0 && p->callbacks.on_string && (p->chunk_len > 0 || done)) {
+        p->callbacks.on_string(p->match, p->chunk, p->chunk_len, done, p->arg);
+    }
+    p->chunk_len = 0;
+}
+
+// 字符串中的一段已解码内容：键写入栈顶，匹配的值攒成块交出，其余丢弃
+static void _put(ai_json_stream_t* p, const char* data, size_t n) {
+    if (p->in_key) {
+        ai_json_frame_t* f = &p->stack[p->depth - 1];
+        if (p->key_len + n >= AI_JSON_MAX_KEY) {
+            f->key_too_long = true;
+            return;
+        }
+        memcpy(f->key + p->key_len, data, n);
+        p->key_len += n;
+        f->key[p->key_len] = '\0';
+        return;
+    }
+    if (p->match < 0) {
+        return;
+    }
+    memcpy(p->chunk + p->chunk_len, data, n);
+    p->chunk_len += n;
+    if (p->chunk_len >= AI_JSON_CHUNK) {
+        _flush(p, false);
+    }
+}
+
+static void _put_codepoint(ai_json_stream_t* p, uint32_t cp) {
+    char buf[4];
+    size_t n;
+    if (cp < 0x80) {
+        buf[0] = (char)cp;
+        n = 1;
+    } else if (cp < 0x800) {
+        buf[0] = (char)(0xC0 | (cp >> 6));
+        buf[1] = (char)(0x80 | (cp & 0x3F));
+        n = 2;
+    } else if (cp < 0x10000) {
+        buf[0] = (char)(0xE0 | (cp >> 12));
+        buf[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        buf[2] = (char)(0x80 | (cp & 0x3F));
+        n = 3;
+    } else {
+        buf[0] = (char)(0xF0 | (cp >> 18));
+        buf[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        buf[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        buf[3] = (char)(0x80 | (cp & 0x3F));
+        n = 4;
+    }
+    _put(p, buf, n);
+}
+
+// 没有配对的代理项替换成 U+FFFD
+static void _drop_surrogate(ai_json_stream_t* p) {
+    if (p->high_surrogate) {
+        p->high_surrogate = 0;
+        _put_codepoint(p, 0xFFFD);
+    }
+}
+
+static void _on_code_unit(ai_json_stream_t* p, uint32_t cu) {
+    if (cu >= 0xDC00 && cu <= 0xDFFF) {
+        if (p->high_surrogate) {
+            uint32_t cp = 0x10000 + ((p->high_surrogate - 0xD800) << 10) + (cu - 0xDC00);
+            p->high_surrogate = 0;
+            _put_codepoint(p, cp);
+        } else {
+            _put_codepoint(p, 0xFFFD);
+        }
+        return;
+    }
+    _drop_surrogate(p);
+    if (cu >= 0xD800 && cu <= 0xDBFF) {
+        p->high_surrogate = cu;
+    } else {
+        _put_codepoint(p, cu);
+    }
+}
+
+static void _end_string(ai_json_stream_t* p) {
+    _drop_surrogate(p);
+    if (p->in_key) {
+        p->in_key = false;
+        p->state = S_COLON;
+        return;
+    }
+    _flush(p, true);
+    _end_value(p);
+}
+
+static void _end_literal(ai_json_stream_t* p) {
+    const char* s = p->chunk;
+    size_t n = p->chunk_len;
+    bool ok;
+    if (s[0] == 't') {
+        ok = n == 4 && memcmp(s, "true", 4) == 0;
+    } else if (s[0] == 'f') {
+        ok = n == 5 && memcmp(s, "false", 5) == 0;
+    } else if (s[0] == 'n') {
+        ok = n == 4 && memcmp(s, "null", 4) == 0;
+    } else {
+        // 数字只做粗略检查：以数字或负号开头，且至少含一个数字
+        ok = false;
+        for (size_t i = 0; i < n; i++) {
+            if (s[i] >= '0' && s[i] <= '9') ok = true;
+        }
+    }
+    if (!ok) {
+        p->state = S_ERROR;
+        return;
+    }
+    _flush(p, true);
+    _end_value(p);
+}
+
+static void _step(ai_json_stream_t* p, char c);
+
+static void _begin_any_value(ai_json_stream_t* p, char c) {
+    switch (c) {
+    case '{':
+        _begin_value(p, AI_JSON_OBJECT);
+        p->match = -1;
+        _push(p, '{');
+        break;
+    case '[':
+        _begin_value(p, AI_JSON_ARRAY);
+        p->match = -1;
+        _push(p, '[');
+        break;
+    case '"':
+        _begin_value(p, AI_JSON_STRING);
+        p->in_key = false;
+        p->chunk_len = 0;
+        p->state = S_STRING;
+        break;
+    case 't': case 'f': case 'n': case '-':
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+        _begin_value(p, c == 't' || c == 'f' ? AI_JSON_BOOL : c == 'n' ? AI_JSON_NULL : AI_JSON_NUMBER);
+        p->chunk[0] = c;
+        p->chunk_len = 1;
+        p->state = S_LITERAL;
+        break;
+    default:
+        p->state = S_ERROR;
+        break;
+    }
+}
+
+static void _close(ai_json_stream_t* p, char c) {
+    char open = c == '}' ? '{' : '[';
+    if (p->depth == 0 || p->stack[p->depth - 1].type != open) {
+        p->state = S_ERROR;
+        return;
+    }
+    p->depth--;
+    _end_value(p);
+}
+
+static void _begin_key(ai_json_stream_t* p) {
+    ai_json_frame_t* f = &p->stack[p->depth - 1];
+    f->key[0] = '\0';
+    f->key_too_long = false;
+    p->key_len = 0;
+    p->in_key = true;
+    p->state = S_STRING;
+}
+
+static int _hex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// 处理一个字节 (字符串内的普通字节由 ai_json_stream_feed 成段处理)
+static void _step(ai_json_stream_t* p, char c) {
+    switch (p->state) {
+    case S_VALUE:
+        if (!_is_ws(c)) _begin_any_value(p, c);
+        break;
+    case S_VALUE_OR_CLOSE:
+        if (c == ']') _close(p, c);
+        else if (!_is_ws(c)) _begin_any_value(p, c);
+        break;
+    case S_KEY_OR_CLOSE:
+        if (c == '}') _close(p, c);
+        else if (c == '"') _begin_key(p);
+        else if (!_is_ws(c)) p->state = S_ERROR;
+        break;
+    case S_KEY:
+        if (c == '"') _begin_key(p);
+        else if (!_is_ws(c)) p->state = S_ERROR;
+        break;
+    case S_COLON:
+        if (c == ':') p->state = S_VALUE;
+        else if (!_is_ws(c)) p->state = S_ERROR;
+        break;
+    case S_AFTER:
+        if (c == ',') {
+            ai_json_frame_t* f = &p->stack[p->depth - 1];
+            if (f->type == '{') {
+                p->state = S_KEY;
+            } else {
+                f->index++;
+                p->state = S_VALUE;
+            }
+        } else if (c == '}' || c == ']') {
+            _close(p, c);
+        } else if (!_is_ws(c)) {
+            p->state = S_ERROR;
+        }
+        break;
+    case S_STRING:
+        if (c == '"') {
+            _end_string(p);
+        } else if (c == '\\') {
+            p->state = S_ESCAPE;
+        } else if ((unsigned char)c < 0x20) {
+            p->state = S_ERROR;
+        } else {
+            _drop_surrogate(p);
+            _put(p, &c, 1);
+        }
+        break;
+    case S_ESCAPE: {
+        char out;
+        switch (c) {
+        case '"': out = '"'; break;
+        case '\\': out = '\\'; break;
+        case '/': out = '/'; break;
+        case 'b': out = '\b'; break;
+        case 'f': out = '\f'; break;
+        case 'n': out = '\n'; break;
+        case 'r': out = '\r'; break;
+        case 't': out = '\t'; break;
+        case 'u':
+            p->code_unit = 0;
+            p->hex_left = 4;
+            p->state = S_UNICODE;
+            return;
+        default:
+            p->state = S_ERROR;
+            return;
+        }
+        _drop_surrogate(p);
+        _put(p, &out, 1);
+        p->state = S_STRING;
+        break;
+    }
+    case S_UNICODE: {
+        int v = _hex(c);
+        if (v < 0) {
+            p->state = S_ERROR;
+            break;
+        }
+        p->code_unit = (p->code_unit << 4) | (uint32_t)v;
+        if (--p->hex_left == 0) {
+            p->state = S_STRING;
+            _on_code_unit(p, p->code_unit);
+        }
+        break;
+    }
+    case S_LITERAL:
+        if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '.' || c == '+' || c == '-' || c == 'E') {
+            if (p->chunk_len >= AI_JSON_CHUNK) {
+                p->state = S_ERROR;
+            } else {
+                p->chunk[p->chunk_len++] = c;
+            }
+        } else {
+            _end_literal(p);
+            if (p->state != S_ERROR) {
+                _step(p, c);  // 分隔符属于后面的状态
+            }
+        }
+        break;
+    case S_DONE:
+        if (!_is_ws(c)) p->state = S_ERROR;
+        break;
+    default:
+        break;
+    }
+}
+
+bool ai_json_stream_feed(ai_json_stream_t* parser, const char* data, size_t len) {
+    ai_json_stream_t* p = parser;
+    size_t i = 0;
+    while (i < len && p->state != S_ERROR) {
+        // 字符串内的普通字节成段处理：匹配的值直接把输入片段交给回调，不经过 chunk
+        if (p->state == S_STRING && !p->high_surrogate) {
+            size_t j = i;
+            while (j < len && data[j] != '"' && data[j] != '\\' && (unsigned char)data[j] >= 0x20) j++;
+            if (j > i) {
+                if (!p->in_key && p->match >= 0) {
+                    _flush(p, false);
+                    if (p->callbacks.on_string) {
+                        p->callbacks.on_string(p->match, data + i, j - i, false, p->arg);
+                    }
+                } else {
+                    _put(p, data + i, j - i);
+                }
+                i = j;
+                continue;
+            }
+        }
+        _step(p, data[i]);
+        i++;
+    }
+    p->offset += i;
+    // 分片结束时把攒下的内容交出去，流式场景下不拖到下一片
+    if (p->state == S_STRING || p->state == S_ESCAPE || p->state == S_UNICODE) {
+        if (!p->in_key) _flush(p, false);
+    }
+    return p->state != S_ERROR;
+}
+
+bool ai_json_stream_finish(ai_json_stream_t* parser) {
+    if (parser->state == S_LITERAL && parser->depth == 0) {
+        _end_literal(parser);
+    }
+    return parser->state == S_DONE;
+}
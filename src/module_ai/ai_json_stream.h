@@ -0,0 +1,98 @@
+// src/module_ai/ai_json_stream.h
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief 增量 (SAX 式) JSON 解析器，按路径选择器只取出需要的字段
+ *
+ * 响应体按任意长度分片喂入，不建 DOM、不分配内存；解析器只维护一个路径栈。
+ * 值开始时如果当前路径匹配某个选择器就回调 on_value，字符串值 (已反转义，\uXXXX 转成 UTF-8)
+ * 按小块通过 on_string 交出，调用方直接拷进最终的输出，整个响应只拷贝这一次。
+ *
+ * 选择器语法：以 "." 分隔的键，"[n]" 取数组第 n 项，"[*]" 匹配任意项，例如
+ *   "choices[0].message.content"、"messages[*].content"、"event"
+ * 键超过 AI_JSON_MAX_KEY - 1 字节时不会匹配任何选择器。
+ */
+
+#define AI_JSON_MAX_DEPTH 12
+#define AI_JSON_MAX_KEY   32
+#define AI_JSON_CHUNK     64          // on_string 每块最多多少字节
+#define AI_JSON_MAX_SELECTORS 8
+
+typedef enum {
+    AI_JSON_STRING,
+    AI_JSON_NUMBER,
+    AI_JSON_BOOL,
+    AI_JSON_NULL,
+    AI_JSON_OBJECT,
+    AI_JSON_ARRAY,
+} ai_json_type_t;
+
+typedef struct {
+    /**
+     * @brief 匹配选择器 sel 的值开始 (可以为 NULL)
+     */
+    void (*on_value)(int sel, ai_json_type_t type, void* arg);
+    /**
+     * @brief 匹配的字符串值的一块内容 (块边界可能在 UTF-8 字符中间)；数字/true/false/null 以原文整体交出一次
+     * @param done 该值的最后一块
+     */
+    void (*on_string)(int sel, const char* data, size_t len, bool done, void* arg);
+} ai_json_callbacks_t;
+
+typedef struct {
+    char type;                    // '{' 或 '['
+    int32_t index;                // 数组中的当前下标
+    char key[AI_JSON_MAX_KEY];    // 对象中的当前键
+    bool key_too_long;
+} ai_json_frame_t;
+
+typedef struct {
+    const char* const* selectors;
+    int selector_count;
+    ai_json_callbacks_t callbacks;
+    void* arg;
+
+    uint8_t state;
+    bool in_key;                  // 当前字符串是对象的键
+    int depth;
+    ai_json_frame_t stack[AI_JSON_MAX_DEPTH];
+    int match;                    // 当前标量值匹配的选择器，-1 为不匹配
+
+    char chunk[AI_JSON_CHUNK + 4];
+    size_t chunk_len;
+    size_t key_len;
+    uint32_t code_unit;           // \uXXXX 解析中的值
+    uint8_t hex_left;
+    uint32_t high_surrogate;      // 等待低位代理的高位代理，0 为无
+
+    size_t offset;                // 已处理的字节数，出错时为出错位置
+} ai_json_stream_t;
+
+/**
+ * @brief 初始化解析器
+ * @param selectors 选择器数组 (最多 AI_JSON_MAX_SELECTORS 个)，解析期间必须保持有效
+ */
+void ai_json_stream_init(ai_json_stream_t* parser, const char* const* selectors, int selector_count,
+                         const ai_json_callbacks_t* callbacks, void* arg);
+
+/**
+ * @brief 喂入一段数据
+ * @return 出现语法错误或嵌套超过 AI_JSON_MAX_DEPTH 时返回 false，之后的数据都会被忽略
+ */
+bool ai_json_stream_feed(ai_json_stream_t* parser, const char* data, size_t len);
+
+/**
+ * @brief 数据结束
+ * @return 是否恰好解析完一个完整的 JSON 值
+ */
+bool ai_json_stream_finish(ai_json_stream_t* parser);
+
+/**
+ * @brief 是否已经出错
+ */
+bool ai_json_stream_failed(const ai_json_stream_t* parser);
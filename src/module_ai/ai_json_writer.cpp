@@ -0,0 +1,94 @@
+// src/module_ai/ai_json_writer.cpp
+
+#include "ai_json_writer.h"
+
+#include <string.h>
+
+void ai_json_writer_init(ai_json_writer_t* writer, char* buf, size_t cap) {
+    writer->buf = buf;
+    writer->cap = cap;
+    writer->len = 0;
+    writer->overflow = cap == 0;
+    if (cap) {
+        buf[0] = '\0';
+    }
+}
+
+void ai_json_write_raw(ai_json_writer_t* writer, const char* text, size_t len) {
+    if (writer->overflow) {
+        return;
+    }
+    // 始终给结尾的 '\0' 留一个字节
+    if (len >= writer->cap - writer->len) {
+        writer->overflow = true;
+        return;
+    }
+    memcpy(writer->buf + writer->len, text, len);
+    writer->len += len;
+}
+
+void ai_json_write_string(ai_json_writer_t* writer, const char* text, size_t len) {
+    static const char kHex[] = "0123456789abcdef";
+    ai_json_write_raw(writer, "\"", 1);
+    size_t run = 0;               // 不需要转义的连续字节从 run 开始，整段拷贝
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        ai_json_write_raw(writer, text + run, i - run);
+        run = i + 1;
+        char esc[6] = { '\\', 0 };
+        size_t esc_len = 2;
+        switch (c) {
+            case '"':  esc[1] = '"'; break;
+            case '\\': esc[1] = '\\'; break;
+            case '\b': esc[1] = 'b'; break;
+            case '\f': esc[1] = 'f'; break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            default:
+                esc[1] = 'u';
+                esc[2] = '0';
+                esc[3] = '0';
+                esc[4] = kHex[c >> 4];
+                esc[5] = kHex[c & 0xf];
+                esc_len = 6;
+                break;
+        }
+        ai_json_write_raw(writer, esc, esc_len);
+    }
+    ai_json_write_raw(writer, text + run, len - run);
+    ai_json_write_raw(writer, "\"", 1);
+}
+
+size_t ai_json_string_len(const char* text, size_t len) {
+    size_t n = 2;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            n += 1;
+        } else if (c == '"' || c == '\\' || c == '\b' || c == '\f' || c == '\n' || c == '\r' || c == '\t') {
+            n += 2;
+        } else {
+            n += 6;
+        }
+    }
+    return n;
+}
+
+void ai_json_write_bool(ai_json_writer_t* writer, bool value) {
+    if (value) {
+        AI_JSON_WRITE_LITERAL(writer, "true");
+    } else {
+        AI_JSON_WRITE_LITERAL(writer, "false");
+    }
+}
+
+bool ai_json_writer_finish(ai_json_writer_t* writer) {
+    if (writer->cap) {
+        writer->buf[writer->len] = '\0';
+    }
+    return !writer->overflow;
+}
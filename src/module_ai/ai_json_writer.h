@@ -0,0 +1,52 @@
+// src/module_ai/ai_json_writer.h
+
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief 顺序 JSON 写入器：直接把 JSON 文本写进调用方提供的缓冲区，不分配内存
+ *
+ * 只负责转义和越界检查，结构 (括号、逗号、键) 由调用方按顺序写出，
+ * 固定不变的部分可以事先写成字符串字面量，用 AI_JSON_WRITE_LITERAL 整段拷贝。
+ * 缓冲区不够时后续写入全部忽略，ai_json_writer_finish 返回 false。
+ */
+
+typedef struct {
+    char* buf;
+    size_t cap;
+    size_t len;                   // 已写入的字节数 (不含结尾的 '\0')
+    bool overflow;
+} ai_json_writer_t;
+
+/**
+ * @brief 初始化写入器，cap 包含结尾 '\0' 的一个字节
+ */
+void ai_json_writer_init(ai_json_writer_t* writer, char* buf, size_t cap);
+
+/**
+ * @brief 原样写入一段已经是合法 JSON 片段的文本
+ */
+void ai_json_write_raw(ai_json_writer_t* writer, const char* text, size_t len);
+
+// 写入字符串字面量，长度在编译期确定
+#define AI_JSON_WRITE_LITERAL(writer, literal) ai_json_write_raw((writer), (literal), sizeof(literal) - 1)
+
+/**
+ * @brief 写入带引号的字符串值，转义 '"'、'\\' 和控制字符；UTF-8 多字节字符原样写入
+ */
+void ai_json_write_string(ai_json_writer_t* writer, const char* text, size_t len);
+
+/**
+ * @brief ai_json_write_string 写出的字节数 (含两侧引号)，用于事先判断放不放得下
+ */
+size_t ai_json_string_len(const char* text, size_t len);
+
+void ai_json_write_bool(ai_json_writer_t* writer, bool value);
+
+/**
+ * @brief 写入结尾 '\0'
+ * @return 是否完整写入 (没有溢出)
+ */
+bool ai_json_writer_finish(ai_json_writer_t* writer);
@@ -1,12 +1,28 @@
 // components/ai_service/ai_service.cpp
 
 #include "ai_service.h"
+#include "ai_http_pool.h"
+#include "ai_sse.h"
+#include "ai_json_stream.h"
+#include "ai_json_writer.h"
+#include "ai_conversation.h"
+#include "ai_cache.h"
+#include "ai_health.h"
+#include "ai_hedge.h"
 #include "../module_wifi/wifi_manager.h" // 包含您提供的WiFi模块头文件
 
+#include <algorithm>
 #include <string>
+#include <string.h>
 #include "esp_log.h"
 #include "esp_http_client.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_sys.h"
 #include "cJSON.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
 // 日志标签
 static const char *TAG = "AI_SERVICE";
@@ -14,191 +30,709 @@ static const char *TAG = "AI_SERVICE";
 // 声明嵌入的根证书变量
 extern const unsigned char digicert_global_root_g2_pem_start[] asm("_binary_digicert_global_root_g2_pem_start");
 // ======== 配置信息 ========
+// 密钥和 ID 用宏定义，以便在编译期拼进请求头和请求体的固定部分 (不能含需要 JSON 转义的字符)
 // DeepSeek 配置
-static const char* DEEPSEEK_API_KEY = "sk-782f873d727140c791b7c43f6ef88068";
+#define DEEPSEEK_API_KEY "sk-782f873d727140c791b7c43f6ef88068"
+#define DEEPSEEK_SYSTEM_PROMPT "你是鹏鹏的生活助手，回答控制在256字符内"
 static const char* DEEPSEEK_API_URL = "https://api.deepseek.com/v1/chat/completions";
 
 // Coze(扣子) 配置
-static const char* COZE_API_KEY = "pat_3hVq6g7PNFQusWWhksJHuLkycKMbBVpje7BCxJ9XCoRkY4Dq8rKLLGJYQFKXKWiH";
+#define COZE_API_KEY "pat_3hVq6g7PNFQusWWhksJHuLkycKMbBVpje7BCxJ9XCoRkY4Dq8rKLLGJYQFKXKWiH"
+#define COZE_BOT_ID "7521739543067361306"
+#define COZE_USER_ID "esp32-user-123" // 可自定义
 static const char* COZE_API_URL = "https://api.coze.cn/open_api/v2/chat";
-static const char* COZE_BOT_ID = "7521739543067361306";
-static const char* COZE_USER_ID = "esp32-user-123"; // 可自定义
 
-// HTTP 事件处理函数，用于接收响应数据
-esp_err_t _http_event_handler(esp_http_client_event_t *evt) {
-    // 将响应数据追加到 user_data 指向的 string 对象
-    if (evt->event_id == HTTP_EVENT_ON_DATA) {
-        std::string* response_body = static_cast<std::string*>(evt->user_data);
-        response_body->append((char*)evt->data, evt->data_len);
+static const char DEEPSEEK_AUTH_HEADER[] = "Bearer " DEEPSEEK_API_KEY;
+static const char COZE_AUTH_HEADER[] = "Bearer " COZE_API_KEY;
+
+// 请求体中除用户问题外的部分，编译期就已经是序列化好的 JSON
+// DeepSeek 多轮对话时，历史消息片段 (见 ai_conversation.h) 拼在 head 和 user_head 之间
+static const char kDeepseekBodyHead[] =
+    "{\"model\":\"deepseek-chat\",\"messages\":[{\"role\":\"system\",\"content\":\"" DEEPSEEK_SYSTEM_PROMPT "\"},";
+static const char kDeepseekUserHead[] = "{\"role\":\"user\",\"content\":";
+static const char kDeepseekBodyTail[] = "}]}";
+static const char kDeepseekBodyTailStream[] = "}],\"stream\":true}";
+static const char kCozeBodyHead[] =
+    "{\"bot_id\":\"" COZE_BOT_ID "\",\"user\":\"" COZE_USER_ID "\",\"query\":";
+static const char kCozeBodyTail[] = ",\"stream\":false}";
+static const char kCozeBodyTailStream[] = ",\"stream\":true}";
+
+// 每个后端一个长连接池 (见 ai_http_pool.h)，在 ai_service_init 中创建
+static ai_http_pool_handle_t s_deepseek_pool = NULL;
+static ai_http_pool_handle_t s_coze_pool = NULL;
+// 连接池全部被占用时最多等待多久
+#define AI_POOL_WAIT_MS 20000
+// 请求非 200 时最多保留多少字节的响应体用于日志
+#define AI_ERROR_BODY_MAX 512
+// 置 1 时阻塞请求额外保留响应体，再用 cJSON 整体解析一遍，打印两种做法的耗时和峰值内存；
+// 请求体也用 cJSON 再构建一遍，打印两种做法的堆分配次数、峰值和堆碎片
+#define AI_JSON_COMPARE_CJSON 0
+// 请求体缓冲区中留给固定部分和本次问题的大小 (每个后端一个，静态分配)；
+// DeepSeek 的缓冲区另外加上对话上下文的 AI_CONV_ARENA_SIZE
+#define AI_REQUEST_BODY_MAX 4096
+// 问题转义后放不进请求体缓冲区时的返回值
+#define AI_ERROR_INPUT_TOO_LONG "<错误: 输入文本过长>"
+// 流式事件中最多取几个字段
+#define AI_STREAM_FIELDS 4
+// 各后端的超时上限，实际超时由 ai_health 按最近的延迟分位数决定
+#define AI_DEEPSEEK_TIMEOUT_MS 15000
+#define AI_COZE_TIMEOUT_MS 30000
+
+// ======== 内部实现函数 ========
+
+// 一次 JSON POST 请求的参数，连接池重试时会再次调用 _prepare_json_post
+typedef struct {
+    const char* auth_header;
+    const char* payload;
+    size_t payload_len;
+    const char* accept;
+    int timeout_ms;
+} json_post_t;
+
+static void _prepare_json_post(esp_http_client_handle_t client, void* arg) {
+    const json_post_t* req = static_cast<const json_post_t*>(arg);
+    esp_http_client_set_method(client, HTTP_METHOD_POST);
+    esp_http_client_set_header(client, "Content-Type", "application/json");
+    // 客户端在池中复用，头部会保留到下一次请求，因此每次都要设置
+    esp_http_client_set_header(client, "Accept", req->accept);
+    esp_http_client_set_header(client, "Authorization", req->auth_header);
+    esp_http_client_set_post_field(client, req->payload, req->payload_len);
+    esp_http_client_set_timeout_ms(client, req->timeout_ms);
+}
+
+// 本次请求的超时：最近的延迟分位数推算，不超过配置的上限，调用方给了 max_ms 时也不超过它
+static int _request_timeout_ms(AiModel model, uint32_t max_ms) {
+    uint32_t limit = model == AiModel::DEEPSEEK ? AI_DEEPSEEK_TIMEOUT_MS : AI_COZE_TIMEOUT_MS;
+    if (max_ms) {
+        limit = std::min(limit, max_ms);
     }
-    return ESP_OK;
+    return ai_health_timeout_ms(model, limit);
 }
 
-// ======== 内部实现函数 ========
+static bool _is_error(const std::string& result) {
+    return result.compare(0, strlen("<错误:"), "<错误:") == 0;
+}
+
+// 请求结果对熔断器的意义：只有后端本身的问题 (连接失败、超时、5xx、限流) 才算失败。
+// timeout_ms 是调用方给的超时上限，耗时已经到了它说明是调用方的期限太短，不算后端的问题
+static AiOutcome _classify(const std::atomic<bool>* abort, esp_err_t err, int status_code,
+                           uint32_t timeout_ms, uint32_t elapsed_ms) {
+    if (abort && abort->load()) {
+        return AiOutcome::NEUTRAL;
+    }
+    if (err == ESP_ERR_TIMEOUT || err == ESP_ERR_INVALID_SIZE) {
+        return AiOutcome::NEUTRAL;        // 连接池繁忙或问题过长，请求没有发出
+    }
+    if (err != ESP_OK && timeout_ms && elapsed_ms >= timeout_ms) {
+        return AiOutcome::NEUTRAL;
+    }
+    if (err != ESP_OK || status_code >= 500 || status_code == 429) {
+        return AiOutcome::FAILURE;
+    }
+    return AiOutcome::NEUTRAL;
+}
+
+// 每个后端一个请求体缓冲区，从构建请求体到请求结束一直持有 lock。
+// 连接池每个后端只有一条连接，同一后端的请求本来就是串行的，这把锁不会增加等待
+typedef struct {
+    SemaphoreHandle_t lock;
+    char* buf;
+    size_t cap;
+} request_body_t;
+
+static char s_deepseek_buf[AI_REQUEST_BODY_MAX + AI_CONV_ARENA_SIZE];
+static char s_coze_buf[AI_REQUEST_BODY_MAX];
+static request_body_t s_deepseek_body = { NULL, s_deepseek_buf, sizeof(s_deepseek_buf) };
+static request_body_t s_coze_body = { NULL, s_coze_buf, sizeof(s_coze_buf) };
+
+// 多轮对话从写请求体 (读上下文) 到追加本轮一直持有，保证下一轮的请求里带上这一轮
+static SemaphoreHandle_t s_chat_lock = NULL;
+
+static request_body_t* _acquire_body(AiModel model) {
+    request_body_t* body = model == AiModel::DEEPSEEK ? &s_deepseek_body : &s_coze_body;
+    if (!body->lock || xSemaphoreTake(body->lock, pdMS_TO_TICKS(AI_POOL_WAIT_MS)) != pdTRUE) {
+        return NULL;
+    }
+    return body;
+}
+
+static void _release_body(request_body_t* body) {
+    xSemaphoreGive(body->lock);
+}
 
 /**
- * @brief 内部函数：请求DeepSeek API
+ * @brief 内部函数：把请求体直接写进 buf，不分配内存
+ * @param chat 带上对话上下文 (只对 DeepSeek 有效)
+ * @return 请求体长度；超出缓冲区时返回 0
  */
-static std::string _get_deepseek_answer(const std::string& input) {
-    std::string response_body;
-    std::string result = "<错误: 未知>";
+static size_t _write_payload(AiModel model, const std::string& input, bool stream, bool chat,
+                             char* buf, size_t cap) {
+    ai_json_writer_t w;
+    ai_json_writer_init(&w, buf, cap);
+    if (model == AiModel::DEEPSEEK) {
+        AI_JSON_WRITE_LITERAL(&w, kDeepseekBodyHead);
+        if (chat) {
+            ai_conversation_write(&w);
+        }
+        AI_JSON_WRITE_LITERAL(&w, kDeepseekUserHead);
+        ai_json_write_string(&w, input.data(), input.size());
+        if (stream) {
+            AI_JSON_WRITE_LITERAL(&w, kDeepseekBodyTailStream);
+        } else {
+            AI_JSON_WRITE_LITERAL(&w, kDeepseekBodyTail);
+        }
+    } else {
+        AI_JSON_WRITE_LITERAL(&w, kCozeBodyHead);
+        ai_json_write_string(&w, input.data(), input.size());
+        if (stream) {
+            AI_JSON_WRITE_LITERAL(&w, kCozeBodyTailStream);
+        } else {
+            AI_JSON_WRITE_LITERAL(&w, kCozeBodyTail);
+        }
+    }
+    return ai_json_writer_finish(&w) ? w.len : 0;
+}
 
-    // 1. 构建JSON请求体
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "model", "deepseek-chat");
-    cJSON *messages = cJSON_AddArrayToObject(root, "messages");
-    cJSON *system_msg = cJSON_CreateObject();
-    cJSON_AddStringToObject(system_msg, "role", "system");
-    cJSON_AddStringToObject(system_msg, "content", "你是鹏鹏的生活助手，回答控制在256字符内");
-    cJSON_AddItemToArray(messages, system_msg);
-    cJSON *user_msg = cJSON_CreateObject();
-    cJSON_AddStringToObject(user_msg, "role", "user");
-    cJSON_AddStringToObject(user_msg, "content", input.c_str());
-    cJSON_AddItemToArray(messages, user_msg);
-    
-    char *json_payload = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
+// 中止标志已置位时关闭连接，esp_http_client_perform 随后以错误返回；在请求所在任务中调用，没有竞争
+static bool _check_abort(const std::atomic<bool>* abort, esp_http_client_event_t *evt) {
+    if (!abort || !abort->load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (evt->event_id != HTTP_EVENT_ON_FINISH && evt->event_id != HTTP_EVENT_DISCONNECTED &&
+        evt->event_id != HTTP_EVENT_ERROR) {
+        esp_http_client_cancel_request(evt->client);
+    }
+    return true;
+}
 
-    // 2. 配置HTTP客户端
-    std::string auth_header = "Bearer " + std::string(DEEPSEEK_API_KEY);
-    esp_http_client_config_t config = {};
-    config.url = DEEPSEEK_API_URL;
-    config.event_handler = _http_event_handler;
-    config.user_data = &response_body;
-    config.timeout_ms = 15000;
-    // ======== 修复点：使用共享的根CA证书 ========
-    config.cert_pem = (const char *)digicert_global_root_g2_pem_start;
-
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_http_client_set_method(client, HTTP_METHOD_POST);
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_http_client_set_header(client, "Authorization", auth_header.c_str());
-    esp_http_client_set_post_field(client, json_payload, strlen(json_payload));
-
-    // 3. 发送请求
-    esp_err_t err = esp_http_client_perform(client);
-    if (err == ESP_OK) {
-        int status_code = esp_http_client_get_status_code(client);
-        if (status_code == 200) {
-            // 4. 解析JSON响应
-            cJSON *json_resp = cJSON_Parse(response_body.c_str());
-            if (json_resp) {
-                cJSON *choices = cJSON_GetObjectItem(json_resp, "choices");
-                if (cJSON_IsArray(choices) && cJSON_GetArraySize(choices) > 0) {
-                    cJSON *first_choice = cJSON_GetArrayItem(choices, 0);
-                    cJSON *message = cJSON_GetObjectItem(first_choice, "message");
-                    cJSON *content = cJSON_GetObjectItem(message, "content");
-                    if (cJSON_IsString(content) && (content->valuestring != NULL)) {
-                        result = content->valuestring;
-                    } else {
-                        result = "<错误: 找不到content字段>";
-                    }
-                } else {
-                    result = "<错误: 响应中无choices>";
-                }
-                cJSON_Delete(json_resp);
-            } else {
-                result = "<错误: JSON解析失败>";
+// 非 200 响应的响应体只留开头一段用于日志
+static void _append_error_body(std::string* body, const esp_http_client_event_t *evt) {
+    if (body->size() < AI_ERROR_BODY_MAX) {
+        size_t n = std::min((size_t)evt->data_len, AI_ERROR_BODY_MAX - body->size());
+        body->append((const char*)evt->data, n);
+    }
+}
+
+// ======== 阻塞式回答 ========
+
+// 一次阻塞请求的状态：响应体边收边喂给增量 JSON 解析器，只把回答拷进 answer，不保留响应体也不建 DOM
+struct answer_ctx_t {
+    AiModel model;
+    const std::atomic<bool>* abort;
+    ai_json_stream_t json;
+    std::string answer;
+    std::string error_body;
+    bool found;                   // DeepSeek: choices[0] 存在；Coze: messages 是数组
+    bool has_content;             // 找到了字符串类型的 content
+    bool capture;                 // 当前匹配的 content 是字符串
+    uint32_t parse_cycles;        // 解析器本身消耗的 CPU 周期 (不含等待网络)
+#if AI_JSON_COMPARE_CJSON
+    std::string body;
+#endif
+};
+
+// 选择器 0 用来判断结构是否正确，选择器 1 是要取出的文本
+static const char* const kDeepseekSelectors[] = { "choices[0]", "choices[0].message.content" };
+static const char* const kCozeSelectors[] = { "messages", "messages[*].content" };
+
+static void _answer_on_value(int sel, ai_json_type_t type, void* arg) {
+    answer_ctx_t* ctx = static_cast<answer_ctx_t*>(arg);
+    if (sel == 0) {
+        ctx->found = ctx->model == AiModel::DEEPSEEK || type == AI_JSON_ARRAY;
+    } else {
+        ctx->capture = type == AI_JSON_STRING;
+        ctx->has_content |= ctx->capture;
+    }
+}
+
+static void _answer_on_string(int sel, const char* data, size_t len, bool done, void* arg) {
+    answer_ctx_t* ctx = static_cast<answer_ctx_t*>(arg);
+    if (sel != 1 || !ctx->capture) return;
+    ctx->answer.append(data, len);
+    // Coze 的多条消息之间用换行分隔
+    if (done && ctx->model == AiModel::COZE) {
+        ctx->answer += "\n";
+    }
+}
+
+static esp_err_t _answer_http_event_handler(esp_http_client_event_t *evt) {
+    answer_ctx_t* ctx = static_cast<answer_ctx_t*>(evt->user_data);
+    if (_check_abort(ctx->abort, evt) || evt->event_id != HTTP_EVENT_ON_DATA) {
+        return ESP_OK;
+    }
+    if (esp_http_client_get_status_code(evt->client) != 200) {
+        _append_error_body(&ctx->error_body, evt);
+        return ESP_OK;
+    }
+#if AI_JSON_COMPARE_CJSON
+    ctx->body.append((const char*)evt->data, evt->data_len);
+#endif
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    ai_json_stream_feed(&ctx->json, (const char*)evt->data, evt->data_len);
+    ctx->parse_cycles += esp_cpu_get_cycle_count() - t0;
+    return ESP_OK;
+}
+
+#if AI_JSON_COMPARE_CJSON
+// 统计 cJSON 分配的峰值：用 heap_caps_get_allocated_size 取块大小，不改变内存布局，
+// 钩子期间其他任务用 cJSON 分配的内存也会被计入，只用于调试对比
+static size_t s_cjson_live = 0;
+static size_t s_cjson_peak = 0;
+static size_t s_cjson_allocs = 0;
+
+static void* _cjson_count_malloc(size_t size) {
+    void* p = malloc(size);
+    if (p) {
+        s_cjson_allocs++;
+        s_cjson_live += heap_caps_get_allocated_size(p);
+        s_cjson_peak = std::max(s_cjson_peak, s_cjson_live);
+    }
+    return p;
+}
+
+static void _cjson_count_free(void* p) {
+    if (p) {
+        size_t n = heap_caps_get_allocated_size(p);
+        s_cjson_live -= std::min(n, s_cjson_live);
+    }
+    free(p);
+}
+
+// 用原来的做法 (整个响应体 cJSON_Parse 后取字段) 再解析一遍，打印耗时和峰值内存对比
+static void _compare_with_cjson(const answer_ctx_t* ctx, const char* name) {
+    cJSON_Hooks hooks = { _cjson_count_malloc, _cjson_count_free };
+    s_cjson_live = s_cjson_peak = 0;
+    cJSON_InitHooks(&hooks);
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    std::string result;
+    cJSON *json_resp = cJSON_Parse(ctx->body.c_str());
+    if (ctx->model == AiModel::DEEPSEEK) {
+        cJSON *first_choice = cJSON_GetArrayItem(cJSON_GetObjectItem(json_resp, "choices"), 0);
+        cJSON *content = cJSON_GetObjectItem(cJSON_GetObjectItem(first_choice, "message"), "content");
+        if (cJSON_IsString(content)) result = content->valuestring;
+    } else {
+        cJSON *message_item;
+        cJSON *messages = cJSON_GetObjectItem(json_resp, "messages");
+        cJSON_ArrayForEach(message_item, messages) {
+            cJSON *content = cJSON_GetObjectItem(message_item, "content");
+            if (cJSON_IsString(content)) {
+                result += content->valuestring;
+                result += "\n";
             }
-        } else {
-            ESP_LOGE(TAG, "DeepSeek API 错误, HTTP状态码: %d", status_code);
-            result = "<错误: API返回非200状态码 " + std::to_string(status_code) + ">";
+        }
+    }
+    size_t dom_peak = s_cjson_peak;
+    cJSON_Delete(json_resp);
+    uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+    cJSON_InitHooks(NULL);
+
+    const uint32_t mhz = esp_rom_get_cpu_ticks_per_us();
+    ESP_LOGI(TAG, "%s 解析对比 (响应体 %u 字节):", name, (unsigned)ctx->body.size());
+    ESP_LOGI(TAG, "  增量解析: %u us, 峰值 %u 字节 (回答 %u + 解析器 %u)",
+             (unsigned)(ctx->parse_cycles / mhz), (unsigned)(ctx->answer.capacity() + sizeof(ctx->json)),
+             (unsigned)ctx->answer.capacity(), (unsigned)sizeof(ctx->json));
+    ESP_LOGI(TAG, "  cJSON   : %u us, 峰值 %u 字节 (响应体 %u + DOM %u + 回答 %u), 结果%s",
+             (unsigned)(cycles / mhz), (unsigned)(ctx->body.capacity() + dom_peak + result.capacity()),
+             (unsigned)ctx->body.capacity(), (unsigned)dom_peak, (unsigned)result.capacity(),
+             result == ctx->answer ? "一致" : "不一致");
+}
+
+// 碎片率：空闲内存中不在最大空闲块里的比例
+static unsigned _fragmentation_pct(const multi_heap_info_t* info) {
+    if (!info->total_free_bytes) return 0;
+    return (unsigned)(100 - info->largest_free_block * 100 / info->total_free_bytes);
+}
+
+// 用原来的做法 (cJSON 建树后 cJSON_PrintUnformatted) 再构建一遍请求体，
+// 打印两种做法的耗时、堆分配次数和峰值，以及 cJSON 构建前后的堆碎片
+static void _compare_payload_with_cjson(AiModel model, const std::string& input, bool stream,
+                                        char* body, size_t cap, size_t body_len) {
+    const uint32_t mhz = esp_rom_get_cpu_ticks_per_us();
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    _write_payload(model, input, stream, false, body, cap);
+    uint32_t writer_cycles = esp_cpu_get_cycle_count() - t0;
+
+    multi_heap_info_t before, after;
+    heap_caps_get_info(&before, MALLOC_CAP_8BIT);
+    cJSON_Hooks hooks = { _cjson_count_malloc, _cjson_count_free };
+    s_cjson_live = s_cjson_peak = s_cjson_allocs = 0;
+    cJSON_InitHooks(&hooks);
+    t0 = esp_cpu_get_cycle_count();
+    cJSON *root = cJSON_CreateObject();
+    if (model == AiModel::DEEPSEEK) {
+        cJSON_AddStringToObject(root, "model", "deepseek-chat");
+        cJSON *messages = cJSON_AddArrayToObject(root, "messages");
+        cJSON *system_msg = cJSON_CreateObject();
+        cJSON_AddStringToObject(system_msg, "role", "system");
+        cJSON_AddStringToObject(system_msg, "content", DEEPSEEK_SYSTEM_PROMPT);
+        cJSON_AddItemToArray(messages, system_msg);
+        cJSON *user_msg = cJSON_CreateObject();
+        cJSON_AddStringToObject(user_msg, "role", "user");
+        cJSON_AddStringToObject(user_msg, "content", input.c_str());
+        cJSON_AddItemToArray(messages, user_msg);
+        if (stream) {
+            cJSON_AddBoolToObject(root, "stream", true);
         }
     } else {
-        ESP_LOGE(TAG, "HTTP POST请求失败: %s", esp_err_to_name(err));
-        result = "<错误: HTTP请求执行失败>";
+        cJSON_AddStringToObject(root, "bot_id", COZE_BOT_ID);
+        cJSON_AddStringToObject(root, "user", COZE_USER_ID);
+        cJSON_AddStringToObject(root, "query", input.c_str());
+        cJSON_AddBoolToObject(root, "stream", stream);
     }
+    char *printed = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    // 原来的做法还要拼一次 "Bearer " + 密钥
+    std::string auth_header = "Bearer " + std::string(model == AiModel::DEEPSEEK ? DEEPSEEK_API_KEY : COZE_API_KEY);
+    uint32_t cjson_cycles = esp_cpu_get_cycle_count() - t0;
+    size_t allocs = s_cjson_allocs + 1;   // 加上拼接请求头的那一次
+    size_t peak = s_cjson_peak;
+    bool same = printed && strcmp(printed, body) == 0;
+    cJSON_free(printed);
+    cJSON_InitHooks(NULL);
+    auth_header = std::string();
+    heap_caps_get_info(&after, MALLOC_CAP_8BIT);
 
-    // 5. 清理
-    esp_http_client_cleanup(client);
-    free(json_payload);
-    return result;
+    ESP_LOGI(TAG, "%s 请求体对比 (%u 字节):", model == AiModel::DEEPSEEK ? "DeepSeek" : "Coze", (unsigned)body_len);
+    ESP_LOGI(TAG, "  写入器: %u us, 堆分配 0 次", (unsigned)(writer_cycles / mhz));
+    ESP_LOGI(TAG, "  cJSON : %u us, 堆分配 %u 次, 峰值 %u 字节, 结果%s", (unsigned)(cjson_cycles / mhz),
+             (unsigned)allocs, (unsigned)peak, same ? "一致" : "不一致");
+    ESP_LOGI(TAG, "  cJSON 构建前后: 空闲 %u -> %u 字节, 最大空闲块 %u -> %u 字节, 空闲块 %u -> %u 个, 碎片率 %u%% -> %u%%",
+             (unsigned)before.total_free_bytes, (unsigned)after.total_free_bytes,
+             (unsigned)before.largest_free_block, (unsigned)after.largest_free_block,
+             (unsigned)before.free_blocks, (unsigned)after.free_blocks,
+             _fragmentation_pct(&before), _fragmentation_pct(&after));
 }
+#endif
 
 /**
- * @brief 内部函数：请求Coze API
+ * @brief 内部函数：在该后端的请求体缓冲区中写好请求体，通过连接池发出
+ * @param http_ms 输出 HTTP 交互本身的耗时 (连接池取得连接之后)，没有发出请求时为 0
+ * @return ai_http_pool_perform 的结果；缓冲区被占用超时返回 ESP_ERR_TIMEOUT，问题过长返回 ESP_ERR_INVALID_SIZE
  */
-static std::string _get_coze_answer(const std::string& input) {
-    std::string response_body;
-    std::string result = "<错误: 未知>";
-    
-    // 1. 构建JSON请求体
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "bot_id", COZE_BOT_ID);
-    cJSON_AddStringToObject(root, "user", COZE_USER_ID);
-    cJSON_AddStringToObject(root, "query", input.c_str());
-    cJSON_AddBoolToObject(root, "stream", false);
+static esp_err_t _perform_json_post(AiModel model, const std::string& input, bool stream, bool chat,
+                                    http_event_handle_cb handler, void* ctx, int* status_code,
+                                    const std::atomic<bool>* abort, uint32_t timeout_ms, uint32_t* http_ms) {
+    *http_ms = 0;
+    request_body_t* body = _acquire_body(model);
+    if (!body) {
+        return ESP_ERR_TIMEOUT;
+    }
+    size_t body_len = _write_payload(model, input, stream, chat, body->buf, body->cap);
+    if (body_len == 0) {
+        _release_body(body);
+        ESP_LOGE(TAG, "问题过长，请求体超过 %u 字节", (unsigned)body->cap);
+        return ESP_ERR_INVALID_SIZE;
+    }
+#if AI_JSON_COMPARE_CJSON
+    // cJSON 的对照做法没有对话上下文，多轮请求不比较
+    if (!chat) {
+        _compare_payload_with_cjson(model, input, stream, body->buf, body->cap, body_len);
+    }
+#endif
 
-    char* json_payload = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
+    const bool deepseek = model == AiModel::DEEPSEEK;
+    json_post_t req = { deepseek ? DEEPSEEK_AUTH_HEADER : COZE_AUTH_HEADER, body->buf, body_len,
+                        stream ? "text/event-stream" : "application/json", _request_timeout_ms(model, timeout_ms) };
+    esp_err_t err = ai_http_pool_perform(deepseek ? s_deepseek_pool : s_coze_pool, handler, ctx,
+                                         _prepare_json_post, &req, status_code, AI_POOL_WAIT_MS, abort, http_ms);
+    _release_body(body);
+    return err;
+}
 
-    // 2. 配置HTTP客户端
-    std::string auth_header = "Bearer " + std::string(COZE_API_KEY);
-    esp_http_client_config_t config = {};
-    config.url = COZE_API_URL;
-    config.event_handler = _http_event_handler;
-    config.user_data = &response_body;
-    config.timeout_ms = 30000;
-    // ======== 修复点：使用共享的根CA证书 ========
-    config.cert_pem = (const char *)digicert_global_root_g2_pem_start;
-    
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_http_client_set_method(client, HTTP_METHOD_POST);
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_http_client_set_header(client, "Authorization", auth_header.c_str());
-    esp_http_client_set_post_field(client, json_payload, strlen(json_payload));
-
-    // 3. 发送请求
-    esp_err_t err = esp_http_client_perform(client);
-    if (err == ESP_OK) {
-        int status_code = esp_http_client_get_status_code(client);
-        if (status_code == 200) {
-            // 4. 解析JSON响应
-            cJSON *json_resp = cJSON_Parse(response_body.c_str());
-            if (json_resp) {
-                cJSON *messages = cJSON_GetObjectItem(json_resp, "messages");
-                if (cJSON_IsArray(messages)) {
-                    result = ""; // 清空默认错误信息
-                    cJSON *message_item;
-                    cJSON_ArrayForEach(message_item, messages) {
-                        cJSON *content = cJSON_GetObjectItem(message_item, "content");
-                        if (cJSON_IsString(content) && content->valuestring != NULL) {
-                           result += content->valuestring;
-                           result += "\n";
-                        }
-                    }
-                    if (result.empty()) result = "<错误: 响应中messages为空>";
-
-                } else {
-                    result = "<错误: 响应中无messages数组>";
-                }
-                cJSON_Delete(json_resp);
-            } else {
-                result = "<错误: JSON解析失败>";
-            }
-        } else {
-            ESP_LOGE(TAG, "Coze API 错误, HTTP状态码: %d", status_code);
-            result = "<错误: API返回非200状态码 " + std::to_string(status_code) + ">";
+/**
+ * @brief 内部函数：请求 DeepSeek / Coze 的完整回答
+ */
+static std::string _get_answer(AiModel model, const std::string& input, bool chat,
+                               const std::atomic<bool>* abort, uint32_t timeout_ms) {
+    const bool deepseek = model == AiModel::DEEPSEEK;
+    const char* name = deepseek ? "DeepSeek" : "Coze";
+
+    // 1. 解析状态 (解析器不到 700 字节，放在堆上)
+    answer_ctx_t* ctx = new answer_ctx_t();
+    ctx->model = model;
+    ctx->abort = abort;
+    ai_json_callbacks_t callbacks = { _answer_on_value, _answer_on_string };
+    ai_json_stream_init(&ctx->json, deepseek ? kDeepseekSelectors : kCozeSelectors, 2, &callbacks, ctx);
+
+    // 2. 在长连接上发送请求 (连接复用、重连由连接池处理)，响应在事件回调中解析
+    int status_code = 0;
+    uint32_t http_ms = 0;
+    esp_err_t err = _perform_json_post(model, input, false, chat, _answer_http_event_handler, ctx, &status_code,
+                                       abort, timeout_ms, &http_ms);
+
+    // 3. 检查结果
+    std::string result;
+    if (abort && abort->load()) {
+        ESP_LOGW(TAG, "%s 请求已中止", name);
+        result = AI_ERROR_ABORTED;
+    } else if (err == ESP_ERR_INVALID_SIZE) {
+        result = AI_ERROR_INPUT_TOO_LONG;
+    } else if (err != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP POST请求失败: %s", esp_err_to_name(err));
+        result = "<错误: HTTP请求执行失败>";
+    } else if (status_code != 200) {
+        ESP_LOGE(TAG, "%s API 错误, HTTP状态码: %d, %s", name, status_code, ctx->error_body.c_str());
+        result = "<错误: API返回非200状态码 " + std::to_string(status_code) + ">";
+    } else if (!ai_json_stream_finish(&ctx->json)) {
+        ESP_LOGE(TAG, "%s 响应 JSON 在第 %u 字节处解析失败", name, (unsigned)ctx->json.offset);
+        result = "<错误: JSON解析失败>";
+    } else if (deepseek) {
+        if (!ctx->found) result = "<错误: 响应中无choices>";
+        else if (!ctx->has_content) result = "<错误: 找不到content字段>";
+    } else {
+        if (!ctx->found) result = "<错误: 响应中无messages数组>";
+        else if (ctx->answer.empty()) result = "<错误: 响应中messages为空>";
+    }
+    ESP_LOGI(TAG, "%s 响应解析 %u us, 回答 %u 字节", name,
+             (unsigned)(ctx->parse_cycles / esp_rom_get_cpu_ticks_per_us()), (unsigned)ctx->answer.size());
+#if AI_JSON_COMPARE_CJSON
+    if (result.empty()) {
+        _compare_with_cjson(ctx, name);
+    }
+#endif
+    // 延迟样本只算 HTTP 交互本身，不含等待请求体缓冲区和连接池的时间 (那是本机排队，不是后端变慢)
+    if (result.empty()) {
+        ai_health_report(model, AiOutcome::SUCCESS, http_ms);
+        result = std::move(ctx->answer);
+    } else {
+        ai_health_report(model, _classify(abort, err, status_code, timeout_ms, http_ms), 0);
+    }
+    delete ctx;
+    return result;
+}
+
+// ======== 流式 (SSE) 实现 ========
+
+// 一次流式请求的状态，由 HTTP 事件回调逐段更新
+struct stream_ctx_t {
+    AiModel model;
+    const std::atomic<bool>* abort;
+    ai_delta_cb_t on_delta;
+    void* arg;
+    ai_sse_parser_t sse;
+    std::string answer;
+    std::string error;            // 流中的错误事件
+    std::string error_body;       // 非 200 响应的响应体 (截断)
+    int64_t start_us;
+    int64_t first_us;
+    uint32_t deltas;
+    bool done;                    // 收到了结束标记 ([DONE] / event done)
+    // 每个事件的 JSON 用增量解析器取字段，字段缓冲区在事件之间复用
+    ai_json_stream_t json;
+    std::string fields[AI_STREAM_FIELDS];
+    bool field_is_string[AI_STREAM_FIELDS];
+};
+
+static void _emit_delta(stream_ctx_t* ctx, const char* text, size_t len) {
+    if (len == 0) return;
+    if (ctx->deltas == 0) {
+        ctx->first_us = esp_timer_get_time();
+    }
+    ctx->deltas++;
+    ctx->answer.append(text, len);
+    if (ctx->on_delta) {
+        ctx->on_delta(text, len, ctx->arg);
+    }
+}
+
+static void _field_on_value(int sel, ai_json_type_t type, void* arg) {
+    static_cast<stream_ctx_t*>(arg)->field_is_string[sel] = type == AI_JSON_STRING;
+}
+
+static void _field_on_string(int sel, const char* data, size_t len, bool done, void* arg) {
+    (void)done;
+    stream_ctx_t* ctx = static_cast<stream_ctx_t*>(arg);
+    if (ctx->field_is_string[sel]) {
+        ctx->fields[sel].append(data, len);
+    }
+}
+
+// 从一个事件的 JSON 中取出选择器对应的字符串字段到 ctx->fields，非字符串的字段留空
+static bool _parse_event_fields(stream_ctx_t* ctx, const char* data, size_t len,
+                                const char* const* selectors, int count) {
+    for (int i = 0; i < count; i++) {
+        ctx->fields[i].clear();
+        ctx->field_is_string[i] = false;
+    }
+    ai_json_callbacks_t callbacks = { _field_on_value, _field_on_string };
+    ai_json_stream_init(&ctx->json, selectors, count, &callbacks, ctx);
+    return ai_json_stream_feed(&ctx->json, data, len) && ai_json_stream_finish(&ctx->json);
+}
+
+// DeepSeek (OpenAI 格式)：data: {"choices":[{"delta":{"content":"..."}}]}，最后是 data: [DONE]
+static void _on_deepseek_event(stream_ctx_t* ctx, const char* data, size_t len) {
+    static const char* const selectors[] = { "choices[0].delta.content" };
+    if (strcmp(data, "[DONE]") == 0) {
+        ctx->done = true;
+        return;
+    }
+    if (!_parse_event_fields(ctx, data, len, selectors, 1)) {
+        ESP_LOGW(TAG, "DeepSeek 流事件解析失败");
+        return;
+    }
+    _emit_delta(ctx, ctx->fields[0].data(), ctx->fields[0].size());
+}
+
+// Coze v2：data:{"event":"message","message":{"type":"answer","content":"..."}}，结束为 "done"，出错为 "error"
+static void _on_coze_event(stream_ctx_t* ctx, const char* data, size_t len) {
+    static const char* const selectors[] = { "event", "message.type", "message.content",
+                                             "error_information.err_msg" };
+    if (!_parse_event_fields(ctx, data, len, selectors, 4)) {
+        ESP_LOGW(TAG, "Coze 流事件解析失败");
+        return;
+    }
+    const std::string& name = ctx->fields[0];
+    if (name == "message") {
+        // 只取回答本身，follow_up / verbose 等附加消息不朗读
+        if (ctx->fields[1] == "answer") {
+            _emit_delta(ctx, ctx->fields[2].data(), ctx->fields[2].size());
         }
+    } else if (name == "done") {
+        ctx->done = true;
+    } else if (name == "error") {
+        ctx->error = ctx->fields[3].empty() ? "流中返回错误" : ctx->fields[3];
+    }
+}
+
+static void _on_sse_event(const char* event, const char* data, size_t len, void* arg) {
+    (void)event;
+    stream_ctx_t* ctx = static_cast<stream_ctx_t*>(arg);
+    if (ctx->model == AiModel::DEEPSEEK) {
+        _on_deepseek_event(ctx, data, len);
     } else {
+        _on_coze_event(ctx, data, len);
+    }
+}
+
+// 流式请求的 HTTP 事件回调：200 的响应体交给 SSE 解析器，其他状态码的响应体留着打印
+static esp_err_t _stream_http_event_handler(esp_http_client_event_t *evt) {
+    stream_ctx_t* ctx = static_cast<stream_ctx_t*>(evt->user_data);
+    if (_check_abort(ctx->abort, evt) || evt->event_id != HTTP_EVENT_ON_DATA) {
+        return ESP_OK;
+    }
+    if (esp_http_client_get_status_code(evt->client) == 200) {
+        ai_sse_parser_feed(&ctx->sse, (const char*)evt->data, evt->data_len);
+    } else {
+        _append_error_body(&ctx->error_body, evt);
+    }
+    return ESP_OK;
+}
+
+// complete 可选，输出是否收到了结束标记 ([DONE] 等)；没有结束标记的回答照常返回，但可能被截断
+static std::string _get_stream_answer(AiModel model, const std::string& input, bool chat,
+                                      ai_delta_cb_t on_delta, void* arg, AiStreamStats* stats,
+                                      const std::atomic<bool>* abort, uint32_t timeout_ms,
+                                      bool* complete = nullptr) {
+    const bool deepseek = model == AiModel::DEEPSEEK;
+    const char* name = deepseek ? "DeepSeek" : "Coze";
+
+    // SSE 解析器带 4KB 缓冲区，JSON 解析器不到 700 字节，放在堆上，不占调用任务的栈
+    stream_ctx_t* ctx = new stream_ctx_t();
+    ctx->model = model;
+    ctx->on_delta = on_delta;
+    ctx->arg = arg;
+    ctx->abort = abort;
+    ai_sse_parser_init(&ctx->sse, _on_sse_event, ctx);
+    ctx->start_us = esp_timer_get_time();
+
+    int status_code = 0;
+    uint32_t http_ms = 0;
+    esp_err_t err = _perform_json_post(model, input, true, chat, _stream_http_event_handler, ctx, &status_code,
+                                       abort, timeout_ms, &http_ms);
+    if (err == ESP_OK && status_code == 200) {
+        ai_sse_parser_finish(&ctx->sse);
+    }
+
+    int64_t end_us = esp_timer_get_time();
+    AiStreamStats st;
+    st.first_token_ms = ctx->deltas ? (uint32_t)((ctx->first_us - ctx->start_us) / 1000) : 0;
+    st.total_ms = (uint32_t)((end_us - ctx->start_us) / 1000);
+    st.deltas = ctx->deltas;
+    st.http_ms = http_ms;
+    if (stats) {
+        *stats = st;
+    }
+    ESP_LOGI(TAG, "%s 流式回答: 首字 %u ms, 总计 %u ms, %u 段, %u 字节", name,
+             (unsigned)st.first_token_ms, (unsigned)st.total_ms, (unsigned)st.deltas,
+             (unsigned)ctx->answer.size());
+    if (ctx->sse.dropped) {
+        ESP_LOGW(TAG, "%s: %u 个超长事件被丢弃", name, (unsigned)ctx->sse.dropped);
+    }
+
+    std::string result;
+    if (abort && abort->load()) {
+        ESP_LOGW(TAG, "%s 流式请求已中止", name);
+        result = AI_ERROR_ABORTED;
+    } else if (err == ESP_ERR_INVALID_SIZE) {
+        result = AI_ERROR_INPUT_TOO_LONG;
+    } else if (err != ESP_OK) {
         ESP_LOGE(TAG, "HTTP POST请求失败: %s", esp_err_to_name(err));
         result = "<错误: HTTP请求执行失败>";
+    } else if (status_code != 200) {
+        ESP_LOGE(TAG, "%s API 错误, HTTP状态码: %d, %s", name, status_code, ctx->error_body.c_str());
+        result = "<错误: API返回非200状态码 " + std::to_string(status_code) + ">";
+    } else if (!ctx->error.empty()) {
+        ESP_LOGE(TAG, "%s 流式响应错误: %s", name, ctx->error.c_str());
+        result = "<错误: " + ctx->error + ">";
+    } else if (ctx->answer.empty()) {
+        result = "<错误: 流式响应中没有内容>";
+    } else {
+        if (!ctx->done) {
+            ESP_LOGW(TAG, "%s 流式响应没有结束标记，回答可能不完整", name);
+        }
+        result = std::move(ctx->answer);
     }
-
-    // 5. 清理
-    esp_http_client_cleanup(client);
-    free(json_payload);
+    if (complete) {
+        *complete = !_is_error(result) && ctx->done;
+    }
+    // 流式请求的总耗时取决于回答长度，不计入延迟统计
+    ai_health_report(model, _is_error(result) ? _classify(abort, err, status_code, timeout_ms, http_ms)
+                                                : AiOutcome::SUCCESS, 0);
+    delete ctx;
     return result;
 }
 
 // ======== 公共接口实现 ========
 
 void ai_service_init() {
+    // DeepSeek/Coze 的 keep-alive 超时在 60s 以上，空闲 45s 后主动关闭
+    ai_http_pool_config_t pool_cfg = {};
+    pool_cfg.cert_pem = (const char *)digicert_global_root_g2_pem_start;
+    pool_cfg.max_conns = 1;
+    pool_cfg.idle_timeout_ms = 45000;
+
+    pool_cfg.name = "DeepSeek";
+    pool_cfg.url = DEEPSEEK_API_URL;
+    pool_cfg.timeout_ms = AI_DEEPSEEK_TIMEOUT_MS;
+    s_deepseek_pool = ai_http_pool_create(&pool_cfg);
+
+    pool_cfg.name = "Coze";
+    pool_cfg.url = COZE_API_URL;
+    pool_cfg.timeout_ms = AI_COZE_TIMEOUT_MS;
+    s_coze_pool = ai_http_pool_create(&pool_cfg);
+    s_deepseek_body.lock = xSemaphoreCreateMutex();
+    s_coze_body.lock = xSemaphoreCreateMutex();
+    s_chat_lock = xSemaphoreCreateMutex();
+
+    ai_conversation_init();
+
+    ai_cache_init();
+
+    ai_hedge_init();
+
     ESP_LOGI(TAG, "AI服务模块已初始化。");
-    // 此处可以添加未来可能需要的一次性设置
 }
 
-std::string get_ai_answer(AiModel model, const std::string& input_text) {
+void ai_service_log_stats() {
+    ai_http_pool_log_stats(s_deepseek_pool);
+    ai_http_pool_log_stats(s_coze_pool);
+    ai_cache_log_stats();
+    ai_health_log_stats();
+    ai_conversation_log_stats();
+}
+
+// 请求前的公共检查，通过时返回空字符串
+static std::string _check_request(const std::string& input_text) {
     // 关键：调用您的WiFi模块检查网络状态
     if (wifi_get_status() != WIFI_STATUS_CONNECTED) {
         ESP_LOGE(TAG, "无法发送请求，WiFi未连接！");
@@ -209,15 +743,133 @@ std::string get_ai_answer(AiModel model, const std::string& input_text) {
         return "<错误: 输入文本不能为空>";
     }
 
-    switch (model) {
-        case AiModel::DEEPSEEK:
-            ESP_LOGI(TAG, "向 DeepSeek 发送问题: %s", input_text.c_str());
-            return _get_deepseek_answer(input_text);
-        case AiModel::COZE:
-            ESP_LOGI(TAG, "向 Coze 发送问题: %s", input_text.c_str());
-            return _get_coze_answer(input_text);
-        default:
-            ESP_LOGE(TAG, "未知的AI模型类型");
-            return "<错误: 未知的AI模型>";
+    if (!s_deepseek_pool || !s_coze_pool) {
+        return "<错误: AI服务未初始化>";
     }
-}
\ No newline at end of file
+    return "";
+}
+
+std::string get_ai_answer(AiModel model, const std::string& input_text, const std::atomic<bool>* abort,
+                          uint32_t timeout_ms) {
+    // 缓存命中时不需要网络
+    std::string result;
+    if (ai_cache_get((int)model, input_text, &result)) {
+        ESP_LOGI(TAG, "缓存命中: %s", input_text.c_str());
+        return result;
+    }
+
+    std::string error = _check_request(input_text);
+    if (!error.empty()) {
+        return error;
+    }
+
+    if (model != AiModel::DEEPSEEK && model != AiModel::COZE) {
+        ESP_LOGE(TAG, "未知的AI模型类型");
+        return "<错误: 未知的AI模型>";
+    }
+    // 熔断期间直接失败，不再等一次完整的超时
+    if (!ai_health_acquire(model)) {
+        return AI_ERROR_BACKEND_DOWN;
+    }
+
+    ESP_LOGI(TAG, "向 %s 发送问题: %s", model == AiModel::DEEPSEEK ? "DeepSeek" : "Coze", input_text.c_str());
+    result = _get_answer(model, input_text, false, abort, timeout_ms);
+    if (!_is_error(result)) {
+        ai_cache_put((int)model, input_text, result);
+    }
+    return result;
+}
+
+std::string get_ai_answer_stream(AiModel model, const std::string& input_text,
+                                 ai_delta_cb_t on_delta, void* arg, AiStreamStats* stats,
+                                 const std::atomic<bool>* abort, uint32_t timeout_ms) {
+    if (stats) {
+        *stats = AiStreamStats();
+    }
+    // 缓存命中时整段回答作为一个增量交出
+    int64_t start_us = esp_timer_get_time();
+    std::string cached;
+    if (ai_cache_get((int)model, input_text, &cached)) {
+        ESP_LOGI(TAG, "缓存命中 (流式): %s", input_text.c_str());
+        if (on_delta) {
+            on_delta(cached.data(), cached.size(), arg);
+        }
+        if (stats) {
+            stats->first_token_ms = stats->total_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+            stats->deltas = 1;
+        }
+        return cached;
+    }
+
+    std::string error = _check_request(input_text);
+    if (!error.empty()) {
+        return error;
+    }
+    if (model != AiModel::DEEPSEEK && model != AiModel::COZE) {
+        ESP_LOGE(TAG, "未知的AI模型类型");
+        return "<错误: 未知的AI模型>";
+    }
+    if (!ai_health_acquire(model)) {
+        return AI_ERROR_BACKEND_DOWN;
+    }
+
+    ESP_LOGI(TAG, "向 %s 发送问题 (流式): %s", model == AiModel::DEEPSEEK ? "DeepSeek" : "Coze",
+             input_text.c_str());
+    std::string result = _get_stream_answer(model, input_text, false, on_delta, arg, stats, abort, timeout_ms);
+    if (!_is_error(result)) {
+        ai_cache_put((int)model, input_text, result);
+    }
+    return result;
+}
+
+// 多轮对话不使用缓存：同一句话在不同的上下文中回答可能不同
+std::string get_ai_chat_answer(const std::string& input_text, const std::atomic<bool>* abort) {
+    std::string error = _check_request(input_text);
+    if (!error.empty()) {
+        return error;
+    }
+    if (!s_chat_lock) {
+        return "<错误: AI服务未初始化>";
+    }
+    if (!ai_health_acquire(AiModel::DEEPSEEK)) {
+        return AI_ERROR_BACKEND_DOWN;
+    }
+
+    ESP_LOGI(TAG, "向 DeepSeek 发送问题 (多轮): %s", input_text.c_str());
+    xSemaphoreTake(s_chat_lock, portMAX_DELAY);
+    std::string result = _get_answer(AiModel::DEEPSEEK, input_text, true, abort, 0);
+    if (!_is_error(result)) {
+        ai_conversation_append(input_text, result);
+    }
+    xSemaphoreGive(s_chat_lock);
+    return result;
+}
+
+std::string get_ai_chat_answer_stream(const std::string& input_text, ai_delta_cb_t on_delta, void* arg,
+                                      AiStreamStats* stats, const std::atomic<bool>* abort) {
+    if (stats) {
+        *stats = AiStreamStats();
+    }
+    std::string error = _check_request(input_text);
+    if (!error.empty()) {
+        return error;
+    }
+    if (!s_chat_lock) {
+        return "<错误: AI服务未初始化>";
+    }
+    if (!ai_health_acquire(AiModel::DEEPSEEK)) {
+        return AI_ERROR_BACKEND_DOWN;
+    }
+
+    ESP_LOGI(TAG, "向 DeepSeek 发送问题 (多轮, 流式): %s", input_text.c_str());
+    // 多轮请求依次执行；只有收到结束标记的完整回答才加入上下文，截断的回答不进入之后的每一轮
+    xSemaphoreTake(s_chat_lock, portMAX_DELAY);
+    bool complete = false;
+    std::string result = _get_stream_answer(AiModel::DEEPSEEK, input_text, true, on_delta, arg, stats, abort, 0,
+                                            &complete);
+    if (complete) {
+        ai_conversation_append(input_text, result);
+    }
+    xSemaphoreGive(s_chat_lock);
+    return result;
+}
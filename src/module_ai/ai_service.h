@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
 #include <string>
 
 /**
@@ -19,14 +22,91 @@ enum class AiModel {
  */
 void ai_service_init();
 
+/**
+ * @brief 打印各后端连接池的冷/热请求延迟对比 (新建连接 vs 复用长连接)、TLS 完整握手/会话恢复的开销、
+ *        缓存命中率和熔断器状态
+ */
+void ai_service_log_stats();
+
 /**
  * @brief 获取AI模型的回答
  * 
  * 这是一个阻塞函数。它会检查WiFi连接，发送HTTP请求，并等待AI的响应。
+ * 不希望阻塞调用任务时使用 ai_async.h 中的异步队列。
  * 
  * @param model 要使用的AI模型 (AiModel::DEEPSEEK 或 AiModel::COZE)。
  * @param input_text 发送给AI的用户问题。
+ * @param abort 可选的中止标志，其他任务置 true 后请求在下一个 HTTP 事件 (通常是下一段响应数据) 时中止，
+ *        返回 AI_ERROR_ABORTED。非流式请求在服务器生成完整个回答之前收不到任何事件，
+ *        需要限时的调用方应该同时给出 timeout_ms。
+ * @param timeout_ms 可选的超时上限 (毫秒)，0 表示只用按延迟推算的超时 (见 ai_health.h)
  * @return std::string AI的回答。如果发生错误（如网络问题、API错误、解析失败），
  *         将返回一个以"<错误:"开头的描述性字符串。
  */
-std::string get_ai_answer(AiModel model, const std::string& input_text);
\ No newline at end of file
+std::string get_ai_answer(AiModel model, const std::string& input_text,
+                          const std::atomic<bool>* abort = nullptr, uint32_t timeout_ms = 0);
+
+// 请求被 abort 标志中止时的返回值
+#define AI_ERROR_ABORTED "<错误: 请求已中止>"
+// 后端连续失败、熔断期间直接返回的错误 (见 ai_health.h)
+#define AI_ERROR_BACKEND_DOWN "<错误: 后端暂时不可用>"
+
+/**
+ * @brief 流式回答的增量回调，每收到一段新文本调用一次
+ *
+ * 在执行 HTTP 请求的任务中同步调用，耗时操作 (例如 TTS) 应该转交给其他任务。
+ * @param text 新增的文本 (UTF-8，不以 '\0' 结尾)
+ * @param len  字节数
+ * @param arg  get_ai_answer_stream 传入的参数
+ */
+typedef void (*ai_delta_cb_t)(const char* text, size_t len, void* arg);
+
+/**
+ * @brief 一次流式请求的耗时
+ */
+struct AiStreamStats {
+    uint32_t first_token_ms = 0;  // 从调用开始到第一段文本 (含建连)，没有收到文本时为 0
+    uint32_t total_ms = 0;        // 从调用开始到响应结束
+    uint32_t deltas = 0;          // 回调次数
+    uint32_t http_ms = 0;         // HTTP 交互本身 (连接池取得连接之后)，不含本地排队，没有发出请求时为 0
+};
+
+/**
+ * @brief 以流式 (server-sent events) 获取AI模型的回答
+ *
+ * 请求带 "stream": true，响应边到边解析，每个增量文本立即通过 on_delta 交出，
+ * 不必等整段回答生成完。同样是阻塞函数，返回时 on_delta 已经收到全部文本。
+ *
+ * @param model      要使用的AI模型
+ * @param input_text 发送给AI的用户问题
+ * @param on_delta   增量回调，可以为 NULL
+ * @param arg        传给 on_delta 的参数
+ * @param stats      输出首字延迟和总耗时，可以为 NULL
+ * @param abort      可选的中止标志，同 get_ai_answer，每收到一段增量都会检查
+ * @param timeout_ms 可选的超时上限，同 get_ai_answer
+ * @return std::string 完整回答 (各段增量拼接)；出错时返回以"<错误:"开头的描述性字符串，
+ *         此前已经回调出去的文本不会撤回。
+ */
+std::string get_ai_answer_stream(AiModel model, const std::string& input_text,
+                                 ai_delta_cb_t on_delta, void* arg, AiStreamStats* stats = nullptr,
+                                 const std::atomic<bool>* abort = nullptr, uint32_t timeout_ms = 0);
+
+/**
+ * @brief 多轮对话：向 DeepSeek 提问并带上之前的对话上下文
+ *
+ * 与 get_ai_answer 相同是阻塞函数。请求中的 messages 为 system 消息、ai_conversation 中保存的历史轮次、
+ * 本次问题；成功后本轮问答加入上下文 (超出预算时淘汰最早的轮次)。不使用回答缓存。
+ * 多轮请求 (包括流式版本) 依次执行，后一轮的请求体一定带上前一轮。
+ * 用 ai_conversation_clear 开始新的对话。
+ *
+ * @return 回答；出错时返回以"<错误:"开头的描述性字符串，上下文不变
+ */
+std::string get_ai_chat_answer(const std::string& input_text, const std::atomic<bool>* abort = nullptr);
+
+/**
+ * @brief 多轮对话的流式版本，参数同 get_ai_answer_stream
+ *
+ * 只有收到结束标记的完整回答才加入上下文；没有结束标记的回答照常返回，但不进入之后的请求。
+ */
+std::string get_ai_chat_answer_stream(const std::string& input_text, ai_delta_cb_t on_delta, void* arg,
+                                      AiStreamStats* stats = nullptr, const std::atomic<bool>* abort = nullptr);
@@ -0,0 +1,108 @@
+// src/module_ai/ai_sse.cpp
+
+#include "ai_sse.h"
+
+#include <string.h>
+
+void ai_sse_parser_init(ai_sse_parser_t* parser, ai_sse_event_cb_t on_event, void* arg) {
+    memset(parser, 0, sizeof(*parser));
+    parser->on_event = on_event;
+    parser->arg = arg;
+}
+
+static void _reset_event(ai_sse_parser_t* p) {
+    p->event[0] = '\0';
+    p->data_len = 0;
+    p->has_data = false;
+    p->event_overflow = false;
+}
+
+static void _dispatch(ai_sse_parser_t* p) {
+    if (p->event_overflow) {
+        p->dropped++;
+    } else if (p->has_data) {
+        p->data[p->data_len] = '\0';
+        p->events++;
+        if (p->on_event) {
+            p->on_event(p->event, p->data, p->data_len, p->arg);
+        }
+    }
+    _reset_event(p);
+}
+
+// 处理一行 (不含行尾)
+static void _process_line(ai_sse_parser_t* p) {
+    if (p->line_overflow) {
+        p->event_overflow = true;
+        return;
+    }
+    if (p->line_len == 0) {
+        _dispatch(p);
+        return;
+    }
+    if (p->line[0] == ':') {
+        return;  // 注释 (常用作心跳)
+    }
+
+    const char* line = p->line;
+    const char* colon = static_cast<const char*>(memchr(line, ':', p->line_len));
+    size_t name_len = colon ? (size_t)(colon - line) : p->line_len;
+    const char* value = colon ? colon + 1 : line + p->line_len;
+    const char* end = line + p->line_len;
+    if (value < end && *value == ' ') {
+        value++;
+    }
+    size_t value_len = end - value;
+
+    if (name_len == 4 && memcmp(line, "data", 4) == 0) {
+        // 多个 data 行之间用 '\n' 连接，末尾预留 '\0'
+        size_t need = value_len + (p->has_data ? 1 : 0);
+        if (p->data_len + need >= AI_SSE_MAX_DATA) {
+            p->event_overflow = true;
+            return;
+        }
+        if (p->has_data) {
+            p->data[p->data_len++] = '\n';
+        }
+        memcpy(p->data + p->data_len, value, value_len);
+        p->data_len += value_len;
+        p->has_data = true;
+    } else if (name_len == 5 && memcmp(line, "event", 5) == 0) {
+        size_t n = value_len < AI_SSE_MAX_EVENT - 1 ? value_len : AI_SSE_MAX_EVENT - 1;
+        memcpy(p->event, value, n);
+        p->event[n] = '\0';
+    }
+    // id / retry 以及未知字段忽略
+}
+
+void ai_sse_parser_feed(ai_sse_parser_t* parser, const char* data, size_t len) {
+    ai_sse_parser_t* p = parser;
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+        if (c == '\n' && p->last_cr) {
+            p->last_cr = false;
+            continue;
+        }
+        p->last_cr = (c == '\r');
+        if (c == '\n' || c == '\r') {
+            _process_line(p);
+            p->line_len = 0;
+            p->line_overflow = false;
+            continue;
+        }
+        if (p->line_len < AI_SSE_MAX_LINE) {
+            p->line[p->line_len++] = c;
+        } else {
+            p->line_overflow = true;
+        }
+    }
+}
+
+void ai_sse_parser_finish(ai_sse_parser_t* parser) {
+    if (parser->line_len > 0 || parser->line_overflow) {
+        _process_line(parser);
+        parser->line_len = 0;
+        parser->line_overflow = false;
+    }
+    _dispatch(parser);
+}
@@ -0,0 +1,58 @@
+// src/module_ai/ai_sse.h
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief 增量的 server-sent events 解析器
+ *
+ * HTTP 响应体按任意长度分片喂入 (esp_http_client 的 HTTP_EVENT_ON_DATA)，事件可以跨分片，
+ * 每遇到一个空行就回调一次完整的事件。支持 LF / CRLF / CR 行尾、":" 开头的注释行、
+ * 多行 data (按规范用 '\n' 连接)，"field:value" 中 value 前的一个空格会被去掉
+ * (Coze 写作 "data:{...}"，DeepSeek 写作 "data: {...}")。
+ * 缓冲区大小固定，不分配内存；单行或单个事件超过缓冲区时整件事件被丢弃并计数。
+ */
+
+#define AI_SSE_MAX_LINE  2048
+#define AI_SSE_MAX_DATA  2048
+#define AI_SSE_MAX_EVENT 32
+
+/**
+ * @brief 事件回调
+ * @param event 事件名 (event 字段)，没有时为空字符串
+ * @param data  事件数据，以 '\0' 结尾
+ * @param len   数据长度
+ * @param arg   ai_sse_parser_init 传入的参数
+ */
+typedef void (*ai_sse_event_cb_t)(const char* event, const char* data, size_t len, void* arg);
+
+typedef struct {
+    ai_sse_event_cb_t on_event;
+    void* arg;
+    char line[AI_SSE_MAX_LINE];
+    size_t line_len;
+    bool line_overflow;
+    bool last_cr;                 // 上一个字节是 '\r'，紧跟的 '\n' 属于同一个行尾
+    char event[AI_SSE_MAX_EVENT];
+    char data[AI_SSE_MAX_DATA];
+    size_t data_len;
+    bool has_data;
+    bool event_overflow;
+    uint32_t events;              // 已回调的事件数
+    uint32_t dropped;             // 因超长丢弃的事件数
+} ai_sse_parser_t;
+
+void ai_sse_parser_init(ai_sse_parser_t* parser, ai_sse_event_cb_t on_event, void* arg);
+
+/**
+ * @brief 喂入一段响应数据，期间可能多次回调 on_event
+ */
+void ai_sse_parser_feed(ai_sse_parser_t* parser, const char* data, size_t len);
+
+/**
+ * @brief 响应结束：最后一个事件后面没有空行时也把它交出去
+ */
+void ai_sse_parser_finish(ai_sse_parser_t* parser);
@@ -1,6 +1,8 @@
 #include "mqtt_manager.h"
 #include "esp_log.h"
 #include "mqtt_client.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
 #include <ArduinoJson.h>
 #include <cmath> 
 // --- 配置 ---
@@ -14,6 +16,10 @@
 static const char *TAG = "MQTT_MANAGER";
 static esp_mqtt_client_handle_t client = NULL;
 static bool is_mqtt_connected = false;
+// 聚合数据缓存，结构体很小，用临界区保护即可
+static AggregatedData s_aggregated;
+static portMUX_TYPE s_aggregated_lock = portMUX_INITIALIZER_UNLOCKED;
+static mqtt_event_listener_t s_event_listener = NULL;
 
 // --- 事件处理器 (与你提供的版本基本相同，无需修改) ---
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data) {
@@ -131,6 +137,20 @@ void mqtt_publish_aggregated_data(const std::string& device_id, const Aggregated
         breathing["value"] = data.breathing;
         breathing["timestamp"] = timestamp;
     }
+    if (data.i2s_rx_overflows != -1) {
+        // 最近一次溢出换算成距发布时刻的秒数，服务端不需要知道设备的开机时间
+        uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        JsonObject i2s = doc.createNestedObject("i2s");
+        i2s["rx_overflows"] = data.i2s_rx_overflows;
+        i2s["tx_underflows"] = data.i2s_tx_underflows;
+        if (data.i2s_rx_overflows > 0) {
+            i2s["rx_overflow_age_s"] = (now_ms - data.i2s_last_rx_overflow_ms) / 1000;
+        }
+        if (data.i2s_tx_underflows > 0) {
+            i2s["tx_underflow_age_s"] = (now_ms - data.i2s_last_tx_underflow_ms) / 1000;
+        }
+        i2s["timestamp"] = timestamp;
+    }
 
     // 如果没有任何有效数据，则不发送
     if (doc.size() == 0) {
@@ -149,6 +169,11 @@ void mqtt_publish_aggregated_data(const std::string& device_id, const Aggregated
 
 // ============== 保留的事件发布函数 ==============
 void mqtt_publish_event(const std::string& device_id, const std::string& event_type, const std::string& priority) {
+    mqtt_event_listener_t listener = s_event_listener;
+    if (listener) {
+        listener(device_id, event_type, priority);
+    }
+
     StaticJsonDocument<256> doc;
     doc["event"] = event_type;
     doc["priority"] = priority;
@@ -160,4 +185,32 @@ void mqtt_publish_event(const std::string& device_id, const std::string& event_t
 
     ESP_LOGW(TAG, "Publishing EVENT to %s: %s", topic.c_str(), payload_str.c_str());
     publish_message(topic, payload_str, 2); // 事件/警报使用 QoS 2 确保送达
-}
\ No newline at end of file
+}
+
+void mqtt_set_event_listener(mqtt_event_listener_t listener) {
+    s_event_listener = listener;
+}
+
+// ============== 聚合数据缓存 ==============
+void mqtt_aggregate_set_breathing(int breathing) {
+    taskENTER_CRITICAL(&s_aggregated_lock);
+    s_aggregated.breathing = breathing;
+    taskEXIT_CRITICAL(&s_aggregated_lock);
+}
+
+void mqtt_aggregate_set_i2s_stats(uint32_t rx_overflows, uint32_t tx_underflows,
+                                  uint32_t last_rx_overflow_ms, uint32_t last_tx_underflow_ms) {
+    taskENTER_CRITICAL(&s_aggregated_lock);
+    s_aggregated.i2s_rx_overflows = (int)rx_overflows;
+    s_aggregated.i2s_tx_underflows = (int)tx_underflows;
+    s_aggregated.i2s_last_rx_overflow_ms = last_rx_overflow_ms;
+    s_aggregated.i2s_last_tx_underflow_ms = last_tx_underflow_ms;
+    taskEXIT_CRITICAL(&s_aggregated_lock);
+}
+
+AggregatedData mqtt_aggregate_snapshot(void) {
+    taskENTER_CRITICAL(&s_aggregated_lock);
+    AggregatedData copy = s_aggregated;
+    taskEXIT_CRITICAL(&s_aggregated_lock);
+    return copy;
+}
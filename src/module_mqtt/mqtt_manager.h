@@ -2,6 +2,7 @@
 #define MQTT_MANAGER_H
 
 #include <string>
+#include <cstdint>
 #include <cmath> // For NAN
 
 // 定义一个结构体来聚合所有传感器的数据
@@ -13,6 +14,11 @@ struct AggregatedData {
     int spo2 = -1;
     int co2 = -1;
     int breathing = -1;
+    // 本机音频链路 (I2S DMA) 的累计溢出次数和最近一次发生的开机时间 (毫秒)
+    int i2s_rx_overflows = -1;
+    int i2s_tx_underflows = -1;
+    uint32_t i2s_last_rx_overflow_ms = 0;
+    uint32_t i2s_last_tx_underflow_ms = 0;
 };
 
 // --- MQTT 管理器公共接口 ---
@@ -51,4 +57,41 @@ void mqtt_publish_aggregated_data(const std::string& device_id, const Aggregated
  */
 void mqtt_publish_event(const std::string& device_id, const std::string& event_type, const std::string& priority);
 
+/**
+ * @brief 事件监听回调，在 mqtt_publish_event 发布之前于调用者的任务中执行
+ *
+ * 用于在告警发生的同时截取现场数据 (例如预录音频)，回调中不要长时间阻塞。
+ */
+typedef void (*mqtt_event_listener_t)(const std::string& device_id, const std::string& event_type, const std::string& priority);
+
+/**
+ * @brief 设置事件监听回调，传 NULL 取消
+ */
+void mqtt_set_event_listener(mqtt_event_listener_t listener);
+
+// --- 聚合数据缓存 ---
+// 各数据源 (ESP-NOW 传感器、本地音频分析等) 在各自的任务中更新最新值，
+// 发布任务取快照后调用 mqtt_publish_aggregated_data。内部有锁，可跨任务调用。
+
+/**
+ * @brief 更新呼吸频率
+ * @param breathing 次/分钟，-1 表示当前无有效值
+ */
+void mqtt_aggregate_set_breathing(int breathing);
+
+/**
+ * @brief 更新 I2S DMA 溢出统计
+ * @param rx_overflows      接收队列溢出累计次数
+ * @param tx_underflows     发送队列溢出 (播放欠载) 累计次数
+ * @param last_rx_overflow_ms  最近一次接收溢出的开机时间 (毫秒)
+ * @param last_tx_underflow_ms 最近一次发送欠载的开机时间 (毫秒)
+ */
+void mqtt_aggregate_set_i2s_stats(uint32_t rx_overflows, uint32_t tx_underflows,
+                                  uint32_t last_rx_overflow_ms, uint32_t last_tx_underflow_ms);
+
+/**
+ * @brief 获取当前聚合数据的拷贝
+ */
+AggregatedData mqtt_aggregate_snapshot(void);
+
 #endif // MQTT_MANAGER_H
\ No newline at end of file
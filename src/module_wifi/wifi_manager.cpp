@@ -1,6 +1,7 @@
 #include "wifi_manager.h"
 #include "esp_log.h"
 #include "esp_event.h"
+#include "esp_netif.h"
 #include "nvs_flash.h"
 #include "freertos/event_groups.h"
 #include "string.h"
@@ -19,6 +20,8 @@ static int s_retry_num = 0;
 
 // 全局变量，用于存储当前WiFi状态
 static wifi_status_t g_wifi_status = WIFI_STATUS_DISCONNECTED;
+// 每次获得 IP 加 1，供长连接判断是否断过网
+static volatile uint32_t g_connection_epoch = 0;
 
 void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data)
@@ -42,6 +45,7 @@ void wifi_event_handler(void* arg, esp_event_base_t event_base,
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "Got ip:" IPSTR, IP2STR(&event->ip_info.ip));
         s_retry_num = 0;
+        g_connection_epoch = g_connection_epoch + 1;
         g_wifi_status = WIFI_STATUS_CONNECTED;
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
@@ -51,7 +55,10 @@ void wifi_init_sta(void)
 {
     s_wifi_event_group = xEventGroupCreate();
 
-
+    // TCP/IP 协议栈、默认事件循环和 STA 网络接口，调用前需要已经初始化 NVS
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    esp_netif_create_default_wifi_sta();
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -84,6 +91,11 @@ wifi_status_t wifi_get_status(void)
     return g_wifi_status;
 }
 
+uint32_t wifi_get_connection_epoch(void)
+{
+    return g_connection_epoch;
+}
+
 void wifi_print_status(void)
 {
     if(g_wifi_status == WIFI_STATUS_CONNECTED) {
@@ -19,8 +19,8 @@ void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id
 /**
  * @brief 初始化Wi-Fi管理器
  * 
- * 该函数会初始化底层的TCP/IP协议栈和Wi-Fi驱动，并启动连接过程。
- * 只需要在 app_main 中调用一次。
+ * 该函数会初始化底层的TCP/IP协议栈、默认事件循环和Wi-Fi驱动，并启动连接过程。
+ * 只需要在 app_main 中调用一次，调用前先 nvs_flash_init()。
  */
 void wifi_init_sta(void);
 
@@ -32,6 +32,15 @@ void wifi_init_sta(void);
  */
 wifi_status_t wifi_get_status(void);
 
+/**
+ * @brief 获取连接代数：每次获得 IP 时加 1
+ *
+ * 持有长连接的模块 (例如 AI 服务的 HTTPS 连接池) 记录建立连接时的代数，
+ * 代数变化说明中间断过网，旧的 TCP/TLS 连接已经失效，需要重建。
+ * @return uint32_t 当前代数，从未连上时为 0
+ */
+uint32_t wifi_get_connection_epoch(void);
+
 /**
  * @brief (测试函数) 打印当前的Wi-Fi状态到串口
  * 
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+二阶节级联设计工具，为 src/audio/biquad_eq.h 生成 Q4.28 定点系数头文件。
+
+  设计并生成:  biquad_design.py hp:180:0.707 peak:1200:-6:1.5 hs:6000:4 -o src/audio/speaker_eq_coeffs.h
+  只看响应:    biquad_design.py hp:180:0.707 peak:1200:-6:1.5
+
+每个参数描述一节 (RBJ Audio EQ Cookbook 公式)：
+  lp:频率[:Q]            低通          hp:频率[:Q]           高通
+  peak:频率:增益dB[:Q]   峰值/陷波     ls:频率:增益dB[:S]     低搁架
+  hs:频率:增益dB[:S]     高搁架
+  lr4lp:频率 / lr4hp:频率  Linkwitz-Riley 4 阶分频 (展开为两节 Q=0.707 的巴特沃斯)
+Q 默认 0.707，搁架斜率 S 默认 1。
+量化后会检查极点是否仍在单位圆内、系数是否超出 Q4.28 范围，并打印量化前后的幅频响应。
+"""
+
+import argparse
+import cmath
+import math
+import os
+import sys
+
+FRAC_BITS = 28          # 与 BIQUAD_COEFF_FRAC_BITS 一致
+MAX_SECTIONS = 12       # 与 BIQUAD_MAX_SECTIONS 一致
+COEFF_LIMIT = (1 << 31) - 1
+
+
+def rbj(kind, rate, freq, gain_db=0.0, q=0.7071):
+    """返回归一化后的 (b0, b1, b2, a1, a2)"""
+    w0 = 2.0 * math.pi * freq / rate
+    cw, sw = math.cos(w0), math.sin(w0)
+    a = 10.0 ** (gain_db / 40.0)
+    if kind in ("ls", "hs"):
+        # q 作为搁架斜率 S
+        alpha = sw / 2.0 * math.sqrt((a + 1.0 / a) * (1.0 / q - 1.0) + 2.0)
+    else:
+        alpha = sw / (2.0 * q)
+
+    if kind == "lp":
+        b = [(1 - cw) / 2, 1 - cw, (1 - cw) / 2]
+        den = [1 + alpha, -2 * cw, 1 - alpha]
+    elif kind == "hp":
+        b = [(1 + cw) / 2, -(1 + cw), (1 + cw) / 2]
+        den = [1 + alpha, -2 * cw, 1 - alpha]
+    elif kind == "peak":
+        b = [1 + alpha * a, -2 * cw, 1 - alpha * a]
+        den = [1 + alpha / a, -2 * cw, 1 - alpha / a]
+    elif kind == "ls":
+        sa = 2 * math.sqrt(a) * alpha
+        b = [a * ((a + 1) - (a - 1) * cw + sa), 2 * a * ((a - 1) - (a + 1) * cw), a * ((a + 1) - (a - 1) * cw - sa)]
+        den = [(a + 1) + (a - 1) * cw + sa, -2 * ((a - 1) + (a + 1) * cw), (a + 1) + (a - 1) * cw - sa]
+    elif kind == "hs":
+        sa = 2 * math.sqrt(a) * alpha
+        b = [a * ((a + 1) + (a - 1) * cw + sa), -2 * a * ((a - 1) + (a + 1) * cw), a * ((a + 1) + (a - 1) * cw - sa)]
+        den = [(a + 1) - (a - 1) * cw + sa, 2 * ((a - 1) - (a + 1) * cw), (a + 1) - (a - 1) * cw - sa]
+    else:
+        raise ValueError("unknown section type: " + kind)
+    a0 = den[0]
+    return (b[0] / a0, b[1] / a0, b[2] / a0, den[1] / a0, den[2] / a0)
+
+
+def parse_section(spec, rate):
+    parts = spec.split(":")
+    kind = parts[0]
+    vals = [float(v) for v in parts[1:]]
+    if kind in ("lr4lp", "lr4hp"):
+        if len(vals) != 1:
+            raise ValueError(spec + ": expected lr4lp:freq")
+        s = rbj(kind[3:], rate, vals[0])
+        return [s, s]
+    if kind in ("lp", "hp"):
+        if not 1 <= len(vals) <= 2:
+            raise ValueError(spec + ": expected %s:freq[:Q]" % kind)
+        return [rbj(kind, rate, vals[0], 0.0, vals[1] if len(vals) > 1 else 0.7071)]
+    if kind in ("peak", "ls", "hs"):
+        if not 2 <= len(vals) <= 3:
+            raise ValueError(spec + ": expected %s:freq:gain_db[:Q]" % kind)
+        default_q = 1.0 if kind != "peak" else 0.7071
+        return [rbj(kind, rate, vals[0], vals[1], vals[2] if len(vals) > 2 else default_q)]
+    raise ValueError("unknown section type: " + kind)
+
+
+def quantize(section):
+    q = [int(round(c * (1 << FRAC_BITS))) for c in section]
+    if any(abs(v) > COEFF_LIMIT for v in q):
+        raise ValueError("coefficient out of Q4.28 range: %r" % (section,))
+    return q
+
+
+def poles_stable(a1, a2):
+    # z^2 + a1 z + a2 的两个根都在单位圆内
+    disc = cmath.sqrt(a1 * a1 - 4 * a2)
+    return all(abs(r) < 1.0 for r in ((-a1 + disc) / 2, (-a1 - disc) / 2))
+
+
+def response_db(sections, freq, rate):
+    z = cmath.exp(-1j * 2 * math.pi * freq / rate)
+    h = 1.0
+    for b0, b1, b2, a1, a2 in sections:
+        h *= (b0 + b1 * z + b2 * z * z) / (1 + a1 * z + a2 * z * z)
+    return 20 * math.log10(max(abs(h), 1e-12))
+
+
+def write_header(path, name, specs, rate, quantized):
+    guard = os.path.basename(path).upper().replace(".", "_")
+    with open(path, "w") as f:
+        f.write("// 由 tools/biquad_design.py 生成，不要手工修改\n")
+        f.write("// biquad_design.py --name %s --rate %d %s\n\n" % (name, rate, " ".join(specs)))
+        f.write("#ifndef %s\n#define %s\n\n" % (guard, guard))
+        f.write('#include "biquad_eq.h"\n\n')
+        f.write("#define %s_SAMPLE_RATE %d\n" % (name.upper(), rate))
+        f.write("#define %s_SECTIONS %d\n\n" % (name.upper(), len(quantized)))
+        f.write("static const BiquadCoeffs k%s[%s_SECTIONS] = {\n" % (
+            "".join(p.capitalize() for p in name.split("_")), name.upper()))
+        for q in quantized:
+            f.write("    {%d, %d, %d, %d, %d},\n" % tuple(q))
+        f.write("};\n\n#endif // %s\n" % guard)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Design a fixed-point biquad cascade")
+    parser.add_argument("sections", nargs="+", help="section specs, e.g. hp:180 peak:1200:-6:1.5")
+    parser.add_argument("--rate", type=int, default=24000)
+    parser.add_argument("--name", default="speaker_eq", help="identifier prefix in the generated header")
+    parser.add_argument("-o", "--output", help="header to write")
+    args = parser.parse_args()
+
+    try:
+        designed = []
+        for spec in args.sections:
+            designed.extend(parse_section(spec, args.rate))
+        if len(designed) > MAX_SECTIONS:
+            raise ValueError("%d sections, at most %d supported" % (len(designed), MAX_SECTIONS))
+        quantized = [quantize(s) for s in designed]
+    except ValueError as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 1
+
+    scale = float(1 << FRAC_BITS)
+    fixed = [tuple(v / scale for v in q) for q in quantized]
+    for i, (_, _, _, a1, a2) in enumerate(fixed):
+        if not poles_stable(a1, a2):
+            print("error: section %d is unstable after quantization" % i, file=sys.stderr)
+            return 1
+
+    print("%d sections @ %d Hz" % (len(designed), args.rate))
+    print("   freq    designed   quantized")
+    freq = 50.0
+    while freq < args.rate / 2:
+        print("%7.0f  %8.2f dB  %8.2f dB" % (freq, response_db(designed, freq, args.rate),
+                                              response_db(fixed, freq, args.rate)))
+        freq *= 2 ** (1 / 3)
+
+    if args.output:
+        write_header(args.output, args.name, args.sections, args.rate, quantized)
+        print("wrote %s" % args.output)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,338 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+提示音资源包工具，生成/检查烧写到 prompts 分区的镜像。
+格式定义见 src/audio/prompt_store.h，两边必须保持一致。
+
+  打包:  prompt_pack.py pack prompts/ -o build/prompts.bin [--rate 24000] [--adpcm] [--size 512K]
+  检查:  prompt_pack.py check build/prompts.bin [--size 512K] [--rate 24000]
+  列表:  prompt_pack.py list build/prompts.bin
+
+输入为 16 位 PCM 或 IMA ADPCM 的 .wav，文件名 (去掉扩展名) 就是资源名。
+采样率与 --rate 不同的 PCM 会线性插值重采样；--adpcm 时单声道资源编码成 ADPCM。
+烧写: esptool.py write_flash 0x780000 build/prompts.bin (或 idf.py flash，见 src/CMakeLists.txt)
+"""
+
+import argparse
+import os
+import struct
+import sys
+import wave
+import zlib
+
+MAGIC = 0x544D5250  # "PRMT"
+VERSION = 1
+NAME_MAX = 24
+HEADER_FMT = "<IHHIII12x"      # PromptPackHeader, 32 字节
+ENTRY_FMT = "<24sIIIIBBHI"     # PromptEntry, 48 字节
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+ENTRY_SIZE = struct.calcsize(ENTRY_FMT)
+FORMAT_PCM16 = 0
+FORMAT_IMA_ADPCM = 1
+BLOCK_ALIGN = 256
+ALIGN = 4
+
+assert HEADER_SIZE == 32 and ENTRY_SIZE == 48
+
+# ======== IMA ADPCM (与 src/audio/adpcm.cpp 相同的算法) ========
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+]
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def samples_per_block(block_align):
+    return (block_align - 4) * 2 + 1
+
+
+def _ima_update(state, code):
+    step = STEP_TABLE[state[1]]
+    diff = step >> 3
+    if code & 4:
+        diff += step
+    if code & 2:
+        diff += step >> 1
+    if code & 1:
+        diff += step >> 2
+    pred = state[0] - diff if code & 8 else state[0] + diff
+    state[0] = max(-32768, min(32767, pred))
+    state[1] = max(0, min(88, state[1] + INDEX_TABLE[code]))
+
+
+def _ima_encode_sample(state, sample):
+    step = STEP_TABLE[state[1]]
+    diff = sample - state[0]
+    code = 0
+    if diff < 0:
+        code = 8
+        diff = -diff
+    if diff >= step:
+        code |= 4
+        diff -= step
+    step >>= 1
+    if diff >= step:
+        code |= 2
+        diff -= step
+    step >>= 1
+    if diff >= step:
+        code |= 1
+    _ima_update(state, code)
+    return code
+
+
+def adpcm_encode(samples, block_align=BLOCK_ALIGN):
+    spb = samples_per_block(block_align)
+    state = [0, 0]
+    out = bytearray()
+    for start in range(0, len(samples), spb):
+        block = list(samples[start:start + spb])
+        block += [block[-1]] * (spb - len(block))
+        state[0] = block[0]
+        out += struct.pack("<hBB", block[0], state[1], 0)
+        for i in range(1, spb, 2):
+            lo = _ima_encode_sample(state, block[i])
+            hi = _ima_encode_sample(state, block[i + 1])
+            out.append(lo | (hi << 4))
+    return bytes(out)
+
+
+# ======== 读取 wav ========
+
+def read_wav(path):
+    """返回 (sample_rate, channels, format, block_align, samples_per_channel, payload)"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[0:4] != b"RIFF" or data[8:12] != b"WAVE":
+        raise ValueError("%s: not a RIFF/WAVE file" % path)
+    pos = 12
+    fmt = None
+    fact_samples = None
+    payload = None
+    while pos + 8 <= len(data):
+        cid, size = struct.unpack_from("<4sI", data, pos)
+        body = data[pos + 8:pos + 8 + size]
+        if cid == b"fmt ":
+            fmt = struct.unpack_from("<HHIIHH", body, 0)
+            extra = body[16:]
+        elif cid == b"fact":
+            fact_samples = struct.unpack_from("<I", body, 0)[0]
+        elif cid == b"data":
+            payload = body
+        pos += 8 + size + (size & 1)
+    if fmt is None or payload is None:
+        raise ValueError("%s: missing fmt/data chunk" % path)
+    tag, channels, rate, _, block_align, bits = fmt
+    if tag == 1 and bits == 16:
+        n = len(payload) // (2 * channels)
+        return rate, channels, FORMAT_PCM16, 0, n, payload[:n * 2 * channels]
+    if tag == 0x11 and channels == 1:
+        spb = struct.unpack_from("<H", extra, 2)[0] if len(extra) >= 4 else samples_per_block(block_align)
+        if spb != samples_per_block(block_align) or block_align > BLOCK_ALIGN:
+            raise ValueError("%s: unsupported ADPCM block layout" % path)
+        blocks = len(payload) // block_align
+        n = fact_samples if fact_samples is not None else blocks * spb
+        return rate, 1, FORMAT_IMA_ADPCM, block_align, n, payload[:blocks * block_align]
+    raise ValueError("%s: only 16-bit PCM or mono IMA ADPCM is supported" % path)
+
+
+def resample_pcm(payload, channels, src_rate, dst_rate):
+    """线性插值重采样，提示音的质量要求足够"""
+    count = len(payload) // 2
+    x = struct.unpack("<%dh" % count, payload)
+    n_in = count // channels
+    n_out = int(n_in * dst_rate / src_rate)
+    out = []
+    for i in range(n_out):
+        t = i * src_rate / dst_rate
+        i0 = int(t)
+        frac = t - i0
+        i1 = min(i0 + 1, n_in - 1)
+        for ch in range(channels):
+            a = x[i0 * channels + ch]
+            b = x[i1 * channels + ch]
+            out.append(int(round(a + (b - a) * frac)))
+    return n_out, struct.pack("<%dh" % len(out), *out)
+
+
+# ======== 打包 ========
+
+def parse_size(text):
+    text = text.strip().upper()
+    mul = 1
+    if text.endswith("K"):
+        mul, text = 1024, text[:-1]
+    elif text.endswith("M"):
+        mul, text = 1024 * 1024, text[:-1]
+    return int(text, 0) * mul
+
+
+def align_up(v, a=ALIGN):
+    return (v + a - 1) // a * a
+
+
+def pack(args):
+    files = sorted(f for f in os.listdir(args.input) if f.lower().endswith(".wav"))
+    assets = []
+    for fname in files:
+        name = os.path.splitext(fname)[0]
+        if len(name.encode()) >= NAME_MAX:
+            sys.exit("error: name too long (max %d bytes): %s" % (NAME_MAX - 1, name))
+        rate, channels, fmt, block_align, samples, payload = read_wav(os.path.join(args.input, fname))
+        if fmt == FORMAT_PCM16:
+            if rate != args.rate:
+                samples, payload = resample_pcm(payload, channels, rate, args.rate)
+                rate = args.rate
+            if args.adpcm and channels == 1:
+                pcm = struct.unpack("<%dh" % samples, payload)
+                payload = adpcm_encode(pcm)
+                fmt, block_align = FORMAT_IMA_ADPCM, BLOCK_ALIGN
+        elif rate != args.rate:
+            sys.exit("error: %s is ADPCM at %d Hz, convert it to %d Hz first" % (fname, rate, args.rate))
+        assets.append((name, fmt, channels, rate, block_align, samples, payload))
+
+    data_offset = align_up(HEADER_SIZE + ENTRY_SIZE * len(assets))
+    entries = bytearray()
+    blob = bytearray()
+    offset = data_offset
+    for name, fmt, channels, rate, block_align, samples, payload in assets:
+        entries += struct.pack(ENTRY_FMT, name.encode(), offset, len(payload), samples, rate,
+                               fmt, channels, block_align, zlib.crc32(payload) & 0xFFFFFFFF)
+        padded = align_up(len(payload))
+        blob += payload + b"\0" * (padded - len(payload))
+        offset += padded
+
+    total = offset
+    header = struct.pack(HEADER_FMT, MAGIC, VERSION, len(assets), data_offset, total,
+                         zlib.crc32(entries) & 0xFFFFFFFF)
+    image = header + entries + b"\0" * (data_offset - HEADER_SIZE - len(entries)) + blob
+    if args.size and len(image) > parse_size(args.size):
+        sys.exit("error: image is %d bytes, partition is only %s" % (len(image), args.size))
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print("prompt_pack: %d prompts, %d bytes -> %s" % (len(assets), len(image), args.output))
+    return check_image(image, args.size, args.rate, quiet=True)
+
+
+# ======== 检查 ========
+
+def check_image(image, size=None, rate=None, quiet=False):
+    errors = []
+    if len(image) < HEADER_SIZE:
+        return ["image too small"]
+    magic, version, count, data_offset, total, index_crc = struct.unpack_from(HEADER_FMT, image, 0)
+    if magic != MAGIC:
+        return ["bad magic 0x%08X" % magic]
+    if version != VERSION:
+        errors.append("version %d, expected %d" % (version, VERSION))
+    index_end = HEADER_SIZE + count * ENTRY_SIZE
+    if total > len(image):
+        errors.append("total_size %d exceeds image size %d" % (total, len(image)))
+    if size and total > parse_size(size):
+        errors.append("total_size %d exceeds partition size %s" % (total, size))
+    if index_end > data_offset or data_offset > total or data_offset % ALIGN:
+        errors.append("bad data_offset %d (index ends at %d)" % (data_offset, index_end))
+        return errors
+    if zlib.crc32(image[HEADER_SIZE:index_end]) & 0xFFFFFFFF != index_crc:
+        errors.append("index CRC mismatch")
+
+    names = set()
+    ranges = []
+    for i in range(count):
+        raw = struct.unpack_from(ENTRY_FMT, image, HEADER_SIZE + i * ENTRY_SIZE)
+        name_raw, offset, length, samples, srate, fmt, channels, block_align, crc = raw
+        label = "entry %d" % i
+        if b"\0" not in name_raw:
+            errors.append("%s: name not NUL-terminated" % label)
+        name = name_raw.split(b"\0", 1)[0].decode(errors="replace")
+        label = "entry %d (%s)" % (i, name)
+        if not name or name in names:
+            errors.append("%s: empty or duplicate name" % label)
+        names.add(name)
+        if offset < data_offset or offset % ALIGN or offset + length > total:
+            errors.append("%s: data [%d, %d) out of bounds or misaligned" % (label, offset, offset + length))
+            continue
+        ranges.append((offset, offset + length, name))
+        if channels not in (1, 2):
+            errors.append("%s: %d channels" % (label, channels))
+        if rate and srate != rate:
+            errors.append("%s: %d Hz, output is %d Hz" % (label, srate, rate))
+        if fmt == FORMAT_PCM16:
+            if samples * channels * 2 != length:
+                errors.append("%s: size %d != samples %d * channels %d * 2" % (label, length, samples, channels))
+        elif fmt == FORMAT_IMA_ADPCM:
+            if channels != 1 or block_align <= 4 or block_align > BLOCK_ALIGN:
+                errors.append("%s: bad ADPCM layout (channels %d, block_align %d)" % (label, channels, block_align))
+            else:
+                spb = samples_per_block(block_align)
+                if (samples + spb - 1) // spb * block_align != length:
+                    errors.append("%s: size %d does not match %d samples" % (label, length, samples))
+        else:
+            errors.append("%s: unknown format %d" % (label, fmt))
+        if zlib.crc32(image[offset:offset + length]) & 0xFFFFFFFF != crc:
+            errors.append("%s: data CRC mismatch" % label)
+
+    ranges.sort()
+    for (a0, a1, an), (b0, b1, bn) in zip(ranges, ranges[1:]):
+        if b0 < a1:
+            errors.append("data of %s and %s overlap" % (an, bn))
+
+    if not quiet or errors:
+        for e in errors:
+            print("error: " + e)
+        if not errors:
+            print("OK: %d prompts, %d bytes" % (count, total))
+    return errors
+
+
+def check(args):
+    with open(args.image, "rb") as f:
+        image = f.read()
+    return check_image(image, args.size, args.rate)
+
+
+def list_image(args):
+    with open(args.image, "rb") as f:
+        image = f.read()
+    magic, version, count, data_offset, total, _ = struct.unpack_from(HEADER_FMT, image, 0)
+    if magic != MAGIC:
+        sys.exit("error: bad magic")
+    print("%-24s %-6s %3s %6s %8s %8s %8s" % ("name", "format", "ch", "rate", "offset", "bytes", "ms"))
+    for i in range(count):
+        name, offset, length, samples, rate, fmt, channels, _, _ = struct.unpack_from(
+            ENTRY_FMT, image, HEADER_SIZE + i * ENTRY_SIZE)
+        print("%-24s %-6s %3d %6d %8d %8d %8d" % (name.split(b"\0", 1)[0].decode(), "adpcm" if fmt else "pcm",
+                                                  channels, rate, offset, length, samples * 1000 // max(rate, 1)))
+    return []
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack/check the prompts partition image")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("pack", help="pack a directory of .wav files")
+    p.add_argument("input")
+    p.add_argument("-o", "--output", required=True)
+    p.add_argument("--rate", type=int, default=24000, help="output sample rate (AUDIO_OUTPUT_SAMPLE_RATE)")
+    p.add_argument("--adpcm", action="store_true", help="encode mono PCM as IMA ADPCM")
+    p.add_argument("--size", help="partition size, e.g. 512K")
+    p.set_defaults(func=pack)
+    c = sub.add_parser("check", help="validate an image")
+    c.add_argument("image")
+    c.add_argument("--size", help="partition size, e.g. 512K")
+    c.add_argument("--rate", type=int, help="expected sample rate")
+    c.set_defaults(func=check)
+    l = sub.add_parser("list", help="list the prompts in an image")
+    l.add_argument("image")
+    l.set_defaults(func=list_image)
+    args = parser.parse_args()
+    sys.exit(1 if args.func(args) else 0)
+
+
+if __name__ == "__main__":
+    main()